@@ -49,6 +49,12 @@
 #include    <versiontheca/versiontheca.h>
 
 
+// C++
+//
+#include    <memory_resource>
+#include    <string_view>
+
+
 
 namespace as2js
 {
@@ -65,7 +71,7 @@ constexpr std::uint32_t BINARY_MAGIC_B3 = 0xE1;
 // version found in the header
 //
 constexpr std::uint8_t  BINARY_VERSION_MAJOR = 1;
-constexpr std::uint8_t  BINARY_VERSION_MINOR = 0;
+constexpr std::uint8_t  BINARY_VERSION_MINOR = 4;
 
 
 // extern functions such as pow(), ipow(), etc.
@@ -139,9 +145,33 @@ enum class external_function_t
     EXTERNAL_FUNCTION_ARRAY_INITIALIZE,             // void array_initialize(binary_variable *)
     EXTERNAL_FUNCTION_ARRAY_FREE,                   // void array_free(binary_variable *)
     EXTERNAL_FUNCTION_ARRAY_PUSH,                   // void array_push(binary_variable *,binary_variable *)
+    EXTERNAL_FUNCTION_ARRAY_INITIALIZE_TYPED,       // void array_initialize_typed(binary_variable *,int64_t)
+    EXTERNAL_FUNCTION_ARRAY_LENGTH,                 // int64_t array_length(binary_variable const *)
+    EXTERNAL_FUNCTION_ARRAY_DATA,                   // void * array_data(binary_variable const *)
+    EXTERNAL_FUNCTION_ARRAY_PUSH_INTEGER,           // void array_push_integer(binary_variable *,int64_t)
+    EXTERNAL_FUNCTION_ARRAY_PUSH_FLOATING_POINT,    // void array_push_floating_point(binary_variable *,double)
+    EXTERNAL_FUNCTION_ARRAY_PUSH_BOOLEAN,           // void array_push_boolean(binary_variable *,bool)
+    EXTERNAL_FUNCTION_ARRAY_GET_INTEGER,            // int64_t array_get_integer(binary_variable const *,int64_t)
+    EXTERNAL_FUNCTION_ARRAY_GET_FLOATING_POINT,     // double array_get_floating_point(binary_variable const *,int64_t)
+    EXTERNAL_FUNCTION_ARRAY_GET_BOOLEAN,            // bool array_get_boolean(binary_variable const *,int64_t)
+    EXTERNAL_FUNCTION_ARRAY_SET_INTEGER,            // void array_set_integer(binary_variable *,int64_t,int64_t)
+    EXTERNAL_FUNCTION_ARRAY_SET_FLOATING_POINT,     // void array_set_floating_point(binary_variable *,int64_t,double)
+    EXTERNAL_FUNCTION_ARRAY_SET_BOOLEAN,            // void array_set_boolean(binary_variable *,int64_t,bool)
+    EXTERNAL_FUNCTION_MATH_RANDOM_BITS,             // uint64_t math_random_bits()
+    EXTERNAL_FUNCTION_CPU_FEATURES,                 // not a function, the CPU_FEATURE_... flags detected at load time
+    EXTERNAL_FUNCTION_STRINGS_HASH,                 // uint64_t strings_hash(binary_variable const *,uint64_t)
 };
 
 
+// flags found at EXTERNAL_FUNCTION_CPU_FEATURES in the external function table
+//
+typedef std::uint64_t               cpu_features_t;
+
+constexpr cpu_features_t const      CPU_FEATURE_SSE4_1 = 0x0001; // ROUNDSD is available
+
+std::uint64_t                       get_extern_function(external_function_t func);
+
+
 enum variable_type_t : std::uint16_t
 {
     VARIABLE_TYPE_UNKNOWN,
@@ -157,10 +187,29 @@ enum variable_type_t : std::uint16_t
 char const * variable_type_to_string(variable_type_t t);
 
 
+// the type of the items of a VARIABLE_TYPE_ARRAY; the numbers and
+// booleans are saved contiguously instead of as pointers to variables
+//
+enum array_element_t : std::uint16_t
+{
+    ARRAY_ELEMENT_VARIABLE,                         // binary_variable::vector_of_pointers_t
+    ARRAY_ELEMENT_INTEGER,                          // binary_variable::vector_of_integers_t
+    ARRAY_ELEMENT_FLOATING_POINT,                   // binary_variable::vector_of_floating_points_t
+    ARRAY_ELEMENT_BOOLEAN,                          // binary_variable::vector_of_booleans_t
+};
+
+
 typedef std::uint32_t                       offset_t;
 typedef std::map<std::string, offset_t>     offset_map_t;
 
 
+// the .data section starts on a new page so the .text can be protected
+// separately (read/execute vs read/write); the .text is amd64 code so
+// the image only runs on x86-64 hosts where the base page is 4Kb
+//
+constexpr offset_t      BINARY_PAGE_SIZE = 4096;
+
+
 struct binary_header
 {
     std::uint8_t        f_magic[4] = { BINARY_MAGIC_B0, BINARY_MAGIC_B1, BINARY_MAGIC_B2, BINARY_MAGIC_B3 };
@@ -172,6 +221,9 @@ struct binary_header
     std::uint32_t       f_file_size = 0;        // useful to allocate the buffer on a load
     variable_type_t     f_return_type = VARIABLE_TYPE_UNKNOWN;
     std::uint16_t       f_private_variable_count = 0;
+    offset_t            f_extern_functions = 0; // offset to std::uint64_t[f_extern_function_count] (patched by the loader)
+    std::uint16_t       f_extern_function_count = 0;
+    std::uint16_t       f_reserved = 0;
 };
 
 // the code (.text) starts right after the header and we want it aligned to
@@ -192,6 +244,8 @@ enum class relocation_t
     RELOCATION_CONSTANT_32BITS,
     //RELOCATION_RT_32BITS,
     RELOCATION_LABEL_32BITS,
+    RELOCATION_LABEL_8BITS,                 // short jumps created by the peephole optimizer
+    RELOCATION_EXTERN_FUNCTION,             // %rip relative offset to a slot of the external function table
 };
 
 
@@ -255,16 +309,23 @@ typedef std::uint16_t               variable_flags_t;
 
 constexpr variable_flags_t const    VARIABLE_FLAG_DEFAULT   = 0x0000;
 constexpr variable_flags_t const    VARIABLE_FLAG_ALLOCATED = 0x0001; // while running, we may allocate a string
+constexpr variable_flags_t const    VARIABLE_FLAG_RELATIVE  = 0x0002; // f_data is an offset relative to the variable itself
+constexpr variable_flags_t const    VARIABLE_FLAG_ARENA     = 0x0004; // f_data was allocated in the arena of the execution context
+constexpr variable_flags_t const    VARIABLE_FLAG_OWNED     = 0x0008; // the items of an array of variables belong to the array
 
 
 struct binary_variable
 {
     typedef std::vector<binary_variable>    vector_t;
-    typedef std::vector<binary_variable *>  vector_of_pointers_t;
+    typedef std::pmr::vector<binary_variable *>
+                                            vector_of_pointers_t;
+    typedef std::pmr::vector<std::int64_t>  vector_of_integers_t;
+    typedef std::pmr::vector<double>        vector_of_floating_points_t;
+    typedef std::pmr::vector<std::uint8_t>  vector_of_booleans_t;
 
     variable_type_t     f_type = VARIABLE_TYPE_UNKNOWN;
     variable_flags_t    f_flags = VARIABLE_FLAG_DEFAULT;
-    std::uint16_t       f_pad = 0;
+    array_element_t     f_element_type = ARRAY_ELEMENT_VARIABLE;  // if f_type == VARIABLE_TYPE_ARRAY
     std::uint16_t       f_name_size = 0;
     offset_t            f_name = 0;
     std::uint32_t       f_data_size = 0;
@@ -291,12 +352,17 @@ public:
     std::size_t         get_size() const;
     ssize_t             get_offset() const;
     void                adjust_offset(ssize_t const offset);
+    void                set_register(register_t reg);
+    bool                has_register() const;
+    register_t          get_register() const;
 
 private:
     std::string         f_name = std::string();
     node_t              f_type = node_t::NODE_UNKNOWN;
     std::size_t         f_size = 0ULL;
     ssize_t             f_offset = 0ULL;
+    register_t          f_register = register_t::REGISTER_RAX;
+    bool                f_has_register = false;
 };
 
 
@@ -317,6 +383,9 @@ public:
     offset_t            get_position() const;
     offset_t            get_offset() const;
     void                adjust_offset(int offset);
+    void                set_relocation(relocation_t type);
+    void                set_position(offset_t position);
+    void                set_offset(offset_t offset);
 
 private:
     std::string         f_name = std::string();
@@ -342,6 +411,7 @@ public:
     void                        add_private_variable(std::string const & name, data::pointer_t type);
     void                        add_constant(double const value, std::string & name);
     void                        add_constant(std::string const value, std::string & name);
+    void                        add_extern_function(external_function_t func, std::string & name);
     void                        add_label(std::string const & name);
     //void                        add_rt_function(
     //                                      std::string const & path
@@ -371,9 +441,18 @@ public:
     void                        adjust_relocation_offset(int offset);
 
     void                        save(base_stream::pointer_t out);
+    std::size_t                 finalize();
+    void                        save(std::uint8_t * image) const;
 
 private:
+    typedef std::vector<std::pair<offset_t, offset_t>>
+                                text_ranges_t;      // position & size
+
     binary_variable *           new_binary_variable(std::string const & name, variable_type_t type, std::size_t size);
+    void                        peephole();
+    void                        remove_redundant_instructions();
+    bool                        shorten_jumps();
+    void                        remove_text(text_ranges_t const & ranges);
 
     binary_header               f_header = binary_header();
     relocation::vector_t        f_relocations = relocation::vector_t();
@@ -386,11 +465,14 @@ private:
     ssize_t                     f_temporary_8bytes_offset = 0;
     std::vector<char>           f_strings = std::vector<char>();
     text_t                      f_text = text_t();
+    std::vector<offset_t>       f_instructions = std::vector<offset_t>(); // offset of each add_text() block
     offset_map_t                f_private_offsets = offset_map_t(); // private data is separated by size for alignment (packing) reason
     offset_map_t                f_private_variable_offsets = offset_map_t(); // private data is separated by size for alignment (packing) reason
     text_t                      f_bool_private = text_t();          // bool
     text_t                      f_number_private = text_t();        // int64_t/double
     text_t                      f_string_private = text_t();        // binary_variable
+    offset_map_t                f_extern_function_offsets = offset_map_t();
+    std::vector<std::uint64_t>  f_extern_functions = std::vector<std::uint64_t>(); // external_function_t of each slot
     archive                     f_archive = archive();
     //offset_map_t                f_rt_function_offsets = offset_map_t();
     //text_t                      f_rt_functions = text_t();
@@ -399,6 +481,7 @@ private:
     offset_t                    f_text_offset = 0;
     offset_t                    f_data_offset = 0;
     offset_t                    f_variable_private_offset = 0;
+    offset_t                    f_extern_functions_offset = 0;
     offset_t                    f_number_private_offset = 0;
     offset_t                    f_string_private_offset = 0;
     offset_t                    f_bool_private_offset = 0;
@@ -424,12 +507,187 @@ public:
     double                      get_floating_point() const;
 
     void                        set_string(std::string const & value);
+    void                        set_string_view(std::string_view value);
     std::string                 get_string() const;
+    std::string_view            get_string_view() const;
 
 private:
     variable_type_t             f_type = VARIABLE_TYPE_UNKNOWN;
     std::uint64_t               f_value[2] = {};        // for dates we'll want 2 int64 once we have that (I think)
     std::string                 f_string = std::string();
+    std::string_view            f_string_view = std::string_view();   // set_string_view() value, not owned
+};
+
+
+
+class variable_handle
+{
+public:
+                                variable_handle(int index = -1);
+
+    bool                        is_valid() const;
+    int                         get_index() const;
+
+private:
+    int                         f_index = -1;
+};
+
+
+
+class batch_column
+{
+public:
+    typedef std::vector<batch_column>   vector_t;
+
+                                batch_column(variable_handle const & handle, bool const * values);
+                                batch_column(variable_handle const & handle, std::int64_t const * values);
+                                batch_column(variable_handle const & handle, double const * values);
+                                batch_column(variable_handle const & handle, std::string const * values);
+
+    variable_handle const &     get_handle() const;
+    variable_type_t             get_type() const;
+    void                        apply(binary_variable * v, std::size_t row) const;
+
+private:
+    variable_handle             f_handle = variable_handle();
+    variable_type_t             f_type = VARIABLE_TYPE_UNKNOWN;
+    void const *                f_values = nullptr;
+};
+
+
+
+class execution_arena
+    : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t    DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+                                execution_arena(std::size_t block_size = DEFAULT_BLOCK_SIZE);
+                                execution_arena(execution_arena const &) = delete;
+    virtual                     ~execution_arena() override;
+    execution_arena &           operator = (execution_arena const &) = delete;
+
+    void                        reset();
+    std::size_t                 get_used() const;
+    std::size_t                 get_capacity() const;
+
+private:
+    struct block
+    {
+        std::uint8_t *          f_buffer = nullptr;
+        std::size_t             f_size = 0;
+    };
+    typedef std::vector<block>  block_vector_t;
+
+    virtual void *              do_allocate(std::size_t bytes, std::size_t alignment) override;
+    virtual void                do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override;
+    virtual bool                do_is_equal(std::pmr::memory_resource const & other) const noexcept override;
+
+    std::size_t                 f_block_size = DEFAULT_BLOCK_SIZE;
+    block_vector_t              f_blocks = block_vector_t();
+    std::size_t                 f_current = 0;          // index of the block being used
+    std::uint8_t *              f_pos = nullptr;        // next available byte in f_blocks[f_current]
+    std::uint8_t *              f_end = nullptr;        // end of f_blocks[f_current]
+    std::size_t                 f_used = 0;             // bytes used in the blocks before f_current
+};
+
+
+
+class random_generator
+{
+public:
+                                random_generator();
+                                random_generator(std::uint64_t seed);
+
+    void                        seed(std::uint64_t seed);
+    std::uint64_t               next();
+    double                      next_double();
+
+private:
+    std::uint64_t               f_state[4] = {};
+};
+
+
+
+class running_file;
+
+
+class execution_context
+{
+public:
+    typedef std::shared_ptr<execution_context>  pointer_t;
+
+                                execution_context(running_file const * file);
+                                execution_context(execution_context const &) = delete;
+                                ~execution_context();
+    execution_context &         operator = (execution_context const &) = delete;
+
+    void                        reset();
+    running_file const *        get_running_file() const;
+    binary_variable *           get_variables();
+    execution_arena &           get_arena();
+    void                        release_arena();
+    random_generator &          get_random_generator();
+    void                        set_random_seed(std::uint64_t seed);
+
+    // prepare variables
+    //
+    variable_handle             get_handle(std::string_view const & name) const;
+    void                        set(variable_handle const & handle, bool value);
+    void                        get(variable_handle const & handle, bool & value) const;
+    void                        set(variable_handle const & handle, std::int64_t value);
+    void                        get(variable_handle const & handle, std::int64_t & value) const;
+    void                        set(variable_handle const & handle, double value);
+    void                        get(variable_handle const & handle, double & value) const;
+    void                        set(variable_handle const & handle, std::string_view const & value);
+    void                        get(variable_handle const & handle, std::string & value) const;
+    void                        get(variable_handle const & handle, std::string_view & value) const;
+
+    binary_variable *           find_variable(std::string const & name) const;
+    bool                        has_variable(std::string const & name) const;
+    void                        set_variable(std::string const & name, bool value);
+    void                        get_variable(std::string const & name, bool & value) const;
+    void                        set_variable(std::string const & name, std::int64_t value);
+    void                        get_variable(std::string const & name, std::int64_t & value) const;
+    void                        set_variable(std::string const & name, double value);
+    void                        get_variable(std::string const & name, double & value) const;
+    void                        set_variable(std::string const & name, std::string const & value);
+    void                        get_variable(std::string const & name, std::string & value) const;
+    void                        get_variable(std::string const & name, std::string_view & value) const;
+    std::size_t                 variable_size() const;
+    binary_variable *           get_variable(int index, std::string & name) const;
+
+private:
+    void                        free_variables();
+    binary_variable *           get_handle_variable(
+                                      variable_handle const & handle
+                                    , variable_type_t type
+                                    , char const * verb
+                                    , char const * what) const;
+    [[noreturn]] void           invalid_size(variable_handle const & handle, binary_variable const * v) const;
+
+    running_file const *        f_running_file = nullptr;
+    mutable binary_variable::vector_t
+                                f_variables = binary_variable::vector_t();
+    execution_arena             f_arena = execution_arena();
+    random_generator            f_random_generator = random_generator();
+};
+
+
+// the runtime functions of the current thread use the arena and the
+// random generator of this context until the scope gets destroyed
+//
+class context_scope
+{
+public:
+                                context_scope(execution_context & context);
+                                context_scope(context_scope const &) = delete;
+                                ~context_scope();
+    context_scope &             operator = (context_scope const &) = delete;
+
+private:
+    execution_arena *           f_previous_arena = nullptr;
+    random_generator *          f_previous_generator = nullptr;
 };
 
 
@@ -450,6 +708,8 @@ public:
     void                        clean();
     bool                        load(std::string const & filename);
     bool                        load(base_stream::pointer_t in);
+    bool                        load(build_file & file);
+    bool                        map(std::string const & filename);
     void                        save(std::string const & filename);
     versiontheca::versiontheca::pointer_t
                                 get_version() const;
@@ -457,6 +717,17 @@ public:
 
     // prepare variables
     //
+    variable_handle             get_handle(std::string_view const & name) const;
+    void                        set(variable_handle const & handle, bool value);
+    void                        get(variable_handle const & handle, bool & value) const;
+    void                        set(variable_handle const & handle, std::int64_t value);
+    void                        get(variable_handle const & handle, std::int64_t & value) const;
+    void                        set(variable_handle const & handle, double value);
+    void                        get(variable_handle const & handle, double & value) const;
+    void                        set(variable_handle const & handle, std::string_view const & value);
+    void                        get(variable_handle const & handle, std::string & value) const;
+    void                        get(variable_handle const & handle, std::string_view & value) const;
+
     bool                        has_variable(std::string const & name) const;
     void                        set_variable(std::string const & name, bool value);
     void                        get_variable(std::string const & name, bool & value) const;
@@ -466,20 +737,70 @@ public:
     void                        get_variable(std::string const & name, double & value) const;
     void                        set_variable(std::string const & name, std::string const & value);
     void                        get_variable(std::string const & name, std::string & value) const;
+    void                        get_variable(std::string const & name, std::string_view & value) const;
     std::size_t                 variable_size() const;
     binary_variable *           get_variable(int index, std::string & name) const;
 
+    // image information used by the execution contexts
+    //
+    int                         find_variable_index(std::string_view const & name) const;
+    std::string                 get_variable_name(int index) const;
+    binary_variable const *     get_default_variables() const;
+    std::uint8_t const *        get_image() const;
+    std::size_t                 get_image_size() const;
+    std::size_t                 get_memory_size() const;
+
     // run the code
     //
+    void                        set_random_seed(std::uint64_t seed);
+    execution_context::pointer_t
+                                create_context() const;
     void                        run(binary_result & result);
+    void                        run(execution_context & context, binary_result & result) const;
+    void                        run_batch(
+                                      execution_context & context
+                                    , batch_column::vector_t const & columns
+                                    , std::size_t rows
+                                    , bool * results) const;
+    void                        run_batch(
+                                      execution_context & context
+                                    , batch_column::vector_t const & columns
+                                    , std::size_t rows
+                                    , std::int64_t * results) const;
+    void                        run_batch(
+                                      execution_context & context
+                                    , batch_column::vector_t const & columns
+                                    , std::size_t rows
+                                    , double * results) const;
+    void                        run_batch(
+                                      execution_context & context
+                                    , batch_column::vector_t const & columns
+                                    , std::size_t rows
+                                    , std::string * results) const;
 
 private:
+    execution_context &         get_default_context() const;
+    std::string_view            get_name_view(binary_variable const & v) const;
+    void                        call_entry(execution_context & context) const;
+    template<typename T>
+    void                        run_batch_rows(
+                                      execution_context & context
+                                    , batch_column::vector_t const & columns
+                                    , std::size_t rows
+                                    , T * results
+                                    , variable_type_t type) const;
+    static bool                 check_header(binary_header const & header, position const & pos);
+    bool                        setup_image(position const & pos, int data_protection);
+    bool                        link_extern_functions(position const & pos);
+
     std::size_t                 f_size = 0;             // size of the file "aligned" to PAGESIZE
     std::uint8_t *              f_file = nullptr;       // this is the entire file
     binary_header *             f_header = nullptr;     // pointer at the start of f_text
     binary_variable *           f_variables = nullptr;  // pointer to variables within f_text
     std::uint8_t *              f_text = nullptr;       // start of code
-    bool                        f_protected = false;    // whether mprotect() was called
+    bool                        f_mapped = false;       // whether f_file was mmap()'ed
+    execution_context::pointer_t
+                                f_context = execution_context::pointer_t(); // default context used by set_variable()/get_variable()/run()
 };
 
 
@@ -498,8 +819,10 @@ public:
     options::pointer_t          get_options();
 
     int                         output(node::pointer_t root);
+    int                         output(node::pointer_t root, running_file & file);
 
 private:
+    bool                        generate(node::pointer_t root);
     variable_type_t             get_type_of_node(node::pointer_t n);
 
     void                        generate_align8();
@@ -514,8 +837,17 @@ private:
     void                        generate_store_string(data::pointer_t d, register_t const reg);
     void                        generate_external_function_call(external_function_t func);
     void                        generate_save_reg_in_binary_variable(temporary_variable * temp_var, register_t reg, variable_type_t const binary_variable_type);
+    void                        generate_spill(temporary_variable const * temp_var, register_t reg, bool load = false);
 
+    bool                        is_register_operation(operation::pointer_t op);
+    bool                        is_register_candidate(data::pointer_t d);
+    void                        allocate_registers(operation::list_t const & operations);
     void                        generate_amd64_code(flatten_nodes::pointer_t fn);
+    void                        generate_frame_size(offset_t temp_size, bool reserve);
+    void                        generate_string_temporaries(data::map_t const & variables, external_function_t func);
+    void                        generate_operations(operation::list_t const & operations);
+    void                        generate_function(user_function::pointer_t f, std::vector<register_t> const & saved_registers, offset_t temp_size);
+    void                        generate_load_as_floating_point(data::pointer_t d, register_t reg);
 
     void                        generate_absolute_value(operation::pointer_t op);
     void                        generate_additive(operation::pointer_t op);
@@ -528,7 +860,15 @@ private:
     void                        generate_call(operation::pointer_t op);
     void                        generate_clz32(operation::pointer_t op);
     void                        generate_compare(operation::pointer_t op);
+    bool                        generate_compare_and_branch(operation::pointer_t compare, operation::pointer_t branch);
+    bool                        generate_compare_and_select(operation::pointer_t compare, operation::pointer_t select);
+    int                         get_compare_condition(operation::pointer_t compare);
+    void                        generate_compare_flags(operation::pointer_t compare);
+    void                        generate_conditional(operation::pointer_t op);
+    void                        generate_select_value(data::pointer_t d, register_t const reg);
+    void                        generate_select(data::pointer_t result, int condition);
     void                        generate_divide(operation::pointer_t op);
+    bool                        generate_divide_by_constant(std::int64_t value, bool is_divide);
     void                        generate_goto(operation::pointer_t op);
     void                        generate_hypot(operation::pointer_t op);
     void                        generate_identity(operation::pointer_t op);
@@ -542,22 +882,51 @@ private:
     void                        generate_math_function(operation::pointer_t op);
     void                        generate_minmax(operation::pointer_t op);
     void                        generate_multiply(operation::pointer_t op);
+    bool                        generate_multiply_by_constant(std::int64_t value);
     void                        generate_negate(operation::pointer_t op);
     void                        generate_param(operation::pointer_t op);
     void                        generate_power(operation::pointer_t op);
     void                        generate_random(operation::pointer_t op);
+    void                        generate_return(operation::pointer_t op);
     void                        generate_shift(operation::pointer_t op);
     void                        generate_sign(operation::pointer_t op);
+    void                        generate_switch(operation::pointer_t op);
+    void                        generate_user_call(operation::pointer_t op);
+
+    struct switch_range
+    {
+        typedef std::vector<switch_range>   vector_t;
+
+        std::int64_t            f_low = 0;
+        std::int64_t            f_high = 0;
+        std::string             f_label = std::string();
+    };
+
+    void                        generate_jump(std::uint8_t code, std::string const & label);
+    void                        generate_cmp_rax_immediate(std::int64_t value);
+    void                        generate_jump_table(std::vector<std::string> const & labels);
+    void                        generate_switch_tree(switch_range::vector_t const & ranges, std::size_t start, std::size_t end, std::string const & default_label);
+    void                        generate_switch_string(data::pointer_t value, data::pointer_t str, std::string const & label);
 
     base_stream::pointer_t      f_output = base_stream::pointer_t();
     options::pointer_t          f_options = options::pointer_t();
     compiler::pointer_t         f_compiler = compiler::pointer_t();
     build_file                  f_file = build_file();
-    data::pointer_t             f_extern_functions = data::pointer_t();
+    data::pointer_t             f_saved_rbx = data::pointer_t();
+    std::map<std::string, register_t>
+                                f_allocated_registers = std::map<std::string, register_t>();
+    std::vector<register_t>     f_saved_registers = std::vector<register_t>();
+    std::size_t                 f_spilled_temporaries = 0;
+    std::size_t                 f_next_label = 0;
     //std::string                 f_rt_functions_oar = std::string("/usr/lib/as2js/rt.oar");
 };
 
 
 
+running_file::pointer_t     compile_script(std::string const & source, options::pointer_t o = options::pointer_t());
+running_file::pointer_t     compile_script(node::pointer_t root, options::pointer_t o = options::pointer_t());
+
+
+
 } // namespace as2js
 // vim: ts=4 sw=4 et
@@ -570,6 +570,49 @@ node::pointer_t node::clone_basic_node() const
 }
 
 
+/** \brief Create a deep copy of a tree of nodes.
+ *
+ * This function creates a copy of this node and all of its children.
+ * The links to other nodes (type, instance, attributes) are shared
+ * with the original, so the copy is still resolved and can be used
+ * in place of the original (i.e. when inlining a function).
+ *
+ * The parent of the new node is not defined.
+ *
+ * \return A new node pointer.
+ *
+ * \sa clone_basic_node()
+ */
+node::pointer_t node::clone_tree() const
+{
+    node::pointer_t n(std::make_shared<node>(f_type));
+
+    n->f_type_node = f_type_node;
+    n->f_flags = f_flags;
+    n->f_attribute_node = f_attribute_node;
+    n->f_attributes = f_attributes;
+    n->f_switch_operator = f_switch_operator;
+    n->f_position = f_position;
+    n->f_int = f_int;
+    n->f_float = f_float;
+    n->f_str = f_str;
+    n->f_param_depth = f_param_depth;
+    n->f_param_index = f_param_index;
+    n->f_instance = f_instance;
+    n->f_goto_enter = f_goto_enter;
+    n->f_goto_exit = f_goto_exit;
+    n->f_variables = f_variables;
+    n->f_labels = f_labels;
+
+    for(auto const & child : f_children)
+    {
+        n->append_child(child->clone_tree());
+    }
+
+    return n;
+}
+
+
 /** \brief Create a new node with the given type.
  *
  * This function creates a new node that is expected to be used as a
@@ -361,6 +361,17 @@ namespace as2js
  */
 
 
+/** \var options::OPTION_NO_REGISTER_ALLOCATION
+ * \brief Whether the binary assembler keeps temporaries in registers.
+ *
+ * By default, the binary assembler assigns registers to the numeric
+ * temporaries (see binary_assembler::allocate_registers()). When this
+ * option is set, all the temporaries stay in their stack slot. This is
+ * mainly used to measure the effect of the register allocator on the
+ * size and speed of the generated code.
+ */
+
+
 /** \var options::OPTION_OCTAL
  * \brief Whether octal numbers are allowed.
  *
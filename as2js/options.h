@@ -41,6 +41,7 @@ enum class option_t
     OPTION_EXTENDED_OPERATORS,  // 1 support extended, 2 or 3 support extended and prevent '=' (use ':=' instead)
     OPTION_EXTENDED_STATEMENTS, // 1 support extended, 2 or 3 support extended and prevent if()/else/for()/while() ... without the '{' ... '}'
     OPTION_JSON,
+    OPTION_NO_REGISTER_ALLOCATION, // keep all the numeric temporaries on the stack (binary only)
     OPTION_OCTAL,
     OPTION_STRICT,
     OPTION_TRACE,
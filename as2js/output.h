@@ -25,6 +25,7 @@
 // C++
 //
 #include    <list>
+#include    <set>
 
 
 
@@ -73,6 +74,18 @@ public:
     typedef std::shared_ptr<operation>  pointer_t;
     typedef std::list<pointer_t>        list_t;
 
+    // one "case" of a NODE_SWITCH operation, f_high is the same as f_low
+    // unless the case is a range
+    //
+    struct switch_case
+    {
+        typedef std::vector<switch_case>    vector_t;
+
+        data::pointer_t     f_low = data::pointer_t();
+        data::pointer_t     f_high = data::pointer_t();
+        std::string         f_label = std::string();
+    };
+
                             operation(node_t op, node::pointer_t n);
 
     node_t                  get_operation() const;
@@ -85,10 +98,14 @@ public:
     void                    add_additional_parameter(data::pointer_t d);    // i.e. for a CALL, an additional variable for the list of parameters
     std::size_t             get_parameter_size() const;
     data::pointer_t         get_parameter(int idx) const;
+    void                    set_parameter(int idx, data::pointer_t d);
     void                    set_result(data::pointer_t d);
     data::pointer_t         get_result() const;
     void                    set_label(std::string const & l);
     std::string const &     get_label() const;
+    void                    add_case(data::pointer_t low, data::pointer_t high, std::string const & label);
+    switch_case::vector_t const &
+                            get_cases() const;
 
     std::string             to_string() const; // for display
 
@@ -100,6 +117,40 @@ private:
     data::vector_t          f_additional_parameters = data::vector_t();
     data::pointer_t         f_result = data::pointer_t();
     std::string             f_label = std::string();
+    switch_case::vector_t   f_cases = switch_case::vector_t();
+};
+
+
+class user_function
+{
+public:
+    typedef std::shared_ptr<user_function>  pointer_t;
+    typedef std::vector<pointer_t>          vector_t;
+
+                            user_function(node::pointer_t n, std::string const & label);
+
+    node::pointer_t         get_node() const;
+    std::string const &     get_label() const;
+    std::string const &     get_exit_label() const;
+
+    void                    add_parameter(data::pointer_t d);
+    data::vector_t const &  get_parameters() const;
+    void                    set_return_value(data::pointer_t d);
+    data::pointer_t         get_return_value() const;
+    operation::list_t &     get_operations();
+    operation::list_t const &
+                            get_operations() const;
+    data::map_t &           get_variables();
+    data::map_t const &     get_variables() const;
+
+private:
+    node::pointer_t         f_node = node::pointer_t();
+    std::string             f_label = std::string();
+    std::string             f_exit_label = std::string();
+    data::vector_t          f_parameters = data::vector_t();
+    data::pointer_t         f_return_value = data::pointer_t();
+    operation::list_t       f_operations = operation::list_t();
+    data::map_t             f_variables = data::map_t();
 };
 
 
@@ -120,10 +171,43 @@ public:
     data::list_t const &    get_data() const;             // floating points, strings, etc.
     void                    add_variable(data::pointer_t var);
     data::map_t const &     get_variables() const;        // user defined variables
+    user_function::vector_t const &
+                            get_functions() const;
+
+    void                    optimize();
+    void                    dump(std::ostream & out) const;
 
 private:
+    struct loop_labels
+    {
+        std::string         f_continue = std::string();
+        std::string         f_break = std::string();
+    };
+    typedef std::map<node::pointer_t, loop_labels>  loop_labels_t;
+
     void                    directive_list(node::pointer_t n);
     data::pointer_t         node_to_operation(node::pointer_t n, bool force_full_variable = false);
+    std::string             new_label();
+    void                    add_label(node::pointer_t n, std::string const & label);
+    void                    add_goto(node::pointer_t n, std::string const & label);
+    void                    add_branch(node::pointer_t n, node::pointer_t condition, std::string const & label, bool jump_when);
+    void                    var_directive(node::pointer_t n);
+    void                    if_directive(node::pointer_t n);
+    void                    while_directive(node::pointer_t n);
+    void                    do_directive(node::pointer_t n);
+    void                    for_directive(node::pointer_t n);
+    void                    switch_directive(node::pointer_t n);
+    void                    declare_variables(node::pointer_t n);
+    void                    zero_local(node::pointer_t var, data::pointer_t local);
+    void                    add_assignment(node::pointer_t n, data::pointer_t lhs, data::pointer_t rhs);
+    void                    function_directive(node::pointer_t n);
+    void                    return_directive(node::pointer_t n);
+    data::pointer_t         user_call(node::pointer_t n, node::pointer_t function_node);
+    bool                    can_inline(node::pointer_t n, node::pointer_t function_node);
+    data::pointer_t         inline_call(node::pointer_t n, node::pointer_t function_node);
+    std::string const &     function_label(node::pointer_t function_node);
+    data::pointer_t         new_temporary(node::pointer_t n, std::string const & prefix, node::pointer_t type);
+    void                    break_continue(node::pointer_t n);
 
     node::pointer_t         f_root = node::pointer_t();
     operation::list_t       f_operations = operation::list_t();
@@ -132,11 +216,20 @@ private:
     data::map_t             f_variables = data::map_t();
     std::size_t             f_next_temp_var = 0;
     std::size_t             f_next_label = 0;
+    loop_labels_t           f_loop_labels = loop_labels_t();
+    user_function::vector_t f_functions = user_function::vector_t();
+    user_function::pointer_t
+                            f_current_function = user_function::pointer_t();
+    std::map<node::pointer_t, std::string>
+                            f_function_labels = std::map<node::pointer_t, std::string>();
+    std::set<node::pointer_t>
+                            f_inlining = std::set<node::pointer_t>();
 };
 
 
 
 
+void                        inline_functions(node::pointer_t root, compiler::pointer_t c);
 flatten_nodes::pointer_t    flatten(node::pointer_t root, compiler::pointer_t c);
 
 
@@ -38,7 +38,6 @@
 // libutf8
 //
 #include    <libutf8/base.h>
-#include    <libutf8/iterator.h>
 #include    <libutf8/libutf8.h>
 
 
@@ -56,8 +55,11 @@
 
 // C
 //
+#include    <fcntl.h>
+#include    <immintrin.h>
 #include    <string.h>
 #include    <sys/mman.h>
+#include    <sys/stat.h>
 #include    <unistd.h>
 
 
@@ -103,6 +105,236 @@ namespace
 constexpr char const g_end_magic[] = { 'E', 'N', 'D', '!' };
 
 
+/** \brief Get a pointer to the characters of a long string.
+ *
+ * Strings of more than 8 bytes do not fit in the f_data field. For those,
+ * the f_data field is either a pointer (allocated strings and the
+ * variables of an execution context) or, for the private strings found
+ * in the image, an offset relative to the variable itself. The relative
+ * offset allows the image to be used as is, without patching it, which
+ * keeps the pages shared between processes when the file is mapped.
+ *
+ * \param[in] v  The string variable with f_data_size > sizeof(f_data).
+ *
+ * \return A pointer to the first character of the string.
+ */
+char const * long_string_data(binary_variable const * v)
+{
+    if((v->f_flags & VARIABLE_FLAG_RELATIVE) != 0)
+    {
+        return reinterpret_cast<char const *>(v) + v->f_data;
+    }
+    return reinterpret_cast<char const *>(v->f_data);
+}
+
+
+/** \brief Get the vector of items of an array variable.
+ *
+ * The f_data field of an array is a pointer to a vector. The type of
+ * that vector depends on the f_element_type of the array.
+ *
+ * \tparam V  The type of vector matching the f_element_type of \p v.
+ * \param[in] v  The array variable.
+ *
+ * \return A pointer to the vector of items.
+ */
+template<typename V>
+V * array_items(binary_variable const * v)
+{
+    return reinterpret_cast<V *>(v->f_data);
+}
+
+
+/** \brief Allocate the vector of items of an array.
+ *
+ * When \p arena is not null, the vector and its items are allocated in
+ * that arena. Otherwise the vector is allocated on the heap.
+ *
+ * \tparam V  The type of vector to allocate.
+ * \param[in] arena  The arena to allocate the vector from or nullptr.
+ *
+ * \return The new vector.
+ */
+template<typename V>
+V * array_new(execution_arena * arena)
+{
+    if(arena == nullptr)
+    {
+        return new V;
+    }
+    void * ptr(arena->allocate(sizeof(V), alignof(V)));
+    return new (ptr) V(arena);
+}
+
+
+/** \brief Copy the vector of items of an array to the heap.
+ *
+ * \tparam V  The type of vector matching the f_element_type of \p v.
+ * \param[in] v  The array variable.
+ *
+ * \return A copy of the vector allocated on the heap.
+ */
+template<typename V>
+V * array_heap_copy(binary_variable const * v)
+{
+    V const * items(array_items<V>(v));
+    return new V(items->begin(), items->end());
+}
+
+
+binary_variable * variable_heap_copy(binary_variable const * v);
+extern "C" void variable_heap_free(binary_variable * v);
+
+
+/** \brief Copy the vector of variables of an array to the heap.
+ *
+ * The items of an array of variables are pointers. Once the arena gets
+ * reset, the variables it holds are gone, so a shallow copy of the
+ * vector would be left with dangling pointers. Instead, each variable
+ * is copied on the heap along with its string or array data. The caller
+ * marks the array with VARIABLE_FLAG_OWNED so array_free() releases
+ * those copies.
+ *
+ * \param[in] v  The array variable.
+ *
+ * \return A deep copy of the vector allocated on the heap.
+ */
+template<>
+binary_variable::vector_of_pointers_t * array_heap_copy<binary_variable::vector_of_pointers_t>(binary_variable const * v)
+{
+    binary_variable::vector_of_pointers_t const * items(array_items<binary_variable::vector_of_pointers_t>(v));
+    std::unique_ptr<binary_variable::vector_of_pointers_t> result(std::make_unique<binary_variable::vector_of_pointers_t>());
+    result->reserve(items->size());
+    try
+    {
+        for(auto const * item : *items)
+        {
+            result->push_back(variable_heap_copy(item));
+        }
+    }
+    catch(...)
+    {
+        for(auto * item : *result)
+        {
+            variable_heap_free(item);
+        }
+        throw;
+    }
+    return result.release();
+}
+
+
+/** \brief Copy one variable to the heap.
+ *
+ * This function allocates a new variable on the heap and copies \p v
+ * in it. Long strings and arrays are duplicated so the copy does not
+ * depend on the arena, the image, or \p v in any way.
+ *
+ * The copy gets released with variable_heap_free().
+ *
+ * \param[in] v  The variable to copy.
+ *
+ * \return The new variable.
+ */
+binary_variable * variable_heap_copy(binary_variable const * v)
+{
+    std::unique_ptr<binary_variable> result(std::make_unique<binary_variable>(*v));
+    result->f_flags &= ~(VARIABLE_FLAG_ALLOCATED | VARIABLE_FLAG_RELATIVE | VARIABLE_FLAG_ARENA | VARIABLE_FLAG_OWNED);
+
+    switch(v->f_type)
+    {
+    case VARIABLE_TYPE_STRING:
+        if(v->f_data_size > sizeof(v->f_data))
+        {
+            void * str(malloc(v->f_data_size));
+            if(str == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            memcpy(str, long_string_data(v), v->f_data_size);
+            result->f_data = reinterpret_cast<std::uint64_t>(str);
+            result->f_flags |= VARIABLE_FLAG_ALLOCATED;
+        }
+        break;
+
+    case VARIABLE_TYPE_ARRAY:
+        if(v->f_data != 0)
+        {
+            switch(v->f_element_type)
+            {
+            case ARRAY_ELEMENT_VARIABLE:
+                result->f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_pointers_t>(v));
+                result->f_flags |= VARIABLE_FLAG_OWNED;
+                break;
+
+            case ARRAY_ELEMENT_INTEGER:
+                result->f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_integers_t>(v));
+                break;
+
+            case ARRAY_ELEMENT_FLOATING_POINT:
+                result->f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_floating_points_t>(v));
+                break;
+
+            case ARRAY_ELEMENT_BOOLEAN:
+                result->f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_booleans_t>(v));
+                break;
+
+            }
+            result->f_flags |= VARIABLE_FLAG_ALLOCATED;
+        }
+        break;
+
+    default:
+        break;
+
+    }
+
+    return result.release();
+}
+
+
+std::size_t array_size(binary_variable const * v)
+{
+    switch(v->f_element_type)
+    {
+    case ARRAY_ELEMENT_VARIABLE:
+        return array_items<binary_variable::vector_of_pointers_t>(v)->size();
+
+    case ARRAY_ELEMENT_INTEGER:
+        return array_items<binary_variable::vector_of_integers_t>(v)->size();
+
+    case ARRAY_ELEMENT_FLOATING_POINT:
+        return array_items<binary_variable::vector_of_floating_points_t>(v)->size();
+
+    case ARRAY_ELEMENT_BOOLEAN:
+        return array_items<binary_variable::vector_of_booleans_t>(v)->size();
+
+    }
+    snapdev::NOT_REACHED();
+}
+
+
+char const * array_element_to_string(array_element_t type)
+{
+    switch(type)
+    {
+    case ARRAY_ELEMENT_VARIABLE:
+        return "VARIABLE";
+
+    case ARRAY_ELEMENT_INTEGER:
+        return "INTEGER";
+
+    case ARRAY_ELEMENT_FLOATING_POINT:
+        return "FLOATING_POINT";
+
+    case ARRAY_ELEMENT_BOOLEAN:
+        return "BOOLEAN";
+
+    }
+    return "UNKNOWN";
+}
+
+
 void display_binary_variable(binary_variable const * v, int indent = 0)
 {
     auto show_flags = [&v]()
@@ -114,7 +346,15 @@ void display_binary_variable(binary_variable const * v, int indent = 0)
             {
                 flags.push_back("ALLOCATED");
             }
-            std::cout << " (" << snapdev::join_strings(flags, ", ") << ")";
+            if((v->f_flags & VARIABLE_FLAG_ARENA) != 0)
+            {
+                flags.push_back("ARENA");
+            }
+            if((v->f_flags & VARIABLE_FLAG_OWNED) != 0)
+            {
+                flags.push_back("OWNED");
+            }
+            std::cout << " ("<< snapdev::join_strings(flags, ", ") << ")";
         }
 
         std::cout << "\n";
@@ -173,7 +413,7 @@ void display_binary_variable(binary_variable const * v, int indent = 0)
         }
         else
         {
-            std::cout << std::string(reinterpret_cast<char const *>(v->f_data), v->f_data_size);
+            std::cout << std::string(long_string_data(v), v->f_data_size);
         }
         break;
 
@@ -182,8 +422,48 @@ void display_binary_variable(binary_variable const * v, int indent = 0)
         return;
 
     case VARIABLE_TYPE_ARRAY:
+        if(v->f_element_type != ARRAY_ELEMENT_VARIABLE)
+        {
+            // typed arrays are shown on a single line
+            //
+            std::cout
+                << left_indent
+                << "* ARRAY: "
+                << array_size(v)
+                << " items of type "
+                << array_element_to_string(v->f_element_type);
+            show_flags();
+            std::cout << left_indent << "  [";
+            for(std::size_t idx(0); idx < array_size(v); ++idx)
+            {
+                if(idx != 0)
+                {
+                    std::cout << ", ";
+                }
+                switch(v->f_element_type)
+                {
+                case ARRAY_ELEMENT_INTEGER:
+                    std::cout << (*array_items<binary_variable::vector_of_integers_t>(v))[idx];
+                    break;
+
+                case ARRAY_ELEMENT_FLOATING_POINT:
+                    std::cout << (*array_items<binary_variable::vector_of_floating_points_t>(v))[idx];
+                    break;
+
+                case ARRAY_ELEMENT_BOOLEAN:
+                    std::cout << ((*array_items<binary_variable::vector_of_booleans_t>(v))[idx] != 0 ? "true" : "false");
+                    break;
+
+                case ARRAY_ELEMENT_VARIABLE:
+                    snapdev::NOT_REACHED();
+
+                }
+            }
+            std::cout << "]\n";
+        }
+        else
         {
-            binary_variable::vector_of_pointers_t const * items(reinterpret_cast<binary_variable::vector_of_pointers_t const *>(v->f_data));
+            binary_variable::vector_of_pointers_t const * items(array_items<binary_variable::vector_of_pointers_t>(v));
             std::cout
                 << "* ARRAY: "
                 << items->size()
@@ -221,7 +501,7 @@ double math_fround(double x)
     }
     if(x < std::numeric_limits<float>::lowest())
     {
-        if(x <= -3.4028235677973362e+38)
+        if(x >= -3.4028235677973362e+38)
         {
             return static_cast<double>(std::numeric_limits<float>::lowest());
         }
@@ -259,24 +539,197 @@ double math_sign(double x)
 }
 
 
-double math_random()
+/** \brief The random number generator of the current run.
+ *
+ * Each execution context has its own generator so threads running
+ * scripts in parallel do not share any state. The pointer is set by
+ * a context_scope (i.e. in running_file::call_entry()) for the duration
+ * of a run.
+ */
+thread_local random_generator * g_random_generator = nullptr;
+
+
+random_generator & current_random_generator()
 {
-    // these two are static since we want to initialize the random number
-    // generator only once (the first time this function is called)
+    if(g_random_generator != nullptr)
+    {
+        return *g_random_generator;
+    }
+
+    // not running (i.e. called directly by a test), use a per thread
+    // generator
     //
-    // note: static variables are thread safe
+    thread_local random_generator generator;
+    return generator;
+}
+
+
+/** \brief Get 64 random bits.
+ *
+ * The code generated for Math.random() calls this function and converts
+ * the result to a double in [0.0, 1.0) inline.
+ *
+ * \return The next 64 bit number of the generator of the current run.
+ */
+std::uint64_t math_random_bits()
+{
+    return current_random_generator().next();
+}
+
+
+double math_random()
+{
+    return current_random_generator().next_double();
+}
+
+
+/** \brief The arena of the execution context currently running.
+ *
+ * While the code of a running_file executes, the runtime functions
+ * allocate their buffers from the arena of the execution context. This
+ * pointer is set by a context_scope (i.e. in running_file::call_entry())
+ * for the duration of the call. Outside of a run, it is null and the
+ * functions use malloc().
+ */
+thread_local execution_arena * g_arena = nullptr;
+
+
+/** \brief Header found in front of the strings allocated in the arena.
+ *
+ * A string allocated in the arena may have more room than necessary
+ * (its capacity) so appending to it does not require a new buffer and
+ * a copy of the existing characters.
+ *
+ * The buffer may be shared by several variables (strings_share() does
+ * not duplicate arena strings). The characters of a buffer are never
+ * modified once written so a variable sees the same string whatever
+ * happens to the rest of the buffer. The f_size field is the size of the
+ * longest string using the buffer. Only a variable of that size can
+ * append in place.
+ */
+struct arena_string_header
+{
+    std::uint32_t       f_capacity = 0;
+    std::uint32_t       f_size = 0;
+};
+
+
+arena_string_header * arena_header(binary_variable const * v)
+{
+    return reinterpret_cast<arena_string_header *>(v->f_data) - 1;
+}
+
+
+/** \brief Allocate the buffer of a long string.
+ *
+ * While running, the buffer is allocated in the arena of the execution
+ * context. It never gets freed individually. Instead, the whole arena
+ * is reset once the run is over.
+ *
+ * The caller must mark the variable with the flag returned by
+ * strings_allocated_flag().
+ *
+ * \param[in] size  The number of bytes to allocate.
+ * \param[in] capacity  The number of bytes to reserve in the arena in
+ * case the string grows later; ignored if smaller than \p size.
+ *
+ * \exception out_of_range
+ * The \p size does not fit in the 32 bit size of a string.
+ *
+ * \return A pointer to the buffer or nullptr if the allocation failed.
+ */
+void * strings_allocate(std::size_t size, std::size_t capacity = 0)
+{
+    // the size of a string is saved in 32 bits (binary_variable::f_data_size)
     //
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+    if(size > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw out_of_range(
+                  "string of "
+                + std::to_string(size)
+                + " bytes is too long, the limit is 4Gb.");
+    }
+
+    if(g_arena != nullptr)
+    {
+        capacity = std::min(
+                  std::max(size, capacity)
+                , static_cast<std::size_t>(std::numeric_limits<std::uint32_t>::max()));
+        try
+        {
+            arena_string_header * header(static_cast<arena_string_header *>(
+                    g_arena->allocate(
+                          sizeof(arena_string_header) + capacity
+                        , alignof(arena_string_header))));
+            header->f_capacity = capacity;
+            header->f_size = size;
+            return header + 1;
+        }
+        catch(std::bad_alloc const &)
+        {
+            return nullptr;
+        }
+    }
+    return malloc(size);
+}
+
+
+/** \brief Compute the capacity of a string which is being appended to.
+ *
+ * The capacity grows geometrically so a sequence of appends is linear.
+ *
+ * \param[in] size  The size of the new string.
+ *
+ * \return The capacity to reserve for that string.
+ */
+std::size_t strings_growth(std::size_t size)
+{
+    return std::max(size + size / 2, static_cast<std::size_t>(64));
+}
+
+
+/** \brief Extend a string in place.
+ *
+ * If \p s was allocated in the arena, is the longest string using its
+ * buffer, and the buffer is large enough for \p size bytes, then the
+ * buffer gets reserved up to \p size bytes and the function returns
+ * the pointer to the characters of \p s. The caller is expected to
+ * write the additional characters right after the existing ones.
+ *
+ * \param[in] s  The string to extend.
+ * \param[in] size  The size of the string once extended.
+ *
+ * \return The buffer of \p s or nullptr if it cannot be extended.
+ */
+char * strings_extend(binary_variable const * s, std::size_t size)
+{
+    if((s->f_flags & VARIABLE_FLAG_ARENA) == 0)
+    {
+        return nullptr;
+    }
+    arena_string_header * header(arena_header(s));
+    if(header->f_size != s->f_data_size
+    || header->f_capacity < size)
+    {
+        return nullptr;
+    }
+    header->f_size = size;
+    return reinterpret_cast<char *>(s->f_data);
+}
+
 
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-    return dis(gen);
+variable_flags_t strings_allocated_flag()
+{
+    return g_arena != nullptr ? VARIABLE_FLAG_ARENA : VARIABLE_FLAG_ALLOCATED;
 }
 
 
 void delete_buffer(char * ptr)
 {
-    free(ptr);
+    if(g_arena == nullptr)
+    {
+        free(ptr);
+    }
 }
 
 
@@ -320,6 +773,44 @@ void strings_free(binary_variable * v)
         v->f_data = 0; // a.k.a. "nullptr"
         v->f_data_size = 0;
     }
+    else if((v->f_flags & VARIABLE_FLAG_ARENA) != 0)
+    {
+        // the arena releases all of its buffers at once after the run
+        //
+        v->f_flags &= ~VARIABLE_FLAG_ARENA;
+        v->f_data = 0;
+        v->f_data_size = 0;
+    }
+}
+
+
+/** \brief Make \p d point to the same string as \p s.
+ *
+ * The source string must not be allocated (i.e. it is small, it is a
+ * constant which lives as long as the running_file, or it lives in the
+ * arena until the end of the run). The data of \p d must already have
+ * been released.
+ *
+ * If the source is a long string with a relative offset, the
+ * destination receives an absolute pointer since it lives elsewhere.
+ *
+ * \param[in] d  The destination string.
+ * \param[in] s  The source string.
+ */
+void strings_share(binary_variable * d, binary_variable const * s)
+{
+    d->f_type = VARIABLE_TYPE_STRING;
+    d->f_flags = (d->f_flags & ~(VARIABLE_FLAG_ALLOCATED | VARIABLE_FLAG_RELATIVE | VARIABLE_FLAG_ARENA))
+               | (s->f_flags & VARIABLE_FLAG_ARENA);
+    d->f_data_size = s->f_data_size;
+    if(s->f_data_size <= sizeof(s->f_data))
+    {
+        d->f_data = s->f_data;
+    }
+    else
+    {
+        d->f_data = reinterpret_cast<std::uint64_t>(long_string_data(s));
+    }
 }
 
 
@@ -348,9 +839,7 @@ void strings_copy(binary_variable * d, binary_variable const * s)
     {
         // not allocated, we can copy as is
         //
-        d->f_flags &= ~VARIABLE_FLAG_ALLOCATED;
-        d->f_data_size = s->f_data_size;
-        d->f_data = s->f_data;
+        strings_share(d, s);
     }
     else if(s->f_data_size <= sizeof(s->f_data))
     {
@@ -358,43 +847,116 @@ void strings_copy(binary_variable * d, binary_variable const * s)
         //       the string fits in f_data
         d->f_flags &= ~VARIABLE_FLAG_ALLOCATED;
         d->f_data_size = s->f_data_size;
-        memcpy(&d->f_data, reinterpret_cast<char const *>(s->f_data), s->f_data_size);
+        memcpy(&d->f_data, long_string_data(s), s->f_data_size);
     }
     else
     {
         // the source is allocated, we need to duplicate the buffer
         // TODO: implement references
         //
-        char * str(static_cast<char *>(malloc(s->f_data_size)));
+        char * str(static_cast<char *>(strings_allocate(s->f_data_size)));
         if(str == nullptr)
         {
             throw std::bad_alloc();
         }
-        memcpy(str, reinterpret_cast<char const *>(s->f_data), s->f_data_size);
+        memcpy(str, long_string_data(s), s->f_data_size);
 
         d->f_type = VARIABLE_TYPE_STRING;
-        d->f_flags = VARIABLE_FLAG_ALLOCATED;
+        d->f_flags = strings_allocated_flag();
         d->f_data_size = s->f_data_size;
         d->f_data = reinterpret_cast<std::uint64_t>(str);
     }
 }
 
 
-std::int64_t strings_compare(binary_variable const * s1, binary_variable const * s2, node_t op)
+/** \brief Hash a string for a switch() statement.
+ *
+ * This is a 64 bit FNV-1a hash followed by a final mix so the lower bits,
+ * which are used to index the dispatch table, depend on all the bytes.
+ * The \p seed is chosen at compile time so the hash is perfect for the
+ * set of strings used in the "case" statements.
+ *
+ * \param[in] s  The string to hash.
+ * \param[in] size  The number of bytes in \p s.
+ * \param[in] seed  The seed selected by the compiler.
+ *
+ * \return The hash of the string.
+ */
+std::uint64_t hash_switch_string(char const * s, std::size_t size, std::uint64_t seed)
 {
-    //case node_t::NODE_SMART_MATCH: -- TBD how do we handle this one? if I'm correct this means rhs is of type regexp which we do not yet support here
-
-#ifdef _DEBUG
-    if(s1->f_type != VARIABLE_TYPE_STRING)
+    std::uint64_t h(0xCBF29CE484222325ULL ^ seed);
+    for(std::size_t idx(0); idx < size; ++idx)
     {
-        throw incompatible_type("s1 is expected to be a string in strings_compare()");
+        h ^= static_cast<std::uint8_t>(s[idx]);
+        h *= 0x100000001B3ULL;
     }
-    if(s2->f_type != VARIABLE_TYPE_STRING)
-    {
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+
+std::uint64_t strings_hash(binary_variable const * s, std::uint64_t seed)
+{
+#ifdef _DEBUG
+    if(s->f_type != VARIABLE_TYPE_STRING)
+    {
+        throw incompatible_type("s is expected to be a string in strings_hash()");
+    }
+#endif
+
+    if(s->f_data_size <= sizeof(s->f_data))
+    {
+        return hash_switch_string(reinterpret_cast<char const *>(&s->f_data), s->f_data_size, seed);
+    }
+    return hash_switch_string(long_string_data(s), s->f_data_size, seed);
+}
+
+
+std::int64_t strings_compare(binary_variable const * s1, binary_variable const * s2, node_t op)
+{
+    //case node_t::NODE_SMART_MATCH: -- TBD how do we handle this one? if I'm correct this means rhs is of type regexp which we do not yet support here
+
+#ifdef _DEBUG
+    if(s1->f_type != VARIABLE_TYPE_STRING)
+    {
+        throw incompatible_type("s1 is expected to be a string in strings_compare()");
+    }
+    if(s2->f_type != VARIABLE_TYPE_STRING)
+    {
         throw incompatible_type("s2 is expected to be a string in strings_compare()");
     }
 #endif
 
+    switch(op)
+    {
+    case node_t::NODE_EQUAL:
+    case node_t::NODE_STRICTLY_EQUAL:
+    case node_t::NODE_NOT_EQUAL:
+    case node_t::NODE_STRICTLY_NOT_EQUAL:
+        {
+            // equality does not depend on the UTF-16 order so we can
+            // directly compare the UTF-8 bytes
+            //
+            bool const not_equal(op == node_t::NODE_NOT_EQUAL
+                              || op == node_t::NODE_STRICTLY_NOT_EQUAL);
+            if(s1->f_data_size != s2->f_data_size)
+            {
+                return not_equal;
+            }
+            if(s1->f_data_size <= sizeof(s1->f_data))
+            {
+                return (memcmp(&s1->f_data, &s2->f_data, s1->f_data_size) == 0) != not_equal;
+            }
+            return (memcmp(long_string_data(s1), long_string_data(s2), s1->f_data_size) == 0) != not_equal;
+        }
+
+    default:
+        break;
+
+    }
+
     if(op == node_t::NODE_ALMOST_EQUAL)
     {
         throw not_implemented("string almost equal require a libutf-8 uppercase transformation which we don't have yet, use == instead");
@@ -413,7 +975,7 @@ std::int64_t strings_compare(binary_variable const * s1, binary_variable const *
         }
         else
         {
-            lhs = libutf8::to_u16string(std::string(reinterpret_cast<char const *>(s1->f_data), s1->f_data_size));
+            lhs = libutf8::to_u16string(std::string(long_string_data(s1), s1->f_data_size));
         }
 
         std::u16string rhs;
@@ -423,7 +985,7 @@ std::int64_t strings_compare(binary_variable const * s1, binary_variable const *
         }
         else
         {
-            rhs = libutf8::to_u16string(std::string(reinterpret_cast<char const *>(s2->f_data), s2->f_data_size));
+            rhs = libutf8::to_u16string(std::string(long_string_data(s2), s2->f_data_size));
         }
 
         std::int32_t r(memcmp(lhs.c_str(), rhs.c_str(), std::min(lhs.length(), rhs.length())));
@@ -505,19 +1067,28 @@ void strings_concat(binary_variable * d, binary_variable const * s1, binary_vari
         return;
     }
 
+    // when d is the string being shared, there is nothing to do; freeing
+    // it first would lose its data (arena strings get cleared)
+    //
     if((s1->f_flags & VARIABLE_FLAG_ALLOCATED) == 0
     && s2->f_data_size == 0)
     {
-        strings_free(d);
-        *d = *s1;
+        if(d != s1)
+        {
+            strings_free(d);
+            strings_share(d, s1);
+        }
         return;
     }
 
     if((s2->f_flags & VARIABLE_FLAG_ALLOCATED) == 0
     && s1->f_data_size == 0)
     {
-        strings_free(d);
-        *d = *s2;
+        if(d != s2)
+        {
+            strings_free(d);
+            strings_share(d, s2);
+        }
         return;
     }
 
@@ -533,7 +1104,33 @@ void strings_concat(binary_variable * d, binary_variable const * s1, binary_vari
         return;
     }
 
-    char * str(static_cast<char *>(malloc(concat_size)));
+    // in a sequence of appends (`s += x` or `s = s + x`), s1 is the
+    // result of the previous concatenation and we can write s2 right
+    // after it
+    //
+    char * str(strings_extend(s1, concat_size));
+    if(str != nullptr)
+    {
+        if(s2->f_data_size <= sizeof(s2->f_data))
+        {
+            memcpy(str + s1->f_data_size, &s2->f_data, s2->f_data_size);
+        }
+        else
+        {
+            memcpy(str + s1->f_data_size, long_string_data(s2), s2->f_data_size);
+        }
+        if(d != s1)
+        {
+            strings_free(d);
+        }
+        d->f_data = reinterpret_cast<std::uint64_t>(str);
+        d->f_data_size = concat_size;
+        d->f_type = VARIABLE_TYPE_STRING;
+        d->f_flags = VARIABLE_FLAG_ARENA;
+        return;
+    }
+
+    str = static_cast<char *>(strings_allocate(concat_size, strings_growth(concat_size)));
     if(str == nullptr)
     {
         throw std::bad_alloc();
@@ -544,7 +1141,7 @@ void strings_concat(binary_variable * d, binary_variable const * s1, binary_vari
     }
     else
     {
-        memcpy(str, reinterpret_cast<char const *>(s1->f_data), s1->f_data_size);
+        memcpy(str, long_string_data(s1), s1->f_data_size);
     }
     if(s2->f_data_size <= sizeof(s2->f_data))
     {
@@ -552,7 +1149,7 @@ void strings_concat(binary_variable * d, binary_variable const * s1, binary_vari
     }
     else
     {
-        memcpy(str + s1->f_data_size, reinterpret_cast<char const *>(s2->f_data), s2->f_data_size);
+        memcpy(str + s1->f_data_size, long_string_data(s2), s2->f_data_size);
     }
     if(d == s1)
     {
@@ -565,7 +1162,7 @@ void strings_concat(binary_variable * d, binary_variable const * s1, binary_vari
     d->f_data = reinterpret_cast<std::uint64_t>(str);
     d->f_data_size = concat_size;
     d->f_type = VARIABLE_TYPE_STRING;
-    d->f_flags = VARIABLE_FLAG_ALLOCATED;
+    d->f_flags = strings_allocated_flag();
 }
 
 
@@ -603,12 +1200,38 @@ void strings_concat_params(binary_variable * d, binary_variable const * s, binar
         size += p->f_data_size;
     }
 
+    // if `s` can be extended, append the parameters in place
+    //
+    char * ptr(strings_extend(s, size));
+    if(ptr != nullptr)
+    {
+        char * dst(ptr + s->f_data_size);
+        for(std::size_t idx(0); idx < max; ++idx)
+        {
+            binary_variable * p(v[0][idx]);
+            if(p->f_data_size <= sizeof(p->f_data))
+            {
+                memcpy(dst, &p->f_data, p->f_data_size);
+            }
+            else
+            {
+                memcpy(dst, long_string_data(p), p->f_data_size);
+            }
+            dst += p->f_data_size;
+        }
+        strings_free(d);
+        d->f_data = reinterpret_cast<std::uint64_t>(ptr);
+        d->f_data_size = size;
+        d->f_flags |= VARIABLE_FLAG_ARENA;
+        return;
+    }
+
     // `d` could be one of the sources, so we cannot free that pointer;
     // instead allocate a new "floating" pointer here and handle the
     // save later
     //
     snapdev::safe_object<char *, delete_buffer> safe_buffer;
-    char * ptr(static_cast<char *>(malloc(size)));
+    ptr = static_cast<char *>(strings_allocate(size, strings_growth(size)));
     if(ptr == nullptr)
     {
         throw std::bad_alloc();
@@ -625,7 +1248,7 @@ void strings_concat_params(binary_variable * d, binary_variable const * s, binar
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
     memcpy(dst, src, s->f_data_size);
     dst += s->f_data_size;
@@ -638,7 +1261,7 @@ void strings_concat_params(binary_variable * d, binary_variable const * s, binar
         }
         else
         {
-            src = reinterpret_cast<char const *>(p->f_data);
+            src = long_string_data(p);
         }
         memcpy(dst, src, p->f_data_size);
         dst += p->f_data_size;
@@ -657,7 +1280,7 @@ void strings_concat_params(binary_variable * d, binary_variable const * s, binar
         safe_buffer.release();
 
         d->f_data = reinterpret_cast<std::int64_t>(ptr);
-        d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+        d->f_flags |= strings_allocated_flag();
     }
     d->f_data_size = size;
 }
@@ -695,7 +1318,7 @@ void strings_unconcat(binary_variable * d, binary_variable const * s1, binary_va
     }
     else
     {
-        p1 = reinterpret_cast<char const *>(s1->f_data);
+        p1 = long_string_data(s1);
     }
     char const * p2;
     if(s2->f_data_size <= sizeof(s2->f_data))
@@ -704,7 +1327,7 @@ void strings_unconcat(binary_variable * d, binary_variable const * s1, binary_va
     }
     else
     {
-        p2 = reinterpret_cast<char const *>(s2->f_data);
+        p2 = long_string_data(s2);
     }
     std::size_t unconcat_size(s1->f_data_size);
     if(s1->f_data_size >= s2->f_data_size)
@@ -731,13 +1354,13 @@ void strings_unconcat(binary_variable * d, binary_variable const * s1, binary_va
         return;
     }
 
-    char * str(static_cast<char *>(malloc(unconcat_size)));
+    char * str(static_cast<char *>(strings_allocate(unconcat_size)));
     if(str == nullptr)
     {
         throw std::bad_alloc();
     }
     memcpy(str, p1, unconcat_size);
-    d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+    d->f_flags |= strings_allocated_flag();
     d->f_data_size = unconcat_size;
     d->f_data = reinterpret_cast<std::uint64_t>(str);
 }
@@ -776,7 +1399,7 @@ void strings_shift(binary_variable * d, binary_variable const * s, int64_t count
     }
     else
     {
-        str = reinterpret_cast<char const *>(s->f_data);
+        str = long_string_data(s);
     }
 
     if(count < 0)
@@ -865,13 +1488,13 @@ void strings_shift(binary_variable * d, binary_variable const * s, int64_t count
             }
             else
             {
-                d->f_data = reinterpret_cast<std::int64_t>(malloc(d->f_data_size));
+                d->f_data = reinterpret_cast<std::int64_t>(strings_allocate(d->f_data_size));
                 if(d->f_data == 0)
                 {
                     d->f_data_size = 0;
                     throw std::bad_alloc();
                 }
-                d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+                d->f_flags |= strings_allocated_flag();
                 dst = reinterpret_cast<char *>(d->f_data);
             }
             std::size_t const rotate_length(d->f_data_size - count);
@@ -889,13 +1512,13 @@ void strings_shift(binary_variable * d, binary_variable const * s, int64_t count
         }
         else
         {
-            d->f_data = reinterpret_cast<std::int64_t>(malloc(d->f_data_size));
+            d->f_data = reinterpret_cast<std::int64_t>(strings_allocate(d->f_data_size));
             if(d->f_data == 0)
             {
                 d->f_data_size = 0;
                 throw std::bad_alloc();
             }
-            d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+            d->f_flags |= strings_allocated_flag();
             dst = reinterpret_cast<char *>(d->f_data);
         }
         memcpy(dst, str, s->f_data_size);
@@ -917,13 +1540,13 @@ void strings_shift(binary_variable * d, binary_variable const * s, int64_t count
             }
             else
             {
-                d->f_data = reinterpret_cast<std::int64_t>(malloc(d->f_data_size));
+                d->f_data = reinterpret_cast<std::int64_t>(strings_allocate(d->f_data_size));
                 if(d->f_data == 0)
                 {
                     d->f_data_size = 0;
                     throw std::bad_alloc();
                 }
-                d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+                d->f_flags |= strings_allocated_flag();
                 dst = reinterpret_cast<char *>(d->f_data);
             }
             memcpy(dst, str, d->f_data_size);
@@ -937,6 +1560,229 @@ void strings_shift(binary_variable * d, binary_variable const * s, int64_t count
 }
 
 
+enum class case_conversion_t
+{
+    CASE_CONVERSION_LOWER,
+    CASE_CONVERSION_UPPER,
+    CASE_CONVERSION_FLIP,
+};
+
+
+bool cpu_has_avx2()
+{
+    // the CPU model may not yet be initialized when the globals get
+    // initialized
+    //
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+
+bool const g_has_avx2(cpu_has_avx2());
+
+
+cpu_features_t cpu_features()
+{
+    __builtin_cpu_init();
+
+    cpu_features_t features(0);
+    if(__builtin_cpu_supports("sse4.1"))
+    {
+        features |= CPU_FEATURE_SSE4_1;
+    }
+    return features;
+}
+
+
+// the compiled code reads these flags from the external function table
+// to select between inline instructions and a function call
+//
+cpu_features_t const g_cpu_features(cpu_features());
+
+
+// AVX2 version of ascii_span(), only called if the CPU supports it
+//
+__attribute__((target("avx2")))
+std::size_t ascii_span_avx2(char const * s, std::size_t size)
+{
+    std::size_t pos(0);
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i const v(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(s + pos)));
+        std::uint32_t const mask(_mm256_movemask_epi8(v));
+        if(mask != 0)
+        {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    for(; pos < size; ++pos)
+    {
+        if(static_cast<std::uint8_t>(s[pos]) >= 0x80)
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+
+/** \brief Count the number of ASCII bytes at the start of a buffer.
+ *
+ * The amd64 processors all support SSE2 so the buffer is checked 16
+ * bytes at a time (32 with AVX2).
+ *
+ * \param[in] s  The buffer to check.
+ * \param[in] size  The size of the buffer.
+ *
+ * \return The position of the first non-ASCII byte or \p size.
+ */
+std::size_t ascii_span(char const * s, std::size_t size)
+{
+    if(g_has_avx2)
+    {
+        return ascii_span_avx2(s, size);
+    }
+
+    std::size_t pos(0);
+    for(; pos + 16 <= size; pos += 16)
+    {
+        __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s + pos)));
+        std::uint32_t const mask(_mm_movemask_epi8(v));
+        if(mask != 0)
+        {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    for(; pos < size; ++pos)
+    {
+        if(static_cast<std::uint8_t>(s[pos]) >= 0x80)
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+
+// AVX2 loop of ascii_convert_case(), returns the number of bytes
+// converted (a multiple of 32)
+//
+__attribute__((target("avx2")))
+std::size_t ascii_convert_case_avx2(char * dst, char const * src, std::size_t size, case_conversion_t conversion)
+{
+    // bytes 0x80 and over are negative and never match the range
+    //
+    char const first(conversion == case_conversion_t::CASE_CONVERSION_LOWER ? 'A' : 'a');
+    __m256i const below(_mm256_set1_epi8(first - 1));
+    __m256i const above(_mm256_set1_epi8(first + 26));
+    __m256i const bit5(_mm256_set1_epi8(0x20));
+    __m256i const fold(conversion == case_conversion_t::CASE_CONVERSION_FLIP ? bit5 : _mm256_setzero_si256());
+
+    std::size_t pos(0);
+    for(; pos + 32 <= size; pos += 32)
+    {
+        __m256i const v(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + pos)));
+        __m256i const c(_mm256_or_si256(v, fold));
+        __m256i const letters(_mm256_and_si256(
+                  _mm256_cmpgt_epi8(c, below)
+                , _mm256_cmpgt_epi8(above, c)));
+        _mm256_storeu_si256(
+                  reinterpret_cast<__m256i *>(dst + pos)
+                , _mm256_xor_si256(v, _mm256_and_si256(letters, bit5)));
+    }
+    return pos;
+}
+
+
+/** \brief Convert the case of ASCII letters.
+ *
+ * This function converts the ASCII letters found in \p src and saves
+ * the result in \p dst. All the other bytes are copied as is (including
+ * bytes 0x80 and over). The \p dst and \p src buffers can be the same.
+ *
+ * The letters are found with two comparisons on 16 bytes at a time
+ * (32 with AVX2) and their case is changed by flipping bit 5.
+ *
+ * \param[out] dst  The destination buffer.
+ * \param[in] src  The source buffer.
+ * \param[in] size  The number of bytes to convert.
+ * \param[in] conversion  The type of conversion to apply.
+ */
+void ascii_convert_case(char * dst, char const * src, std::size_t size, case_conversion_t conversion)
+{
+    std::size_t pos(0);
+    if(g_has_avx2)
+    {
+        pos = ascii_convert_case_avx2(dst, src, size, conversion);
+    }
+    else
+    {
+        char const first(conversion == case_conversion_t::CASE_CONVERSION_LOWER ? 'A' : 'a');
+        __m128i const below(_mm_set1_epi8(first - 1));
+        __m128i const above(_mm_set1_epi8(first + 26));
+        __m128i const bit5(_mm_set1_epi8(0x20));
+        __m128i const fold(conversion == case_conversion_t::CASE_CONVERSION_FLIP ? bit5 : _mm_setzero_si128());
+
+        for(; pos + 16 <= size; pos += 16)
+        {
+            __m128i const v(_mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos)));
+            __m128i const c(_mm_or_si128(v, fold));
+            __m128i const letters(_mm_and_si128(
+                      _mm_cmpgt_epi8(c, below)
+                    , _mm_cmplt_epi8(c, above)));
+            _mm_storeu_si128(
+                      reinterpret_cast<__m128i *>(dst + pos)
+                    , _mm_xor_si128(v, _mm_and_si128(letters, bit5)));
+        }
+    }
+
+    char const first(conversion == case_conversion_t::CASE_CONVERSION_LOWER ? 'A' : 'a');
+    for(; pos < size; ++pos)
+    {
+        char const c(src[pos]);
+        char const folded(conversion == case_conversion_t::CASE_CONVERSION_FLIP ? c | 0x20 : c);
+        if(folded >= first && folded < first + 26)
+        {
+            dst[pos] = c ^ 0x20;
+        }
+        else
+        {
+            dst[pos] = c;
+        }
+    }
+}
+
+
+/** \brief Save a buffer in a string variable.
+ *
+ * The \p buffer must have been allocated with strings_allocate() when
+ * \p size is larger than f_data. Otherwise, it is copied in f_data.
+ *
+ * The destination is released only now so \p d can be one of the
+ * sources used to compute \p buffer.
+ *
+ * \param[in,out] d  The destination string.
+ * \param[in] buffer  The buffer with the new string.
+ * \param[in] size  The size of the new string.
+ */
+void strings_attach(binary_variable * d, char * buffer, std::size_t size)
+{
+    strings_free(d);
+    d->f_type = VARIABLE_TYPE_STRING;
+    d->f_data_size = size;
+    if(size <= sizeof(d->f_data))
+    {
+        d->f_data = 0;
+        memcpy(&d->f_data, buffer, size);
+    }
+    else
+    {
+        d->f_data = reinterpret_cast<std::uint64_t>(buffer);
+        d->f_flags |= strings_allocated_flag();
+    }
+}
+
+
 void strings_flip_case(binary_variable * d, binary_variable const * s)
 {
 #ifdef _DEBUG
@@ -950,6 +1796,20 @@ void strings_flip_case(binary_variable * d, binary_variable const * s)
     }
 #endif
 
+    if(d == s
+    && d->f_data_size > sizeof(d->f_data)
+    && (d->f_flags & VARIABLE_FLAG_ALLOCATED) == 0)
+    {
+        // the buffer is a constant or it may be shared in the arena,
+        // it cannot be modified in place
+        //
+        binary_variable source(*s);
+        source.f_data = reinterpret_cast<std::uint64_t>(long_string_data(s));
+        source.f_flags &= ~VARIABLE_FLAG_RELATIVE;
+        strings_flip_case(d, &source);
+        return;
+    }
+
     // TODO: use libutf8 to flip the case
     //       note that at that point the output string may have a different
     //       length as a few characters have upper lower which are encoded
@@ -960,12 +1820,12 @@ void strings_flip_case(binary_variable * d, binary_variable const * s)
         strings_free(d);
         if(s->f_data_size > sizeof(d->f_data))
         {
-            d->f_data = reinterpret_cast<std::int64_t>(malloc(s->f_data_size));
+            d->f_data = reinterpret_cast<std::int64_t>(strings_allocate(s->f_data_size));
             if(d->f_data == 0)
             {
                 throw std::bad_alloc();
             }
-            d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+            d->f_flags |= strings_allocated_flag();
         }
         d->f_data_size = s->f_data_size;
     }
@@ -977,7 +1837,7 @@ void strings_flip_case(binary_variable * d, binary_variable const * s)
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
     char * dst(nullptr);
     if(d->f_data_size <= sizeof(d->f_data))
@@ -988,18 +1848,9 @@ void strings_flip_case(binary_variable * d, binary_variable const * s)
     {
         dst = reinterpret_cast<char *>(d->f_data);
     }
-    for(std::uint32_t idx(0); idx < d->f_data_size; ++idx)
-    {
-        char c(src[idx]);
-        if((c >= 'A' && c <= 'Z')
-        || (c >= 'a' && c <= 'z'))
-        {
-            // TODO: use proper UTF-8 upper/lower functions
-            //
-            c ^= 0x20;
-        }
-        dst[idx] = c;
-    }
+    // TODO: use proper UTF-8 upper/lower functions
+    //
+    ascii_convert_case(dst, src, d->f_data_size, case_conversion_t::CASE_CONVERSION_FLIP);
 }
 
 
@@ -1031,13 +1882,13 @@ void strings_multiply(binary_variable * d, binary_variable const * s, std::int64
     d->f_data_size = s->f_data_size * n;
     if(d->f_data_size > sizeof(d->f_data))
     {
-        d->f_data = reinterpret_cast<std::int64_t>(malloc(d->f_data_size));
+        d->f_data = reinterpret_cast<std::int64_t>(strings_allocate(d->f_data_size));
         if(d->f_data == 0)
         {
             d->f_data_size = 0;
             throw std::bad_alloc();
         }
-        d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+        d->f_flags |= strings_allocated_flag();
     }
 
     char const * src(nullptr);
@@ -1047,7 +1898,7 @@ void strings_multiply(binary_variable * d, binary_variable const * s, std::int64
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
     char * dst(nullptr);
     if(d->f_data_size <= sizeof(d->f_data))
@@ -1092,83 +1943,445 @@ void strings_minmax(binary_variable * d, binary_variable const * s1, binary_vari
 }
 
 
-void strings_at(binary_variable * d, binary_variable const * s, std::int64_t index)
+bool utf8_is_continuation(char c)
 {
-#ifdef _DEBUG
-    if(d->f_type != VARIABLE_TYPE_STRING)
+    return (static_cast<std::uint8_t>(c) & 0xC0) == 0x80;
+}
+
+
+/** \brief Index of the character positions of a UTF-8 string.
+ *
+ * The runtime functions work with character positions while the
+ * strings are saved in UTF-8. Without an index, converting a position
+ * to a byte offset requires a scan from the start of the string.
+ *
+ * The index saves the byte offset of one character every
+ * UTF8_INDEX_STRIDE characters so converting a position or an offset
+ * requires checking at most that many characters. If the string is
+ * pure ASCII, no offsets are saved since the positions and offsets
+ * are the same.
+ */
+class utf8_index
+{
+public:
+    static constexpr std::size_t    UTF8_INDEX_STRIDE = 32;
+
+    void                build(char const * s, std::size_t size);
+    void                clear();
+    bool                is_for(char const * s, std::size_t size) const;
+    std::size_t         length() const;
+    std::size_t         offset(std::size_t position) const;
+    std::size_t         position(std::size_t offset) const;
+
+private:
+    char const *        f_string = nullptr;
+    std::size_t         f_size = 0;
+    std::size_t         f_length = 0;
+    bool                f_ascii = false;
+    std::vector<std::uint32_t>
+                        f_offsets = std::vector<std::uint32_t>();
+};
+
+
+void utf8_index::build(char const * s, std::size_t size)
+{
+    f_string = s;
+    f_size = size;
+    f_offsets.clear();
+    f_ascii = ascii_span(s, size) == size;
+    if(f_ascii)
     {
-        throw incompatible_type("d is expected to be a string in strings_at()");
+        f_length = size;
+        return;
     }
-    if(s->f_type != VARIABLE_TYPE_STRING)
+
+    f_length = 0;
+    for(std::size_t idx(0); idx < size; ++idx)
     {
-        throw incompatible_type("s is expected to be a string in strings_at()");
+        if(!utf8_is_continuation(s[idx]))
+        {
+            if(f_length % UTF8_INDEX_STRIDE == 0)
+            {
+                f_offsets.push_back(idx);
+            }
+            ++f_length;
+        }
     }
-#endif
+}
 
-    if(s->f_data_size == 0)
+
+void utf8_index::clear()
+{
+    f_string = nullptr;
+    f_size = 0;
+}
+
+
+bool utf8_index::is_for(char const * s, std::size_t size) const
+{
+    return f_string == s && f_size == size;
+}
+
+
+std::size_t utf8_index::length() const
+{
+    return f_length;
+}
+
+
+std::size_t utf8_index::offset(std::size_t position) const
+{
+    if(position >= f_length)
     {
-        strings_free(d);
-        return;
+        return f_size;
     }
-
-    // we have UTF-8 strings, so the index doesn't work as is on our
-    // strings, instead we have to scan the string (arg!)
-    //
-    // also, compared to JavaScript, we ignore the fact that the characters
-    // are UTF-16 in JavaScript (that way we do not have to deal with
-    // surrogates)
-    //
-    // TODO: see that the libutf8 offers an iterator on `char [const] *`
-    //
-    std::string src;
-    if(s->f_data_size <= sizeof(s->f_data))
+    if(f_ascii)
     {
-        src = std::string(reinterpret_cast<char const *>(&s->f_data), s->f_data_size);
+        return position;
     }
-    else
+    std::size_t result(f_offsets[position / UTF8_INDEX_STRIDE]);
+    for(position %= UTF8_INDEX_STRIDE; position > 0; --position)
     {
-        src = std::string(reinterpret_cast<char const *>(s->f_data), s->f_data_size);
+        do
+        {
+            ++result;
+        }
+        while(result < f_size && utf8_is_continuation(f_string[result]));
     }
+    return result;
+}
 
-    char32_t c(libutf8::EOS);
-    std::int64_t count(labs(index));
-    if(index >= 0)
+
+std::size_t utf8_index::position(std::size_t offset) const
+{
+    if(f_ascii)
     {
-        ++count;
+        return std::min(offset, f_size);
     }
-
-    // WARNING: do not test with `it != s.end()` because doing so would give
-    //          you the last character instead of "" if index is too large
-    //
-    if(index >= 0)
+    auto it(std::upper_bound(f_offsets.begin(), f_offsets.end(), offset));
+    std::size_t const block(it - f_offsets.begin() - 1);
+    std::size_t result(block * UTF8_INDEX_STRIDE);
+    for(std::size_t idx(f_offsets[block]); idx < offset && idx < f_size; ++idx)
     {
-        for(libutf8::utf8_iterator it(src); count > 0; ++it, --count)
+        if(!utf8_is_continuation(f_string[idx]))
         {
-            c = *it;
-            if(c == libutf8::EOS)
-            {
-                break;
-            }
+            ++result;
         }
     }
-    else
+    return result;
+}
+
+
+/** \brief The UTF-8 indexes of the strings used by the current run.
+ *
+ * The strings used while running are never modified in place (other
+ * than flipping the case of ASCII letters which does not change the
+ * positions) and their buffers are not freed before the run ends, so
+ * the data pointer and size identify a string. The cache is cleared
+ * at the end of each run by call_entry().
+ */
+constexpr std::size_t UTF8_INDEX_MIN_SIZE = 64;     // shorter strings are scanned
+constexpr std::size_t UTF8_INDEX_CACHE_SIZE = 4;
+
+thread_local utf8_index g_utf8_indexes[UTF8_INDEX_CACHE_SIZE];
+thread_local std::size_t g_utf8_next_index = 0;
+
+
+utf8_index const * get_utf8_index(char const * s, std::size_t size)
+{
+    if(size < UTF8_INDEX_MIN_SIZE
+    || g_arena == nullptr)
+    {
+        return nullptr;
+    }
+    for(auto const & index : g_utf8_indexes)
+    {
+        if(index.is_for(s, size))
+        {
+            return &index;
+        }
+    }
+    utf8_index & index(g_utf8_indexes[g_utf8_next_index]);
+    g_utf8_next_index = (g_utf8_next_index + 1) % UTF8_INDEX_CACHE_SIZE;
+    index.build(s, size);
+    return &index;
+}
+
+
+void clear_utf8_indexes()
+{
+    for(auto & index : g_utf8_indexes)
+    {
+        index.clear();
+    }
+}
+
+
+/** \brief Get the number of characters in a UTF-8 string.
+ *
+ * \param[in] s  The UTF-8 string.
+ * \param[in] size  The size of \p s in bytes.
+ *
+ * \return The number of characters in \p s.
+ */
+std::size_t utf8_length(char const * s, std::size_t size)
+{
+    utf8_index const * index(get_utf8_index(s, size));
+    if(index != nullptr)
+    {
+        return index->length();
+    }
+    std::size_t result(0);
+    for(std::size_t idx(0); idx < size; ++idx)
+    {
+        if(!utf8_is_continuation(s[idx]))
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+
+/** \brief Convert a character position to a byte offset.
+ *
+ * \param[in] s  The UTF-8 string.
+ * \param[in] size  The size of \p s in bytes.
+ * \param[in] position  The character position to convert.
+ *
+ * \return The offset of that character or \p size if \p position is
+ * past the end of the string.
+ */
+std::size_t utf8_offset(char const * s, std::size_t size, std::size_t position)
+{
+    utf8_index const * index(get_utf8_index(s, size));
+    if(index != nullptr)
+    {
+        return index->offset(position);
+    }
+    std::size_t result(0);
+    for(; position > 0 && result < size; --position)
+    {
+        do
+        {
+            ++result;
+        }
+        while(result < size && utf8_is_continuation(s[result]));
+    }
+    return result;
+}
+
+
+/** \brief Convert a byte offset to a character position.
+ *
+ * \param[in] s  The UTF-8 string.
+ * \param[in] size  The size of \p s in bytes.
+ * \param[in] offset  The offset of the first byte of a character.
+ *
+ * \return The position of the character at \p offset.
+ */
+std::size_t utf8_position(char const * s, std::size_t size, std::size_t offset)
+{
+    utf8_index const * index(get_utf8_index(s, size));
+    if(index != nullptr)
+    {
+        return index->position(offset);
+    }
+    std::size_t result(0);
+    for(std::size_t idx(0); idx < offset && idx < size; ++idx)
+    {
+        if(!utf8_is_continuation(s[idx]))
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+
+// AVX2 loop of find_bytes(), returns the offset of the first match or
+// std::string::npos; *next is set to the first offset not yet checked
+//
+__attribute__((target("avx2")))
+std::size_t find_bytes_avx2(
+      char const * haystack
+    , std::size_t haystack_size
+    , char const * needle
+    , std::size_t needle_size
+    , std::size_t * next)
+{
+    __m256i const first(_mm256_set1_epi8(needle[0]));
+    __m256i const last(_mm256_set1_epi8(needle[needle_size - 1]));
+
+    std::size_t pos(0);
+    for(; pos + needle_size - 1 + 32 <= haystack_size; pos += 32)
+    {
+        __m256i const block_first(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(haystack + pos)));
+        __m256i const block_last(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(haystack + pos + needle_size - 1)));
+        std::uint32_t mask(_mm256_movemask_epi8(_mm256_and_si256(
+                  _mm256_cmpeq_epi8(first, block_first)
+                , _mm256_cmpeq_epi8(last, block_last))));
+        while(mask != 0)
+        {
+            std::size_t const offset(pos + __builtin_ctz(mask));
+            if(memcmp(haystack + offset + 1, needle + 1, needle_size - 2) == 0)
+            {
+                return offset;
+            }
+            mask &= mask - 1;
+        }
+    }
+    *next = pos;
+    return std::string::npos;
+}
+
+
+/** \brief Search a string of bytes in another.
+ *
+ * The search compares the first and the last byte of the needle to
+ * 16 bytes of the haystack at once (32 with AVX2) and only compares the
+ * rest of the needle where both match.
+ *
+ * Since UTF-8 is self-synchronizing, a match always starts at the
+ * beginning of a character when both strings are valid UTF-8.
+ *
+ * \param[in] haystack  The string to search.
+ * \param[in] haystack_size  The size of \p haystack.
+ * \param[in] needle  The string to search for.
+ * \param[in] needle_size  The size of \p needle.
+ *
+ * \return The offset of the first match or std::string::npos.
+ */
+std::size_t find_bytes(
+      char const * haystack
+    , std::size_t haystack_size
+    , char const * needle
+    , std::size_t needle_size)
+{
+    if(needle_size == 0)
     {
-        for(libutf8::utf8_iterator it(src, true); count > 0; --count)
+        return 0;
+    }
+    if(needle_size > haystack_size)
+    {
+        return std::string::npos;
+    }
+    if(needle_size == 1)
+    {
+        void const * ptr(memchr(haystack, needle[0], haystack_size));
+        return ptr == nullptr
+                    ? std::string::npos
+                    : static_cast<char const *>(ptr) - haystack;
+    }
+
+    std::size_t pos(0);
+    if(g_has_avx2)
+    {
+        std::size_t const offset(find_bytes_avx2(haystack, haystack_size, needle, needle_size, &pos));
+        if(offset != std::string::npos)
+        {
+            return offset;
+        }
+    }
+    else
+    {
+        __m128i const first(_mm_set1_epi8(needle[0]));
+        __m128i const last(_mm_set1_epi8(needle[needle_size - 1]));
+        for(; pos + needle_size - 1 + 16 <= haystack_size; pos += 16)
         {
-            --it;
-            c = *it;
-            if(c == libutf8::EOS)
+            __m128i const block_first(_mm_loadu_si128(reinterpret_cast<__m128i const *>(haystack + pos)));
+            __m128i const block_last(_mm_loadu_si128(reinterpret_cast<__m128i const *>(haystack + pos + needle_size - 1)));
+            std::uint32_t mask(_mm_movemask_epi8(_mm_and_si128(
+                      _mm_cmpeq_epi8(first, block_first)
+                    , _mm_cmpeq_epi8(last, block_last))));
+            while(mask != 0)
             {
-                break;
+                std::size_t const offset(pos + __builtin_ctz(mask));
+                if(memcmp(haystack + offset + 1, needle + 1, needle_size - 2) == 0)
+                {
+                    return offset;
+                }
+                mask &= mask - 1;
             }
         }
     }
 
-    strings_free(d);
-    if(c != libutf8::EOS)
+    for(; pos + needle_size <= haystack_size; ++pos)
+    {
+        if(haystack[pos] == needle[0]
+        && memcmp(haystack + pos + 1, needle + 1, needle_size - 1) == 0)
+        {
+            return pos;
+        }
+    }
+    return std::string::npos;
+}
+
+
+void strings_at(binary_variable * d, binary_variable const * s, std::int64_t index)
+{
+#ifdef _DEBUG
+    if(d->f_type != VARIABLE_TYPE_STRING)
+    {
+        throw incompatible_type("d is expected to be a string in strings_at()");
+    }
+    if(s->f_type != VARIABLE_TYPE_STRING)
+    {
+        throw incompatible_type("s is expected to be a string in strings_at()");
+    }
+#endif
+
+    if(s->f_data_size == 0)
+    {
+        strings_free(d);
+        return;
+    }
+
+    // we have UTF-8 strings, so the index doesn't work as is on our
+    // strings, instead we use the character positions
+    //
+    // also, compared to JavaScript, we ignore the fact that the characters
+    // are UTF-16 in JavaScript (that way we do not have to deal with
+    // surrogates)
+    //
+    char const * src(nullptr);
+    if(s->f_data_size <= sizeof(s->f_data))
+    {
+        src = reinterpret_cast<char const *>(&s->f_data);
+    }
+    else
+    {
+        src = long_string_data(s);
+    }
+    std::size_t const size(s->f_data_size);
+
+    std::int64_t const length(utf8_length(src, size));
+    if(index < 0)
+    {
+        index += length;
+    }
+    if(index < 0
+    || index >= length)
+    {
+        strings_free(d);
+        return;
+    }
+
+    // `d` may be `s` so copy the character before releasing `d`
+    //
+    std::size_t const offset(utf8_offset(src, size, index));
+    std::size_t end(offset + 1);
+    while(end < size && utf8_is_continuation(src[end]))
     {
-        d->f_data_size = libutf8::wctombs(reinterpret_cast<char *>(&d->f_data), c, sizeof(d->f_data));
+        ++end;
     }
+    std::uint64_t c(0);
+    std::size_t const c_size(std::min(end - offset, sizeof(c)));
+    memcpy(&c, src + offset, c_size);
+
+    strings_free(d);
+    d->f_data = c;
+    d->f_data_size = c_size;
 }
 
 
@@ -1196,52 +2409,41 @@ void strings_substr(binary_variable * d, binary_variable const * s, std::int64_t
     }
 
     // we have UTF-8 strings, so the index doesn't work as is on our
-    // strings, instead we have to scan the string (arg!)
+    // strings, instead we convert the character positions to offsets
     //
     // also, compared to JavaScript, we ignore the fact that the characters
     // are UTF-16 in JavaScript (that way we do not have to deal with
     // surrogates)
     //
-    std::string src;
+    char const * src(nullptr);
     if(s->f_data_size <= sizeof(s->f_data))
     {
-        src = std::string(reinterpret_cast<char const *>(&s->f_data), s->f_data_size);
+        src = reinterpret_cast<char const *>(&s->f_data);
     }
     else
     {
-        src = std::string(reinterpret_cast<char const *>(s->f_data), s->f_data_size);
+        src = long_string_data(s);
     }
+    std::size_t const size(s->f_data_size);
 
-    std::int64_t count(0);
-
-    libutf8::utf8_iterator::difference_type idx_start(src.end() - src.begin());
-    libutf8::utf8_iterator::difference_type idx_end(idx_start);
-    for(libutf8::utf8_iterator it(src); it != src.end(); ++it, ++count)
-    {
-        if(count == start)
-        {
-            idx_start = it - src.begin();
-        }
-        if(count == end)
-        {
-            idx_end = it - src.begin();
-            break; // no need to go further
-        }
-    }
+    std::size_t const idx_start(utf8_offset(src, size, start));
+    std::size_t const idx_end(utf8_offset(src, size, end));
+    std::size_t const length(idx_end - idx_start);
 
-    strings_free(d);
-    d->f_data_size = idx_end - idx_start;
-    if(d->f_data_size > 0)
+    // `d` may be `s` so strings_attach() releases `d` after the copy
+    //
+    char small[sizeof(d->f_data)];
+    char * dst(small);
+    if(length > sizeof(d->f_data))
     {
-        if(d->f_data_size <= sizeof(d->f_data))
-        {
-            memcpy(&d->f_data, src.c_str() + idx_start, d->f_data_size);
-        }
-        else
+        dst = static_cast<char *>(strings_allocate(length));
+        if(dst == nullptr)
         {
-            memcpy(reinterpret_cast<char *>(d->f_data), src.c_str() + idx_start, d->f_data_size);
+            throw std::bad_alloc();
         }
     }
+    memcpy(dst, src + idx_start, length);
+    strings_attach(d, dst, length);
 }
 
 
@@ -1289,20 +2491,24 @@ void strings_char_at(binary_variable * d, binary_variable const * s, binary_vari
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
-    std::string const input(std::string(src, s->f_data_size));
-    libutf8::utf8_iterator::value_type wc(libutf8::NOT_A_CHARACTER);
-    libutf8::utf8_iterator it(input);
-    for(int idx(0); idx <= pos; ++idx, ++it)
+    char32_t wc(libutf8::NOT_A_CHARACTER);
+    if(pos >= 0)
     {
-        wc = *it;
-        if(wc == libutf8::EOS)
+        std::size_t const offset(utf8_offset(src, s->f_data_size, pos));
+        if(offset >= s->f_data_size)
         {
             // TODO: this needs to be a script throw, not a C++ throw...
             //
             throw out_of_range("position out of range for String.charAt(). (1)");
         }
+        char const * mb(src + offset);
+        std::size_t len(s->f_data_size - offset);
+        if(libutf8::mbstowc(wc, mb, len) < 0)
+        {
+            wc = libutf8::NOT_A_CHARACTER;
+        }
     }
     if(wc == libutf8::NOT_A_CHARACTER)
     {
@@ -1355,20 +2561,24 @@ void strings_char_code_at(std::int64_t * d, binary_variable const * s, binary_va
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
-    std::string const input(std::string(src, s->f_data_size));
-    libutf8::utf8_iterator::value_type wc(libutf8::NOT_A_CHARACTER);
-    libutf8::utf8_iterator it(input);
-    for(int idx(0); idx <= pos; ++idx, ++it)
+    char32_t wc(libutf8::NOT_A_CHARACTER);
+    if(pos >= 0)
     {
-        wc = *it;
-        if(wc == libutf8::EOS)
+        std::size_t const offset(utf8_offset(src, s->f_data_size, pos));
+        if(offset >= s->f_data_size)
         {
             // TODO: this needs to be a script throw, not a C++ throw...
             //
             throw out_of_range("position out of range for String.charCodeAt(). (1)");
         }
+        char const * mb(src + offset);
+        std::size_t len(s->f_data_size - offset);
+        if(libutf8::mbstowc(wc, mb, len) < 0)
+        {
+            wc = libutf8::NOT_A_CHARACTER;
+        }
     }
     if(wc == libutf8::NOT_A_CHARACTER)
     {
@@ -1433,7 +2643,7 @@ void strings_index_of(std::int64_t * d, binary_variable const * s, binary_variab
     }
     else
     {
-        search_string = reinterpret_cast<char const *>(p1->f_data);
+        search_string = long_string_data(p1);
     }
 
     char const * src(nullptr);
@@ -1443,62 +2653,28 @@ void strings_index_of(std::int64_t * d, binary_variable const * s, binary_variab
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
 
     *d = -1;
 
-    // the strings are UTF-8 so we need to iterate them with libutf8
-    //
-    std::string const haystack(src, s->f_data_size);
-    std::string const needle(search_string, p1->f_data_size);
-
-    libutf8::utf8_iterator it(haystack);
-
-    // skip 'pos' characters at the start
-    //
-    for(std::int64_t idx(0); idx < pos; ++idx, ++it)
+    std::size_t const size(s->f_data_size);
+    if(p1->f_data_size == 0)
     {
-        if(*it == libutf8::EOS)
-        {
-            // input is too small
-            //
-            if(needle.empty())
-            {
-                // here is a special case in JavaScript for the empty string
-                //
-                *d = idx;
-            }
-            return;
-        }
+        // here is a special case in JavaScript for the empty string
+        //
+        *d = std::min(pos, static_cast<std::int64_t>(utf8_length(src, size)));
+        return;
     }
 
-    // now check whether 'haystack[0 .. needle.size() - 1]' == 'needle'
-    // if not, try skipping one more character from haystack and try again
+    // the strings are UTF-8 so we search the bytes and then convert
+    // the offset of the match to a character position
     //
-    for(; *it != libutf8::EOS; ++pos, ++it)
+    std::size_t const start(utf8_offset(src, size, pos));
+    std::size_t const found(find_bytes(src + start, size - start, search_string, p1->f_data_size));
+    if(found != std::string::npos)
     {
-        libutf8::utf8_iterator pt(it);
-        for(libutf8::utf8_iterator nt(needle);; ++nt, ++pt)
-        {
-            if(*nt == libutf8::EOS)
-            {
-                // found it, we're done
-                //
-                *d = pos;
-                return;
-            }
-            if(*pt == libutf8::EOS)
-            {
-                // needle.length > haystack.length, we can return now
-                //
-                return;
-            }
-            if(*nt != *pt)
-            {
-                break;
-            }
-        }
+        *d = utf8_position(src, size, start + found);
     }
 }
 
@@ -1557,7 +2733,7 @@ void strings_last_index_of(std::int64_t * d, binary_variable const * s, binary_v
     }
     else
     {
-        search_string = reinterpret_cast<char const *>(p1->f_data);
+        search_string = long_string_data(p1);
     }
 
     char const * src(nullptr);
@@ -1567,60 +2743,43 @@ void strings_last_index_of(std::int64_t * d, binary_variable const * s, binary_v
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
 
     *d = -1;
 
-    // the strings are UTF-8 so we need to iterate them with libutf8
-    //
-    std::string const haystack(src, s->f_data_size);
-    std::string const needle(search_string, p1->f_data_size);
+    std::size_t const size(s->f_data_size);
 
     // if needle is empty, we return the size of the string or pos
     // whichever is smaller
     //
-    if(needle.empty())
+    if(p1->f_data_size == 0)
     {
         // here is a special case in JavaScript for the empty string
         //
-        *d = std::min(pos, static_cast<std::int64_t>(libutf8::u8length(haystack)));
+        *d = std::min(pos, static_cast<std::int64_t>(utf8_length(src, size)));
         return;
     }
 
-    // now check whether 'haystack[0 .. needle.size() - 1]' == 'needle'
-    // if not, try skipping one more character from haystack and try again
-    //
-    // IMPORTANT NOTE: since we're dealing with UTF-8, we start from the
-    //                 beginning of the string and save the position of
-    //                 the last occurence instead of trying to go backward
-    //                 (TODO: fix because I think this is fixable? but 'pos'
-    //                 is a big issue here...)
+    // the match has to start at or before character `pos`; search
+    // forward in that window and keep the last match
     //
-    libutf8::utf8_iterator it(haystack);
-    for(std::int64_t idx(0); *it != libutf8::EOS && idx <= pos; ++idx, ++it)
+    std::size_t const limit(utf8_offset(src, size, pos));
+    std::size_t const window(std::min(size, limit + p1->f_data_size));
+    std::size_t last(std::string::npos);
+    for(std::size_t offset(0); offset < window;)
     {
-        libutf8::utf8_iterator pt(it);
-        for(libutf8::utf8_iterator nt(needle);; ++nt, ++pt)
+        std::size_t const found(find_bytes(src + offset, window - offset, search_string, p1->f_data_size));
+        if(found == std::string::npos)
         {
-            if(*nt == libutf8::EOS)
-            {
-                // found an occurence, save/replace the value
-                //
-                *d = idx;
-                break;
-            }
-            if(*pt == libutf8::EOS)
-            {
-                // needle.length > haystack.length, we can return now
-                //
-                return;
-            }
-            if(*nt != *pt)
-            {
-                break;
-            }
+            break;
         }
+        last = offset + found;
+        offset = last + 1;
+    }
+    if(last != std::string::npos)
+    {
+        *d = utf8_position(src, size, last);
     }
 }
 
@@ -1637,12 +2796,12 @@ void strings_save(binary_variable * d, std::string const & result)
         }
         else
         {
-            d->f_data = reinterpret_cast<std::uint64_t>(malloc(d->f_data_size));
+            d->f_data = reinterpret_cast<std::uint64_t>(strings_allocate(d->f_data_size));
             if(d->f_data == 0)
             {
                 throw std::bad_alloc();
             }
-            d->f_flags |= VARIABLE_FLAG_ALLOCATED;
+            d->f_flags |= strings_allocated_flag();
             memcpy(reinterpret_cast<char *>(d->f_data), result.c_str(), d->f_data_size);
         }
     }
@@ -1691,7 +2850,7 @@ void strings_replace_apply(binary_variable * d, binary_variable const * s, binar
     }
     else
     {
-        search_string = reinterpret_cast<char const *>(search->f_data);
+        search_string = long_string_data(search);
     }
 
     char const * replace_string(nullptr);
@@ -1701,7 +2860,7 @@ void strings_replace_apply(binary_variable * d, binary_variable const * s, binar
     }
     else
     {
-        replace_string = reinterpret_cast<char const *>(replace->f_data);
+        replace_string = long_string_data(replace);
     }
 
     char const * src(nullptr);
@@ -1711,7 +2870,7 @@ void strings_replace_apply(binary_variable * d, binary_variable const * s, binar
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
 
     // if needle is empty, just prepend replace_string
@@ -2001,7 +3160,21 @@ void strings_substring(binary_variable * d, binary_variable const * s, binary_va
 }
 
 
-void strings_to_lowercase(binary_variable * d, binary_variable const * s)
+/** \brief Change the case of a string.
+ *
+ * When the string is pure ASCII, which is the most common case, the
+ * conversion happens directly in the buffer of the destination with
+ * ascii_convert_case().
+ *
+ * Otherwise the ASCII spans are still converted with ascii_convert_case()
+ * and only the other characters go through towlower() or towupper().
+ * These may change the length of the string.
+ *
+ * \param[out] d  The destination string.
+ * \param[in] s  The source string.
+ * \param[in] conversion  Whether to convert to lower or upper case.
+ */
+void strings_convert_case(binary_variable * d, binary_variable const * s, case_conversion_t conversion)
 {
     char const * src(nullptr);
     if(s->f_data_size <= sizeof(s->f_data))
@@ -2010,54 +3183,69 @@ void strings_to_lowercase(binary_variable * d, binary_variable const * s)
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
-    std::string const in(src, s->f_data_size);
+    std::size_t const size(s->f_data_size);
 
-    std::string result;
-    for(libutf8::utf8_iterator it(in);; ++it)
+    std::size_t pos(ascii_span(src, size));
+    if(pos == size)
+    {
+        char small[sizeof(d->f_data)];
+        char * dst(small);
+        if(size > sizeof(d->f_data))
+        {
+            dst = static_cast<char *>(strings_allocate(size));
+            if(dst == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+        }
+        ascii_convert_case(dst, src, size, conversion);
+        strings_attach(d, dst, size);
+        return;
+    }
+
+    std::string result(size, '\0');
+    ascii_convert_case(result.data(), src, pos, conversion);
+    result.resize(pos);
+    while(pos < size)
     {
-        char32_t wc(*it);
-        if(wc == libutf8::NOT_A_CHARACTER
-        || wc == libutf8::EOS)
+        char32_t wc(libutf8::NOT_A_CHARACTER);
+        char const * mb(src + pos);
+        std::size_t len(size - pos);
+        if(libutf8::mbstowc(wc, mb, len) < 0)
         {
             break;
         }
-        wc = towlower(wc);
-        result += libutf8::to_u8string(wc);
+        pos = mb - src;
+        wc = conversion == case_conversion_t::CASE_CONVERSION_LOWER ? towlower(wc) : towupper(wc);
+        char buf[8];
+        int const l(libutf8::wctombs(buf, wc, sizeof(buf)));
+        if(l > 0)
+        {
+            result.append(buf, l);
+        }
+
+        std::size_t const span(ascii_span(src + pos, size - pos));
+        std::size_t const length(result.length());
+        result.resize(length + span);
+        ascii_convert_case(result.data() + length, src + pos, span, conversion);
+        pos += span;
     }
 
     strings_save(d, result);
 }
 
 
-void strings_to_uppercase(binary_variable * d, binary_variable const * s)
+void strings_to_lowercase(binary_variable * d, binary_variable const * s)
 {
-    char const * src(nullptr);
-    if(s->f_data_size <= sizeof(s->f_data))
-    {
-        src = reinterpret_cast<char const *>(&s->f_data);
-    }
-    else
-    {
-        src = reinterpret_cast<char const *>(s->f_data);
-    }
-    std::string const in(src, s->f_data_size);
+    strings_convert_case(d, s, case_conversion_t::CASE_CONVERSION_LOWER);
+}
 
-    std::string result;
-    for(libutf8::utf8_iterator it(in);; ++it)
-    {
-        char32_t wc(*it);
-        if(wc == libutf8::NOT_A_CHARACTER
-        || wc == libutf8::EOS)
-        {
-            break;
-        }
-        wc = towupper(wc);
-        result += libutf8::to_u8string(wc);
-    }
 
-    strings_save(d, result);
+void strings_to_uppercase(binary_variable * d, binary_variable const * s)
+{
+    strings_convert_case(d, s, case_conversion_t::CASE_CONVERSION_UPPER);
 }
 
 
@@ -2100,6 +3288,18 @@ bool strings_is_white_space(char32_t wc)
 }
 
 
+/** \brief Remove white spaces at the start and/or end of a string.
+ *
+ * Only the edges of the string are checked. ASCII white spaces are
+ * skipped directly and only bytes 0x80 and over get decoded to check
+ * for the Unicode white spaces. The remaining characters are copied
+ * as is to the destination.
+ *
+ * \param[out] d  The destination string.
+ * \param[in] s  The source string.
+ * \param[in] trim_start  Whether to remove the white spaces at the start.
+ * \param[in] trim_end  Whether to remove the white spaces at the end.
+ */
 void strings_trim(binary_variable * d, binary_variable const * s, bool trim_start, bool trim_end)
 {
     char const * src(nullptr);
@@ -2109,46 +3309,93 @@ void strings_trim(binary_variable * d, binary_variable const * s, bool trim_star
     }
     else
     {
-        src = reinterpret_cast<char const *>(s->f_data);
+        src = long_string_data(s);
     }
-    std::string const in(src, s->f_data_size);
 
-    std::string result;
-    std::string inside_white_spaces;
-    for(libutf8::utf8_iterator it(in);; ++it)
+    std::size_t start(0);
+    std::size_t end(s->f_data_size);
+    if(trim_start)
     {
-        char32_t const wc(*it);
-        if(wc == libutf8::NOT_A_CHARACTER
-        || wc == libutf8::EOS)
-        {
-            break;
-        }
-//std::cerr << "--- wc = " << static_cast<int>(wc)
-//<< " is white? " << strings_is_white_space(wc)
-//<< " not a character= " << static_cast<int>(libutf8::NOT_A_CHARACTER)
-//<< " EOS= " << static_cast<int>(libutf8::EOS)
-//<< "\n";
-        if(strings_is_white_space(wc))
+        while(start < end)
         {
-            if(!trim_start)
+            std::uint8_t const c(src[start]);
+            if(c < 0x80)
             {
-                inside_white_spaces += libutf8::to_u8string(wc);
-            }
+                if(!strings_is_white_space(c))
+                {
+                    break;
+                }
+                ++start;
+            }
+            else
+            {
+                char32_t wc(libutf8::NOT_A_CHARACTER);
+                char const * mb(src + start);
+                std::size_t len(end - start);
+                if(libutf8::mbstowc(wc, mb, len) < 0
+                || !strings_is_white_space(wc))
+                {
+                    break;
+                }
+                start = mb - src;
+            }
         }
-        else
+    }
+    if(trim_end)
+    {
+        while(end > start)
         {
-            trim_start = false;
-            result += inside_white_spaces;
-            inside_white_spaces.clear();
-            result += libutf8::to_u8string(wc);
+            std::uint8_t const c(src[end - 1]);
+            if(c < 0x80)
+            {
+                if(!strings_is_white_space(c))
+                {
+                    break;
+                }
+                --end;
+            }
+            else
+            {
+                // go back to the first byte of that character
+                //
+                std::size_t first(end - 1);
+                while(first > start
+                   && (static_cast<std::uint8_t>(src[first]) & 0xC0) == 0x80)
+                {
+                    --first;
+                }
+                char32_t wc(libutf8::NOT_A_CHARACTER);
+                char const * mb(src + first);
+                std::size_t len(end - first);
+                if(libutf8::mbstowc(wc, mb, len) < 0
+                || !strings_is_white_space(wc))
+                {
+                    break;
+                }
+                end = first;
+            }
         }
     }
-    if(!trim_end)
+
+    std::size_t const size(end - start);
+    if(size == s->f_data_size)
     {
-        result += inside_white_spaces;
+        strings_copy(d, s);
+        return;
     }
 
-    strings_save(d, result);
+    char small[sizeof(d->f_data)];
+    char * dst(small);
+    if(size > sizeof(d->f_data))
+    {
+        dst = static_cast<char *>(strings_allocate(size));
+        if(dst == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+    }
+    memcpy(dst, src + start, size);
+    strings_attach(d, dst, size);
 }
 
 
@@ -2289,11 +3536,67 @@ void floating_points_to_string(binary_variable * d, double number, binary_variab
 void array_initialize(binary_variable * v)
 {
     v->f_type = VARIABLE_TYPE_ARRAY;
-    v->f_flags = VARIABLE_FLAG_ALLOCATED;
+    v->f_element_type = ARRAY_ELEMENT_VARIABLE;
     v->f_name = 0;              // TODO: add a name (for debug purposes)
     v->f_name_size = 0;
     v->f_data_size = sizeof(binary_variable::vector_of_pointers_t *);
-    v->f_data = reinterpret_cast<std::int64_t>(new binary_variable::vector_of_pointers_t);
+
+    // when running, the vector and its items both live in the arena
+    //
+    v->f_flags = g_arena != nullptr ? VARIABLE_FLAG_ARENA : VARIABLE_FLAG_ALLOCATED;
+    v->f_data = reinterpret_cast<std::int64_t>(array_new<binary_variable::vector_of_pointers_t>(g_arena));
+}
+
+
+/** \brief Initialize a typed array.
+ *
+ * A typed array saves its items contiguously instead of as a vector of
+ * pointers to variables. An array of integers is an array of int64_t,
+ * an array of floating points is an array of double, and an array of
+ * booleans is an array of bytes set to 0 or 1.
+ *
+ * The array_data() function returns a pointer to the first item so the
+ * code can go through the items without a function call per item.
+ *
+ * \param[in] v  The variable to initialize as an array.
+ * \param[in] element_type  One of the array_element_t types.
+ */
+void array_initialize_typed(binary_variable * v, std::int64_t element_type)
+{
+    std::uint64_t items(0);
+    switch(element_type)
+    {
+    case ARRAY_ELEMENT_VARIABLE:
+        array_initialize(v);
+        return;
+
+    case ARRAY_ELEMENT_INTEGER:
+        items = reinterpret_cast<std::uint64_t>(array_new<binary_variable::vector_of_integers_t>(g_arena));
+        break;
+
+    case ARRAY_ELEMENT_FLOATING_POINT:
+        items = reinterpret_cast<std::uint64_t>(array_new<binary_variable::vector_of_floating_points_t>(g_arena));
+        break;
+
+    case ARRAY_ELEMENT_BOOLEAN:
+        items = reinterpret_cast<std::uint64_t>(array_new<binary_variable::vector_of_booleans_t>(g_arena));
+        break;
+
+    default:
+        throw incompatible_type(
+                  "unknown array element type "
+                + std::to_string(element_type)
+                + " in array_initialize_typed().");
+
+    }
+
+    v->f_type = VARIABLE_TYPE_ARRAY;
+    v->f_element_type = static_cast<array_element_t>(element_type);
+    v->f_name = 0;
+    v->f_name_size = 0;
+    v->f_data_size = sizeof(void *);
+    v->f_flags = g_arena != nullptr ? VARIABLE_FLAG_ARENA : VARIABLE_FLAG_ALLOCATED;
+    v->f_data = items;
 }
 
 
@@ -2309,10 +3612,131 @@ void array_free(binary_variable * v)
     if((v->f_flags & VARIABLE_FLAG_ALLOCATED) != 0)
     {
         v->f_flags &= ~VARIABLE_FLAG_ALLOCATED;
-        delete reinterpret_cast<binary_variable::vector_of_pointers_t *>(v->f_data);
+        switch(v->f_element_type)
+        {
+        case ARRAY_ELEMENT_VARIABLE:
+            if((v->f_flags & VARIABLE_FLAG_OWNED) != 0)
+            {
+                v->f_flags &= ~VARIABLE_FLAG_OWNED;
+                for(auto * item : *array_items<binary_variable::vector_of_pointers_t>(v))
+                {
+                    variable_heap_free(item);
+                }
+            }
+            delete array_items<binary_variable::vector_of_pointers_t>(v);
+            break;
+
+        case ARRAY_ELEMENT_INTEGER:
+            delete array_items<binary_variable::vector_of_integers_t>(v);
+            break;
+
+        case ARRAY_ELEMENT_FLOATING_POINT:
+            delete array_items<binary_variable::vector_of_floating_points_t>(v);
+            break;
+
+        case ARRAY_ELEMENT_BOOLEAN:
+            delete array_items<binary_variable::vector_of_booleans_t>(v);
+            break;
+
+        }
         v->f_data = 0; // a.k.a. "nullptr"
         v->f_data_size = 0;
     }
+    else if((v->f_flags & VARIABLE_FLAG_ARENA) != 0)
+    {
+        // no need to call the destructor, the vector only allocates
+        // from the arena which gets reset after the run
+        //
+        v->f_flags &= ~VARIABLE_FLAG_ARENA;
+        v->f_data = 0;
+        v->f_data_size = 0;
+    }
+}
+
+
+/** \brief Release a variable allocated by variable_heap_copy().
+ *
+ * The string or array data of the variable is released first, then
+ * the variable itself.
+ *
+ * \param[in] v  The variable to release.
+ */
+void variable_heap_free(binary_variable * v)
+{
+    switch(v->f_type)
+    {
+    case VARIABLE_TYPE_STRING:
+        strings_free(v);
+        break;
+
+    case VARIABLE_TYPE_ARRAY:
+        array_free(v);
+        break;
+
+    default:
+        break;
+
+    }
+    delete v;
+}
+
+
+/** \brief Verify that an array can be accessed.
+ *
+ * The typed array functions are only called with arrays of the expected
+ * type. This function makes sure that is the case.
+ *
+ * \param[in] array  The array to verify.
+ * \param[in] element_type  The expected type of the items.
+ * \param[in] function  The name of the calling function.
+ */
+void array_verify(binary_variable const * array, array_element_t element_type, char const * function)
+{
+    if(array->f_type != VARIABLE_TYPE_ARRAY)
+    {
+        throw incompatible_type(std::string("array is expected to be an array variable in ") + function + "().");
+    }
+    if(array->f_data == 0
+    || (array->f_flags & (VARIABLE_FLAG_ALLOCATED | VARIABLE_FLAG_ARENA)) == 0)
+    {
+        throw incompatible_type(std::string("array in ") + function + "() is not allocated.");
+    }
+    if(array->f_element_type != element_type)
+    {
+        throw incompatible_type(
+                  std::string("array in ")
+                + function
+                + "() has items of type "
+                + array_element_to_string(array->f_element_type)
+                + " instead of "
+                + array_element_to_string(element_type)
+                + ".");
+    }
+}
+
+
+/** \brief Verify that an index is valid for reading an item.
+ *
+ * \param[in] index  The index to verify.
+ * \param[in] size  The number of items in the array.
+ * \param[in] function  The name of the calling function.
+ */
+void array_verify_index(std::int64_t index, std::size_t size, char const * function)
+{
+    if(index < 0
+    || static_cast<std::size_t>(index) >= size)
+    {
+        // TODO: this needs to be a script throw, not a C++ throw...
+        //
+        throw out_of_range(
+                  "index "
+                + std::to_string(index)
+                + " out of range in "
+                + function
+                + "(), the array has "
+                + std::to_string(size)
+                + " items.");
+    }
 }
 
 
@@ -2326,13 +3750,210 @@ void array_push(binary_variable * array, binary_variable * item)
 #endif
 
     if(array->f_data == 0
-    || (array->f_flags & VARIABLE_FLAG_ALLOCATED) == 0)
+    || (array->f_flags & (VARIABLE_FLAG_ALLOCATED | VARIABLE_FLAG_ARENA)) == 0)
     {
         throw incompatible_type("array in array_push() is not allocated");
     }
 
-    binary_variable::vector_of_pointers_t * v(reinterpret_cast<binary_variable::vector_of_pointers_t *>(array->f_data));
-    v->push_back(item);
+    switch(array->f_element_type)
+    {
+    case ARRAY_ELEMENT_VARIABLE:
+        array_items<binary_variable::vector_of_pointers_t>(array)->push_back(item);
+        return;
+
+    case ARRAY_ELEMENT_INTEGER:
+        if(item->f_type == VARIABLE_TYPE_INTEGER)
+        {
+            array_items<binary_variable::vector_of_integers_t>(array)->push_back(item->f_data);
+            return;
+        }
+        break;
+
+    case ARRAY_ELEMENT_FLOATING_POINT:
+        if(item->f_type == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            std::uint64_t const * value(&item->f_data);
+            array_items<binary_variable::vector_of_floating_points_t>(array)->push_back(*reinterpret_cast<double const *>(value));
+            return;
+        }
+        if(item->f_type == VARIABLE_TYPE_INTEGER)
+        {
+            array_items<binary_variable::vector_of_floating_points_t>(array)->push_back(static_cast<std::int64_t>(item->f_data));
+            return;
+        }
+        break;
+
+    case ARRAY_ELEMENT_BOOLEAN:
+        if(item->f_type == VARIABLE_TYPE_BOOLEAN)
+        {
+            array_items<binary_variable::vector_of_booleans_t>(array)->push_back(item->f_data != 0 ? 1 : 0);
+            return;
+        }
+        break;
+
+    }
+
+    throw incompatible_type(
+              std::string("cannot push an item of type ")
+            + variable_type_to_string(item->f_type)
+            + " to an array of "
+            + array_element_to_string(array->f_element_type)
+            + " in array_push().");
+}
+
+
+std::int64_t array_length(binary_variable const * array)
+{
+    if(array->f_data == 0)
+    {
+        return 0;
+    }
+    return array_size(array);
+}
+
+
+/** \brief Get a pointer to the first item of an array.
+ *
+ * The items of an array are contiguous. This gives the code direct
+ * access to them: an array of integers is an int64_t[], an array of
+ * floating points a double[], an array of booleans a uint8_t[], and
+ * a generic array a binary_variable *[]. Use array_length() to get
+ * the number of items.
+ *
+ * \warning
+ * The pointer becomes invalid as soon as an item gets pushed.
+ *
+ * \param[in] array  The array variable.
+ *
+ * \return A pointer to the first item or nullptr if the array is empty.
+ */
+void * array_data(binary_variable const * array)
+{
+    if(array->f_data == 0)
+    {
+        return nullptr;
+    }
+    switch(array->f_element_type)
+    {
+    case ARRAY_ELEMENT_VARIABLE:
+        return array_items<binary_variable::vector_of_pointers_t>(array)->data();
+
+    case ARRAY_ELEMENT_INTEGER:
+        return array_items<binary_variable::vector_of_integers_t>(array)->data();
+
+    case ARRAY_ELEMENT_FLOATING_POINT:
+        return array_items<binary_variable::vector_of_floating_points_t>(array)->data();
+
+    case ARRAY_ELEMENT_BOOLEAN:
+        return array_items<binary_variable::vector_of_booleans_t>(array)->data();
+
+    }
+    snapdev::NOT_REACHED();
+}
+
+
+void array_push_integer(binary_variable * array, std::int64_t value)
+{
+    array_verify(array, ARRAY_ELEMENT_INTEGER, "array_push_integer");
+    array_items<binary_variable::vector_of_integers_t>(array)->push_back(value);
+}
+
+
+void array_push_floating_point(binary_variable * array, double value)
+{
+    array_verify(array, ARRAY_ELEMENT_FLOATING_POINT, "array_push_floating_point");
+    array_items<binary_variable::vector_of_floating_points_t>(array)->push_back(value);
+}
+
+
+void array_push_boolean(binary_variable * array, bool value)
+{
+    array_verify(array, ARRAY_ELEMENT_BOOLEAN, "array_push_boolean");
+    array_items<binary_variable::vector_of_booleans_t>(array)->push_back(value ? 1 : 0);
+}
+
+
+std::int64_t array_get_integer(binary_variable const * array, std::int64_t index)
+{
+    array_verify(array, ARRAY_ELEMENT_INTEGER, "array_get_integer");
+    binary_variable::vector_of_integers_t const * items(array_items<binary_variable::vector_of_integers_t>(array));
+    array_verify_index(index, items->size(), "array_get_integer");
+    return (*items)[index];
+}
+
+
+double array_get_floating_point(binary_variable const * array, std::int64_t index)
+{
+    array_verify(array, ARRAY_ELEMENT_FLOATING_POINT, "array_get_floating_point");
+    binary_variable::vector_of_floating_points_t const * items(array_items<binary_variable::vector_of_floating_points_t>(array));
+    array_verify_index(index, items->size(), "array_get_floating_point");
+    return (*items)[index];
+}
+
+
+bool array_get_boolean(binary_variable const * array, std::int64_t index)
+{
+    array_verify(array, ARRAY_ELEMENT_BOOLEAN, "array_get_boolean");
+    binary_variable::vector_of_booleans_t const * items(array_items<binary_variable::vector_of_booleans_t>(array));
+    array_verify_index(index, items->size(), "array_get_boolean");
+    return (*items)[index] != 0;
+}
+
+
+/** \brief Set an item of an array of integers.
+ *
+ * As in JavaScript, setting an item past the end of the array enlarges
+ * the array. The new items in between are set to 0.
+ *
+ * \param[in] array  The array to modify.
+ * \param[in] index  The index of the item to set.
+ * \param[in] value  The new value of the item.
+ */
+void array_set_integer(binary_variable * array, std::int64_t index, std::int64_t value)
+{
+    array_verify(array, ARRAY_ELEMENT_INTEGER, "array_set_integer");
+    binary_variable::vector_of_integers_t * items(array_items<binary_variable::vector_of_integers_t>(array));
+    if(index < 0)
+    {
+        throw out_of_range("negative index in array_set_integer().");
+    }
+    if(static_cast<std::size_t>(index) >= items->size())
+    {
+        items->resize(index + 1);
+    }
+    (*items)[index] = value;
+}
+
+
+void array_set_floating_point(binary_variable * array, std::int64_t index, double value)
+{
+    array_verify(array, ARRAY_ELEMENT_FLOATING_POINT, "array_set_floating_point");
+    binary_variable::vector_of_floating_points_t * items(array_items<binary_variable::vector_of_floating_points_t>(array));
+    if(index < 0)
+    {
+        throw out_of_range("negative index in array_set_floating_point().");
+    }
+    if(static_cast<std::size_t>(index) >= items->size())
+    {
+        items->resize(index + 1);
+    }
+    (*items)[index] = value;
+}
+
+
+void array_set_boolean(binary_variable * array, std::int64_t index, bool value)
+{
+    array_verify(array, ARRAY_ELEMENT_BOOLEAN, "array_set_boolean");
+    binary_variable::vector_of_booleans_t * items(array_items<binary_variable::vector_of_booleans_t>(array));
+    if(index < 0)
+    {
+        throw out_of_range("negative index in array_set_boolean().");
+    }
+    if(static_cast<std::size_t>(index) >= items->size())
+    {
+        items->resize(index + 1);
+    }
+    (*items)[index] = value ? 1 : 0;
 }
 
 
@@ -2351,7 +3972,6 @@ typedef std::int64_t (*func_pointer_t)();
 #define EXTERN_FUNCTION_ADD(index, func)    \
     [static_cast<int>(external_function_t::EXTERNAL_FUNCTION_##index)] = \
                                     reinterpret_cast<func_pointer_t>(func)
-typedef func_pointer_t const    extern_functions_t[];
 func_pointer_t const g_extern_functions[] =
 {
     EXTERN_FUNCTION_ADD(MATH_ACOS,                 ::acos),
@@ -2417,10 +4037,75 @@ func_pointer_t const g_extern_functions[] =
     EXTERN_FUNCTION_ADD(ARRAY_INITIALIZE,          array_initialize),
     EXTERN_FUNCTION_ADD(ARRAY_FREE,                array_free),
     EXTERN_FUNCTION_ADD(ARRAY_PUSH,                array_push),
+    EXTERN_FUNCTION_ADD(ARRAY_INITIALIZE_TYPED,    array_initialize_typed),
+    EXTERN_FUNCTION_ADD(ARRAY_LENGTH,              array_length),
+    EXTERN_FUNCTION_ADD(ARRAY_DATA,                array_data),
+    EXTERN_FUNCTION_ADD(ARRAY_PUSH_INTEGER,        array_push_integer),
+    EXTERN_FUNCTION_ADD(ARRAY_PUSH_FLOATING_POINT, array_push_floating_point),
+    EXTERN_FUNCTION_ADD(ARRAY_PUSH_BOOLEAN,        array_push_boolean),
+    EXTERN_FUNCTION_ADD(ARRAY_GET_INTEGER,         array_get_integer),
+    EXTERN_FUNCTION_ADD(ARRAY_GET_FLOATING_POINT,  array_get_floating_point),
+    EXTERN_FUNCTION_ADD(ARRAY_GET_BOOLEAN,         array_get_boolean),
+    EXTERN_FUNCTION_ADD(ARRAY_SET_INTEGER,         array_set_integer),
+    EXTERN_FUNCTION_ADD(ARRAY_SET_FLOATING_POINT,  array_set_floating_point),
+    EXTERN_FUNCTION_ADD(ARRAY_SET_BOOLEAN,         array_set_boolean),
+    EXTERN_FUNCTION_ADD(MATH_RANDOM_BITS,          math_random_bits),
+    EXTERN_FUNCTION_ADD(CPU_FEATURES,              static_cast<std::uintptr_t>(g_cpu_features)),
+    EXTERN_FUNCTION_ADD(STRINGS_HASH,              strings_hash),
 };
 #pragma GCC diagnostic pop
 
 
+/** \brief Compute the magic number of a signed division by a constant.
+ *
+ * A division by a constant \p d can be replaced by a multiplication by
+ * \p magic keeping the high 64 bits of the product, an arithmetic shift
+ * by \p shift, and a few adjustments (see
+ * binary_assembler::generate_divide_by_constant()). This is the
+ * algorithm found in Hacker's Delight, chapter 10.
+ *
+ * \param[in] d  The divisor, its absolute value must be 2 or more.
+ * \param[out] magic  The number to multiply by.
+ * \param[out] shift  The number of bits to shift the high 64 bits by.
+ */
+void signed_division_magic(std::int64_t d, std::int64_t & magic, int & shift)
+{
+    std::uint64_t const two63(1ULL << 63);
+    std::uint64_t const ad(d < 0 ? -static_cast<std::uint64_t>(d) : static_cast<std::uint64_t>(d));
+    std::uint64_t const t(two63 + (static_cast<std::uint64_t>(d) >> 63));
+    std::uint64_t const anc(t - 1 - t % ad);
+    int p(63);
+    std::uint64_t q1(two63 / anc);
+    std::uint64_t r1(two63 - q1 * anc);
+    std::uint64_t q2(two63 / ad);
+    std::uint64_t r2(two63 - q2 * ad);
+    std::uint64_t delta(0);
+    do
+    {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if(r1 >= anc)
+        {
+            ++q1;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if(r2 >= ad)
+        {
+            ++q2;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    }
+    while(q1 < delta || (q1 == delta && r1 == 0));
+
+    magic = static_cast<std::int64_t>(d < 0 ? -(q2 + 1) : q2 + 1);
+    shift = p - 64;
+}
+
+
 
 } // no name namespace
 
@@ -2479,6 +4164,34 @@ char const * variable_type_to_string(variable_type_t t)
 }
 
 
+/** \brief Get the address of an external function.
+ *
+ * This is the address the loader saves in the slot of \p func in the
+ * external function table of a running_file. It can be used to call
+ * a runtime function directly (i.e. from a test).
+ *
+ * \exception out_of_range
+ * The \p func parameter is not one of the external functions.
+ *
+ * \param[in] func  The external function to get.
+ *
+ * \return The address of the function (or the CPU features for
+ * EXTERNAL_FUNCTION_CPU_FEATURES).
+ */
+std::uint64_t get_extern_function(external_function_t func)
+{
+    std::size_t const idx(static_cast<std::size_t>(func));
+    if(idx >= std::size(g_extern_functions))
+    {
+        throw out_of_range(
+                  "unknown external function "
+                + std::to_string(static_cast<int>(func))
+                + ".");
+    }
+    return reinterpret_cast<std::uint64_t>(g_extern_functions[idx]);
+}
+
+
 
 
 temporary_variable::temporary_variable(
@@ -2532,6 +4245,37 @@ void temporary_variable::adjust_offset(ssize_t const offset)
 }
 
 
+/** \brief Keep this temporary in a register.
+ *
+ * The register allocator calls this function when the temporary can
+ * live in a register for its entire lifetime. The stack slot remains
+ * reserved so the value can be spilled when an instruction requires
+ * a memory operand.
+ *
+ * Integer temporaries use a general purpose register and Double
+ * temporaries use an XMM register.
+ *
+ * \param[in] reg  The register holding this temporary.
+ */
+void temporary_variable::set_register(register_t reg)
+{
+    f_register = reg;
+    f_has_register = true;
+}
+
+
+bool temporary_variable::has_register() const
+{
+    return f_has_register;
+}
+
+
+register_t temporary_variable::get_register() const
+{
+    return f_register;
+}
+
+
 
 
 
@@ -2585,6 +4329,24 @@ void relocation::adjust_offset(int offset)
 }
 
 
+void relocation::set_relocation(relocation_t type)
+{
+    f_relocation = type;
+}
+
+
+void relocation::set_position(offset_t position)
+{
+    f_position = position;
+}
+
+
+void relocation::set_offset(offset_t offset)
+{
+    f_offset = offset;
+}
+
+
 
 
 
@@ -3005,6 +4767,31 @@ void build_file::add_constant(double const value, std::string & /*out*/ name)
 }
 
 
+/** \brief Reserve a slot for an external function.
+ *
+ * The image includes a table with one slot per external function it
+ * calls. In the file, each slot holds the external_function_t number of
+ * the function. The loader replaces that number with the address of the
+ * function so the code can call it with `CALL *disp32(%rip)`.
+ *
+ * The \p name returned is used with a RELOCATION_EXTERN_FUNCTION.
+ *
+ * \param[in] func  The external function to call.
+ * \param[out] name  The name of the slot.
+ */
+void build_file::add_extern_function(external_function_t func, std::string & /*out*/ name)
+{
+    name = "%extern";
+    name += std::to_string(static_cast<int>(func));
+    auto it(f_extern_function_offsets.find(name));
+    if(it == f_extern_function_offsets.end())
+    {
+        f_extern_function_offsets[name] = f_extern_functions.size() * sizeof(std::uint64_t);
+        f_extern_functions.push_back(static_cast<std::uint64_t>(func));
+    }
+}
+
+
 void build_file::add_constant(std::string const value, std::string & /*out*/ name)
 {
     // TODO: constant strings should be accessible directly, we have two
@@ -3254,6 +5041,13 @@ offset_t build_file::get_current_text_offset() const
 
 void build_file::add_text(std::uint8_t const * text, std::size_t size)
 {
+    // the peephole optimizer only works on complete blocks so remember
+    // where each one starts
+    //
+    if(size != 0)
+    {
+        f_instructions.push_back(f_text.size());
+    }
     f_text.insert(f_text.end(), text, text + size);
 }
 
@@ -3270,23 +5064,55 @@ void build_file::adjust_relocation_offset(int offset)
 }
 
 
+/** \brief Save the binary file to a stream.
+ *
+ * This function finalizes the image (see finalize()) and writes it
+ * to \p out.
+ *
+ * \param[in] out  The output stream.
+ */
 void build_file::save(base_stream::pointer_t out)
 {
+    std::vector<std::uint8_t> image(finalize());
+    save(image.data());
+    out->write_bytes(reinterpret_cast<char const *>(image.data()), image.size());
+}
+
+
+/** \brief Finalize the image.
+ *
+ * This function runs the peephole optimizer, computes the offset of
+ * each section, applies the relocations, and sets up the header.
+ * It must be called exactly once, before save().
+ *
+ * \return The size of the binary file in bytes.
+ */
+std::size_t build_file::finalize()
+{
+    peephole();
+
     // compute offsets / rellocations
     //
     f_text_offset = sizeof(binary_header);
 
-    // note: f_text and each run-time function added are already aligned to
+    // note: f_text and each run-time function added were aligned to
     //       a multiple of 8 bytes (see the generate_align8() call after the
-    //       frame restoration) so no need to adjust here
+    //       frame restoration) but the peephole optimizer may have removed
+    //       bytes since; nothing requires that alignment, the data starts
+    //       on a page boundary anyway
     //
-    f_data_offset = sizeof(binary_header)
-                  + f_text.size();
-                  //+ f_rt_functions.size();
+    // the data has to start on its own page so the loader can protect
+    // the header & text as read/execute and the data as read/write
+    //
+    f_data_offset = (sizeof(binary_header)
+                        + f_text.size()
+                        //+ f_rt_functions.size()
+                        + BINARY_PAGE_SIZE - 1) & -BINARY_PAGE_SIZE;
 
     // save the data types with the largest alignment requirements first
     //
-    f_string_private_offset = f_data_offset + f_extern_variables.size() * sizeof(binary_variable);
+    f_extern_functions_offset = f_data_offset + f_extern_variables.size() * sizeof(binary_variable);
+    f_string_private_offset = f_extern_functions_offset + f_extern_functions.size() * sizeof(std::uint64_t);
     f_number_private_offset = f_string_private_offset + f_string_private.size();
     f_bool_private_offset = f_number_private_offset + f_number_private.size();
     f_strings_offset = f_bool_private_offset + f_bool_private.size();
@@ -3339,16 +5165,15 @@ void build_file::save(base_stream::pointer_t out)
                 {
                     extra_offset = offsetof(binary_variable, f_data_size);
                 }
-                offset_t offset(it->f_data_size <= sizeof(it->f_data)
-                        ? f_data_offset
-                            + sizeof(binary_variable) * (it - f_extern_variables.begin())
-                            + extra_offset
-                            - f_text_offset
-                        : it->f_data);
-
-                // subtract position of rip at the time this offset is used
+
+                // extern variables are accessed through %rbx which points
+                // to the array of variables of the running context so the
+                // offset is relative to the start of that array (it does
+                // not depend on %rip)
                 //
-                offset -= r.get_offset();
+                offset_t const offset(
+                              sizeof(binary_variable) * (it - f_extern_variables.begin())
+                            + extra_offset);
 
                 // save the result in f_text
                 //
@@ -3471,19 +5296,81 @@ void build_file::save(base_stream::pointer_t out)
             }
             break;
 
+        case relocation_t::RELOCATION_LABEL_8BITS:
+            {
+                auto it(f_label_offsets.find(r.get_name()));
+                if(it == f_label_offsets.end())
+                {
+                    throw internal_error(
+                              "could not find label for relocation named \""
+                            + r.get_name()
+                            + "\".");
+                }
+
+                std::int64_t const offset(static_cast<std::int64_t>(it->second) - r.get_offset());
+                if(offset < -128 || offset > 127)
+                {
+                    throw internal_error(
+                              "short jump to label \""
+                            + r.get_name()
+                            + "\" is out of range.");
+                }
+
+                f_text[r.get_position()] = static_cast<std::uint8_t>(offset);
+            }
+            break;
+
+        case relocation_t::RELOCATION_EXTERN_FUNCTION:
+            {
+                auto it(f_extern_function_offsets.find(r.get_name()));
+                if(it == f_extern_function_offsets.end())
+                {
+                    throw internal_error(
+                              "could not find external function for relocation named \""
+                            + r.get_name()
+                            + "\".");
+                }
+
+                offset_t const offset(f_extern_functions_offset
+                                        - f_text_offset
+                                        + it->second
+                                        - r.get_offset());
+
+                // save the result in f_text
+                //
+                offset_t const idx(r.get_position());
+                f_text[idx + 0] = offset >>  0;
+                f_text[idx + 1] = offset >>  8;
+                f_text[idx + 2] = offset >> 16;
+                f_text[idx + 3] = offset >> 24;
+            }
+            break;
+
         default:
             throw not_implemented("this relocation type is not yet implemented.");
 
         }
     }
 
+    // the data of long strings is saved as an offset relative to the
+    // variable itself so the loader does not have to patch the image
+    //
     for(std::size_t idx(0); idx < f_extern_variables.size(); ++idx)
     {
-        if(f_extern_variables[idx].f_name_size > sizeof(f_extern_variables[0].f_name))
+        binary_variable * var(f_extern_variables.data() + idx);
+        if(var->f_name_size > sizeof(var->f_name))
         {
             // relocate from start of file
             //
-            f_extern_variables[idx].f_name += f_strings_offset;
+            var->f_name += f_strings_offset;
+        }
+        if(var->f_type == VARIABLE_TYPE_STRING
+        && var->f_data_size > sizeof(var->f_data))
+        {
+            var->f_data = var->f_data
+                        + f_strings_offset
+                        - (f_data_offset + idx * sizeof(binary_variable));
+            var->f_flags |= VARIABLE_FLAG_RELATIVE;
         }
     }
 
@@ -3498,9 +5385,10 @@ void build_file::save(base_stream::pointer_t out)
         }
         if(var->f_data_size > sizeof(var->f_data))
         {
-            // relocate from start of file
-            //
-            var->f_data += f_strings_offset;
+            var->f_data = var->f_data
+                        + f_strings_offset
+                        - (f_string_private_offset + offset);
+            var->f_flags |= VARIABLE_FLAG_RELATIVE;
         }
     }
 
@@ -3510,45 +5398,57 @@ void build_file::save(base_stream::pointer_t out)
     f_header.f_private_variable_count = f_private_variable_offsets.size();
     f_header.f_variables = f_data_offset; // variables are saved first
     f_header.f_start = f_text_offset;
+    f_header.f_extern_functions = f_extern_functions_offset;
+    f_header.f_extern_function_count = f_extern_functions.size();
     f_header.f_file_size = ((f_after_strings_offset + 3) & -4) + sizeof(char) * 4;
-    out->write_bytes(reinterpret_cast<char const *>(&f_header), sizeof(f_header));
+
+    return f_header.f_file_size;
+}
+
+
+/** \brief Copy the finalized image to memory.
+ *
+ * This function writes the binary file as is to \p image. It is used
+ * to save the file and by running_file::load() to create the image
+ * directly in page aligned memory, without going through a file.
+ *
+ * \param[out] image  A buffer of at least the size returned by finalize().
+ */
+void build_file::save(std::uint8_t * image) const
+{
+    memcpy(image, &f_header, sizeof(f_header));
 
     // .text (i.e. binary code we want to execute)
     //
-    out->write_bytes(
-              reinterpret_cast<char const *>(f_text.data())
-            , f_text.size());
-    //out->write_bytes(
-    //          reinterpret_cast<char const *>(f_rt_functions.data())
-    //        , f_rt_functions.size());
+    memcpy(image + f_text_offset, f_text.data(), f_text.size());
+
+    // pad the last page of .text with INT3 instructions
+    //
+    memset(
+          image + f_text_offset + f_text.size()
+        , 0xCC
+        , f_data_offset - f_text_offset - f_text.size());
 
     // .data
     //
-    out->write_bytes(
-              reinterpret_cast<char const *>(f_extern_variables.data())
-            , f_extern_variables.size() * sizeof(binary_variable));
-    out->write_bytes(
-              reinterpret_cast<char const *>(f_string_private.data())
-            , f_string_private.size());
-    out->write_bytes(
-              reinterpret_cast<char const *>(f_number_private.data())
-            , f_number_private.size());
-    out->write_bytes(
-              reinterpret_cast<char const *>(f_bool_private.data())
-            , f_bool_private.size());
-    out->write_bytes(
-              reinterpret_cast<char const *>(f_strings.data())
-            , f_strings.size());
+    memcpy(
+          image + f_data_offset
+        , f_extern_variables.data()
+        , f_extern_variables.size() * sizeof(binary_variable));
+    memcpy(
+          image + f_extern_functions_offset
+        , f_extern_functions.data()
+        , f_extern_functions.size() * sizeof(std::uint64_t));
+    memcpy(image + f_string_private_offset, f_string_private.data(), f_string_private.size());
+    memcpy(image + f_number_private_offset, f_number_private.data(), f_number_private.size());
+    memcpy(image + f_bool_private_offset, f_bool_private.data(), f_bool_private.size());
+    memcpy(image + f_strings_offset, f_strings.data(), f_strings.size());
 
     // clearly mark the end of the file aligned to 4 bytes
     //
-    offset_t const adjust(4 - (f_after_strings_offset & 3));
-    if(adjust != 4)
-    {
-        char buf[4] = {};
-        out->write_bytes(buf, adjust);
-    }
-    out->write_bytes(g_end_magic, 4);;
+    offset_t const end((f_after_strings_offset + 3) & -4);
+    memset(image + f_after_strings_offset, 0, end - f_after_strings_offset);
+    memcpy(image + end, g_end_magic, 4);
 }
 
 
@@ -3652,550 +5552,341 @@ temporary_variable * build_file::find_temporary_variable(std::string const & nam
 
 
 
-running_file::running_file()
+namespace
 {
-}
-
 
-running_file::~running_file()
-{
-    clean();
-}
 
 
-void running_file::clean()
+/** \brief Save a string in a string variable.
+ *
+ * This function releases the existing string, if allocated, and then
+ * saves a copy of \p value in \p v.
+ *
+ * \param[in,out] v  The variable receiving the string.
+ * \param[in] value  The new value of the variable.
+ */
+void set_string_variable(binary_variable * v, std::string_view const & value)
 {
-    if(f_file != nullptr)
+    if((v->f_flags & VARIABLE_FLAG_ALLOCATED) != 0
+    && v->f_data != reinterpret_cast<std::uint64_t>(nullptr))
     {
-        // first free variables that were allocated
+        // use intermediate pointer to avoid the strict aliasing issue
         //
-        for(std::size_t idx(0); idx < f_header->f_variable_count; ++idx)
+        std::uint64_t * data_ptr(&v->f_data);
+        free(*reinterpret_cast<void **>(data_ptr));
+        v->f_flags &= ~VARIABLE_FLAG_ALLOCATED;
+    }
+    v->f_data_size = value.length();
+    if(v->f_data_size <= sizeof(v->f_data))
+    {
+        memcpy(&v->f_data, value.data(), v->f_data_size);
+    }
+    else
+    {
+        void * str(malloc(value.length()));
+        if(str == nullptr)
         {
-            binary_variable * v(f_variables + idx);
-            if(v->f_type == VARIABLE_TYPE_STRING
-            && (v->f_flags & VARIABLE_FLAG_ALLOCATED) != 0)
-            {
-                free(reinterpret_cast<void *>(v->f_data));
-            }
+            throw std::bad_alloc();
         }
-
-        free(f_file);
+        v->f_data = reinterpret_cast<std::uint64_t>(str);
+        memcpy(str, value.data(), value.length());
+        v->f_flags |= VARIABLE_FLAG_ALLOCATED;
     }
-
-    // the other pointers points inside f_file, nothing to free
-    // however, we still want to clear the values
-    //
-    f_size = 0;
-    f_file = nullptr;
-    f_header = nullptr;
-    f_variables = nullptr;
-    f_text = nullptr;
-    f_protected = false;
 }
 
 
-bool running_file::load(std::string const & filename)
+void get_result(binary_variable const * v, bool & value)
 {
-    clean();
+    value = v->f_data != 0;
+}
 
-    as2js::input_stream<std::ifstream>::pointer_t in(std::make_shared<as2js::input_stream<std::ifstream>>());
-    in->get_position().set_filename(filename);
-    in->open(filename);
-    if(!in->is_open())
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "could not open binary file \""
-            << filename
-            << "\".";
-        throw cannot_open_file(msg.str());
-    }
-    return load(in);
+
+void get_result(binary_variable const * v, std::int64_t & value)
+{
+    value = v->f_data;
 }
 
 
-bool running_file::load(base_stream::pointer_t in)
+void get_result(binary_variable const * v, double & value)
 {
-    clean();
+    std::uint64_t const * ptr(&v->f_data);
+    value = *reinterpret_cast<double const *>(ptr);
+}
 
-    binary_header header;
-    ssize_t size(in->read_bytes(reinterpret_cast<char *>(&header), sizeof(header)));
-    if(size != sizeof(header))
+
+void get_result(binary_variable const * v, std::string & value)
+{
+    if(v->f_data_size <= sizeof(v->f_data))
     {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, in->get_position());
-        msg << "could not read header.";
-        return false;
+        value.assign(reinterpret_cast<char const *>(&v->f_data), v->f_data_size);
     }
-
-    long const sc_page_size(sysconf(_SC_PAGESIZE));
-    f_size = (header.f_file_size + sc_page_size - 1) & -sc_page_size;
-    if(posix_memalign(
-          reinterpret_cast<void **>(&f_file)
-        , sc_page_size
-        , f_size) != 0)
+    else
     {
-        throw std::bad_alloc();
+        value.assign(long_string_data(v), v->f_data_size);
     }
+}
 
-    memcpy(f_file, &header, sizeof(header));
 
-    size = header.f_file_size - sizeof(header);
-    if(in->read_bytes(reinterpret_cast<char *>(f_file + sizeof(header)), size) != size)
-    {
-        free(f_file);
-        f_file = nullptr;
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, in->get_position());
-        msg << "could not read text and variables from binary file (size: "
-            << size
-            << ").";
-        return false;
-    }
 
-    f_header = reinterpret_cast<binary_header *>(f_file);
-    f_text = reinterpret_cast<std::uint8_t *>(f_header + 1);
-    f_variables = reinterpret_cast<binary_variable *>(f_file + f_header->f_variables);
+} // no name namespace
 
-    // variable data need to be relocated
-    //
-    // Note: at the moment the f_text buffer is using %rip to access data
-    //       so there is no need for relocation in the code
-    //
-    std::size_t const var_count(f_header->f_variable_count + f_header->f_private_variable_count);
-    for(std::uint16_t idx(0); idx < var_count; ++idx)
-    {
-// the name is 32 bit and thus does not support a full pointer
-//        if(f_variables[idx].f_name_size > sizeof(f_variables[idx].f_name))
-//        {
-//            f_variables[idx].f_name += reinterpret_cast<std::uint64_t>(f_file);
-//        }
-        if(f_variables[idx].f_data_size > sizeof(f_variables[idx].f_data))
-        {
-            f_variables[idx].f_data += reinterpret_cast<std::uint64_t>(f_file);
-        }
-    }
 
-    return true;
-}
 
 
-/** \brief Save the file buffer to disk.
- *
- * This is expected to be used only to debug the processes.
- *
- * Here is an example saving the file to "c.out":
+
+
+
+
+/** \brief Initialize a variable handle.
  *
- * \code
- * std::cerr << "--- save to c.out now...\n";
- * system("pwd");
- * const_cast<running_file *>(this)->save("c.out");
- * \endcode
+ * A handle is the index of a variable in the variable table of a
+ * running_file. Use running_file::get_handle() to retrieve a valid
+ * handle. The default handle (index -1) is not valid.
  *
- * \param[in] filename  The name of the file to save to.
+ * \param[in] index  The index of the variable.
  */
-void running_file::save(std::string const & filename)
+variable_handle::variable_handle(int index)
+    : f_index(index)
 {
-    std::ofstream out;
-    out.open(filename);
-    if(!out.is_open())
-    {
-        std::cerr << "error: could not open output file \""
-            << filename
-            << "\".\n";
-        return;
-    }
-
-    out.write(reinterpret_cast<char const *>(f_file), f_size);
 }
 
 
-versiontheca::versiontheca::pointer_t running_file::get_version() const
+bool variable_handle::is_valid() const
 {
-    versiontheca::basic::pointer_t t(std::make_shared<versiontheca::basic>());
-    versiontheca::versiontheca::pointer_t version(std::make_shared<versiontheca::versiontheca>(t));
-    if(f_file != nullptr)
-    {
-        version->set_major(f_header->f_version_major);
-        version->set_minor(f_header->f_version_minor);
-    }
-
-    return version;
+    return f_index >= 0;
 }
 
 
-binary_variable * running_file::find_variable(std::string const & name) const
+int variable_handle::get_index() const
 {
-    if(f_variables == nullptr)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "no variables defined, running_file::load() was not called or failed.";
-        throw invalid_data(msg.str());
-    }
-    auto it(std::lower_bound(
-              f_variables
-            , f_variables + f_header->f_variable_count
-            , name
-            , [&](binary_variable const & v, std::string const & n)
-            {
-                char const * s(v.f_name_size <= sizeof(v.f_name)
-                    ? reinterpret_cast<char const *>(&v.f_name)
-                    : reinterpret_cast<char const *>(f_file + v.f_name));
-                return std::string(s, v.f_name_size) < n;
-            }));
-    bool found(it != f_variables + f_header->f_variable_count);
-    if(found)
-    {
-        // lower bound returns the "next variable" if the exact variable
-        // does not exist, so here we have to make sure we've got the
-        // actual variable and not the next one
-        //
-        char const * s(it->f_name_size <= sizeof(it->f_name)
-            ? reinterpret_cast<char const *>(&it->f_name)
-            : reinterpret_cast<char const *>(f_file + it->f_name));
-        found = std::string(s, it->f_name_size) == name;
-    }
-    if(!found)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "could not find variable \""
-            << name
-            << "\".";
-        throw invalid_data(msg.str());
-    }
-    return it;
+    return f_index;
 }
 
 
-bool running_file::has_variable(std::string const & name) const
-{
-    if(f_variables == nullptr)
-    {
-        return false;
-    }
-    auto it(std::lower_bound(
-              f_variables
-            , f_variables + f_header->f_variable_count
-            , name
-            , [&](binary_variable const & v, std::string const & n)
-            {
-                char const * s(v.f_name_size <= sizeof(v.f_name)
-                    ? reinterpret_cast<char const *>(&v.f_name)
-                    : reinterpret_cast<char const *>(f_file + v.f_name));
-                return std::string(s, v.f_name_size) < n;
-            }));
-    if(it == f_variables + f_header->f_variable_count)
-    {
-        return false;
-    }
 
-    char const * s(it->f_name_size <= sizeof(it->f_name)
-        ? reinterpret_cast<char const *>(&it->f_name)
-        : reinterpret_cast<char const *>(f_file + it->f_name));
-    return std::string(s, it->f_name_size) == name;
-}
 
 
-void running_file::set_variable(std::string const & name, bool value)
+
+
+
+/** \brief Initialize a random generator with a random seed.
+ *
+ * The seed comes from std::random_device so each generator produces a
+ * different sequence. Use seed() to get a reproducible sequence.
+ */
+random_generator::random_generator()
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_BOOLEAN)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to set variable \""
-            << name
-            << "\" to a boolean value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    v->f_data_size = sizeof(value);
-    v->f_data = static_cast<std::int64_t>(value);
+    std::random_device rd;
+    seed((static_cast<std::uint64_t>(rd()) << 32) ^ rd());
 }
 
 
-void running_file::get_variable(std::string const & name, bool & value) const
+random_generator::random_generator(std::uint64_t seed)
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_BOOLEAN)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to get variable \""
-            << name
-            << "\" as a boolean value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    if(v->f_data_size != sizeof(value))
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
-        msg << "variable \""
-            << name
-            << "\" is not set as expected (size: "
-            << v->f_data_size
-            << ").";
-        throw incompatible_type(msg.str());
-    }
-    value = static_cast<bool>(v->f_data);
+    random_generator::seed(seed);
 }
 
 
-void running_file::set_variable(std::string const & name, std::int64_t value)
+/** \brief Reset the state of the generator.
+ *
+ * The 256 bits of state are computed from \p seed using splitmix64 so
+ * any seed, including 0, gives a valid state. The same seed always
+ * produces the same sequence of numbers.
+ *
+ * \param[in] seed  The seed of the new sequence.
+ */
+void random_generator::seed(std::uint64_t seed)
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_INTEGER)
+    for(auto & s : f_state)
     {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to set variable \""
-            << name
-            << "\" to an integer value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
+        seed += 0x9E3779B97F4A7C15ULL;
+        std::uint64_t z(seed);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        s = z ^ (z >> 31);
     }
-    v->f_data_size = sizeof(value);
-    v->f_data = value;
 }
 
 
-void running_file::get_variable(std::string const & name, std::int64_t & value) const
+/** \brief Get the next 64 bits number.
+ *
+ * This is the xoshiro256** generator. It is much faster than the
+ * std::mt19937 and its state is only 32 bytes.
+ *
+ * \return The next number of the sequence.
+ */
+std::uint64_t random_generator::next()
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_INTEGER)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to get variable \""
-            << name
-            << "\" as an integer value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    if(v->f_data_size != sizeof(value))
+    auto rotl = [](std::uint64_t x, int k)
     {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
-        msg << "variable \""
-            << name
-            << "\" is not set as expected (size: "
-            << v->f_data_size
-            << ").";
-        throw incompatible_type(msg.str());
-    }
-    value = v->f_data;
+        return (x << k) | (x >> (64 - k));
+    };
+
+    std::uint64_t const result(rotl(f_state[1] * 5, 7) * 9);
+    std::uint64_t const t(f_state[1] << 17);
+
+    f_state[2] ^= f_state[0];
+    f_state[3] ^= f_state[1];
+    f_state[1] ^= f_state[2];
+    f_state[0] ^= f_state[3];
+    f_state[2] ^= t;
+    f_state[3] = rotl(f_state[3], 45);
+
+    return result;
 }
 
 
-void running_file::set_variable(std::string const & name, double value)
+/** \brief Get the next number as a double in [0.0, 1.0).
+ *
+ * The top 52 bits of the next number become the mantissa of a double
+ * in [1.0, 2.0) and 1.0 gets subtracted. The code generated for
+ * Math.random() does the same inline.
+ *
+ * \return A double in [0.0, 1.0).
+ */
+double random_generator::next_double()
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_FLOATING_POINT)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to set variable \""
-            << name
-            << "\" to a double value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    v->f_data_size = sizeof(value);
-    double const * value_ptr(&value);
-    v->f_data = *reinterpret_cast<std::uint64_t const *>(value_ptr);
+    std::uint64_t const bits((next() >> 12) | 0x3FF0000000000000ULL);
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result - 1.0;
 }
 
 
-void running_file::get_variable(std::string const & name, double & value) const
-{
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_FLOATING_POINT)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to get variable \""
-            << name
-            << "\" as a floating point value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    if(v->f_data_size != sizeof(value))
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
-        msg << "variable \""
-            << name
-            << "\" is not set as expected (size: "
-            << v->f_data_size
-            << ").";
-        throw incompatible_type(msg.str());
-    }
 
-    // use intermediate pointer to avoid the strict aliasing issue
-    //
-    std::uint64_t const * data_ptr(&v->f_data);
-    value = *reinterpret_cast<double const *>(data_ptr);
+
+
+
+
+
+/** \brief Initialize an arena.
+ *
+ * The arena allocates memory by blocks of \p block_size bytes. The
+ * first block is allocated on the first call to allocate().
+ *
+ * \param[in] block_size  The size of one block of memory.
+ */
+execution_arena::execution_arena(std::size_t block_size)
+    : f_block_size(block_size)
+{
 }
 
 
-void running_file::set_variable(std::string const & name, std::string const & value)
+execution_arena::~execution_arena()
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_STRING)
+    for(auto const & b : f_blocks)
     {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to set variable \""
-            << name
-            << "\" to a string value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    if((v->f_flags & VARIABLE_FLAG_ALLOCATED) != 0
-    && v->f_data != reinterpret_cast<std::uint64_t>(nullptr))
-    {
-        // use intermediate pointer to avoid the strict aliasing issue
-        //
-        std::uint64_t * data_ptr(&v->f_data);
-        free(*reinterpret_cast<void **>(data_ptr));
-        v->f_flags &= ~VARIABLE_FLAG_ALLOCATED;
-    }
-    v->f_data_size = value.length();
-    if(v->f_data_size <= sizeof(v->f_data))
-    {
-        memcpy(&v->f_data, value.c_str(), v->f_data_size);
-    }
-    else
-    {
-        void * str(malloc(value.length()));
-        v->f_data = reinterpret_cast<std::uint64_t>(str);
-        memcpy(str, value.c_str(), value.length());
-        v->f_flags |= VARIABLE_FLAG_ALLOCATED;
+        free(b.f_buffer);
     }
 }
 
 
-void running_file::get_variable(std::string const & name, std::string & value) const
+/** \brief Release all the allocations at once.
+ *
+ * The blocks are kept so the next run does not have to allocate them
+ * again. Resetting the arena is O(1) whatever the number of allocations
+ * made since the last reset.
+ *
+ * \warning
+ * Any pointer returned by allocate() becomes invalid.
+ */
+void execution_arena::reset()
 {
-    binary_variable * v(find_variable(name));
-    if(v->f_type != VARIABLE_TYPE_STRING)
-    {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
-        msg << "trying to get variable \""
-            << name
-            << "\" as a string value when the variable is of type: \""
-            << variable_type_to_string(v->f_type)
-            << "\".";
-        throw incompatible_type(msg.str());
-    }
-    if(v->f_data_size <= sizeof(v->f_data))
-    {
-        value = std::string(reinterpret_cast<char const *>(&v->f_data), v->f_data_size);
-    }
-    else if((v->f_flags & VARIABLE_FLAG_ALLOCATED) != 0)
+    f_current = 0;
+    f_used = 0;
+    if(f_blocks.empty())
     {
-        value = std::string(reinterpret_cast<char const *>(v->f_data), v->f_data_size);
+        f_pos = nullptr;
+        f_end = nullptr;
     }
     else
     {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
-        msg << "string variable named \""
-            << name
-            << "\" is not small ("
-            << v->f_data_size
-            << ") and not allocated.";
-        throw incompatible_type(msg.str());
+        f_pos = f_blocks[0].f_buffer;
+        f_end = f_pos + f_blocks[0].f_size;
     }
 }
 
 
-std::size_t running_file::variable_size() const
+/** \brief Number of bytes allocated since the last reset.
+ *
+ * This includes the padding added for alignment and the unused bytes
+ * at the end of the blocks that were skipped.
+ *
+ * \return The number of bytes used in this arena.
+ */
+std::size_t execution_arena::get_used() const
 {
-    if(f_header == nullptr)
+    if(f_blocks.empty())
     {
-        throw invalid_data("running_file has no data.");
+        return 0;
     }
-    return f_header->f_variable_count;
+    return f_used + (f_pos - f_blocks[f_current].f_buffer);
 }
 
 
-binary_variable * running_file::get_variable(int index, std::string & name) const
+std::size_t execution_arena::get_capacity() const
 {
-    name.clear();
-    if(index < 0)
-    {
-        throw out_of_range("running_file::get_variable() called with a negative index.");
-    }
-    if(f_header == nullptr)
-    {
-        throw invalid_data("running_file has no data.");
-    }
-    if(index >= f_header->f_variable_count)
+    std::size_t capacity(0);
+    for(auto const & b : f_blocks)
     {
-        return nullptr;
+        capacity += b.f_size;
     }
-    binary_variable * v(f_variables + index);
-    char const * s(v->f_name_size <= sizeof(v->f_name)
-                    ? reinterpret_cast<char const *>(&v->f_name)
-                    : reinterpret_cast<char const *>(f_file + v->f_name));
-    name = std::string(s, v->f_name_size);
-    return v;
+    return capacity;
 }
 
 
-void running_file::run(binary_result & result)
+void * execution_arena::do_allocate(std::size_t bytes, std::size_t alignment)
 {
-    if(f_header == nullptr)
+    for(;;)
     {
-        throw invalid_data("running_file has no data.");
-    }
+        std::uint8_t * ptr(reinterpret_cast<std::uint8_t *>(
+                (reinterpret_cast<std::uintptr_t>(f_pos) + alignment - 1) & -alignment));
+        if(f_pos != nullptr
+        && ptr + bytes <= f_end)
+        {
+            f_pos = ptr + bytes;
+            return ptr;
+        }
 
-    if(!f_protected)
-    {
-        // TODO: consider placing variables on the following 4K page
-        //       so we can remove PROT_WRITE here
+        // move on to the next block, allocate a new one if none are
+        // available or the next one is too small
         //
-        int const r(mprotect(f_file, f_size, PROT_READ | PROT_WRITE | PROT_EXEC));
-        if(r != 0)
+        std::size_t next(f_blocks.empty() ? 0 : f_current + 1);
+        if(next >= f_blocks.size()
+        || f_blocks[next].f_size < bytes + alignment)
+        {
+            block b;
+            b.f_size = std::max(f_block_size, bytes + alignment);
+            b.f_buffer = static_cast<std::uint8_t *>(malloc(b.f_size));
+            if(b.f_buffer == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            f_blocks.insert(f_blocks.begin() + next, b);
+        }
+        if(!f_blocks.empty()
+        && next > 0)
         {
-            throw execution_error("the file could not be protected for execution.");
+            f_used += f_blocks[f_current].f_size;
         }
-        f_protected = true;
+        f_current = next;
+        f_pos = f_blocks[f_current].f_buffer;
+        f_end = f_pos + f_blocks[f_current].f_size;
     }
-    binary_variable * var(find_variable("%result"));
+}
 
-std::cerr << "--- run with return type: " << static_cast<int>(f_header->f_return_type) << "\n";
-    typedef void (*entry_point)(extern_functions_t);
-    reinterpret_cast<entry_point>(f_text)(g_extern_functions);
 
-    switch(f_header->f_return_type)
-    {
-    case VARIABLE_TYPE_BOOLEAN:
-        result.set_boolean(var->f_data != 0);
-        break;
+void execution_arena::do_deallocate(void * p, std::size_t bytes, std::size_t alignment)
+{
+    // memory gets released by reset()
+    //
+    snapdev::NOT_USED(p, bytes, alignment);
+}
 
-    case VARIABLE_TYPE_INTEGER:
-        result.set_integer(var->f_data);
-        break;
 
-    case VARIABLE_TYPE_FLOATING_POINT:
-        {
-            std::uint64_t * ptr(&var->f_data);
-            result.set_floating_point(*reinterpret_cast<double *>(ptr));
-        }
-        break;
-
-    case VARIABLE_TYPE_STRING:
-        if(var->f_data_size <= sizeof(var->f_data))
-        {
-            result.set_string(std::string(reinterpret_cast<char const *>(&var->f_data), var->f_data_size));
-        }
-        else
-        {
-            result.set_string(std::string(reinterpret_cast<char const *>(var->f_data), var->f_data_size));
-        }
-        break;
-
-    default:
-        result.set_type(VARIABLE_TYPE_UNKNOWN);
-        break;
-
-    }
+bool execution_arena::do_is_equal(std::pmr::memory_resource const & other) const noexcept
+{
+    return this == &other;
 }
 
 
@@ -4205,4718 +5896,8600 @@ std::cerr << "--- run with return type: " << static_cast<int>(f_header->f_return
 
 
 
-void binary_result::set_type(variable_type_t type)
+/** \brief Initialize an execution context.
+ *
+ * An execution context holds a copy of the extern variables of a
+ * running_file. The code found in the running_file accesses these
+ * variables through a pointer to that copy (passed in %rdi on entry
+ * and kept in %rbx while running) so the loaded image itself is never
+ * modified by a call to run(). This means one running_file can be
+ * executed by any number of threads simultaneously as long as each
+ * thread uses its own execution context.
+ *
+ * The variables are initialized with the default values found in the
+ * running_file.
+ *
+ * \warning
+ * The context keeps a bare pointer to the running_file. That file must
+ * remain loaded for as long as the context is in use.
+ *
+ * \param[in] file  The running_file this context is attached to.
+ */
+execution_context::execution_context(running_file const * file)
+    : f_running_file(file)
 {
-    f_type = type;
+    reset();
 }
 
 
-variable_type_t binary_result::get_type() const
+execution_context::~execution_context()
 {
-    return f_type;
+    free_variables();
 }
 
 
-void binary_result::set_boolean(bool value)
+void execution_context::free_variables()
 {
-    f_type = VARIABLE_TYPE_BOOLEAN;
-    f_value[0] = static_cast<std::uint64_t>(value);
+    for(auto & v : f_variables)
+    {
+        if((v.f_flags & VARIABLE_FLAG_ALLOCATED) == 0)
+        {
+            continue;
+        }
+        switch(v.f_type)
+        {
+        case VARIABLE_TYPE_STRING:
+            strings_free(&v);
+            break;
+
+        case VARIABLE_TYPE_ARRAY:
+            array_free(&v);
+            break;
+
+        default:
+            break;
+
+        }
+    }
+    f_variables.clear();
 }
 
 
-bool binary_result::get_boolean() const
+/** \brief Reset the variables to their default values.
+ *
+ * This function frees the strings allocated by the previous runs and
+ * then copies the default values from the running_file to this context.
+ */
+void execution_context::reset()
 {
-    return static_cast<bool>(f_value[0]);
+    free_variables();
+
+    if(f_running_file != nullptr)
+    {
+        binary_variable const * defaults(f_running_file->get_default_variables());
+        if(defaults != nullptr)
+        {
+            f_variables.assign(defaults, defaults + f_running_file->variable_size());
+
+            // the copy lives elsewhere so relative offsets become pointers
+            //
+            for(std::size_t idx(0); idx < f_variables.size(); ++idx)
+            {
+                binary_variable & v(f_variables[idx]);
+                if((v.f_flags & VARIABLE_FLAG_RELATIVE) != 0)
+                {
+                    v.f_data = reinterpret_cast<std::uint64_t>(long_string_data(defaults + idx));
+                    v.f_flags &= ~VARIABLE_FLAG_RELATIVE;
+                }
+            }
+        }
+    }
 }
 
 
-void binary_result::set_integer(std::int64_t value)
+running_file const * execution_context::get_running_file() const
 {
-    f_type = VARIABLE_TYPE_INTEGER;
-    f_value[0] = value;
+    return f_running_file;
 }
 
 
-std::int64_t binary_result::get_integer() const
+binary_variable * execution_context::get_variables()
 {
-    return f_value[0];
+    return f_variables.data();
 }
 
 
-void binary_result::set_floating_point(double value)
+/** \brief The arena used by the runtime functions.
+ *
+ * While the code runs, the strings and arrays created by the runtime
+ * functions are allocated in this arena.
+ *
+ * \return A reference to the arena of this context.
+ */
+execution_arena & execution_context::get_arena()
 {
-    f_type = VARIABLE_TYPE_FLOATING_POINT;
-
-    // use intermediate pointer to avoid the strict aliasing issue
-    //
-    double const * value_ptr(&value);
-    f_value[0] = *reinterpret_cast<std::uint64_t const *>(value_ptr);
+    return f_arena;
 }
 
 
-double binary_result::get_floating_point() const
+/** \brief Get the random generator used by Math.random().
+ *
+ * Each context has its own generator so contexts used by different
+ * threads do not share any state.
+ *
+ * \return A reference to the random generator of this context.
+ */
+random_generator & execution_context::get_random_generator()
 {
-    std::uint64_t const * value_ptr(f_value + 0);
-    return *reinterpret_cast<double const *>(value_ptr);
+    return f_random_generator;
 }
 
 
-void binary_result::set_string(std::string const & value)
+/** \brief Seed the random generator of this context.
+ *
+ * By default the generator is seeded with a random number. Setting the
+ * seed makes the numbers returned by Math.random() reproducible.
+ *
+ * \param[in] seed  The new seed.
+ */
+void execution_context::set_random_seed(std::uint64_t seed)
 {
-    f_type = VARIABLE_TYPE_STRING;
-    f_string = value;
+    f_random_generator.seed(seed);
 }
 
 
-std::string binary_result::get_string() const
+/** \brief Make a context the one used by the runtime functions.
+ *
+ * The runtime functions allocate their buffers in the arena of the
+ * context and Math.random() uses its generator. The previous context
+ * of the thread is restored when the scope gets destroyed.
+ *
+ * \param[in] context  The context to use.
+ */
+context_scope::context_scope(execution_context & context)
+    : f_previous_arena(g_arena)
+    , f_previous_generator(g_random_generator)
 {
-    return f_string;
+    g_arena = &context.get_arena();
+    g_random_generator = &context.get_random_generator();
 }
 
 
+context_scope::~context_scope()
+{
+    g_arena = f_previous_arena;
+    g_random_generator = f_previous_generator;
+}
 
 
+/** \brief Release the memory allocated during a run.
+ *
+ * This function is called at the end of each run. The extern variables
+ * which still point to a buffer in the arena are copied to the heap so
+ * their values survive the run. Then the whole arena is reset at once.
+ *
+ * The cost of this function depends on the number of extern variables,
+ * not on the number of temporaries the script created.
+ */
+void execution_context::release_arena()
+{
+    bool failed(false);
+    for(auto & v : f_variables)
+    {
+        if((v.f_flags & VARIABLE_FLAG_ARENA) == 0)
+        {
+            continue;
+        }
+        v.f_flags &= ~VARIABLE_FLAG_ARENA;
 
+        switch(v.f_type)
+        {
+        case VARIABLE_TYPE_STRING:
+            {
+                void * str(malloc(v.f_data_size));
+                if(str == nullptr)
+                {
+                    v.f_data = 0;
+                    v.f_data_size = 0;
+                    failed = true;
+                    break;
+                }
+                memcpy(str, reinterpret_cast<void const *>(v.f_data), v.f_data_size);
+                v.f_data = reinterpret_cast<std::uint64_t>(str);
+                v.f_flags |= VARIABLE_FLAG_ALLOCATED;
+            }
+            break;
 
+        case VARIABLE_TYPE_ARRAY:
+            {
+                switch(v.f_element_type)
+                {
+                case ARRAY_ELEMENT_VARIABLE:
+                    // the items may live in the arena too, copy them
+                    //
+                    v.f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_pointers_t>(&v));
+                    v.f_flags |= VARIABLE_FLAG_OWNED;
+                    break;
 
+                case ARRAY_ELEMENT_INTEGER:
+                    v.f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_integers_t>(&v));
+                    break;
 
+                case ARRAY_ELEMENT_FLOATING_POINT:
+                    v.f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_floating_points_t>(&v));
+                    break;
 
+                case ARRAY_ELEMENT_BOOLEAN:
+                    v.f_data = reinterpret_cast<std::uint64_t>(array_heap_copy<binary_variable::vector_of_booleans_t>(&v));
+                    break;
 
+                }
+                v.f_flags |= VARIABLE_FLAG_ALLOCATED;
+            }
+            break;
 
+        default:
+            v.f_data = 0;
+            v.f_data_size = 0;
+            break;
 
+        }
+    }
 
+    f_arena.reset();
 
-
-binary_assembler::binary_assembler(
-          base_stream::pointer_t output
-        , options::pointer_t o
-        , compiler::pointer_t c)
-    : f_output(output)
-    , f_options(o)
-    , f_compiler(c)
-{
-    //if(!rt_functions_oar.empty())
-    //{
-    //    f_rt_functions_oar = rt_functions_oar;
-    //}
+    if(failed)
+    {
+        throw std::bad_alloc();
+    }
 }
 
 
-base_stream::pointer_t binary_assembler::get_output()
+binary_variable * execution_context::find_variable(std::string const & name) const
 {
-    return f_output;
+    if(f_running_file == nullptr
+    || f_running_file->get_default_variables() == nullptr)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "no variables defined, running_file::load() was not called or failed.";
+        throw invalid_data(msg.str());
+    }
+    return f_variables.data() + f_running_file->get_handle(name).get_index();
 }
 
 
-options::pointer_t binary_assembler::get_options()
+bool execution_context::has_variable(std::string const & name) const
 {
-    return f_options;
+    if(f_running_file == nullptr)
+    {
+        return false;
+    }
+    return f_running_file->find_variable_index(name) >= 0;
 }
 
 
-int binary_assembler::output(node::pointer_t root)
-{
-    int const save_errcnt(error_count());
-
-std::cerr << "----- start flattening...\n";
-    flatten_nodes::pointer_t fn(flatten(root, f_compiler));
-std::cerr << "----- end flattening... (";
-if(fn == nullptr)
-{
-std::cerr << "<nullptr>";
-}
-else
+/** \brief Get a handle to a variable.
+ *
+ * The handle can be used with the set() and get() functions to access
+ * the variable without having to search for it each time. The handle
+ * is valid for the running_file that created it and all of its
+ * execution contexts.
+ *
+ * \exception invalid_data
+ * This exception is raised if the variable does not exist.
+ *
+ * \param[in] name  The name of the variable.
+ *
+ * \return The handle to the variable.
+ */
+variable_handle execution_context::get_handle(std::string_view const & name) const
 {
-std::cerr << fn->get_operations().size();
-}
-std::cerr << ")\n";
-
-    if(fn != nullptr)
+    if(f_running_file == nullptr)
     {
-        // generate binary output
-        //
-std::cerr << "----- start generating... (" << fn->get_operations().size() << ")\n";
-        generate_amd64_code(fn);
-std::cerr << "----- end generating... (" << fn->get_operations().size() << ")\n";
-
-        // it worked, save the results
-        //
-std::cerr << "----- start saving... (" << fn->get_operations().size() << ")\n";
-        f_file.save(f_output);
-std::cerr << "----- end saving... (" << fn->get_operations().size() << ")\n";
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "no variables defined, running_file::load() was not called or failed.";
+        throw invalid_data(msg.str());
     }
-
-    return error_count() - save_errcnt;
+    return f_running_file->get_handle(name);
 }
 
 
-variable_type_t binary_assembler::get_type_of_node(node::pointer_t n)
+binary_variable * execution_context::get_handle_variable(
+      variable_handle const & handle
+    , variable_type_t type
+    , char const * verb
+    , char const * what) const
 {
-    node::pointer_t type_node(n->get_type_node());
-    if(type_node == nullptr)
+    if(static_cast<std::size_t>(handle.get_index()) >= f_variables.size())
     {
-        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_INVALID_TYPE, n->get_position());
-        msg << "no type found for node of type: \""
-            << n->get_type_name()
-            << "\".";
-        throw internal_error(msg.str());
+        throw out_of_range("execution_context used with an invalid variable handle.");
     }
-
-    if(type_node->get_type() != node_t::NODE_CLASS
-    || !type_node->get_attribute(attribute_t::NODE_ATTR_NATIVE))
+    binary_variable * v(f_variables.data() + handle.get_index());
+    if(v->f_type != type)
     {
-        return VARIABLE_TYPE_UNKNOWN;
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "trying to "
+            << verb
+            << " variable \""
+            << f_running_file->get_variable_name(handle.get_index())
+            << "\" "
+            << what
+            << " value when the variable is of type: \""
+            << variable_type_to_string(v->f_type)
+            << "\".";
+        throw incompatible_type(msg.str());
     }
-    std::string const & type_name(type_node->get_string());
+    return v;
+}
 
-    if(type_name == "Boolean")
-    {
-        return VARIABLE_TYPE_BOOLEAN;
-    }
 
-    if(type_name == "Integer" || type_name == "CompareResult")
-    {
-        return VARIABLE_TYPE_INTEGER;
-    }
+void execution_context::set(variable_handle const & handle, bool value)
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_BOOLEAN, "set", "to a boolean"));
+    v->f_data_size = sizeof(value);
+    v->f_data = static_cast<std::int64_t>(value);
+}
 
-    if(type_name == "Double" || type_name == "Number")
-    {
-        return VARIABLE_TYPE_FLOATING_POINT;
-    }
 
-    if(type_name == "String")
+void execution_context::get(variable_handle const & handle, bool & value) const
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_BOOLEAN, "get", "as a boolean"));
+    if(v->f_data_size != sizeof(value))
     {
-        return VARIABLE_TYPE_STRING;
+        invalid_size(handle, v);
     }
+    value = static_cast<bool>(v->f_data);
+}
 
-    if(type_name == "Range")
+
+void execution_context::set(variable_handle const & handle, std::int64_t value)
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_INTEGER, "set", "to an integer"));
+    v->f_data_size = sizeof(value);
+    v->f_data = value;
+}
+
+
+void execution_context::get(variable_handle const & handle, std::int64_t & value) const
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_INTEGER, "get", "as an integer"));
+    if(v->f_data_size != sizeof(value))
     {
-        return VARIABLE_TYPE_RANGE;
+        invalid_size(handle, v);
     }
+    value = v->f_data;
+}
 
-    return VARIABLE_TYPE_UNKNOWN;
+
+void execution_context::set(variable_handle const & handle, double value)
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_FLOATING_POINT, "set", "to a double"));
+    v->f_data_size = sizeof(value);
+    double const * value_ptr(&value);
+    v->f_data = *reinterpret_cast<std::uint64_t const *>(value_ptr);
 }
 
 
-void binary_assembler::generate_amd64_code(flatten_nodes::pointer_t fn)
+void execution_context::get(variable_handle const & handle, double & value) const
 {
-    if(fn->get_operations().empty())
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_FLOATING_POINT, "get", "as a floating point"));
+    if(v->f_data_size != sizeof(value))
     {
-        throw out_of_range("the code in generate_amd64_code() expects a non-empty set of operations.");
+        invalid_size(handle, v);
     }
 
-    // clear the existing file
+    // use intermediate pointer to avoid the strict aliasing issue
     //
-    f_file = {};
+    std::uint64_t const * data_ptr(&v->f_data);
+    value = *reinterpret_cast<double const *>(data_ptr);
+}
 
-    // on entry setup rsp & rbp
-    //
-    std::uint8_t setup_frame[] = {
-        0x55,           // PUSH %rbp
-
-        0x48,           // MOV %rsp, %rbp
-        0x89,
-        0xE5,
-    };
-    f_file.add_text(setup_frame, sizeof(setup_frame));
 
-    // we do not have a node for the pointer to the external function table,
-    // so create one here -- it will get added automatically since it is
-    // part of the temporary table
-    //
-    // WARNING: the type node inside the node object is a weak pointer
-    //          so we need to keep a hold of it in this function
-    //
-    // TODO: we can optimize this out if no function gets called
-    //
-    node::pointer_t type_class(std::make_shared<node>(node_t::NODE_CLASS));
-    type_class->set_string("Integer");
-    type_class->set_attribute(attribute_t::NODE_ATTR_NATIVE, true);
-    {
-        node::pointer_t var(std::make_shared<node>(node_t::NODE_VARIABLE));
-        var->set_flag(flag_t::NODE_VARIABLE_FLAG_TEMPORARY, true);
-        var->set_string("%extern_functions");
+void execution_context::set(variable_handle const & handle, std::string_view const & value)
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_STRING, "set", "to a string"));
+    set_string_variable(v, value);
+}
 
-        // TODO: call "resolve_internal_type()" instead...
-        //
-        var->set_type_node(type_class); // weak pointer
 
-        f_extern_functions = std::make_shared<data>(var);
-        fn->add_variable(f_extern_functions);
-    }
+void execution_context::get(variable_handle const & handle, std::string & value) const
+{
+    std::string_view view;
+    get(handle, view);
+    value.assign(view);
+}
 
-//for(auto const & it : fn->get_operations())
-//{
-//std::cerr << "  --  " << it->to_string() << "\n";
-//}
 
-    for(auto const & it : fn->get_variables())
+/** \brief Get a string variable without copying it.
+ *
+ * The returned view points to the buffer of the variable in this
+ * context. It remains valid until the next run with this context or
+ * until the variable is modified, whichever happens first.
+ *
+ * \param[in] handle  The handle of the string variable.
+ * \param[out] value  The view receiving the string.
+ */
+void execution_context::get(variable_handle const & handle, std::string_view & value) const
+{
+    binary_variable * v(get_handle_variable(handle, VARIABLE_TYPE_STRING, "get", "as a string"));
+    if(v->f_data_size <= sizeof(v->f_data))
     {
-        if(it.second->is_temporary())
-        {
-            // at this point, a temporary variable does not have a value,
-            // only a type and a name; temporaries automatically have a
-            // STORE before a LOAD
-            //
-            f_file.add_temporary_variable(it.first, it.second);
-        }
-        else if(it.second->is_extern())
-        {
-            f_file.add_extern_variable(it.first, it.second);
-        }
-        else
-        {
-            f_file.add_private_variable(it.first, it.second);
-        }
+        value = std::string_view(reinterpret_cast<char const *>(&v->f_data), v->f_data_size);
     }
-
-    f_file.adjust_temporary_offset_1byte();
-
-    for(auto & it : fn->get_data())
+    else if((v->f_flags & VARIABLE_FLAG_ALLOCATED) != 0)
     {
-        std::string name;
-        switch(it->get_data_type())
-        {
-        case node_t::NODE_FLOATING_POINT:
-            f_file.add_constant(it->get_floating_point().get(), name);
-            break;
+        value = std::string_view(reinterpret_cast<char const *>(v->f_data), v->f_data_size);
+    }
+    else
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
+        msg << "string variable named \""
+            << f_running_file->get_variable_name(handle.get_index())
+            << "\" is not small ("
+            << v->f_data_size
+            << ") and not allocated.";
+        throw incompatible_type(msg.str());
+    }
+}
 
-        case node_t::NODE_STRING:
-            f_file.add_constant(it->get_string(), name);
-            break;
 
-        default:
-            throw not_implemented("trying to add a constant with a data type which is not yet implemented.");
+void execution_context::invalid_size(variable_handle const & handle, binary_variable const * v) const
+{
+    message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
+    msg << "variable \""
+        << f_running_file->get_variable_name(handle.get_index())
+        << "\" is not set as expected (size: "
+        << v->f_data_size
+        << ").";
+    throw incompatible_type(msg.str());
+}
 
-        }
-        it->set_data_name(name);
-    }
 
-    offset_t temp_size(f_file.get_size_of_temporary_variables());
+void execution_context::set_variable(std::string const & name, bool value)
+{
+    set(get_handle(name), value);
+}
 
-    if(temp_size > 0)
-    {
-        // we need to reserve the space for our temporary variables
-        //
-        // WARNING: the stack must be properly aligned to 16 bytes when
-        //          calling a function (not considering the function pointer
-        //          that is pushed by the CALL instruction, which gets fixed
-        //          by the `PUSH %rbp` anyway)
-        //
-        temp_size = (temp_size + 15) & -16;
-        if(temp_size < 128)
-        {
-            std::uint8_t buf[] = { // SUB imm7, %rsp
-                0x48,
-                0x83,
-                0xEC,
-                static_cast<std::uint8_t>(temp_size),
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-        else
-        {
-            std::uint8_t buf[] = { // SUB imm32, %rsp
-                0x48,
-                0x81,
-                0xEC,
-                static_cast<std::uint8_t>(temp_size >>  0),
-                static_cast<std::uint8_t>(temp_size >>  8),
-                static_cast<std::uint8_t>(temp_size >> 16),
-                static_cast<std::uint8_t>(temp_size >> 24),
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-    }
 
-    generate_store_integer(f_extern_functions, register_t::REGISTER_RDI);
+void execution_context::get_variable(std::string const & name, bool & value) const
+{
+    get(get_handle(name), value);
+}
 
-    // the temporary strings need to be initialized
-    //
-    for(auto const & it : fn->get_variables())
-    {
-        if(it.second->is_temporary()
-        && !it.second->no_init())
-        {
-            // at this point, a temporary variable does not have a value,
-            // only a type and a name; temporaries automatically have a
-            // STORE before a LOAD
-            //
-            //generate_reg_mem_string(<...>, register_t::REGISTER_RSI);
-            temporary_variable * temp_var(f_file.find_temporary_variable(it.first));
-            if(temp_var == nullptr)
-            {
-                throw internal_error("temporary not found in generate_amd64_code()");
-            }
-            // TODO: transform in a switch once we have other types than string
-            if(temp_var->get_type() != node_t::NODE_STRING)
-            {
-                continue;
-            }
-            generate_pointer_to_temporary(temp_var, register_t::REGISTER_RDI);
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_INITIALIZE);
-        }
-    }
 
-    for(auto const & it : fn->get_operations())
-    {
-std::cerr << "  ++  " << it->to_string() << "\n";
-        switch(it->get_operation())
-        {
-        case node_t::NODE_ABSOLUTE_VALUE:
-            generate_absolute_value(it);
-            break;
+void execution_context::set_variable(std::string const & name, std::int64_t value)
+{
+    set(get_handle(name), value);
+}
 
-        case node_t::NODE_ACOS:
-        case node_t::NODE_ACOSH:
-        case node_t::NODE_ASIN:
-        case node_t::NODE_ASINH:
-        case node_t::NODE_ATAN:
-        case node_t::NODE_ATANH:
-        case node_t::NODE_CBRT:
-        case node_t::NODE_CEIL:
-        case node_t::NODE_COS:
-        case node_t::NODE_COSH:
-        case node_t::NODE_EXP:
-        case node_t::NODE_EXPM1:
-        case node_t::NODE_FLOOR:
-        case node_t::NODE_FROUND:
-        case node_t::NODE_LOG:
-        case node_t::NODE_LOG1P:
-        case node_t::NODE_LOG10:
-        case node_t::NODE_LOG2:
-        case node_t::NODE_ROUND:
-        case node_t::NODE_SIN:
-        case node_t::NODE_SINH:
-        case node_t::NODE_SQRT:
-        case node_t::NODE_TAN:
-        case node_t::NODE_TANH:
-        case node_t::NODE_TRUNC:
-            generate_math_function(it);
-            break;
 
-        case node_t::NODE_ADD:
-        case node_t::NODE_ASSIGNMENT_ADD:
-        case node_t::NODE_ASSIGNMENT_SUBTRACT:
-        case node_t::NODE_SUBTRACT:
-            generate_additive(it);
-            break;
+void execution_context::get_variable(std::string const & name, std::int64_t & value) const
+{
+    get(get_handle(name), value);
+}
 
-        case node_t::NODE_ALMOST_EQUAL:
-        case node_t::NODE_COMPARE:
-        case node_t::NODE_EQUAL:
-        case node_t::NODE_LESS:
-        case node_t::NODE_LESS_EQUAL:
-        case node_t::NODE_GREATER:
-        case node_t::NODE_GREATER_EQUAL:
-        case node_t::NODE_NOT_EQUAL:
-        case node_t::NODE_SMART_MATCH:
-        case node_t::NODE_STRICTLY_EQUAL:
-        case node_t::NODE_STRICTLY_NOT_EQUAL:
-            generate_compare(it);
-            break;
 
-        case node_t::NODE_ARRAY:
-            generate_array(it);
-            break;
+void execution_context::set_variable(std::string const & name, double value)
+{
+    set(get_handle(name), value);
+}
 
-        case node_t::NODE_ASSIGNMENT:
-            generate_assignment(it);
-            break;
 
-        case node_t::NODE_ASSIGNMENT_LOGICAL_AND:
-        case node_t::NODE_LOGICAL_AND:
-        case node_t::NODE_ASSIGNMENT_LOGICAL_OR:
-        case node_t::NODE_LOGICAL_OR:
-        case node_t::NODE_ASSIGNMENT_LOGICAL_XOR:
-        case node_t::NODE_LOGICAL_XOR:
-            generate_logical(it);
-            break;
+void execution_context::get_variable(std::string const & name, double & value) const
+{
+    get(get_handle(name), value);
+}
 
-        case node_t::NODE_ASSIGNMENT_BITWISE_AND:
-        case node_t::NODE_ASSIGNMENT_BITWISE_OR:
-        case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
-        case node_t::NODE_BITWISE_AND:
-        case node_t::NODE_BITWISE_OR:
-        case node_t::NODE_BITWISE_XOR:
-            generate_bitwise(it);
-            break;
 
-        case node_t::NODE_ASSIGNMENT_DIVIDE:
-        case node_t::NODE_ASSIGNMENT_MODULO:
-        case node_t::NODE_DIVIDE:
-        case node_t::NODE_MODULO:
-            generate_divide(it);
-            break;
+void execution_context::set_variable(std::string const & name, std::string const & value)
+{
+    set(get_handle(name), std::string_view(value));
+}
 
-        case node_t::NODE_ASSIGNMENT_MAXIMUM:
-        case node_t::NODE_ASSIGNMENT_MINIMUM:
-        case node_t::NODE_MAXIMUM:
-        case node_t::NODE_MINIMUM:
-            generate_minmax(it);
-            break;
 
-        case node_t::NODE_HYPOT:
-            generate_hypot(it);
-            break;
+void execution_context::get_variable(std::string const & name, std::string & value) const
+{
+    get(get_handle(name), value);
+}
 
-        case node_t::NODE_ASSIGNMENT_MULTIPLY:
-        case node_t::NODE_MULTIPLY:
-            generate_multiply(it);
-            break;
 
-        case node_t::NODE_ATAN2:
-            generate_atan2(it);
-            break;
+void execution_context::get_variable(std::string const & name, std::string_view & value) const
+{
+    get(get_handle(name), value);
+}
 
-        case node_t::NODE_IMUL:
-            generate_imul(it);
-            break;
 
-        case node_t::NODE_SIGN:
-            generate_sign(it);
-            break;
+std::size_t execution_context::variable_size() const
+{
+    return f_variables.size();
+}
 
-        case node_t::NODE_ASSIGNMENT_POWER:
-        case node_t::NODE_POWER:
-            generate_power(it);
-            break;
 
-        case node_t::NODE_ASSIGNMENT_ROTATE_LEFT:
-        case node_t::NODE_ASSIGNMENT_ROTATE_RIGHT:
-        case node_t::NODE_ASSIGNMENT_SHIFT_LEFT:
-        case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT:
-        case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT_UNSIGNED:
-        case node_t::NODE_ROTATE_LEFT:
-        case node_t::NODE_ROTATE_RIGHT:
-        case node_t::NODE_SHIFT_LEFT:
-        case node_t::NODE_SHIFT_RIGHT:
-        case node_t::NODE_SHIFT_RIGHT_UNSIGNED:
-            generate_shift(it);
-            break;
+binary_variable * execution_context::get_variable(int index, std::string & name) const
+{
+    name.clear();
+    if(index < 0)
+    {
+        throw out_of_range("execution_context::get_variable() called with a negative index.");
+    }
+    if(f_running_file == nullptr)
+    {
+        throw invalid_data("execution_context is not attached to a running_file.");
+    }
+    if(static_cast<std::size_t>(index) >= f_variables.size())
+    {
+        return nullptr;
+    }
+    name = f_running_file->get_variable_name(index);
+    return f_variables.data() + index;
+}
 
-        case node_t::NODE_BITWISE_NOT:
-            generate_bitwise_not(it);
-            break;
 
-        case node_t::NODE_CALL:
-            generate_call(it);
-            break;
 
-        case node_t::NODE_CLZ32:
-            generate_clz32(it);
-            break;
 
-        case node_t::NODE_DECREMENT:
-        case node_t::NODE_INCREMENT:
-        case node_t::NODE_POST_DECREMENT:
-        case node_t::NODE_POST_INCREMENT:
-            generate_increment(it);
-            break;
 
-        case node_t::NODE_GOTO:
-            generate_goto(it);
-            break;
 
-        case node_t::NODE_IF_FALSE:
-        case node_t::NODE_IF_TRUE:
-            generate_if(it);
-            break;
 
-        case node_t::NODE_IDENTITY:
-            generate_identity(it);
-            break;
 
-        case node_t::NODE_LABEL:
-            generate_label(it);
-            break;
+running_file::running_file()
+{
+}
 
-        case node_t::NODE_LIST:
-            generate_list(it);
-            break;
 
-        case node_t::NODE_LOGICAL_NOT:
-            generate_logical_not(it);
-            break;
+running_file::~running_file()
+{
+    clean();
+}
 
-        case node_t::NODE_NEGATE:
-            generate_negate(it);
-            break;
 
-        case node_t::NODE_PARAM:
-            generate_param(it);
-            break;
+void running_file::clean()
+{
+    // the default context may have allocated strings, release them
+    // before the image goes away
+    //
+    f_context.reset();
 
-        case node_t::NODE_RANDOM:
-            generate_random(it);
-            break;
+    if(f_file != nullptr)
+    {
+        if(f_mapped)
+        {
+            munmap(f_file, f_size);
+        }
+        else
+        {
+            // free() may write to the buffer so make sure all the pages
+            // are writable again
+            //
+            mprotect(f_file, f_size, PROT_READ | PROT_WRITE);
+            free(f_file);
+        }
+    }
 
-        default:
-            throw not_implemented(
-                  std::string("operation ")
-                + node::type_to_string(it->get_operation())
-                + " is not yet implemented.");
+    // the other pointers points inside f_file, nothing to free
+    // however, we still want to clear the values
+    //
+    f_size = 0;
+    f_file = nullptr;
+    f_header = nullptr;
+    f_variables = nullptr;
+    f_text = nullptr;
+    f_mapped = false;
+}
 
-        }
+
+bool running_file::load(std::string const & filename)
+{
+    clean();
+
+    as2js::input_stream<std::ifstream>::pointer_t in(std::make_shared<as2js::input_stream<std::ifstream>>());
+    in->get_position().set_filename(filename);
+    in->open(filename);
+    if(!in->is_open())
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "could not open binary file \""
+            << filename
+            << "\".";
+        throw cannot_open_file(msg.str());
     }
+    return load(in);
+}
+
+
+bool running_file::load(base_stream::pointer_t in)
+{
+    clean();
 
+    binary_header header;
+    ssize_t size(in->read_bytes(reinterpret_cast<char *>(&header), sizeof(header)));
+    if(size != sizeof(header))
     {
-        auto const & it(fn->get_operations().back());
-        node::pointer_t n(it->get_node());
-        node::pointer_t t(n->get_type_node());
-        if(t != nullptr)
-        {
-            f_file.set_return_type(get_type_of_node(n));
-        }
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, in->get_position());
+        msg << "could not read header.";
+        return false;
+    }
+    if(!check_header(header, in->get_position()))
+    {
+        return false;
     }
 
-    // the temporary strings need to be freed
-    //
-int vcount(0);
-    for(auto const & it : fn->get_variables())
+    long const sc_page_size(sysconf(_SC_PAGESIZE));
+    f_size = (header.f_file_size + sc_page_size - 1) & -sc_page_size;
+    if(posix_memalign(
+          reinterpret_cast<void **>(&f_file)
+        , sc_page_size
+        , f_size) != 0)
     {
-        if(it.second->is_temporary()
-        && !it.second->no_init())
-        {
-            // at this point, a temporary variable does not have a value,
-            // only a type and a name; temporaries automatically have a
-            // STORE before a LOAD
-            //
-            //generate_reg_mem_string(<...>, register_t::REGISTER_RSI);
-            temporary_variable * temp_var(f_file.find_temporary_variable(it.first));
-            if(temp_var == nullptr)
-            {
-                throw internal_error("temporary not found in generate_amd64_code()");
-            }
-            // TODO: transform in a switch once we have other types than string
-            if(temp_var->get_type() != node_t::NODE_STRING)
-            {
-                continue;
-            }
-            generate_pointer_to_temporary(temp_var, register_t::REGISTER_RDI);
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_FREE);
-std::cerr << "--- free var #" << vcount << " named \"" << temp_var->get_name() << "\".\n";
-++vcount;
-        }
+        throw std::bad_alloc();
     }
 
-    // on exit, restore frame and return
-    //
-    if(temp_size > 0)
+    memcpy(f_file, &header, sizeof(header));
+
+    size = header.f_file_size - sizeof(header);
+    if(in->read_bytes(reinterpret_cast<char *>(f_file + sizeof(header)), size) != size)
     {
-        // we need to restore the stack pointer first
-        //
-        if(temp_size < 128)
-        {
-            std::uint8_t buf[] = {   // ADD $imm8, %rsp
-                0x48,
-                0x83,
-                0xC4,
-                static_cast<std::uint8_t>(temp_size),
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-        else
-        {
-            std::uint8_t buf[] = {   // ADD $imm32, %rsp
-                0x48,
-                0x81,
-                0xC4,
-                static_cast<std::uint8_t>(temp_size >>  0),
-                static_cast<std::uint8_t>(temp_size >>  8),
-                static_cast<std::uint8_t>(temp_size >> 16),
-                static_cast<std::uint8_t>(temp_size >> 24),
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+        free(f_file);
+        f_file = nullptr;
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, in->get_position());
+        msg << "could not read text and variables from binary file (size: "
+            << size
+            << ").";
+        return false;
     }
-    std::uint8_t restore_frame[] = {  // POP %rbp  &  RET
-        0x5D,
-        0xC3,
-    };
-    f_file.add_text(restore_frame, sizeof(restore_frame));
 
-    generate_align8();
+    return setup_image(in->get_position(), PROT_READ | PROT_WRITE);
 }
 
 
-void binary_assembler::generate_align8()
+/** \brief Load the image generated by a binary_assembler.
+ *
+ * This function is similar to load() except that the image is copied
+ * from the \p file being built instead of being read from a stream.
+ * The code is emitted directly in page aligned memory which then gets
+ * protected for execution, so a script compiled at runtime does not
+ * go through a file. See compile_script().
+ *
+ * \param[in] file  The file built by the binary_assembler. It gets
+ * finalized by this call.
+ *
+ * \return true if the image is ready to run.
+ */
+bool running_file::load(build_file & file)
 {
-    switch(f_file.get_current_text_offset() & 7)
+    clean();
+
+    std::size_t const file_size(file.finalize());
+
+    long const sc_page_size(sysconf(_SC_PAGESIZE));
+    f_size = (file_size + sc_page_size - 1) & -sc_page_size;
+    if(posix_memalign(
+          reinterpret_cast<void **>(&f_file)
+        , sc_page_size
+        , f_size) != 0)
     {
-    case 0:
-        // already aligned
-        break;
+        throw std::bad_alloc();
+    }
 
-    case 8 - 1:
-        {
-            std::uint8_t nop[] = {
-                0x90,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
+    file.save(f_file);
 
-    case 8 - 2:
-        {
-            std::uint8_t nop[] = {
-                0x66,
-                0x90,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
+    return setup_image(position(), PROT_READ | PROT_WRITE);
+}
 
-    case 8 - 3:
-        {
-            std::uint8_t nop[] = {
-                0x0F,
-                0x1F,
-                0x00,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
 
-    case 8 - 4:
-        {
-            std::uint8_t nop[] = {
-                0x0F,
-                0x1F,
-                0x40,
-                0x00,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
+/** \brief Map a binary file in memory.
+ *
+ * This function is similar to load() except that it uses mmap() to
+ * access the file instead of reading it in a buffer. The image is not
+ * otherwise modified (the variables live in an execution_context and
+ * the data of long strings is saved as an offset relative to its
+ * variable) so, except for the page holding the external function
+ * table, all the pages remain clean and are shared with the page cache
+ * and with all the other processes mapping the same file.
+ *
+ * \param[in] filename  The name of the binary file to map.
+ *
+ * \return true if the file was mapped successfully.
+ */
+bool running_file::map(std::string const & filename)
+{
+    clean();
 
-    case 8 - 5:
-        {
-            std::uint8_t nop[] = {
-                0x0F,
-                0x1F,
-                0x44,
-                0x00,
-                0x00,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
+    position pos;
+    pos.set_filename(filename);
 
-    case 8 - 6:
-        {
-            std::uint8_t nop[] = {
-                0x66,
-                0x0F,
-                0x1F,
-                0x44,
-                0x00,
-                0x00,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
+    int const fd(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if(fd < 0)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "could not open binary file \""
+            << filename
+            << "\".";
+        throw cannot_open_file(msg.str());
+    }
 
-    case 8 - 7:
-        {
-            std::uint8_t nop[] = {
-                0x0F,
-                0x1F,
-                0x80,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-            };
-            f_file.add_text(nop, sizeof(nop));
-        }
-        break;
+    struct stat st;
+    if(fstat(fd, &st) != 0
+    || static_cast<std::size_t>(st.st_size) < sizeof(binary_header))
+    {
+        close(fd);
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, pos);
+        msg << "could not read header.";
+        return false;
+    }
 
+    void * ptr(mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if(ptr == MAP_FAILED)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, pos);
+        msg << "could not map binary file in memory.";
+        return false;
     }
-}
+    f_file = static_cast<std::uint8_t *>(ptr);
+    f_size = st.st_size;
+    f_mapped = true;
 
+    binary_header const * header(reinterpret_cast<binary_header const *>(f_file));
+    if(!check_header(*header, pos))
+    {
+        clean();
+        return false;
+    }
+    if(header->f_file_size > f_size)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND, pos);
+        msg << "binary file is too small (size: "
+            << f_size
+            << ", expected: "
+            << header->f_file_size
+            << ").";
+        clean();
+        return false;
+    }
 
+    // the .data is never written to, keep it read-only
+    //
+    return setup_image(pos, PROT_READ);
+}
 
 
-void binary_assembler::generate_reg_mem_integer(data::pointer_t d, register_t const reg, std::uint8_t code, int adjust_offset)
+bool running_file::check_header(binary_header const & header, position const & pos)
 {
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
+    if(header.f_magic[0] != BINARY_MAGIC_B0
+    || header.f_magic[1] != BINARY_MAGIC_B1
+    || header.f_magic[2] != BINARY_MAGIC_B2
+    || header.f_magic[3] != BINARY_MAGIC_B3)
     {
-    case node_t::NODE_INTEGER: // immediate integer
-        {
-            std::int64_t const value(d->get_node()->get_integer().get());
-            switch(get_smallest_size(value))
-            {
-            case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
-            case integer_size_t::INTEGER_SIZE_64BITS:
-                {
-                    std::uint8_t buf[] = {   // REX.W MOV $imm64, %rn
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        static_cast<std::uint8_t>(0xB8 | (static_cast<int>(reg) & 7)),
-                        static_cast<std::uint8_t>(value >>  0),
-                        static_cast<std::uint8_t>(value >>  8),
-                        static_cast<std::uint8_t>(value >> 16),
-                        static_cast<std::uint8_t>(value >> 24),
-                        static_cast<std::uint8_t>(value >> 32),
-                        static_cast<std::uint8_t>(value >> 40),
-                        static_cast<std::uint8_t>(value >> 48),
-                        static_cast<std::uint8_t>(value >> 56),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-                break;
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, pos);
+        msg << "this is not an as2js binary file (invalid magic).";
+        return false;
+    }
 
-            default:
-                // in 64bit the sign extend works with 32 bits so all others
-                // can make use of the 32 bit value
-                //
-                // on the other hand, the 16 & 8 bit immediate do not get
-                // extended; the upper part of the register remains unchanged
-                //
-                // Note: the MOVSX/MOVZX do not work with immediate values
-                {
-                    std::uint8_t buf[] = {   // REX.W MOV $imm32, %rn
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        0xC7,
-                        static_cast<std::uint8_t>(0xC0 | (static_cast<int>(reg) & 7)),
-                        static_cast<std::uint8_t>(value >>  0),
-                        static_cast<std::uint8_t>(value >>  8),
-                        static_cast<std::uint8_t>(value >> 16),
-                        static_cast<std::uint8_t>(value >> 24),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-                break;
+    // the code generated by older versions accesses the variables
+    // differently, running it would crash
+    //
+    if(header.f_version_major != BINARY_VERSION_MAJOR
+    || header.f_version_minor != BINARY_VERSION_MINOR)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, pos);
+        msg << "unsupported binary file version "
+            << static_cast<int>(header.f_version_major)
+            << '.'
+            << static_cast<int>(header.f_version_minor)
+            << " (expected "
+            << static_cast<int>(BINARY_VERSION_MAJOR)
+            << '.'
+            << static_cast<int>(BINARY_VERSION_MINOR)
+            << ").";
+        return false;
+    }
 
-            }
-        }
-        break;
+    return true;
+}
 
-    case node_t::NODE_FLOATING_POINT: // immediate floating point to load as an integer
-        {
-            double const floating_point(d->get_node()->get_floating_point().get());
-            double const * fp(&floating_point);
-            std::int64_t const value(*reinterpret_cast<std::int64_t const *>(fp));
-            std::uint8_t buf[] = {   // REX.W MOV $imm64, %rn
-                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                static_cast<std::uint8_t>(0xB8 | (static_cast<int>(reg) & 7)),
-                static_cast<std::uint8_t>(value >>  0),
-                static_cast<std::uint8_t>(value >>  8),
-                static_cast<std::uint8_t>(value >> 16),
-                static_cast<std::uint8_t>(value >> 24),
-                static_cast<std::uint8_t>(value >> 32),
-                static_cast<std::uint8_t>(value >> 40),
-                static_cast<std::uint8_t>(value >> 48),
-                static_cast<std::uint8_t>(value >> 56),
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-        break;
 
-    case node_t::NODE_VARIABLE:
-        if(d->is_temporary())
-        {
-            std::string const name(n->get_string());
-            temporary_variable * temp_var(f_file.find_temporary_variable(name));
-            if(temp_var == nullptr)
-            {
-                throw internal_error("temporary not found in generate_reg_mem_integer()");
-            }
-            switch(temp_var->get_size())
-            {
-            case 1: // Boolean
-                {
-                    ssize_t const offset(temp_var->get_offset());
-                    integer_size_t const offset_size(get_smallest_size(offset));
-                    std::uint8_t rm(0x45);
-                    switch(code)
-                    {
-                    case 0x8B:  // MOVSX 64bit -> MOV 8bit
-                        switch(offset_size)
-                        {
-                        case integer_size_t::INTEGER_SIZE_1BIT:
-                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                            {
-                                std::uint8_t buf[] = {          // REX.W MOV byte disp8(%rbp), %rn
-                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                    0x0F,
-                                    0xBE,
-                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                                    static_cast<std::uint8_t>(offset),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
+/** \brief Finish the setup of the image once in memory.
+ *
+ * This function sets up the pointers to the various parts of the image,
+ * protects the pages, and creates the default execution context.
+ *
+ * The only relocation necessary is the external function table (see
+ * link_extern_functions()): the f_text buffer uses %rip to access the
+ * constants and %rbx to access the variables, and the data of long
+ * strings is relative to their variable.
+ *
+ * \param[in] pos  The position used in error messages.
+ * \param[in] data_protection  The protection of the .data pages.
+ *
+ * \return true if the image is ready to run.
+ */
+bool running_file::setup_image(position const & pos, int data_protection)
+{
+    f_header = reinterpret_cast<binary_header *>(f_file);
+    f_text = reinterpret_cast<std::uint8_t *>(f_header + 1);
+    f_variables = reinterpret_cast<binary_variable *>(f_file + f_header->f_variables);
 
-                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                            {
-                                std::uint8_t buf[] = {          // REX.W MOV disp32(%rbp), %rn
-                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                    0x0F,
-                                    0xBE,
-                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                                    static_cast<std::uint8_t>(offset >>  0),
-                                    static_cast<std::uint8_t>(offset >>  8),
-                                    static_cast<std::uint8_t>(offset >> 16),
-                                    static_cast<std::uint8_t>(offset >> 24),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
+    // the image does not change once loaded so we can protect it here
+    // instead of on the first run() (which would not be thread safe)
+    //
+    // the header & .text are made read/execute and the .data as
+    // requested by the caller; this requires the .data to start on
+    // a page boundary
+    //
+    long const sc_page_size(sysconf(_SC_PAGESIZE));
+    if(f_header->f_variables % sc_page_size != 0
+    || f_header->f_variables > f_size)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, pos);
+        msg << "the .data section of the binary file is not page aligned (offset: "
+            << f_header->f_variables
+            << ", page size: "
+            << sc_page_size
+            << ").";
+        clean();
+        return false;
+    }
+    if(!link_extern_functions(pos))
+    {
+        clean();
+        return false;
+    }
+    if(mprotect(f_file, f_header->f_variables, PROT_READ | PROT_EXEC) != 0
+    || mprotect(f_file + f_header->f_variables, f_size - f_header->f_variables, data_protection) != 0)
+    {
+        clean();
+        throw execution_error("the file could not be protected for execution.");
+    }
 
-                        default:
-                            // x86-64 only supports disp8 and disp32
-                            //
-                            // for larger offsets we would need to use an
-                            // index register; but we should never go over
-                            // disp32 on the stack anyway since it's only 2Mb
-                            //
-                            throw not_implemented("offset size not yet supported for \""
-                                + temp_var->get_name()
-                                + "\" (type: "
-                                + std::to_string(static_cast<int>(offset_size))
-                                + " for size: "
-                                + std::to_string(offset)
-                                + ").");
+    f_context = create_context();
 
-                        }
-                        return;
+    return true;
+}
 
-                    case 0x83:  // CMP 64bit, imm8 -> CMP 8bit, imm8
-                        code = 0x80;
-                        rm = 0x7D;
-                        break;
 
-                    default:
-                        throw not_implemented(
-                              "8 bit code \""
-                            + std::to_string(static_cast<int>(code))
-                            + "\" in generate_reg_mem_integer() not yet supported (temporary variable).");
+/** \brief Save the address of the external functions in the image.
+ *
+ * The code calls the external functions (i.e. the math and string
+ * helpers found in libas2js) through a table saved in the .data of the
+ * image. In the file, each slot of that table holds an
+ * external_function_t number. This function replaces those numbers
+ * with the address of the corresponding function.
+ *
+ * The pages holding the table are made writable for the time of the
+ * update. The caller protects the .data as expected afterward.
+ *
+ * \param[in] pos  The position used in error messages.
+ *
+ * \return true if all the slots were updated.
+ */
+bool running_file::link_extern_functions(position const & pos)
+{
+    std::size_t const count(f_header->f_extern_function_count);
+    if(count == 0)
+    {
+        return true;
+    }
 
-                    }
-                    switch(offset_size)
-                    {
-                    case integer_size_t::INTEGER_SIZE_1BIT:
-                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                        if(reg >= register_t::REGISTER_RSP)
-                        {
-                            std::uint8_t buf[] = {          // REX.W MOV byte disp8(%rbp), %rn.b
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                code,
-                                static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        else
-                        {
-                            std::uint8_t buf[] = {          // MOV byte disp8(%rbp), %rn.b
-                                code,
-                                static_cast<std::uint8_t>(rm | (static_cast<int>(reg) << 3)),
-                                static_cast<std::uint8_t>(offset),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+    if(f_header->f_extern_functions < f_header->f_variables
+    || f_header->f_extern_functions % sizeof(std::uint64_t) != 0
+    || f_header->f_extern_functions + count * sizeof(std::uint64_t) > f_header->f_file_size)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, pos);
+        msg << "the external function table of the binary file is invalid (offset: "
+            << f_header->f_extern_functions
+            << ", count: "
+            << count
+            << ").";
+        return false;
+    }
 
-                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                        if(reg >= register_t::REGISTER_RSP)
-                        {
-                            // rm = 0x45 -> 0x85 for 32 bit disp
-                            //
-                            std::uint8_t buf[] = {          // REX.W MOV disp32(%rbp), %r8
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                code,
-                                static_cast<std::uint8_t>((rm ^ 0xC0) | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset >>  0),
-                                static_cast<std::uint8_t>(offset >>  8),
-                                static_cast<std::uint8_t>(offset >> 16),
-                                static_cast<std::uint8_t>(offset >> 24),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        else
-                        {
-                            // rm = 0x45 -> 0x85 for 32 bit disp
-                            //
-                            std::uint8_t buf[] = {          // MOV disp32(%rbp), %r8
-                                code,
-                                static_cast<std::uint8_t>((rm ^ 0xC0) | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset >>  0),
-                                static_cast<std::uint8_t>(offset >>  8),
-                                static_cast<std::uint8_t>(offset >> 16),
-                                static_cast<std::uint8_t>(offset >> 24),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+    long const sc_page_size(sysconf(_SC_PAGESIZE));
+    std::size_t const start(f_header->f_extern_functions & -sc_page_size);
+    std::size_t const end((f_header->f_extern_functions
+                                + count * sizeof(std::uint64_t)
+                                + sc_page_size - 1) & -sc_page_size);
+    if(mprotect(f_file + start, end - start, PROT_READ | PROT_WRITE) != 0)
+    {
+        throw execution_error("the external function table could not be made writable.");
+    }
 
-                    default:
-                        // x86-64 only supports disp8 and disp32
-                        //
-                        // for larger offsets we would need to use an
-                        // index register; but we should never go over
-                        // disp32 on the stack anyway since it's only 2Mb
-                        //
-                        throw not_implemented("offset size not yet supported for \""
-                            + temp_var->get_name()
-                            + "\" (type: "
-                            + std::to_string(static_cast<int>(offset_size))
-                            + " for size: "
-                            + std::to_string(offset)
-                            + ").");
+    std::uint64_t * table(reinterpret_cast<std::uint64_t *>(f_file + f_header->f_extern_functions));
+    for(std::size_t idx(0); idx < count; ++idx)
+    {
+        if(table[idx] >= std::size(g_extern_functions))
+        {
+            message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, pos);
+            msg << "unknown external function "
+                << table[idx]
+                << " in binary file.";
+            return false;
+        }
+        table[idx] = reinterpret_cast<std::uint64_t>(g_extern_functions[table[idx]]);
+    }
 
-                    }
-                }
-                break;
+    return true;
+}
 
-            case 8: // Integer / Double
-                {
-                    ssize_t const offset(temp_var->get_offset());
-                    integer_size_t const offset_size(get_smallest_size(offset));
-                    switch(offset_size)
-                    {
-                    case integer_size_t::INTEGER_SIZE_1BIT:
-                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                        {
-                            std::uint8_t buf[] = {    // REX.W MOV disp8(%rbp), %rn
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                code,
-                                static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
 
-                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                        {
-                            std::uint8_t buf[] = {   // REX.W MOV disp32(%rbp), %rn
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                code,
-                                static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset >>  0),
-                                static_cast<std::uint8_t>(offset >>  8),
-                                static_cast<std::uint8_t>(offset >> 16),
-                                static_cast<std::uint8_t>(offset >> 24),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+/** \brief Save the file buffer to disk.
+ *
+ * This is expected to be used only to debug the processes.
+ *
+ * Here is an example saving the file to "c.out":
+ *
+ * \code
+ * std::cerr << "--- save to c.out now...\n";
+ * system("pwd");
+ * const_cast<running_file *>(this)->save("c.out");
+ * \endcode
+ *
+ * \param[in] filename  The name of the file to save to.
+ */
+void running_file::save(std::string const & filename)
+{
+    std::ofstream out;
+    out.open(filename);
+    if(!out.is_open())
+    {
+        std::cerr << "error: could not open output file \""
+            << filename
+            << "\".\n";
+        return;
+    }
 
-                    default:
-                        // x86-64 only supports disp8 and disp32
-                        //
-                        // for larger offsets we would need to use an
-                        // index register; but we should never go over
-                        // disp32 on the stack anyway since it's only 2Mb
-                        //
-                        throw not_implemented("offset size not yet supported for \""
-                            + temp_var->get_name()
-                            + "\" (type: "
-                            + std::to_string(static_cast<int>(offset_size))
-                            + " for size: "
-                            + std::to_string(offset)
-                            + ").");
+    out.write(reinterpret_cast<char const *>(f_file), f_size);
+}
 
-                    }
-                }
-                break;
 
-            default:
-                throw not_implemented("temporary size not yet supported in generate_reg_mem_integer()");
+versiontheca::versiontheca::pointer_t running_file::get_version() const
+{
+    versiontheca::basic::pointer_t t(std::make_shared<versiontheca::basic>());
+    versiontheca::versiontheca::pointer_t version(std::make_shared<versiontheca::versiontheca>(t));
+    if(f_file != nullptr)
+    {
+        version->set_major(f_header->f_version_major);
+        version->set_minor(f_header->f_version_minor);
+    }
 
-            }
-        }
-        else if(d->is_extern())
-        {
-            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
+    return version;
+}
 
-            // I do not think this is correct, we probably need to check
-            // the type first? (i.e. strings have variable sizes and encoding
-            // that as 1 or 8 bytes is not going to work)
-            //
-            switch(var->f_data_size)
-            {
-            case 1:
-                {
-                    std::uint8_t rm(0x05);
-                    switch(code)
-                    {
-                    case 0x0B:  // OR (m8), %r8
-                        code = 0x0A;
-                        break;
 
-                    case 0x23:  // AND (m8), %r8
-                        code = 0x22;
-                        break;
+execution_context & running_file::get_default_context() const
+{
+    if(f_context == nullptr)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "no variables defined, running_file::load() was not called or failed.";
+        throw invalid_data(msg.str());
+    }
+    return *f_context;
+}
 
-                    case 0x33:  // XOR (m8), %r8
-                        code = 0x32;
-                        break;
 
-                    case 0x3B:  // CMP (m8), %r8
-                        code = 0x3A;
-                        break;
+/** \brief Seed the random generator of the default context.
+ *
+ * Math.random() returns numbers from the generator of the execution
+ * context used to run the code. By default that generator is seeded
+ * with a random number. Seeding it makes runs reproducible.
+ *
+ * To seed the generator of another context, use
+ * execution_context::set_random_seed().
+ *
+ * \param[in] seed  The new seed.
+ */
+void running_file::set_random_seed(std::uint64_t seed)
+{
+    get_default_context().set_random_seed(seed);
+}
 
-                    case 0x8B:  // MOV (m8), %r8
-                        code = 0x8A;
-                        break;
 
-                    case 0x83:  // CMP $imm8, %r8
-                        code = 0x80;
-                        rm = 0x3D;
-                        break;
+binary_variable * running_file::find_variable(std::string const & name) const
+{
+    return get_default_context().find_variable(name);
+}
 
-                    default:
-                        throw not_implemented(
-                              "8 bit code \""
-                            + std::to_string(static_cast<int>(code))
-                            + "\" in generate_reg_mem_integer() not yet supported (external variable).");
 
-                    }
-//std::cerr << " -- select reg [" << static_cast<int>(reg) << "]\n";
-                    if(reg >= register_t::REGISTER_RSP || code == 0x8A)
-                    {
-                        std::size_t pos(f_file.get_current_text_offset());
-                        if(code == 0x8A)
-                        {
-                            // the MOV requires one more byte using the
-                            // MOVZX to clear all the upper bits...
-                            //
-                            std::uint8_t buf[] = {
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                0x0F,                       // REX.W MOVSBQ disp32(%rip), %r64
-                                0xBE,
-                                static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
-                                0x00,
-                                0x00,
-                                0x00,
-                                0x00,
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                            pos += 4;
-                        }
-                        else
-                        {
-                            std::uint8_t buf[] = {          // CMP disp32(%rip), %r8
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                code,
-                                static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
-                                0x00,                       // 32 bit offset
-                                0x00,
-                                0x00,
-                                0x00,
-                                // for CMP disp(%rip), $imm8, the immediate
-                                // is added by the caller on return
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                            pos += 3;
-                        }
-                        f_file.add_relocation(
-                                  d->get_string()
-                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                , pos
-                                , f_file.get_current_text_offset() + adjust_offset);
-                    }
-                    else
-                    {
-                        std::size_t const pos(f_file.get_current_text_offset());
-                        std::uint8_t buf[] = {          // MOV disp32(m8), r8
-                            code,
-                            static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
-                            0x00,                       // 32 bit offset
-                            0x00,
-                            0x00,
-                            0x00,
-                            // for CMP disp(%rip), $imm8, the immediate
-                            // is added by the caller on return
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                        f_file.add_relocation(
-                                  d->get_string()
-                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                , pos + 2
-                                , f_file.get_current_text_offset() + adjust_offset);
-                    }
-                }
-                break;
+bool running_file::has_variable(std::string const & name) const
+{
+    return find_variable_index(name) >= 0;
+}
 
-            case 8:
-                {
-                    std::size_t const pos(f_file.get_current_text_offset());
-                    std::uint8_t buf[] = {          // REX.W MOV disp32(%rip), %r64
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        code,
-                        static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                    f_file.add_relocation(
-                              d->get_string()
-                            , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                            , pos + 3
-                            , f_file.get_current_text_offset() + adjust_offset);
-                }
-                break;
 
-            default:
-                throw not_implemented(
-                      "WARNING: generate_reg_mem_integer() hit an extern variable size ("
-                    + std::to_string(var->f_data_size)
-                    + ") not yet implemented...");
+void running_file::set_variable(std::string const & name, bool value)
+{
+    get_default_context().set_variable(name, value);
+}
 
-            }
-        }
-        else
-        {
-            throw not_implemented("WARNING: generate_reg_mem_integer() hit a variable type not yet implemented...");
-        }
-        break;
 
-    default:
-        throw not_implemented("WARNING: generate_reg_mem_integer() hit a data type not yet implemented...");
+void running_file::get_variable(std::string const & name, bool & value) const
+{
+    get_default_context().get_variable(name, value);
+}
 
-    }
+
+void running_file::set_variable(std::string const & name, std::int64_t value)
+{
+    get_default_context().set_variable(name, value);
 }
 
 
-void binary_assembler::generate_reg_mem_floating_point(data::pointer_t d, register_t const reg, sse_operation_t op, int adjust_offset)
+void running_file::get_variable(std::string const & name, std::int64_t & value) const
 {
-    std::uint8_t code(0x8B);
+    get_default_context().get_variable(name, value);
+}
 
-    std::uint8_t sse_code(0x10);    // code for MOVSD
-    switch(op)
-    {
-    case sse_operation_t::SSE_OPERATION_ADD:
-        sse_code = 0x58;
-        break;
 
-    case sse_operation_t::SSE_OPERATION_CMP:
-        sse_code = 0xC2;
-        break;
+void running_file::set_variable(std::string const & name, double value)
+{
+    get_default_context().set_variable(name, value);
+}
 
-    case sse_operation_t::SSE_OPERATION_DIV:
-        sse_code = 0x5E;
-        break;
 
-    case sse_operation_t::SSE_OPERATION_LOAD:
-    case sse_operation_t::SSE_OPERATION_CVT2I: // convert is used like a LOAD
-    case sse_operation_t::SSE_OPERATION_CVT2D: // convert is used like a LOAD
-        // sse_code is already set to MOVSD
-        break;
+void running_file::get_variable(std::string const & name, double & value) const
+{
+    get_default_context().get_variable(name, value);
+}
 
-    case sse_operation_t::SSE_OPERATION_MAX:
-        sse_code = 0x5F;
-        break;
 
-    case sse_operation_t::SSE_OPERATION_MIN:
-        sse_code = 0x5D;
-        break;
+void running_file::set_variable(std::string const & name, std::string const & value)
+{
+    get_default_context().set_variable(name, value);
+}
 
-    case sse_operation_t::SSE_OPERATION_MUL:
-        sse_code = 0x59;
-        break;
 
-    case sse_operation_t::SSE_OPERATION_SUB:
-        sse_code = 0x5C;
-        break;
+void running_file::get_variable(std::string const & name, std::string & value) const
+{
+    get_default_context().get_variable(name, value);
+}
 
-    default:
-        throw internal_error(
-                  "unknown SSE operation "
-                + std::to_string(static_cast<int>(op))
-                + " in generate_reg_mem_floating_point().");
 
+void running_file::get_variable(std::string const & name, std::string_view & value) const
+{
+    get_default_context().get_variable(name, value);
+}
+
+
+std::size_t running_file::variable_size() const
+{
+    if(f_header == nullptr)
+    {
+        throw invalid_data("running_file has no data.");
     }
+    return f_header->f_variable_count;
+}
 
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
+
+binary_variable * running_file::get_variable(int index, std::string & name) const
+{
+    name.clear();
+    if(index < 0)
     {
-    case node_t::NODE_INTEGER: // immediate integer
-        if(op == sse_operation_t::SSE_OPERATION_CVT2I)
-        {
-            // the caller wants the result as an integer in a regular
-            // register so do that with a generate_reg_mem_integer() call
-            //
-            generate_reg_mem_integer(d, reg, 0x8B, adjust_offset);
-            break;
-        }
+        throw out_of_range("running_file::get_variable() called with a negative index.");
+    }
+    if(f_header == nullptr)
+    {
+        throw invalid_data("running_file has no data.");
+    }
+    return get_default_context().get_variable(index, name);
+}
 
-        {
-            double const value(static_cast<double>(d->get_node()->get_integer().get()));
-            std::string name;
-            f_file.add_constant(value, name);
-            d->set_data_name(name);
-        }
-        [[fallthrough]];
-    case node_t::NODE_FLOATING_POINT: // immediate double--use the copy in the private data section
-        {
-            offset_t const offset(f_file.get_constant_offset(d->get_data_name()));
-            switch(op)
+
+/** \brief Search for a variable in the image.
+ *
+ * The extern variables are sorted by name so this function uses a binary
+ * search to find the named variable. The returned index is valid for
+ * the image and any execution_context created from it.
+ *
+ * \param[in] name  The name of the variable to search.
+ *
+ * \return The index of the variable or -1 if it is not defined.
+ */
+int running_file::find_variable_index(std::string_view const & name) const
+{
+    if(f_variables == nullptr)
+    {
+        return -1;
+    }
+    auto it(std::lower_bound(
+              f_variables
+            , f_variables + f_header->f_variable_count
+            , name
+            , [&](binary_variable const & v, std::string_view const & n)
             {
-            case sse_operation_t::SSE_OPERATION_ADD:
-            case sse_operation_t::SSE_OPERATION_DIV:
-            case sse_operation_t::SSE_OPERATION_LOAD:
-            case sse_operation_t::SSE_OPERATION_CVT2D:
-            case sse_operation_t::SSE_OPERATION_MAX:
-            case sse_operation_t::SSE_OPERATION_MIN:
-            case sse_operation_t::SSE_OPERATION_MUL:
-            case sse_operation_t::SSE_OPERATION_SUB:
-                {
-                    std::size_t const pos(f_file.get_current_text_offset());
-                    std::uint8_t buf[] = {   // MOVSD disp32(%rip), %xmm
-                        0xF2,
-                        // TODO: add 0x44 if reg >= xmm8
-                        0x0F,
-                        sse_code,
-                        static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                        static_cast<std::uint8_t>(offset >>  0),
-                        static_cast<std::uint8_t>(offset >>  8),
-                        static_cast<std::uint8_t>(offset >> 16),
-                        static_cast<std::uint8_t>(offset >> 24),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                    f_file.add_relocation(
-                              d->get_data_name()
-                            , relocation_t::RELOCATION_CONSTANT_32BITS
-                            , pos + 4
-                            , f_file.get_current_text_offset() + adjust_offset);
-                }
-                break;
+                return get_name_view(v) < n;
+            }));
+    if(it == f_variables + f_header->f_variable_count)
+    {
+        return -1;
+    }
 
-            case sse_operation_t::SSE_OPERATION_CVT2I:
-                {
-                    // if we had an INTEGER, it was caught in the previous
-                    // case at the previous level so the following call
-                    // cannot fail because of that
-                    //
-                    double const floating_point(static_cast<double>(d->get_node()->get_floating_point().get()));
-                    std::int64_t const value(floating_point);
-                    switch(get_smallest_size(value))
-                    {
-                    case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_64BITS:
-                        {
-                            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rn
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),       // 64 bits
-                                static_cast<std::uint8_t>(0xB8 | (static_cast<int>(reg) & 7)),
-                                static_cast<std::uint8_t>(value >>  0),
-                                static_cast<std::uint8_t>(value >>  8),
-                                static_cast<std::uint8_t>(value >> 16),
-                                static_cast<std::uint8_t>(value >> 24),
-                                static_cast<std::uint8_t>(value >> 32),
-                                static_cast<std::uint8_t>(value >> 40),
-                                static_cast<std::uint8_t>(value >> 48),
-                                static_cast<std::uint8_t>(value >> 56),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+    // lower bound returns the "next variable" if the exact variable
+    // does not exist, so here we have to make sure we've got the
+    // actual variable and not the next one
+    //
+    if(get_name_view(*it) != name)
+    {
+        return -1;
+    }
 
-                    default:
-                        // in 64bit the sign extend works with 32 bits so all others
-                        // can make use of the 32 bit value
-                        //
-                        // on the other hand, the 16 & 8 bit immediate do not get
-                        // extended; the upper part of the register remains unchanged
-                        //
-                        // Note: the MOVSX/MOVZX do not work with immediate values
-                        {
-                            std::uint8_t buf[] = {   // REX.W MOV $imm32, %rn
-                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                0xC7,
-                                static_cast<std::uint8_t>(0xC0 | (static_cast<int>(reg) & 7)),
-                                static_cast<std::uint8_t>(value >>  0),
-                                static_cast<std::uint8_t>(value >>  8),
-                                static_cast<std::uint8_t>(value >> 16),
-                                static_cast<std::uint8_t>(value >> 24),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+    return static_cast<int>(it - f_variables);
+}
 
-                    }
-                    //std::size_t const pos(f_file.get_current_text_offset());
-                    //std::uint8_t buf[] = {
-                    //    0xF2,       // REX.W CVTSD2SI disp32(%rip), %xmm
-                    //    0x48,
-                    //    0x0F,
-                    //    0x2D,
-                    //    static_cast<std::uint8_t>(0x05 | (reg << 3)),
-                    //    static_cast<std::uint8_t>(offset >>  0),
-                    //    static_cast<std::uint8_t>(offset >>  8),
-                    //    static_cast<std::uint8_t>(offset >> 16),
-                    //    static_cast<std::uint8_t>(offset >> 24),
-                    //};
-                    //f_file.add_text(buf, sizeof(buf));
-                    //f_file.add_relocation(
-                    //          d->get_data_name()
-                    //        , relocation_t::RELOCATION_CONSTANT_32BITS
-                    //        , pos + 5
-                    //        , f_file.get_current_text_offset() + adjust_offset);
-                }
-                break;
 
-            default:
-                throw not_implemented(
-                      "floating point operation ("
-                    + std::to_string(static_cast<int>(op))
-                    + ") not yet implemented in generate_reg_mem_floating_point()");
+/** \brief Get a handle to a variable.
+ *
+ * This function searches for the named variable once and returns a
+ * handle which can then be used with the set() and get() functions
+ * of the running_file and of any of its execution contexts. Those
+ * functions do not search for the variable and do not allocate memory
+ * (except for long strings).
+ *
+ * \exception invalid_data
+ * This exception is raised if the variable does not exist.
+ *
+ * \param[in] name  The name of the variable.
+ *
+ * \return The handle of the variable.
+ */
+variable_handle running_file::get_handle(std::string_view const & name) const
+{
+    if(f_variables == nullptr)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "no variables defined, running_file::load() was not called or failed.";
+        throw invalid_data(msg.str());
+    }
+    int const index(find_variable_index(name));
+    if(index < 0)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "could not find variable \""
+            << name
+            << "\".";
+        throw invalid_data(msg.str());
+    }
+    return variable_handle(index);
+}
 
-            }
-        }
-        break;
 
-    case node_t::NODE_VARIABLE:
-        if(d->is_temporary())
-        {
-            std::string const name(n->get_string());
-            temporary_variable * temp_var(f_file.find_temporary_variable(name));
-            if(temp_var == nullptr)
-            {
-                throw internal_error("temporary not found in generate_reg_mem_floating_point()");
-            }
-            switch(temp_var->get_size())
-            {
-            case 1: // Boolean
-                {
-                    ssize_t const offset(temp_var->get_offset());
-                    integer_size_t const offset_size(get_smallest_size(offset));
-                    std::uint8_t rm(0x45);
-                    switch(op)
-                    {
-                    case sse_operation_t::SSE_OPERATION_LOAD:  // MOV 64bit -> MOV 8bit
-                    case sse_operation_t::SSE_OPERATION_CVT2D:
-                        code = 0x8A;
-                        break;
+void running_file::set(variable_handle const & handle, bool value)
+{
+    get_default_context().set(handle, value);
+}
 
-                    case sse_operation_t::SSE_OPERATION_CMP:  // CMP 64bit, imm8 -> CMP 8bit, imm8
-                        code = 0x80;
-                        rm = 0x7D;
-                        break;
 
-                    default:
-                        throw not_implemented("8 bit code in generate_reg_mem_floating_point() not yet supported.");
+void running_file::get(variable_handle const & handle, bool & value) const
+{
+    get_default_context().get(handle, value);
+}
 
-                    }
-                    switch(offset_size)
-                    {
-                    case integer_size_t::INTEGER_SIZE_1BIT:
-                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                        {
-                            std::uint8_t buf[] = {    // MOV disp8(%rbp), %r8
-                                code,
-                                static_cast<std::uint8_t>(rm | (static_cast<int>(reg) << 3)),
-                                static_cast<std::uint8_t>(offset),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
 
-                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                        {
-                            std::uint8_t buf[] = {    // MOV disp32(%rbp), %r8
-                                code,
-                                static_cast<std::uint8_t>((rm ^ 0xC0) | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset >>  0),
-                                static_cast<std::uint8_t>(offset >>  8),
-                                static_cast<std::uint8_t>(offset >> 16),
-                                static_cast<std::uint8_t>(offset >> 24),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+void running_file::set(variable_handle const & handle, std::int64_t value)
+{
+    get_default_context().set(handle, value);
+}
 
-                    default:
-                        // x86-64 only supports disp8 and disp32
-                        //
-                        // for larger offsets we would need to use an
-                        // index register; but we should never go over
-                        // disp32 on the stack anyway since it's only 2Mb
-                        //
-                        throw not_implemented("offset size not yet supported for \""
-                            + temp_var->get_name()
-                            + "\" (type: "
-                            + std::to_string(static_cast<int>(offset_size))
-                            + " for size: "
-                            + std::to_string(offset)
-                            + ").");
 
-                    }
-                }
-                break;
+void running_file::get(variable_handle const & handle, std::int64_t & value) const
+{
+    get_default_context().get(handle, value);
+}
 
-            case 8: // Integer / Double
-                {
-                    ssize_t const offset(temp_var->get_offset());
-                    integer_size_t const offset_size(get_smallest_size(offset));
-                    switch(offset_size)
-                    {
-                    case integer_size_t::INTEGER_SIZE_1BIT:
-                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                        {
-                            std::uint8_t buf[] = {    // MOVSD disp8(%rbp), %xmm
-                                0xF2,
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        if(reg >= register_t::REGISTER_R8)
-                        {
-                            std::uint8_t buf[] = {
-                                0x44,
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        {
-                            std::uint8_t buf[] = {
-                                0x0F,
-                                sse_code,
-                                static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
 
-                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                        {
-                            std::uint8_t buf[] = {    // MOVSD disp32(%rbp), %xmm
-                                0xF2,
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        if(reg >= register_t::REGISTER_R8)
-                        {
-                            std::uint8_t buf[] = {
-                                0x44,
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        {
-                            std::uint8_t buf[] = {
-                                0x0F,
-                                0x10,
-                                static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                                static_cast<std::uint8_t>(offset >>  0),
-                                static_cast<std::uint8_t>(offset >>  8),
-                                static_cast<std::uint8_t>(offset >> 16),
-                                static_cast<std::uint8_t>(offset >> 24),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                        break;
+void running_file::set(variable_handle const & handle, double value)
+{
+    get_default_context().set(handle, value);
+}
 
-                    default:
-                        // x86-64 only supports disp8 and disp32
-                        //
-                        // for larger offsets we would need to use an
-                        // index register; but we should never go over
-                        // disp32 on the stack anyway since it's only 2Mb
-                        //
-                        throw not_implemented("offset size not yet supported for \""
-                            + temp_var->get_name()
-                            + "\" (type: "
-                            + std::to_string(static_cast<int>(offset_size))
-                            + " for size: "
-                            + std::to_string(offset)
-                            + ").");
 
-                    }
-                }
-                break;
+void running_file::get(variable_handle const & handle, double & value) const
+{
+    get_default_context().get(handle, value);
+}
 
-            default:
-                throw not_implemented("temporary size not yet supported in generate_reg_mem_floating_point()");
 
-            }
-        }
-        else if(d->is_extern())
-        {
-            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
-            if(var == nullptr)
-            {
-                throw internal_error(
-                      "extern variable \""
-                    + d->get_string()
-                    + "\" not found in generate_reg_mem_floating_point()");
-            }
-            switch(var->f_type)
-            {
-            case VARIABLE_TYPE_BOOLEAN:
-                {
-                    std::uint8_t rm(0x05);
-                    switch(op)
-                    {
-                    case sse_operation_t::SSE_OPERATION_LOAD:  // MOV 64bit -> MOV 8bit
-                    case sse_operation_t::SSE_OPERATION_CVT2D:
-                        code = 0x8A;
-                        break;
+void running_file::set(variable_handle const & handle, std::string_view const & value)
+{
+    get_default_context().set(handle, value);
+}
 
-                    case sse_operation_t::SSE_OPERATION_CMP:  // CMP 64bit, imm8 -> CMP 8bit, imm8
-                        code = 0x80;
-                        rm = 0x3D;
-                        break;
 
-                    default:
-                        throw not_implemented("8 bit code in generate_reg_mem_floating_point() not yet supported.");
+void running_file::get(variable_handle const & handle, std::string & value) const
+{
+    get_default_context().get(handle, value);
+}
 
-                    }
-//std::cerr << " -- select reg [" << static_cast<int>(reg) << "]\n";
-                    std::size_t pos(f_file.get_current_text_offset());
-                    if(code == 0x8A)
-                    {
-                        // the MOV requires one more byte using the
-                        // MOVZX to clear all the upper bits
-                        //
-                        std::uint8_t buf[] = {      // REX.W MOVZBQ disp32(%rip), %r64
-                            0x48,
-                            0x0F,
-                            0xB6,
-                            static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
-                            0x00,                       // 32 bit offset
-                            0x00,
-                            0x00,
-                            0x00,
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                        ++pos;
-                    }
-                    else
-                    {
-                        std::uint8_t buf[] = {      // REX.W CMP disp32(%rip), %r8 (or $imm8?)
-                            0x48,
-                            code,
-                            static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
-                            0x00,                       // 32 bit offset
-                            0x00,
-                            0x00,
-                            0x00,
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                    }
-                    f_file.add_relocation(
-                              d->get_string()
-                            , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                            , pos + 3
-                            , f_file.get_current_text_offset() + adjust_offset);
-                }
-                break;
 
-            case VARIABLE_TYPE_INTEGER:
-                switch(op)
-                {
-                case sse_operation_t::SSE_OPERATION_LOAD:
-                case sse_operation_t::SSE_OPERATION_CVT2I:
-                    {
-                        std::size_t const pos(f_file.get_current_text_offset());
-                        std::uint8_t buf[] = {      // MOV disp32(%rip), %rn
-                            0x48,
-                            code,
-                            static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                            0x00,       // 32 bit offset
-                            0x00,
-                            0x00,
-                            0x00,
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                        f_file.add_relocation(
-                                  d->get_string()
-                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                , pos + 3
-                                , f_file.get_current_text_offset() + adjust_offset);
-                    }
-                    break;
+void running_file::get(variable_handle const & handle, std::string_view & value) const
+{
+    get_default_context().get(handle, value);
+}
 
-                case sse_operation_t::SSE_OPERATION_CVT2D:
-                    {
-                        std::size_t const pos(f_file.get_current_text_offset());
-                        std::uint8_t buf[] = {     // REX.W CVTSI2SD disp32(%rip), %xmmn
-                            0xF2,
-                            0x48,
-                            0x0F,
-                            0x2A,
-                            static_cast<std::uint8_t>(0x05 | (static_cast<int>(reg) << 3)),
-                            0x00,
-                            0x00,
-                            0x00,
-                            0x00,
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                        f_file.add_relocation(
-                                  d->get_string()
-                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                , pos + 5
-                                , f_file.get_current_text_offset() + adjust_offset);
-                    }
-                    break;
 
-                case sse_operation_t::SSE_OPERATION_MAX:
-                case sse_operation_t::SSE_OPERATION_MIN:
-                    {
-                        register_t const other_reg(
-                                reg == register_t::REGISTER_XMM0
-                                        ? register_t::REGISTER_XMM1
-                                        : register_t::REGISTER_XMM0);
+std::string_view running_file::get_name_view(binary_variable const & v) const
+{
+    char const * s(v.f_name_size <= sizeof(v.f_name)
+        ? reinterpret_cast<char const *>(&v.f_name)
+        : reinterpret_cast<char const *>(f_file + v.f_name));
+    return std::string_view(s, v.f_name_size);
+}
 
-                        {
-                            std::size_t const pos(f_file.get_current_text_offset());
-                            std::uint8_t buf[] = {      // CVTSI2SD disp32(%rip), %xmm1
-                                0xF2,
-                                0x48,
-                                0x0F,
-                                0x2A,
-                                static_cast<std::uint8_t>(0x05 | ((static_cast<int>(other_reg) & 7) << 3)),
-                                0x00,       // 32 bit offset
-                                0x00,
-                                0x00,
-                                0x00,
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                            f_file.add_relocation(
-                                      d->get_string()
-                                    , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                    , pos + 5
-                                    , f_file.get_current_text_offset() + adjust_offset);
-                        }
 
-                        {
-                            std::uint8_t buf[] = {      // MAXSD or MINSD %xmm1, %xmm0
-                                0xF2,
-                                0x0F,
-                                sse_code,
-                                static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3) | static_cast<int>(other_reg)),
-                            };
-                            f_file.add_text(buf, sizeof(buf));
-                        }
-                    }
-                    break;
+std::string running_file::get_variable_name(int index) const
+{
+    if(f_header == nullptr)
+    {
+        throw invalid_data("running_file has no data.");
+    }
+    if(index < 0
+    || index >= f_header->f_variable_count)
+    {
+        throw out_of_range("running_file::get_variable_name() called with an out of range index.");
+    }
+    return std::string(get_name_view(f_variables[index]));
+}
 
-                default:
-                    throw not_implemented(
-                              "Integer/SSE operation "
-                            + std::to_string(static_cast<int>(op))
-                            + " not yet implemented in generate_reg_mem_floating_point() -- expected one of MOVSD/CVTD2I/MINSD/MAXSD");
 
-                }
-                break;
+binary_variable const * running_file::get_default_variables() const
+{
+    return f_variables;
+}
 
-            case VARIABLE_TYPE_FLOATING_POINT:
-                switch(op)
-                {
-                case sse_operation_t::SSE_OPERATION_ADD:
-                case sse_operation_t::SSE_OPERATION_CMP:
-                case sse_operation_t::SSE_OPERATION_DIV:
-                case sse_operation_t::SSE_OPERATION_LOAD:
-                case sse_operation_t::SSE_OPERATION_CVT2D:
-                case sse_operation_t::SSE_OPERATION_MAX:
-                case sse_operation_t::SSE_OPERATION_MIN:
-                case sse_operation_t::SSE_OPERATION_MUL:
-                case sse_operation_t::SSE_OPERATION_SUB:
-                    {
-                        std::size_t const pos(f_file.get_current_text_offset());
-                        std::uint8_t buf[] = {       // MOVSD disp32(%rip), %xmm
-                            0xF2,
-                            0x0F,
-                            sse_code,
-                            static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                            0x00,       // 32 bit offset
-                            0x00,
-                            0x00,
-                            0x00,
-                            // CMP??SD uses an immediate as well, which is
-                            // added by the caller
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                        f_file.add_relocation(
-                                  d->get_string()
-                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                , pos + 4
-                                , f_file.get_current_text_offset() + adjust_offset);
-                    }
-                    break;
 
-                case sse_operation_t::SSE_OPERATION_CVT2I:
-                    {
-                        std::size_t const pos(f_file.get_current_text_offset());
-                        std::uint8_t buf[] = {     // REX.W CVTSD2SI disp32(%rip), %rn
-                            0xF2,
-                            0x48,
-                            0x0F,
-                            0x2D,
-                            static_cast<std::uint8_t>(0x05 | (static_cast<int>(reg) << 3)),
-                            0x00,
-                            0x00,
-                            0x00,
-                            0x00,
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                        f_file.add_relocation(
-                                  d->get_string()
-                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                                , pos + 5
-                                , f_file.get_current_text_offset() + adjust_offset);
-                    }
-                    break;
+/** \brief Retrieve a pointer to the loaded image.
+ *
+ * The image starts with the binary_header and is get_image_size()
+ * bytes. It is used to compute a hash of the file contents.
+ *
+ * \return A pointer to the image or nullptr if nothing was loaded.
+ */
+std::uint8_t const * running_file::get_image() const
+{
+    return f_file;
+}
 
-                default:
-                    throw not_implemented("SSE operation not yet implemented in generate_reg_mem_floating_point()");
 
-                }
-                break;
+/** \brief Size of the image as saved in the binary file.
+ *
+ * \return The size of the file in bytes or 0 if nothing was loaded.
+ */
+std::size_t running_file::get_image_size() const
+{
+    if(f_header == nullptr)
+    {
+        return 0;
+    }
+    return f_header->f_file_size;
+}
 
-            default:
-                throw not_implemented("WARNING: generate_reg_mem_floating_point() hit an extern variable type not yet implemented...");
 
-            }
-        }
-        else
-        {
-            throw not_implemented("WARNING: generate_reg_mem_floating_point() hit a variable type not yet implemented...");
-        }
-        break;
+/** \brief Amount of memory used by the image.
+ *
+ * This is the size of the buffer allocated by load() (rounded up to
+ * a page) or the size of the mapping created by map().
+ *
+ * \return The number of bytes used by this running_file image.
+ */
+std::size_t running_file::get_memory_size() const
+{
+    return f_size;
+}
 
-    default:
-        throw not_implemented("WARNING: generate_reg_mem_floating_point() hit a data type not yet implemented...");
 
+/** \brief Create a new execution context.
+ *
+ * Each thread executing this running_file must use its own execution
+ * context. The context holds the extern variables so setting a
+ * variable in one context has no effect on the others.
+ *
+ * \return A new execution context with the variables set to their
+ * default values.
+ */
+execution_context::pointer_t running_file::create_context() const
+{
+    if(f_header == nullptr)
+    {
+        throw invalid_data("running_file has no data.");
     }
+    return std::make_shared<execution_context>(this);
 }
 
 
-void binary_assembler::generate_reg_mem_string(data::pointer_t d, register_t const reg, int adjust_offset)
+void running_file::run(binary_result & result)
 {
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
+    run(get_default_context(), result);
+}
+
+
+/** \brief Run the code using the specified execution context.
+ *
+ * This function executes the code of this running_file. The variables
+ * are read from and written to the \p context. The running_file itself
+ * is not modified so this function can be called by multiple threads
+ * simultaneously, each with its own context.
+ *
+ * \param[in,out] context  The context holding the variables.
+ * \param[out] result  The result of the execution.
+ */
+void running_file::run(execution_context & context, binary_result & result) const
+{
+    if(f_header == nullptr)
     {
-    case node_t::NODE_STRING: // immediate string, load pointer in reg
-        {
-            offset_t const offset(f_file.get_constant_offset(d->get_data_name()));
-            std::size_t const pos(f_file.get_current_text_offset());
-            std::uint8_t buf[] = {  // REX.W LEA disp32(%rip), %rn
-                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                0x8D,
-                static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                static_cast<std::uint8_t>(offset >>  0),
-                static_cast<std::uint8_t>(offset >>  8),
-                static_cast<std::uint8_t>(offset >> 16),
-                static_cast<std::uint8_t>(offset >> 24),
-            };
-            f_file.add_text(buf, sizeof(buf));
-            f_file.add_relocation(
-                      d->get_data_name()
-                    , relocation_t::RELOCATION_CONSTANT_32BITS
-                    , pos + 3
-                    , f_file.get_current_text_offset() + adjust_offset);
-        }
-        break;
+        throw invalid_data("running_file has no data.");
+    }
+    if(context.get_running_file() != this
+    || context.variable_size() != f_header->f_variable_count)
+    {
+        throw invalid_data("the execution context was not created by this running_file.");
+    }
 
-    case node_t::NODE_VARIABLE:
-        if(d->is_temporary())
-        {
-            std::string const name(n->get_string());
-            temporary_variable * temp_var(f_file.find_temporary_variable(name));
-            if(temp_var == nullptr)
-            {
-                throw internal_error("temporary \""
-                    + name
-                    + "\" not found in generate_reg_mem_string()");
-            }
-            if(temp_var->get_type() != node_t::NODE_STRING)
-            {
-                throw internal_error("temporary \""
-                    + name
-                    + "\" in generate_reg_mem_string() is of type "
-                    + node::type_to_string(temp_var->get_type())
-                    + " when the compiler expected it to be of type string.");
-            }
-            ssize_t const offset(temp_var->get_offset());
-            integer_size_t const offset_size(get_smallest_size(offset));
-            switch(offset_size)
-            {
-            case integer_size_t::INTEGER_SIZE_1BIT:
-            case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                {
-                    std::uint8_t buf[] = {  // REX.W LEA disp8(%rbp), %rn
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        0x8D,
-                        static_cast<std::uint8_t>(0x45 | (static_cast<int>(reg) << 3)),
-                        static_cast<std::uint8_t>(offset),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-                break;
+    binary_variable * var(context.find_variable("%result"));
 
-            case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-            case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-            case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-            case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                {
-                    std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rn
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        0x8D,
-                        static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                        static_cast<std::uint8_t>(offset >>  0),
-                        static_cast<std::uint8_t>(offset >>  8),
-                        static_cast<std::uint8_t>(offset >> 16),
-                        static_cast<std::uint8_t>(offset >> 24),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-                break;
+    call_entry(context);
 
-            default:
-                // x86-64 only supports disp8 and disp32
-                //
-                // for larger offsets we would need to use an
-                // index register; but we should never go over
-                // disp32 on the stack anyway since it's only 2Mb
-                //
-                throw not_implemented("offset size not yet supported for \""
-                    + temp_var->get_name()
-                    + "\" (type: "
-                    + std::to_string(static_cast<int>(offset_size))
-                    + " for size: "
-                    + std::to_string(offset)
-                    + ").");
+    switch(f_header->f_return_type)
+    {
+    case VARIABLE_TYPE_BOOLEAN:
+        result.set_boolean(var->f_data != 0);
+        break;
 
-            }
-        }
-        else if(d->is_extern())
-        {
-            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
-            if(var == nullptr)
-            {
-                throw internal_error(
-                      "extern variable \""
-                    + d->get_string()
-                    + "\" not found in generate_reg_mem_string()");
-            }
-            // TODO: other variable types need an auto-cast (but that should
-            //       be done by the compiler ahead of time?)
-            //
-            switch(var->f_type)
-            {
-            case VARIABLE_TYPE_STRING:
-                {
-                    std::size_t pos(f_file.get_current_text_offset());
-                    std::uint8_t buf[] = {      // REX.W LEA disp32(%rip), %rn
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        0x8D,
-                        static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                    f_file.add_relocation(
-                              d->get_string()
-                            , relocation_t::RELOCATION_VARIABLE_32BITS
-                            , pos + 3
-                            , f_file.get_current_text_offset() + adjust_offset);
-                }
-                break;
+    case VARIABLE_TYPE_INTEGER:
+        result.set_integer(var->f_data);
+        break;
 
-            default:
-                throw not_implemented(
-                      std::string("WARNING: generate_reg_mem_string() hit an extern variable type \"")
-                    + variable_type_to_string(var->f_type)
-                    + "\" not yet implemented...");
+    case VARIABLE_TYPE_FLOATING_POINT:
+        {
+            std::uint64_t * ptr(&var->f_data);
+            result.set_floating_point(*reinterpret_cast<double *>(ptr));
+        }
+        break;
 
-            }
+    case VARIABLE_TYPE_STRING:
+        // the result references the %result variable of the context,
+        // it is not copied
+        //
+        if(var->f_data_size <= sizeof(var->f_data))
+        {
+            result.set_string_view(std::string_view(reinterpret_cast<char const *>(&var->f_data), var->f_data_size));
         }
         else
         {
-            throw not_implemented("WARNING: generate_reg_mem_string() hit a variable type not yet implemented...");
+            result.set_string_view(std::string_view(reinterpret_cast<char const *>(var->f_data), var->f_data_size));
         }
         break;
 
     default:
-        throw not_implemented(
-              "WARNING: generate_reg_mem_string() hit data type "
-            + std::to_string(static_cast<int>(d->get_data_type()))
-            + "/"
-            + node::type_to_string(d->get_data_type())
-            + " not yet implemented...");
+        result.set_type(VARIABLE_TYPE_UNKNOWN);
+        break;
 
     }
 }
 
-
-void binary_assembler::generate_load_string_size(data::pointer_t d, register_t const reg)
+void running_file::call_entry(execution_context & context) const
 {
-    node::pointer_t n(d->get_node());
-    if(d->is_temporary())
-    {
-        std::string const name(n->get_string());
-        temporary_variable * temp_var(f_file.find_temporary_variable(name));
-        if(temp_var == nullptr)
-        {
-            throw internal_error("temporary \""
-                + name
-                + "\" not found in generate_load_string_size()");
-        }
-        if(temp_var->get_type() != node_t::NODE_STRING)
-        {
-            throw internal_error("temporary \""
-                + name
-                + "\" in generate_load_string_size() is not of type string.");
-        }
-        ssize_t const offset(temp_var->get_offset() + offsetof(binary_variable, f_data_size));
-        integer_size_t const offset_size(get_smallest_size(offset));
-        switch(offset_size)
-        {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {  // MOV disp8(%rbp), %eax
-                    0x8B,
-                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                    static_cast<std::uint8_t>(offset),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
-
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {  // MOV disp32(%rbp), %eax
-                    0x8B,
-                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                    static_cast<std::uint8_t>(offset >>  0),
-                    static_cast<std::uint8_t>(offset >>  8),
-                    static_cast<std::uint8_t>(offset >> 16),
-                    static_cast<std::uint8_t>(offset >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
-
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
-            //
-            throw not_implemented("offset size not yet supported for \""
-                + name
-                + "\" (type: "
-                + std::to_string(static_cast<int>(offset_size))
-                + " for size: "
-                + std::to_string(offset)
-                + ").");
+    typedef void (*entry_point)(binary_variable *);
 
-        }
-    }
-    else if(d->is_extern())
+    try
     {
-        std::size_t const pos(f_file.get_current_text_offset());
-        std::uint8_t buf[] = {      // MOV disp32(%rip), %eax
-            0x8B,
-            static_cast<std::uint8_t>(0x05 + ((static_cast<int>(reg) & 7) << 3)),
-            0x00,
-            0x00,
-            0x00,
-            0x00,
-        };
-        f_file.add_text(buf, sizeof(buf));
-        f_file.add_relocation(
-                  d->get_string()
-                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA_SIZE
-                , pos + 2
-                , f_file.get_current_text_offset());
+        context_scope const scope(context);
+        reinterpret_cast<entry_point>(f_text)(context.get_variables());
     }
-    else
+    catch(...)
     {
-        throw not_implemented("load string size not implemented for this data type?!");
+        clear_utf8_indexes();
+        context.release_arena();
+        throw;
     }
+    clear_utf8_indexes();
+    context.release_arena();
 }
 
 
-void binary_assembler::generate_pointer_to_temporary(temporary_variable * temp_var, register_t reg)
+/** \brief Run the code once per row of a batch of inputs.
+ *
+ * This function executes the code \p rows times. Before each execution,
+ * the value found in each column at that row is saved in the
+ * corresponding variable and after the execution the result is saved
+ * in \p results at that same row.
+ *
+ * The loop happens here so the caller does not have to set each variable
+ * and create a binary_result object for each row. The variables are
+ * verified once before starting the loop.
+ *
+ * \exception incompatible_type
+ * The type of a column does not match the type of its variable or the
+ * type of \p results does not match the type returned by the script.
+ *
+ * \param[in,out] context  The context holding the variables.
+ * \param[in] columns  The columns of input values.
+ * \param[in] rows  The number of rows in each column and in \p results.
+ * \param[out] results  The array receiving the results.
+ */
+template<typename T>
+void running_file::run_batch_rows(
+      execution_context & context
+    , batch_column::vector_t const & columns
+    , std::size_t rows
+    , T * results
+    , variable_type_t type) const
 {
-    ssize_t const offset(temp_var->get_offset());
-    integer_size_t const offset_size(get_smallest_size(offset));
-    switch(offset_size)
+    if(f_header == nullptr)
     {
-    case integer_size_t::INTEGER_SIZE_1BIT:
-    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-        {
-            std::uint8_t buf[] = {  // REX.W LEA disp8(%rbp), %rn
-                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                0x8D,
-                static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                static_cast<std::uint8_t>(offset),
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-        break;
+        throw invalid_data("running_file has no data.");
+    }
+    if(context.get_running_file() != this
+    || context.variable_size() != f_header->f_variable_count)
+    {
+        throw invalid_data("the execution context was not created by this running_file.");
+    }
+    if(f_header->f_return_type != type)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED);
+        msg << "the script returns a value of type \""
+            << variable_type_to_string(f_header->f_return_type)
+            << "\" and run_batch() was called with an array of \""
+            << variable_type_to_string(type)
+            << "\".";
+        throw incompatible_type(msg.str());
+    }
 
-    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+    std::vector<binary_variable *> vars;
+    vars.reserve(columns.size());
+    for(auto const & c : columns)
+    {
+        int const index(c.get_handle().get_index());
+        if(static_cast<std::size_t>(index) >= context.variable_size())
         {
-            std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rn
-                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                0x8D,
-                static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                static_cast<std::uint8_t>(offset >>  0),
-                static_cast<std::uint8_t>(offset >>  8),
-                static_cast<std::uint8_t>(offset >> 16),
-                static_cast<std::uint8_t>(offset >> 24),
-            };
-            f_file.add_text(buf, sizeof(buf));
+            throw out_of_range("run_batch() called with an invalid variable handle.");
         }
-        break;
+        binary_variable * v(context.get_variables() + index);
+        if(v->f_type != c.get_type())
+        {
+            message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+            msg << "run_batch() column of type \""
+                << variable_type_to_string(c.get_type())
+                << "\" used with variable \""
+                << get_variable_name(index)
+                << "\" of type \""
+                << variable_type_to_string(v->f_type)
+                << "\".";
+            throw incompatible_type(msg.str());
+        }
+        vars.push_back(v);
+    }
 
-    default:
-        // x86-64 only supports disp8 and disp32
-        //
-        // for larger offsets we would need to use an
-        // index register; but we should never go over
-        // disp32 on the stack anyway since it's only 2Mb
-        //
-        throw not_implemented("offset size not yet supported for \""
-            + temp_var->get_name()
-            + "\" (type: "
-            + std::to_string(static_cast<int>(offset_size))
-            + " for size: "
-            + std::to_string(offset)
-            + ").");
+    binary_variable const * var(context.find_variable("%result"));
 
+    std::size_t const max_columns(columns.size());
+    for(std::size_t row(0); row < rows; ++row)
+    {
+        for(std::size_t col(0); col < max_columns; ++col)
+        {
+            columns[col].apply(vars[col], row);
+        }
+        call_entry(context);
+        get_result(var, results[row]);
     }
 }
 
 
-void binary_assembler::generate_pointer_to_variable(data::pointer_t d, register_t const reg, int adjust_offset)
+void running_file::run_batch(
+      execution_context & context
+    , batch_column::vector_t const & columns
+    , std::size_t rows
+    , bool * results) const
 {
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
+    run_batch_rows(context, columns, rows, results, VARIABLE_TYPE_BOOLEAN);
+}
+
+
+void running_file::run_batch(
+      execution_context & context
+    , batch_column::vector_t const & columns
+    , std::size_t rows
+    , std::int64_t * results) const
+{
+    run_batch_rows(context, columns, rows, results, VARIABLE_TYPE_INTEGER);
+}
+
+
+void running_file::run_batch(
+      execution_context & context
+    , batch_column::vector_t const & columns
+    , std::size_t rows
+    , double * results) const
+{
+    run_batch_rows(context, columns, rows, results, VARIABLE_TYPE_FLOATING_POINT);
+}
+
+
+void running_file::run_batch(
+      execution_context & context
+    , batch_column::vector_t const & columns
+    , std::size_t rows
+    , std::string * results) const
+{
+    run_batch_rows(context, columns, rows, results, VARIABLE_TYPE_STRING);
+}
+
+
+
+
+
+
+
+
+/** \brief Define a column of boolean values.
+ *
+ * The column does not make a copy of the values. The array must remain
+ * valid until the running_file::run_batch() function returns.
+ *
+ * \param[in] handle  The variable receiving the values.
+ * \param[in] values  The array of values, one per row.
+ */
+batch_column::batch_column(variable_handle const & handle, bool const * values)
+    : f_handle(handle)
+    , f_type(VARIABLE_TYPE_BOOLEAN)
+    , f_values(values)
+{
+}
+
+
+batch_column::batch_column(variable_handle const & handle, std::int64_t const * values)
+    : f_handle(handle)
+    , f_type(VARIABLE_TYPE_INTEGER)
+    , f_values(values)
+{
+}
+
+
+batch_column::batch_column(variable_handle const & handle, double const * values)
+    : f_handle(handle)
+    , f_type(VARIABLE_TYPE_FLOATING_POINT)
+    , f_values(values)
+{
+}
+
+
+batch_column::batch_column(variable_handle const & handle, std::string const * values)
+    : f_handle(handle)
+    , f_type(VARIABLE_TYPE_STRING)
+    , f_values(values)
+{
+}
+
+
+variable_handle const & batch_column::get_handle() const
+{
+    return f_handle;
+}
+
+
+variable_type_t batch_column::get_type() const
+{
+    return f_type;
+}
+
+
+/** \brief Save the value of a row in a variable.
+ *
+ * The caller is expected to have verified that the type of the variable
+ * matches the type of this column.
+ *
+ * \param[in,out] v  The variable receiving the value.
+ * \param[in] row  The row to copy.
+ */
+void batch_column::apply(binary_variable * v, std::size_t row) const
+{
+    switch(f_type)
     {
-    case node_t::NODE_STRING:
-        generate_reg_mem_string(d, reg, adjust_offset);
+    case VARIABLE_TYPE_BOOLEAN:
+        v->f_data_size = sizeof(bool);
+        v->f_data = static_cast<bool const *>(f_values)[row];
         break;
 
-    case node_t::NODE_VARIABLE:
-        if(d->is_temporary())
-        {
-            std::string const name(n->get_string());
-            temporary_variable * temp_var(f_file.find_temporary_variable(name));
-            if(temp_var == nullptr)
-            {
-                throw internal_error("temporary \""
-                    + name
-                    + "\" not found in generate_pointer_to_variable()");
-            }
-std::cerr << "--- generate pointer to temp var \"" << name << "\".\n";
-            generate_pointer_to_temporary(temp_var, reg);
-        }
-        else if(d->is_extern())
-        {
-            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
-            if(var == nullptr)
-            {
-                throw internal_error(
-                      "extern variable \""
-                    + d->get_string()
-                    + "\" not found in generate_pointer_to_variable()");
-            }
-            std::size_t pos(f_file.get_current_text_offset());
-            std::uint8_t buf[] = {      // REX.W LEA disp32(%rip), %rn
-                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                0x8D,
-                static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-            };
-            f_file.add_text(buf, sizeof(buf));
-            f_file.add_relocation(
-                      d->get_string()
-                    , relocation_t::RELOCATION_VARIABLE_32BITS
-                    , pos + 3
-                    , f_file.get_current_text_offset() + adjust_offset);
-        }
-        else
-        {
-            throw not_implemented("WARNING: generate_pointer_to_variable() hit a variable type not yet implemented...");
-        }
+    case VARIABLE_TYPE_INTEGER:
+        v->f_data_size = sizeof(std::int64_t);
+        v->f_data = static_cast<std::int64_t const *>(f_values)[row];
+        break;
+
+    case VARIABLE_TYPE_FLOATING_POINT:
+        v->f_data_size = sizeof(double);
+        memcpy(&v->f_data, static_cast<double const *>(f_values) + row, sizeof(double));
+        break;
+
+    case VARIABLE_TYPE_STRING:
+        set_string_variable(v, static_cast<std::string const *>(f_values)[row]);
         break;
 
     default:
-        throw not_implemented(
-              "WARNING: generate_pointer_to_variable() hit data type "
-            + std::to_string(static_cast<int>(d->get_data_type()))
-            + "/"
-            + node::type_to_string(d->get_data_type())
-            + " not yet implemented...");
+        throw internal_error("unsupported batch_column type in batch_column::apply().");
 
     }
 }
 
 
-void binary_assembler::generate_store_integer(data::pointer_t d, register_t const reg)
+
+
+
+
+
+
+void binary_result::set_type(variable_type_t type)
 {
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
-    {
-    case node_t::NODE_VARIABLE:
-        {
-            std::string const name(n->get_string());
-            if(d->is_temporary())
-            {
-                // TODO: add a map so we can find these at once instead of
-                //       having a search through all those vars.
-                //
-                temporary_variable * temp_var(f_file.find_temporary_variable(name));
-                if(temp_var == nullptr)
-                {
-                    throw internal_error("temporary not found in generate_store_integer()");
-                }
-                switch(temp_var->get_size())
-                {
-                case 1: // Boolean
-                    {
-                        ssize_t const offset(temp_var->get_offset());
-                        integer_size_t const offset_size(get_smallest_size(offset));
-                        switch(offset_size)
-                        {
-                        case integer_size_t::INTEGER_SIZE_1BIT:
-                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                            if(reg >= register_t::REGISTER_RSP)
-                            {
-                                std::uint8_t buf[] = {    // MOV %rn.b, disp8(%rbp)
-                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                    0x88,
-                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                                                                // 'r' and disp(rbp) (r/m)
-                                    static_cast<std::uint8_t>(offset),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            else
-                            {
-                                std::uint8_t buf[] = {    // MOV %rn.b, disp8(%rbp)
-                                    0x88,
-                                    static_cast<std::uint8_t>(0x45 | (static_cast<int>(reg) << 3)),
-                                    static_cast<std::uint8_t>(offset),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
+    f_type = type;
+}
 
-                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                            if(reg >= register_t::REGISTER_RSP)
-                            {
-                                std::uint8_t buf[] = {    // REX.W MOV %rn.b, disp8(%rbp)
-                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                    0x88,
-                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                                    static_cast<std::uint8_t>(offset >>  0),
-                                    static_cast<std::uint8_t>(offset >>  8),
-                                    static_cast<std::uint8_t>(offset >> 16),
-                                    static_cast<std::uint8_t>(offset >> 24),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            else
-                            {
-                                std::uint8_t buf[] = {    // REX.W MOV %rn.b, disp32(%rbp)
-                                    0x88,
-                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                                    static_cast<std::uint8_t>(offset >>  0),
-                                    static_cast<std::uint8_t>(offset >>  8),
-                                    static_cast<std::uint8_t>(offset >> 16),
-                                    static_cast<std::uint8_t>(offset >> 24),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
 
-                        default:
-                            // x86-64 only supports disp8 and disp32
-                            //
-                            // for larger offsets we would need to use an
-                            // index register; but we should never go over
-                            // disp32 on the stack anyway since it's only 2Mb
-                            //
-                            throw not_implemented("offset size not supported yet in "
-                                + temp_var->get_name()
-                                + " (type: "
-                                + std::to_string(static_cast<int>(offset_size))
-                                + " for size: "
-                                + std::to_string(offset)
-                                + ").");
+variable_type_t binary_result::get_type() const
+{
+    return f_type;
+}
 
-                        }
-                    }
-                    break;
 
-                case 8: // Integer / Double
-                    {
-                        ssize_t const offset(temp_var->get_offset());
-                        integer_size_t const offset_size(get_smallest_size(offset));
-                        switch(offset_size)
-                        {
-                        case integer_size_t::INTEGER_SIZE_1BIT:
-                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                            {
-                                std::uint8_t buf[] = {   // REX.W MOV %rn, disp8(%rbp)
-                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                    0x89,
-                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                                    static_cast<std::uint8_t>(offset),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
+void binary_result::set_boolean(bool value)
+{
+    f_type = VARIABLE_TYPE_BOOLEAN;
+    f_value[0] = static_cast<std::uint64_t>(value);
+}
 
-                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                            {
-                                std::uint8_t buf[] = {   // REX.W MOV %rn, disp32(%rbp)
-                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                    0x89,
-                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                                    static_cast<std::uint8_t>(offset >>  0),
-                                    static_cast<std::uint8_t>(offset >>  8),
-                                    static_cast<std::uint8_t>(offset >> 16),
-                                    static_cast<std::uint8_t>(offset >> 24),
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
 
-                        default:
-                            // x86-64 only supports disp8 and disp32
-                            //
-                            // for larger offsets we would need to use an
-                            // index register; but we should never go over
-                            // disp32 on the stack anyway since it's only 2Mb
-                            //
-                            throw not_implemented("offset size not supported yet in "
-                                + temp_var->get_name()
-                                + " (type: "
-                                + std::to_string(static_cast<int>(offset_size))
-                                + " for size: "
-                                + std::to_string(offset)
-                                + ").");
+bool binary_result::get_boolean() const
+{
+    return static_cast<bool>(f_value[0]);
+}
 
-                        }
-                    }
-                    break;
 
-                case sizeof(binary_variable):
-                    if(!n->get_flag(flag_t::NODE_VARIABLE_FLAG_VARIABLE))
-                    {
-                        throw not_implemented("temporary size not supported yet (sizeof(binary_varible) when the NODE_VARIABLE_FLAG_VARIABLE is not set)");
-                    }
-                    generate_save_reg_in_binary_variable(temp_var, reg, get_type_of_node(d->get_node()));
-                    break;
+void binary_result::set_integer(std::int64_t value)
+{
+    f_type = VARIABLE_TYPE_INTEGER;
+    f_value[0] = value;
+}
 
-                default:
-                    throw not_implemented("temporary size not yet supported in generate_store_integer()");
 
-                }
-            }
-            else if(d->is_extern())
-            {
-                std::size_t const pos(f_file.get_current_text_offset());
-                std::uint8_t buf[] = {
-                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                                                // 64 bits
-                    0x89,                       // MOV r := m
-                    static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                                                // 'r' and disp(rip) (r/m)
-                    0x00,                       // 32 bit offset
-                    0x00,
-                    0x00,
-                    0x00,
-                };
-                f_file.add_text(buf, sizeof(buf));
-                f_file.add_relocation(
-                          d->get_string()
-                        , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                        , pos + 3
-                        , f_file.get_current_text_offset());
-            }
-            else
-            {
-                throw not_implemented("generate_store_integer() unhandled variable type.");
-            }
-        }
-        break;
+std::int64_t binary_result::get_integer() const
+{
+    return f_value[0];
+}
 
-    default:
-        throw not_implemented("generate_store_integer() hit a data type other than already implemented.");
 
-    }
+void binary_result::set_floating_point(double value)
+{
+    f_type = VARIABLE_TYPE_FLOATING_POINT;
+
+    // use intermediate pointer to avoid the strict aliasing issue
+    //
+    double const * value_ptr(&value);
+    f_value[0] = *reinterpret_cast<std::uint64_t const *>(value_ptr);
 }
 
 
-void binary_assembler::generate_store_floating_point(data::pointer_t d, register_t const reg)
+double binary_result::get_floating_point() const
 {
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
+    std::uint64_t const * value_ptr(f_value + 0);
+    return *reinterpret_cast<double const *>(value_ptr);
+}
+
+
+void binary_result::set_string(std::string const & value)
+{
+    f_type = VARIABLE_TYPE_STRING;
+    f_string = value;
+    f_string_view = std::string_view();
+}
+
+
+/** \brief Set the result to a string without copying it.
+ *
+ * The result keeps a reference to \p value. The caller is responsible
+ * for keeping the string alive for as long as the result is in use.
+ * running_file::run() uses this function to reference the %result
+ * variable of the execution context, which remains valid until the
+ * next run with that context.
+ *
+ * \param[in] value  The string to reference.
+ */
+void binary_result::set_string_view(std::string_view value)
+{
+    f_type = VARIABLE_TYPE_STRING;
+    f_string.clear();
+    f_string_view = value;
+}
+
+
+std::string binary_result::get_string() const
+{
+    return std::string(get_string_view());
+}
+
+
+/** \brief Get the string result without copying it.
+ *
+ * When the result was set by running_file::run(), the view remains
+ * valid until the next run with the same execution context. Use
+ * get_string() to keep a copy of the result.
+ *
+ * \return A view of the string result.
+ */
+std::string_view binary_result::get_string_view() const
+{
+    if(f_string_view.data() != nullptr)
     {
-    case node_t::NODE_VARIABLE:
-        {
-            std::string const name(n->get_string());
-            if(d->is_temporary())
-            {
-                // TODO: add a map so we can find these at once instead of
-                //       having a search through all those vars.
-                //
-                temporary_variable * temp_var(f_file.find_temporary_variable(name));
-                if(temp_var == nullptr)
-                {
-                    throw internal_error("temporary not found in generate_store_floating_point()");
-                }
-                switch(temp_var->get_type())
-                {
-                case node_t::NODE_DOUBLE:
-                    {
-                        ssize_t const offset(temp_var->get_offset());
-                        integer_size_t const offset_size(get_smallest_size(offset));
-                        switch(offset_size)
-                        {
-                        case integer_size_t::INTEGER_SIZE_1BIT:
-                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                            {
-                                std::uint8_t buf[] = {    // MOVSD %xmm, disp8(%rbp)
-                                    0xF2,
-                                    // TODO: if reg >= 8 insert 0x44
-                                    0x0F,
-                                    0x11,
-                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                                                                // 'r' and disp(rbp) (r/m)
-                                    static_cast<std::uint8_t>(offset),
-                                                                // 8 bit offset
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
+        return f_string_view;
+    }
+    return f_string;
+}
 
-                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                            {
-                                std::uint8_t buf[] = {    // MOVSD %xmm, disp32(%rbp)
-                                    0xF2,
-                                    // TODO: if reg >= 8 insert 0x44
-                                    0x0F,
-                                    0x11,
-                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                                                                // 'r' and disp(rbp) (r/m)
-                                    static_cast<std::uint8_t>(offset >>  0),
-                                    static_cast<std::uint8_t>(offset >>  8),
-                                    static_cast<std::uint8_t>(offset >> 16),
-                                    static_cast<std::uint8_t>(offset >> 24),
-                                                                // 32 bit offset
-                                };
-                                f_file.add_text(buf, sizeof(buf));
-                            }
-                            break;
 
-                        default:
-                            // x86-64 only supports disp8 and disp32
-                            //
-                            // for larger offsets we would need to use an
-                            // index register; but we should never go over
-                            // disp32 on the stack anyway since it's only 2Mb
-                            //
-                            throw not_implemented("offset size not supported yet in "
-                                + temp_var->get_name()
-                                + " (type: "
-                                + std::to_string(static_cast<int>(offset_size))
-                                + " for size: "
-                                + std::to_string(offset)
-                                + ").");
 
-                        }
-                    }
-                    break;
 
-                default:
-                    throw not_implemented("temporary size not yet supported in generate_store_floating_point()");
 
-                }
-            }
-            else if(d->is_extern())
-            {
-                std::size_t const pos(f_file.get_current_text_offset());
-                std::uint8_t buf[] = {    // MOVSD %xmm, disp32(%rip)
-                    0xF2,
-                    // TODO: if reg >= 8 insert 0x44
-                    0x0F,
-                    0x11,
-                    static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
-                    0x00,
-                    0x00,
-                    0x00,
-                    0x00,
-                };
-                f_file.add_text(buf, sizeof(buf));
-                f_file.add_relocation(
-                          d->get_string()
-                        , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                        , pos + 4
-                        , f_file.get_current_text_offset());
-            }
-            else
-            {
-                throw not_implemented("generate_store_floating_point() unhandled variable type.");
-            }
-        }
-        break;
 
-    default:
-        throw not_implemented("generate_store_floating_point() hit a data type other than already implemented.");
 
-    }
-}
 
 
-void binary_assembler::generate_store_string(data::pointer_t d, register_t const reg)
+
+
+
+
+
+
+binary_assembler::binary_assembler(
+          base_stream::pointer_t output
+        , options::pointer_t o
+        , compiler::pointer_t c)
+    : f_output(output)
+    , f_options(o)
+    , f_compiler(c)
 {
-    // reg is pointer to a variable_t to be copied
-    //
-    node::pointer_t n(d->get_node());
-    switch(d->get_data_type())
-    {
-    case node_t::NODE_STRING:
-        throw not_implemented("generate_store_string() hit data type STRING which is a constant and you cannot store in a constant.");
+    //if(!rt_functions_oar.empty())
+    //{
+    //    f_rt_functions_oar = rt_functions_oar;
+    //}
+}
 
-    case node_t::NODE_VARIABLE:
-        {
-            std::string const name(n->get_string());
-            if(d->is_temporary())
-            {
-                // TODO: add a map so we can find these at once instead of
-                //       having a search through all those vars.
-                //
-                temporary_variable * temp_var(f_file.find_temporary_variable(name));
-                if(temp_var == nullptr)
-                {
-                    throw internal_error("temporary not found in generate_store_string().");
-                }
-                if(temp_var->get_type() != node_t::NODE_STRING)
-                {
-                    throw internal_error("temporary in generate_store_string() is not of type string.");
-                }
 
-                // load source if not already RSI
-                //
-                if(reg != register_t::REGISTER_RSI)
-                {
-                    std::uint8_t buf[] = {       // MOV %rn, %rsi
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        0x89,
-                        static_cast<std::uint8_t>(0xC6 | ((static_cast<int>(reg) & 7) << 3)),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
+base_stream::pointer_t binary_assembler::get_output()
+{
+    return f_output;
+}
 
-                // load destination
-                //
-                ssize_t const offset(temp_var->get_offset());
-                switch(get_smallest_size(offset))
-                {
-                case integer_size_t::INTEGER_SIZE_1BIT:
-                case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-                    {
-                        std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rdi
-                            0x48,
-                            0x8D,
-                            0x7D,
-                            static_cast<std::uint8_t>(offset),
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                    }
-                    break;
 
-                case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-                case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
-                case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-                case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-                    {
-                        std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rdi
-                            0x48,
-                            0x8D,
-                            0xBD,
-                            static_cast<std::uint8_t>(offset >>  0),
-                            static_cast<std::uint8_t>(offset >>  8),
-                            static_cast<std::uint8_t>(offset >> 16),
-                            static_cast<std::uint8_t>(offset >> 24),
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                    }
-                    break;
+options::pointer_t binary_assembler::get_options()
+{
+    return f_options;
+}
 
-                default:
-                    throw not_implemented("generate_store_string() unhandled integer size for displacement.");
 
-                };
+/** \brief Transform the tree in a binary file.
+ *
+ * This function generates the code of the compiled tree \p root and
+ * saves the resulting binary file in the output stream passed to the
+ * constructor.
+ *
+ * \param[in] root  The compiled tree.
+ *
+ * \return The number of errors which occurred.
+ */
+int binary_assembler::output(node::pointer_t root)
+{
+    int const save_errcnt(error_count());
 
-                generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
-            }
-            else if(d->is_extern())
-            {
-                // load source if not already RSI
-                //
-                if(reg != register_t::REGISTER_RSI)
-                {
-                    std::uint8_t buf[] = {       // MOV %rn, %rsi
-                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                        0x89,
-                        static_cast<std::uint8_t>(0xC6 | ((static_cast<int>(reg) & 7) << 3)),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
+    if(generate(root))
+    {
+        // it worked, save the results
+        //
+std::cerr << "----- start saving...\n";
+        f_file.save(f_output);
+std::cerr << "----- end saving...\n";
+    }
 
-                std::size_t const pos(f_file.get_current_text_offset());
-                std::uint8_t buf[] = {      // LEA disp32(%rip), %rdi
-                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                    0x8D,
-                    0x3D,
-                    0x00,
-                    0x00,
-                    0x00,
-                    0x00,
-                };
-                f_file.add_text(buf, sizeof(buf));
-                f_file.add_relocation(
-                          d->get_string()
-                        , relocation_t::RELOCATION_VARIABLE_32BITS
-                        , pos + 3
-                        , f_file.get_current_text_offset());
+    return error_count() - save_errcnt;
+}
 
-                generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
-            }
-            else
-            {
-                throw not_implemented("generate_store_string() unhandled variable type.");
-            }
-        }
-        break;
 
-    default:
-        throw not_implemented(
-              "generate_store_string() hit data type "
-            + std::string(node::type_to_string(d->get_data_type()))
-            + " which is not yet implemented.");
+/** \brief Transform the tree in a running_file.
+ *
+ * This function generates the code of the compiled tree \p root and
+ * loads it in \p file, ready to run. The image is created directly in
+ * page aligned memory so there is no file to write and read back. The
+ * output stream passed to the constructor is not used and can be null.
+ *
+ * \param[in] root  The compiled tree.
+ * \param[out] file  The running_file receiving the image.
+ *
+ * \return The number of errors which occurred.
+ */
+int binary_assembler::output(node::pointer_t root, running_file & file)
+{
+    int const save_errcnt(error_count());
 
+    if(generate(root))
+    {
+        file.load(f_file);
     }
+
+    return error_count() - save_errcnt;
 }
 
 
-void binary_assembler::generate_external_function_call(external_function_t func)
+bool binary_assembler::generate(node::pointer_t root)
 {
-    // load pointer to table in RAX
-    //
-    generate_reg_mem_integer(f_extern_functions, register_t::REGISTER_RAX);
+std::cerr << "----- start flattening...\n";
+    flatten_nodes::pointer_t fn(flatten(root, f_compiler));
+std::cerr << "----- end flattening... (";
+if(fn == nullptr)
+{
+std::cerr << "<nullptr>";
+}
+else
+{
+std::cerr << fn->get_operations().size();
+}
+std::cerr << ")\n";
 
-    offset_t const disp(static_cast<offset_t>(func) * 8);
-    if(disp == 0)
+    if(fn == nullptr)
     {
-        std::uint8_t buf[] = {
-            0xFF,       // CALL *(%rax)
-            0x10,
-        };
-        f_file.add_text(buf, sizeof(buf));
+        return false;
     }
-    else if(disp < 128)
+
+    // common subexpressions, copies, constants, dead temporaries
+    //
+    fn->optimize();
+
+    // generate binary output
+    //
+std::cerr << "----- start generating... (" << fn->get_operations().size() << ")\n";
+    generate_amd64_code(fn);
+std::cerr << "----- end generating... (" << fn->get_operations().size() << ")\n";
+
+    return true;
+}
+
+
+variable_type_t binary_assembler::get_type_of_node(node::pointer_t n)
+{
+    node::pointer_t type_node(n->get_type_node());
+    if(type_node == nullptr)
     {
-        std::uint8_t buf[] = {
-            0xFF,       // CALL *disp8(%rax)
-            0x50,
-            static_cast<std::uint8_t>(disp),
-        };
-        f_file.add_text(buf, sizeof(buf));
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_INVALID_TYPE, n->get_position());
+        msg << "no type found for node of type: \""
+            << n->get_type_name()
+            << "\".";
+        throw internal_error(msg.str());
     }
-    else
+
+    if(type_node->get_type() != node_t::NODE_CLASS
+    || !type_node->get_attribute(attribute_t::NODE_ATTR_NATIVE))
     {
-        std::uint8_t buf[] = {
-            0xFF,       // CALL *disp32(%rax)
-            0x90,
-            static_cast<std::uint8_t>(disp >>  0),
-            static_cast<std::uint8_t>(disp >>  8),
-            static_cast<std::uint8_t>(disp >> 16),
-            static_cast<std::uint8_t>(disp >> 24),
-        };
-        f_file.add_text(buf, sizeof(buf));
+        return VARIABLE_TYPE_UNKNOWN;
     }
-}
+    std::string const & type_name(type_node->get_string());
 
+    if(type_name == "Boolean")
+    {
+        return VARIABLE_TYPE_BOOLEAN;
+    }
 
-void binary_assembler::generate_absolute_value(operation::pointer_t op)
-{
-    data::pointer_t lhs(op->get_left_handside());
-    //variable_type_t const type(get_type_of_node(lhs->get_node()));
-    node_t const type(lhs->get_node()->get_type());
-//std::cerr << "--- generate absolute value =\n"
-//<< *lhs->get_node()
-//<< "\n"
-//<< "--- with lhs type = " << static_cast<int>(type)
-//<< "\n";
-    switch(type)
+    if(type_name == "Integer" || type_name == "CompareResult")
     {
-    case node_t::NODE_INTEGER:
-        {
-            variable_type_t const var_type(get_type_of_node(lhs->get_node()));
-            switch(var_type)
-            {
-            case VARIABLE_TYPE_INTEGER:
-                {
-                    // integers to integer (function abs(Integer) : Integer)
-                    //
-                    // TBD: err if integer is out of range? (i.e. MIN_INT)
-                    //
-                    std::int64_t const value(llabs(lhs->get_node()->get_integer().get()));
-                    std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                        0x48,
-                        0xB8,
-                        static_cast<std::uint8_t>(value >>  0),
-                        static_cast<std::uint8_t>(value >>  8),
-                        static_cast<std::uint8_t>(value >> 16),
-                        static_cast<std::uint8_t>(value >> 24),
-                        static_cast<std::uint8_t>(value >> 32),
-                        static_cast<std::uint8_t>(value >> 40),
-                        static_cast<std::uint8_t>(value >> 48),
-                        static_cast<std::uint8_t>(value >> 56),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
+        return VARIABLE_TYPE_INTEGER;
+    }
 
-                    generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-                }
-                break;
+    if(type_name == "Double" || type_name == "Number")
+    {
+        return VARIABLE_TYPE_FLOATING_POINT;
+    }
 
-            default:
-                throw not_implemented("generate_absolute_value() unhandled result type for integers.");
+    if(type_name == "String")
+    {
+        return VARIABLE_TYPE_STRING;
+    }
 
-            }
-        }
-        break;
+    if(type_name == "Range")
+    {
+        return VARIABLE_TYPE_RANGE;
+    }
 
-    case node_t::NODE_FLOATING_POINT:
-        {
-            double const floating_point(fabs(lhs->get_node()->get_floating_point().get()));
-            double const * fp(&floating_point);
-            std::int64_t const value(*reinterpret_cast<std::int64_t const *>(fp));
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                static_cast<std::uint8_t>(value >>  0),
-                static_cast<std::uint8_t>(value >>  8),
-                static_cast<std::uint8_t>(value >> 16),
-                static_cast<std::uint8_t>(value >> 24),
-                static_cast<std::uint8_t>(value >> 32),
-                static_cast<std::uint8_t>(value >> 40),
-                static_cast<std::uint8_t>(value >> 48),
-                static_cast<std::uint8_t>(value >> 56),
-            };
-            f_file.add_text(buf, sizeof(buf));
+    return VARIABLE_TYPE_UNKNOWN;
+}
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-        }
+
+/** \brief Check whether an operation can work with temporaries in registers.
+ *
+ * The register allocator only keeps a temporary in a register when all
+ * the operations referencing it were verified to access their operands
+ * exclusively through generate_reg_mem_integer(),
+ * generate_reg_mem_floating_point(), generate_store_integer(), and
+ * generate_store_floating_point(). Those functions know how to use
+ * the register instead of the stack.
+ *
+ * The operands must also all be numbers. Strings and other objects
+ * go through external functions which do not preserve the XMM registers.
+ *
+ * \param[in] op  The operation to check.
+ *
+ * \return true if the operation supports temporaries in registers.
+ */
+bool binary_assembler::is_register_operation(operation::pointer_t op)
+{
+    switch(op->get_operation())
+    {
+    case node_t::NODE_ADD:
+    case node_t::NODE_ASSIGNMENT:
+    case node_t::NODE_ASSIGNMENT_ADD:
+    case node_t::NODE_ASSIGNMENT_BITWISE_AND:
+    case node_t::NODE_ASSIGNMENT_BITWISE_OR:
+    case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
+    case node_t::NODE_ASSIGNMENT_MULTIPLY:
+    case node_t::NODE_ASSIGNMENT_SUBTRACT:
+    case node_t::NODE_BITWISE_AND:
+    case node_t::NODE_BITWISE_NOT:
+    case node_t::NODE_BITWISE_OR:
+    case node_t::NODE_BITWISE_XOR:
+    case node_t::NODE_CONDITIONAL:
+    case node_t::NODE_IDENTITY:
+    case node_t::NODE_MULTIPLY:
+    case node_t::NODE_NEGATE:
+    case node_t::NODE_RETURN:
+    case node_t::NODE_SUBTRACT:
         break;
 
-    case node_t::NODE_VARIABLE:
+    default:
+        return false;
+
+    }
+
+    data::pointer_t const operands[] = {
+        op->get_left_handside(),
+        op->get_right_handside(),
+        op->get_result(),
+    };
+    for(auto const & d : operands)
+    {
+        if(d == nullptr)
         {
-            variable_type_t const var_type(get_type_of_node(lhs->get_node()));
-            switch(var_type)
+            continue;
+        }
+        switch(d->get_data_type())
+        {
+        case node_t::NODE_BOOLEAN:
+        case node_t::NODE_INTEGER:
+        case node_t::NODE_FLOATING_POINT:
+            break;
+
+        case node_t::NODE_VARIABLE:
+            if(d->get_node()->get_type_node() == nullptr)
             {
+                return false;
+            }
+            switch(get_type_of_node(d->get_node()))
+            {
+            case VARIABLE_TYPE_BOOLEAN:
             case VARIABLE_TYPE_INTEGER:
-                generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-                {
-                    // ABS %rax with three instructions
-                    std::uint8_t buf[] = {
-                        0x48,   // REX.W MOV %rax, %rcx
-                        0x8B,
-                        0xC8,
-
-                        0x48,   // REX.W SAR $63, %rcx
-                        0xC1,
-                        0xF9,
-                        0x3F,
+            case VARIABLE_TYPE_FLOATING_POINT:
+                break;
 
-                        0x48,   // REX.W XOR %rcx, %rax
-                        0x31,
-                        0xC8,
+            default:
+                return false;
 
-                        0x48,   // REX.W SUB %rcx, %rax
-                        0x29,
-                        0xC8,
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-                break;
+            }
+            break;
 
-            case VARIABLE_TYPE_FLOATING_POINT:
-                generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+        default:
+            return false;
 
-                // there is no ABSPD instruction, use integers instructions
-                // to remove the upper bit
-                {
-                    std::uint8_t buf[] = {
-                        0x66,   // PADDQ %xmm0, %xmm0
-                        0x0F,
-                        0xD4,
-                        0xC0,
+        }
+    }
 
-                        0x66,   // PSRLQ $1, %xmm0
-                        0x0F,
-                        0x73,
-                        0xD0,
-                        0x01,
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
+    return true;
+}
 
-                generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-                break;
 
-            default:
-                throw not_implemented("generate_absolute_value() unhandled variable type.");
+/** \brief Check whether a temporary may be kept in a register.
+ *
+ * Only plain 64 bit Integer and Double temporaries are candidates.
+ * Temporaries saved in a binary_variable (NODE_VARIABLE_FLAG_VARIABLE)
+ * and the special temporaries (i.e. "%saved_rbx", "%mxcsr", all
+ * the names not starting with "%temp") always remain on the stack.
+ *
+ * \param[in] d  The data representing the temporary.
+ *
+ * \return true if the temporary can be kept in a register.
+ */
+bool binary_assembler::is_register_candidate(data::pointer_t d)
+{
+    node::pointer_t n(d->get_node());
+    std::string const & name(n->get_string());
+    if(name.compare(0, 5, "%temp") != 0
+    || n->get_flag(flag_t::NODE_VARIABLE_FLAG_VARIABLE)
+    || n->get_type_node() == nullptr)
+    {
+        return false;
+    }
 
-            }
-        }
-        break;
+    switch(get_type_of_node(n))
+    {
+    case VARIABLE_TYPE_INTEGER:
+    case VARIABLE_TYPE_FLOATING_POINT:
+        return true;
 
     default:
-        throw not_implemented(
-              "absolute value node type "
-            + std::to_string(static_cast<int>(type))
-            + " not implemented.");
+        return false;
 
     }
 }
 
 
-void binary_assembler::generate_additive(operation::pointer_t op)
+namespace
 {
-    bool is_add(false);
-    bool is_assignment(false);
-    switch(op->get_operation())
-    {
-    case node_t::NODE_ADD:
-        is_add = true;
-        break;
 
-    case node_t::NODE_ASSIGNMENT_ADD:
-        is_add = true;
-        is_assignment = true;
-        break;
 
-    case node_t::NODE_ASSIGNMENT_SUBTRACT:
-        is_assignment = true;
-        break;
+struct live_interval
+{
+    std::string     f_name = std::string();
+    bool            f_floating_point = false;
+    bool            f_defined_first = false;
+    bool            f_rejected = false;
+    std::size_t     f_start = 0;
+    std::size_t     f_end = 0;
+};
 
-    default:
-        break;
 
-    }
-    data::pointer_t lhs(op->get_left_handside());
-    data::pointer_t rhs(op->get_right_handside());
+} // no name namespace
 
-    variable_type_t const op_type(get_type_of_node(op->get_node()));
-    switch(op_type)
+
+/** \brief Assign registers to the numeric temporaries.
+ *
+ * This function runs a linear scan register allocation over the
+ * list of operations. The live interval of a temporary goes from the
+ * first to the last operation referencing it. An interval that crosses
+ * a backward jump gets extended to the whole loop since its value
+ * has to survive the next iteration.
+ *
+ * Integer temporaries get assigned to %r12 to %r15. These are callee
+ * saved so they survive calls to external functions. Since our caller
+ * expects them to be preserved, the ones we use are saved in the
+ * prologue and restored in the epilogue.
+ *
+ * Double temporaries get assigned to %xmm8 to %xmm15. All the XMM
+ * registers are caller saved, so a Double temporary is only kept in a
+ * register if no operation within its interval may call a function.
+ *
+ * When we run out of registers, the interval ending last gets spilled,
+ * meaning that it stays in its stack slot for its entire lifetime.
+ *
+ * The function gets called once for the main program and once per user
+ * function. The results are added to f_allocated_registers and applied
+ * to the temporary variables by generate_amd64_code(). The callee saved
+ * registers used by this list of operations are saved in
+ * f_saved_registers.
+ *
+ * \param[in] operations  The list of operations to allocate registers for.
+ */
+void binary_assembler::allocate_registers(operation::list_t const & operations)
+{
+    f_saved_registers.clear();
+
+    // the allocator can be turned off to compare the code generated
+    // with and without it
+    //
+    if(f_options != nullptr
+    && f_options->get_option(option_t::OPTION_NO_REGISTER_ALLOCATION) != 0)
     {
-    case VARIABLE_TYPE_FLOATING_POINT:
-        // floating points
-        //
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+        return;
+    }
 
-        switch(rhs->get_integer_size())
-        {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_64BITS:
-            //{
-            //    generate_reg_mem_floating_point(rhs, register_t::REGISTER_RCX);
-            //    std::uint8_t buf[] = {
-            //        0xF2,       // ADD or SUB %xmm1, %xmm0
-            //        0x0F,
-            //        static_cast<std::uint8_t>(is_add ? 0x58 : 0x5C),
-            //        0xC8,
-            //    };
-            //    f_file.add_text(buf, sizeof(buf));
-            //}
-            //break;
+    std::vector<operation::pointer_t> ops(operations.begin(), operations.end());
 
-        case integer_size_t::INTEGER_SIZE_FLOATING_POINT:
-            generate_reg_mem_floating_point(
-                      rhs
-                    , register_t::REGISTER_XMM0
-                    , is_add
-                        ? sse_operation_t::SSE_OPERATION_ADD
-                        : sse_operation_t::SSE_OPERATION_SUB);
+    std::map<std::string, std::size_t> labels;
+    std::map<std::string, live_interval> intervals;
+    std::vector<bool> call_free(ops.size(), false);
+    for(std::size_t idx(0); idx < ops.size(); ++idx)
+    {
+        operation::pointer_t op(ops[idx]);
+        bool const register_operation(is_register_operation(op));
+        switch(op->get_operation())
+        {
+        case node_t::NODE_LABEL:
+            labels[op->get_label()] = idx;
+            call_free[idx] = true;
             break;
 
-        default:
-            if(rhs->get_data_type() == node_t::NODE_VARIABLE)
-            {
-                // a variable needs to be loaded from memory so we need an ADD
-                // which reads the variable location
-                //
-                generate_reg_mem_floating_point(
-                          rhs
-                        , register_t::REGISTER_XMM0
-                        , is_add
-                            ? sse_operation_t::SSE_OPERATION_ADD
-                            : sse_operation_t::SSE_OPERATION_SUB);
-            }
-            else
-            {
-                if(rhs->get_data_type() != node_t::NODE_INTEGER)
-                {
-                    throw not_implemented(
-                          std::string("trying to add/subtract a \"")
-                        + node::type_to_string(rhs->get_data_type())
-                        + "\" which is not yet implemented.");
-                }
-                throw not_implemented(
-                      "found integer size "
-                    + std::to_string(static_cast<int>(rhs->get_integer_size()))
-                    + " which is not yet implemented in generate_additive().");
-            }
+        case node_t::NODE_GOTO:
+        case node_t::NODE_IF_FALSE:
+        case node_t::NODE_IF_TRUE:
+            call_free[idx] = true;
+            break;
+
+        default:
+            call_free[idx] = register_operation;
             break;
 
         }
 
-        if(is_assignment)
+        data::vector_t operands{
+            op->get_left_handside(),
+            op->get_right_handside(),
+            op->get_result(),
+        };
+        std::size_t const max(op->get_parameter_size());
+        for(std::size_t p(0); p < max; ++p)
         {
-            generate_store_floating_point(op->get_left_handside(), register_t::REGISTER_RAX);
+            operands.push_back(op->get_parameter(p));
         }
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_RAX);
-        break;
-
-    case VARIABLE_TYPE_INTEGER:
-        // integers
-        //
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-
-        switch(rhs->get_integer_size())
+        for(auto const & d : operands)
         {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            if(d == nullptr
+            || d->get_data_type() != node_t::NODE_VARIABLE
+            || !d->is_temporary())
             {
-                std::uint8_t buf[] = {
-                    0x48,       // 64 bits
-                    0x83,       // ADD or SUB r64 +/-= imm8
-                    static_cast<std::uint8_t>(is_add ? 0xC0 : 0xE8),
-                                // r/m
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get()),
-                };
-                f_file.add_text(buf, sizeof(buf));
+                continue;
             }
-            break;
-
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            std::string const & name(d->get_node()->get_string());
+            auto it(intervals.find(name));
+            if(it == intervals.end())
             {
-                std::uint8_t buf[] = {
-                    0x48,       // 64 bits
-                    static_cast<std::uint8_t>(is_add ? 0x05 : 0x2D),
-                                // ADD or SUB rax +/-= imm32
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  0),
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  8),
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 16),
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
+                live_interval interval;
+                interval.f_name = name;
+                interval.f_start = idx;
+                interval.f_end = idx;
+                interval.f_rejected = !is_register_candidate(d);
+                if(!interval.f_rejected)
+                {
+                    interval.f_floating_point = get_type_of_node(d->get_node()) == VARIABLE_TYPE_FLOATING_POINT;
+                    interval.f_defined_first = d == op->get_result()
+                                            && d != op->get_left_handside()
+                                            && d != op->get_right_handside();
+                }
+                it = intervals.insert({name, interval}).first;
             }
-            break;
-
-        case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_64BITS:
+            else
             {
-                generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
-                std::uint8_t buf[] = {       // ADD or SUB %rdx, %rax
-                    0x48,
-                    static_cast<std::uint8_t>(is_add ? 0x01 : 0x29),
-                    0xD0,
-                };
-                f_file.add_text(buf, sizeof(buf));
+                it->second.f_end = idx;
             }
-            break;
+            if(!register_operation)
+            {
+                it->second.f_rejected = true;
+            }
+        }
+    }
 
-        default:
-            if(rhs->get_data_type() == node_t::NODE_VARIABLE)
+    // a value alive across a backward jump must be kept for the whole loop
+    //
+    bool changed(true);
+    while(changed)
+    {
+        changed = false;
+        for(std::size_t idx(0); idx < ops.size(); ++idx)
+        {
+            switch(ops[idx]->get_operation())
             {
-                // a variable needs to be loaded from memory so we need an ADD
-                // which reads the variable location
-                //
-                generate_reg_mem_integer(rhs, register_t::REGISTER_RAX, static_cast<std::uint8_t>(is_add ? 0x03 : 0x2B));
+            case node_t::NODE_GOTO:
+            case node_t::NODE_IF_FALSE:
+            case node_t::NODE_IF_TRUE:
+                break;
+
+            default:
+                continue;
+
             }
-            else
+            auto const label(labels.find(ops[idx]->get_label()));
+            if(label == labels.end()
+            || label->second >= idx)
             {
-                if(rhs->get_data_type() != node_t::NODE_INTEGER)
+                continue;
+            }
+            std::size_t const loop_start(label->second);
+            for(auto & it : intervals)
+            {
+                live_interval & interval(it.second);
+                if(interval.f_end < loop_start
+                || interval.f_start > idx)
                 {
-                    throw not_implemented(
-                          std::string("trying to add/subtract a \"")
-                        + node::type_to_string(rhs->get_data_type())
-                        + "\" which is not yet implemented.");
+                    continue;
+                }
+                if(interval.f_defined_first
+                && interval.f_start > loop_start
+                && interval.f_end < idx)
+                {
+                    // defined and used within one iteration
+                    //
+                    continue;
+                }
+                if(interval.f_start > loop_start)
+                {
+                    interval.f_start = loop_start;
+                    interval.f_defined_first = false;
+                    changed = true;
+                }
+                if(interval.f_end < idx)
+                {
+                    interval.f_end = idx;
+                    changed = true;
                 }
-                throw not_implemented(
-                      "found integer size "
-                    + std::to_string(static_cast<int>(rhs->get_integer_size()))
-                    + " which is not yet implemented in generate_additive().");
             }
-            break;
-
         }
+    }
 
-        if(is_assignment)
+    std::vector<live_interval *> sorted;
+    for(auto & it : intervals)
+    {
+        live_interval & interval(it.second);
+        if(interval.f_rejected)
         {
-            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+            continue;
         }
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-        break;
-
-    case VARIABLE_TYPE_STRING:
-        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-        generate_reg_mem_string(rhs, register_t::REGISTER_RDX);
-
-        // TODO: this optimization works unless the next step makes use of
-        //       the temporary variable (which at least happens for the
-        //       last expression--a.k.a. the result)
-        //
-        //       I think those optimizations would have to happen in the
-        //       flattening step (output.cpp)
-        //
-        //if(is_assignment)
-        //{
-        //    // save the results in the same location (RSI == RDI)
-        //    //
-        //    //generate_reg_mem_string(lhs, register_t::REGISTER_RDI);
-        //    std::uint8_t buf[] = {       // MOV %rsi, %rdi
-        //        0x48,
-        //        0x89,
-        //        0xF7,
-        //    };
-        //    f_file.add_text(buf, sizeof(buf));
-        //}
-        //else
-        //{
-            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-        //}
+        if(interval.f_floating_point)
+        {
+            for(std::size_t idx(interval.f_start + 1); idx < interval.f_end; ++idx)
+            {
+                if(!call_free[idx])
+                {
+                    interval.f_rejected = true;
+                    break;
+                }
+            }
+            if(interval.f_rejected)
+            {
+                continue;
+            }
+        }
+        sorted.push_back(&interval);
+    }
+    std::stable_sort(
+              sorted.begin()
+            , sorted.end()
+            , [](live_interval const * a, live_interval const * b)
+            {
+                return a->f_start < b->f_start;
+            });
 
-        if(is_add)
+    for(int pool(0); pool < 2; ++pool)
+    {
+        bool const floating_point(pool == 1);
+        std::vector<register_t> available;
+        if(floating_point)
         {
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CONCAT);
+            available = {
+                register_t::REGISTER_XMM15,
+                register_t::REGISTER_XMM14,
+                register_t::REGISTER_XMM13,
+                register_t::REGISTER_XMM12,
+                register_t::REGISTER_XMM11,
+                register_t::REGISTER_XMM10,
+                register_t::REGISTER_XMM9,
+                register_t::REGISTER_XMM8,
+            };
         }
         else
         {
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_UNCONCAT);
+            available = {
+                register_t::REGISTER_R15,
+                register_t::REGISTER_R14,
+                register_t::REGISTER_R13,
+                register_t::REGISTER_R12,
+            };
         }
-        if(is_assignment)
+
+        // active intervals sorted by end
+        //
+        std::vector<live_interval *> active;
+        for(auto interval : sorted)
         {
-            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RSI);
-            generate_store_string(lhs, register_t::REGISTER_RSI);
-        }
-        break;
+            if(interval->f_floating_point != floating_point)
+            {
+                continue;
+            }
 
-    default:
-        throw not_implemented(
-              "additive node type "
-            + std::to_string(static_cast<int>(op_type))
-            + " not implemented.");
+            // intervals ending before this one starts release their register
+            //
+            while(!active.empty()
+               && active.front()->f_end < interval->f_start)
+            {
+                available.push_back(f_allocated_registers[active.front()->f_name]);
+                active.erase(active.begin());
+            }
+
+            if(available.empty())
+            {
+                live_interval * spill(active.back());
+                if(spill->f_end <= interval->f_end)
+                {
+                    ++f_spilled_temporaries;
+                    continue;
+                }
+                f_allocated_registers[interval->f_name] = f_allocated_registers[spill->f_name];
+                f_allocated_registers.erase(spill->f_name);
+                active.pop_back();
+                ++f_spilled_temporaries;
+            }
+            else
+            {
+                register_t const reg(available.back());
+                available.pop_back();
+                f_allocated_registers[interval->f_name] = reg;
+                if(!floating_point
+                && std::find(f_saved_registers.begin(), f_saved_registers.end(), reg) == f_saved_registers.end())
+                {
+                    f_saved_registers.push_back(reg);
+                }
+            }
 
+            active.insert(
+                      std::upper_bound(
+                              active.begin()
+                            , active.end()
+                            , interval
+                            , [](live_interval const * a, live_interval const * b)
+                            {
+                                return a->f_end < b->f_end;
+                            })
+                    , interval);
+        }
     }
 }
 
 
-void binary_assembler::generate_compare(operation::pointer_t op)
+void binary_assembler::generate_amd64_code(flatten_nodes::pointer_t fn)
 {
-    data::pointer_t lhs(op->get_left_handside());
-    data::pointer_t rhs(op->get_right_handside());
-
-    // if the left or right hand side are floating points then use the
-    // floating point compare mechanism
-    //
-    if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_FLOATING_POINT
-    || get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    if(fn->get_operations().empty())
     {
-        // TODO: if lhs or rhs is a string, we need to transform it to a
-        //       floating point first
-        //
-        std::uint8_t cmp_code(0x00);
-        bool swapped(false);
-        switch(op->get_operation())
-        {
-        case node_t::NODE_ALMOST_EQUAL:
-            {
-                generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-                generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+        throw out_of_range("the code in generate_amd64_code() expects a non-empty set of operations.");
+    }
 
-                {
-                    // this is way too long as one single block of code!
-                    //
-                    // TODO: use an external function instead, especially
-                    //       if we want to support a variable epsilon
-                    //       (right now, we use 0.00001, hard coded)
-                    //
-                    std::uint8_t buf[] = {
-                        0xF2,       // MOVSD %xmm0, %xmm3
-                        0x0F,
-                        0x10,
-                        0xD8,
+    // clear the existing file
+    //
+    f_file = {};
+    f_next_label = 0;
 
-                        0xF2,       // CMPORDSD %xmm1, %xmm3
-                        0x0F,
-                        0xC2,
-                        0xD9,
-                        0x07,
+    // on entry setup rsp & rbp
+    //
+    std::uint8_t setup_frame[] = {
+        0x55,           // PUSH %rbp
 
-                        0x66,       // REX.W MOVQ %xmm3, %rax
-                        0x48,
-                        0x0F,
-                        0x7E,
-                        0xD8,
-
-                        0x85,       // TEST %eax, %eax
-                        0xC0,
-
-                        0x74,       // JZ false
-                        0x53,
+        0x48,           // MOV %rsp, %rbp
+        0x89,
+        0xE5,
+    };
+    f_file.add_text(setup_frame, sizeof(setup_frame));
 
-                        0x66,       // COMISD %xmm0, %xmm1
-                        0x0F,
-                        0x2F,
-                        0xC8,
+    // WARNING: the type node inside the node object is a weak pointer
+    //          so we need to keep a hold of it in this function
+    //
+    node::pointer_t type_class(std::make_shared<node>(node_t::NODE_CLASS));
+    type_class->set_string("Integer");
+    type_class->set_attribute(attribute_t::NODE_ATTR_NATIVE, true);
 
-                        0x74,       // JE true
-                        0x76,
+    // the extern variables are not part of the loaded image, instead the
+    // caller passes a pointer to its own copy in %rdi and we keep that
+    // pointer in %rbx for the duration of the call; %rbx is callee saved
+    // so we need to save it in the frame and restore it on exit
+    //
+    {
+        node::pointer_t var(std::make_shared<node>(node_t::NODE_VARIABLE));
+        var->set_flag(flag_t::NODE_VARIABLE_FLAG_TEMPORARY, true);
+        var->set_string("%saved_rbx");
+        var->set_type_node(type_class); // weak pointer
 
-                        // here xmm3 is already 0xFFFFFFFF:FFFFFFFF
-                        //0xF2,       // CMPEQSD %xmm3, %xmm3
-                        //0x0F,
-                        //0xC2,
-                        //0xDB,
-                        //0x00,
+        f_saved_rbx = std::make_shared<data>(var);
+        fn->add_variable(f_saved_rbx);
+    }
 
-                        0x66,       // PSRLD $1, %xmm3
-                        0x0F,
-                        0x73,
-                        0xD3,
-                        0x01,
+    // keep numeric temporaries in registers; the callee saved registers
+    // we use get saved in temporaries of their own
+    //
+    // each user function has its own frame and saves its own registers,
+    // the frames all share the same layout so the %saved_r<N> temporaries
+    // are created once for all of them
+    //
+    f_allocated_registers.clear();
+    f_spilled_temporaries = 0;
+    std::vector<std::vector<register_t>> function_saved_registers;
+    std::vector<register_t> all_saved_registers;
+    for(auto const & f : fn->get_functions())
+    {
+        allocate_registers(f->get_operations());
+        function_saved_registers.push_back(f_saved_registers);
+        all_saved_registers.insert(all_saved_registers.end(), f_saved_registers.begin(), f_saved_registers.end());
+    }
+    allocate_registers(fn->get_operations());
+    all_saved_registers.insert(all_saved_registers.end(), f_saved_registers.begin(), f_saved_registers.end());
+    std::sort(all_saved_registers.begin(), all_saved_registers.end());
+    all_saved_registers.erase(
+              std::unique(all_saved_registers.begin(), all_saved_registers.end())
+            , all_saved_registers.end());
+    for(auto const & reg : all_saved_registers)
+    {
+        node::pointer_t var(std::make_shared<node>(node_t::NODE_VARIABLE));
+        var->set_flag(flag_t::NODE_VARIABLE_FLAG_TEMPORARY, true);
+        var->set_string("%saved_r" + std::to_string(static_cast<int>(reg)));
+        var->set_type_node(type_class); // weak pointer
 
-                        0xF2,       // MOVSD %xmm0, %xmm2
-                        0x0F,
-                        0x10,
-                        0xD0,
+        fn->add_variable(std::make_shared<data>(var));
+    }
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_DEBUG, err_code_t::AS_ERR_NONE);
+        msg << "register allocation: "
+            << f_allocated_registers.size()
+            << " temporaries in registers, "
+            << f_spilled_temporaries
+            << " spilled.";
+    }
 
-                        0xF2,       // SUBSD %xmm1, %xmm2
-                        0x0F,
-                        0x5C,
-                        0xD1,
+//for(auto const & it : fn->get_operations())
+//{
+//std::cerr << "  --  " << it->to_string() << "\n";
+//}
 
-                        0x66,       // REX.W MOVQ %xmm0, %rax
-                        0x48,
-                        0x0F,
-                        0x7E,
-                        0xC0,
+    for(auto const & it : fn->get_variables())
+    {
+        if(it.second->is_temporary())
+        {
+            // at this point, a temporary variable does not have a value,
+            // only a type and a name; temporaries automatically have a
+            // STORE before a LOAD
+            //
+            f_file.add_temporary_variable(it.first, it.second);
+        }
+        else if(it.second->is_extern())
+        {
+            f_file.add_extern_variable(it.first, it.second);
+        }
+        else
+        {
+            f_file.add_private_variable(it.first, it.second);
+        }
+    }
+    for(auto const & f : fn->get_functions())
+    {
+        for(auto const & it : f->get_variables())
+        {
+            f_file.add_temporary_variable(it.first, it.second);
+        }
+    }
 
-                        0x66,       // REX.W MOVQ %xmm1, %rdx
-                        0x48,
-                        0x0F,
-                        0x7E,
-                        0xCA,
+    for(auto const & it : f_allocated_registers)
+    {
+        temporary_variable * temp_var(f_file.find_temporary_variable(it.first));
+        if(temp_var == nullptr)
+        {
+            throw internal_error("allocated temporary not found in generate_amd64_code()");
+        }
+        temp_var->set_register(it.second);
+    }
 
-                        0x66,       // ANDPD %xmm3, %xmm2 -- xmm2 = fabs(xmm0 - xmm1)
-                        0x0F,
-                        0x54,
-                        0xD3,
+    f_file.adjust_temporary_offset_1byte();
 
-                        0x48,       // REX.W AND %rdx, %rax  (xmm0 == 0 || xmm1 == 0)
-                        0x21,
-                        0xD0,
+    for(auto & it : fn->get_data())
+    {
+        std::string name;
+        switch(it->get_data_type())
+        {
+        case node_t::NODE_FLOATING_POINT:
+            f_file.add_constant(it->get_floating_point().get(), name);
+            break;
 
-                        0x48,       // REX.W ADD %rax, %rax (ignore sign)
-                        0x01,
-                        0xC0,
+        case node_t::NODE_STRING:
+            f_file.add_constant(it->get_string(), name);
+            break;
 
-                        0x74,       // JZ zero
-                        0x15,
+        default:
+            throw not_implemented("trying to add a constant with a data type which is not yet implemented.");
 
-                        0x48,       // REX.W MOV $0x100000:00000000, %rax   (i.e. std::numeric_limits<double>::min())
-                        0xB8,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x10,
-                        0x00,
+        }
+        it->set_data_name(name);
+    }
 
-                        0x66,       // MOVQ %rax, %xmm4
-                        0x48,
-                        0x0F,
-                        0x6E,
-                        0xE0,
+    // we need to reserve the space for our temporary variables
+    //
+    // WARNING: the stack must be properly aligned to 16 bytes when
+    //          calling a function (not considering the function pointer
+    //          that is pushed by the CALL instruction, which gets fixed
+    //          by the `PUSH %rbp` anyway)
+    //
+    offset_t const temp_size((f_file.get_size_of_temporary_variables() + 15) & -16);
+    generate_frame_size(temp_size, true);
 
-                        0x66,       // COMISD %xmm4, %xmm2
-                        0x0F,
-                        0x2F,
-                        0xD4,
+    generate_store_integer(f_saved_rbx, register_t::REGISTER_RBX);
+    {
+        std::uint8_t buf[] = {      // MOV %rdi, %rbx
+            0x48,
+            0x89,
+            0xFB,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    for(auto const & reg : f_saved_registers)
+    {
+        generate_spill(
+                  f_file.find_temporary_variable("%saved_r" + std::to_string(static_cast<int>(reg)))
+                , reg);
+    }
 
-                        0x73,       // JNB full_cmp
-                        0x19,
+    // the temporary strings need to be initialized
+    //
+    generate_string_temporaries(fn->get_variables(), external_function_t::EXTERNAL_FUNCTION_STRINGS_INITIALIZE);
 
-                    //zero: %xmm0 == 0 || %xmm1 == 0
-                        0x48,       // REX.W MOV $0xA7C5AC472, %rax   (i.e. epsilon * std::numeric_limits<double>::min())
-                        0xB8,
-                        0x72,
-                        0xC4,
-                        0x5A,
-                        0x7C,
-                        0x0A,
-                        0x00,
-                        0x00,
-                        0x00,
+    generate_operations(fn->get_operations());
 
-                        0x66,       // MOVQ %rax, %xmm4
-                        0x48,
-                        0x0F,
-                        0x6E,
-                        0xE0,
+    {
+        auto const & it(fn->get_operations().back());
+        node::pointer_t n(it->get_node());
+        node::pointer_t t(n->get_type_node());
+        if(t != nullptr)
+        {
+            f_file.set_return_type(get_type_of_node(n));
+        }
+    }
 
-                        0x66,       // COMISD %xmm4, %xmm2
-                        0x0F,
-                        0x2F,
-                        0xD4,
+    // the temporary strings need to be freed
+    //
+    generate_string_temporaries(fn->get_variables(), external_function_t::EXTERNAL_FUNCTION_STRINGS_FREE);
 
-                        0x72,       // JB true
-                        0x29,
+    // restore the caller's %r12 to %r15 and %rbx
+    //
+    for(auto const & reg : f_saved_registers)
+    {
+        generate_spill(
+                  f_file.find_temporary_variable("%saved_r" + std::to_string(static_cast<int>(reg)))
+                , reg
+                , true);
+    }
+    generate_reg_mem_integer(f_saved_rbx, register_t::REGISTER_RBX);
 
-                        //[[fallthrough]];
+    // on exit, restore frame and return
+    //
+    generate_frame_size(temp_size, false);
+    std::uint8_t restore_frame[] = {  // POP %rbp  &  RET
+        0x5D,
+        0xC3,
+    };
+    f_file.add_text(restore_frame, sizeof(restore_frame));
 
-                    //false:
-                        0x33,       // XOR $rax, $rax
-                        0xC0,
+    generate_align8();
 
-                        0xEB,       // JMP done
-                        0x2A,
+    // the user functions follow the main program
+    //
+    std::size_t idx(0);
+    for(auto const & f : fn->get_functions())
+    {
+        generate_function(f, function_saved_registers[idx], temp_size);
+        ++idx;
+    }
+}
 
-                    //full_cmp:
-                        0x66,       // ANDPD %xmm3, %xmm0 -- xmm0 = fabs(xmm1)
-                        0x0F,
-                        0x54,
-                        0xC3,
 
-                        0x66,       // ANDPD %xmm3, %xmm1 -- xmm1 = fabs(xmm0)
-                        0x0F,
-                        0x54,
-                        0xCB,
+/** \brief Reserve or release the stack frame.
+ *
+ * The prologue reserves \p temp_size bytes on the stack for the
+ * temporary variables and the epilogue releases them. The size must
+ * already be aligned to 16 bytes.
+ *
+ * \param[in] temp_size  The size of the frame.
+ * \param[in] reserve  true to reserve (SUB), false to release (ADD).
+ */
+void binary_assembler::generate_frame_size(offset_t temp_size, bool reserve)
+{
+    if(temp_size == 0)
+    {
+        return;
+    }
 
-                        0xF2,       // ADDSD %xmm1, %xmm0
-                        0x0F,
-                        0x58,
-                        0xC1,
+    if(temp_size < 128)
+    {
+        std::uint8_t buf[] = { // SUB/ADD $imm8, %rsp
+            0x48,
+            0x83,
+            static_cast<std::uint8_t>(reserve ? 0xEC : 0xC4),
+            static_cast<std::uint8_t>(temp_size),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    else
+    {
+        std::uint8_t buf[] = { // SUB/ADD $imm32, %rsp
+            0x48,
+            0x81,
+            static_cast<std::uint8_t>(reserve ? 0xEC : 0xC4),
+            static_cast<std::uint8_t>(temp_size >>  0),
+            static_cast<std::uint8_t>(temp_size >>  8),
+            static_cast<std::uint8_t>(temp_size >> 16),
+            static_cast<std::uint8_t>(temp_size >> 24),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+}
 
-                        0xF2,       // DIVSD %xmm0, %xmm2 -- %xmm2 = %xmm2 / %xmm0
-                        0x0F,
-                        0x5E,
-                        0xD0,
 
-                        0x48,       // REX.W MOV $0x3EE4F8B588E368F1, %rax   (i.e. epsilon)
-                        0xB8,
-                        0xF1,
-                        0x68,
-                        0xE3,
-                        0x88,
-                        0xB5,
-                        0xF8,
-                        0xE4,
-                        0x3E,
+/** \brief Initialize or free the temporary strings.
+ *
+ * At this point, a temporary variable does not have a value, only a
+ * type and a name. The temporary strings have to be initialized before
+ * the first operation and freed after the last one.
+ *
+ * \param[in] variables  The variables to go through.
+ * \param[in] func  EXTERNAL_FUNCTION_STRINGS_INITIALIZE or
+ * EXTERNAL_FUNCTION_STRINGS_FREE.
+ */
+void binary_assembler::generate_string_temporaries(data::map_t const & variables, external_function_t func)
+{
+    for(auto const & it : variables)
+    {
+        if(it.second->is_temporary()
+        && !it.second->no_init())
+        {
+            temporary_variable * temp_var(f_file.find_temporary_variable(it.first));
+            if(temp_var == nullptr)
+            {
+                throw internal_error("temporary not found in generate_string_temporaries()");
+            }
+            // TODO: transform in a switch once we have other types than string
+            if(temp_var->get_type() != node_t::NODE_STRING)
+            {
+                continue;
+            }
+            generate_pointer_to_temporary(temp_var, register_t::REGISTER_RDI);
+            generate_external_function_call(func);
+        }
+    }
+}
 
-                        0x66,       // MOVQ %rax, %xmm1
-                        0x48,
-                        0x0F,
-                        0x6E,
-                        0xC8,
 
-                        0x66,       // COMISD %xmm1, %xmm2
-                        0x0F,
-                        0x2F,
-                        0xD1,
+void binary_assembler::generate_operations(operation::list_t const & operations)
+{
+    // count how many times each temporary gets used so we know whether
+    // a comparison can be fused with the branch that follows
+    //
+    std::map<std::string, std::size_t> temporary_uses;
+    for(auto const & it : operations)
+    {
+        data::vector_t operands{
+            it->get_left_handside(),
+            it->get_right_handside(),
+        };
+        std::size_t const max(it->get_parameter_size());
+        for(std::size_t p(0); p < max; ++p)
+        {
+            operands.push_back(it->get_parameter(p));
+        }
+        for(auto const & d : operands)
+        {
+            if(d != nullptr
+            && d->get_data_type() == node_t::NODE_VARIABLE
+            && d->is_temporary())
+            {
+                ++temporary_uses[d->get_node()->get_string()];
+            }
+        }
+    }
 
-                        0x73,       // JBN false
-                        0xD7,
+    operation::pointer_t pending_compare;
+    for(auto const & it : operations)
+    {
+std::cerr << "  ++  " << it->to_string() << "\n";
+        if(pending_compare != nullptr)
+        {
+            operation::pointer_t compare(pending_compare);
+            pending_compare.reset();
+            if(generate_compare_and_branch(compare, it)
+            || generate_compare_and_select(compare, it))
+            {
+                continue;
+            }
+            generate_compare(compare);
+        }
 
-                        //[[fallthrough]];
+        switch(it->get_operation())
+        {
+        case node_t::NODE_ABSOLUTE_VALUE:
+            generate_absolute_value(it);
+            break;
 
-                    //true:
-                        0xB8,       // MOV $1, $eax
-                        0x01,
-                        0x00,
-                        0x00,
-                        0x00,
-                    //done:
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
+        case node_t::NODE_ACOS:
+        case node_t::NODE_ACOSH:
+        case node_t::NODE_ASIN:
+        case node_t::NODE_ASINH:
+        case node_t::NODE_ATAN:
+        case node_t::NODE_ATANH:
+        case node_t::NODE_CBRT:
+        case node_t::NODE_CEIL:
+        case node_t::NODE_COS:
+        case node_t::NODE_COSH:
+        case node_t::NODE_EXP:
+        case node_t::NODE_EXPM1:
+        case node_t::NODE_FLOOR:
+        case node_t::NODE_FROUND:
+        case node_t::NODE_LOG:
+        case node_t::NODE_LOG1P:
+        case node_t::NODE_LOG10:
+        case node_t::NODE_LOG2:
+        case node_t::NODE_ROUND:
+        case node_t::NODE_SIN:
+        case node_t::NODE_SINH:
+        case node_t::NODE_SQRT:
+        case node_t::NODE_TAN:
+        case node_t::NODE_TANH:
+        case node_t::NODE_TRUNC:
+            generate_math_function(it);
+            break;
 
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            }
-            return;
+        case node_t::NODE_ADD:
+        case node_t::NODE_ASSIGNMENT_ADD:
+        case node_t::NODE_ASSIGNMENT_SUBTRACT:
+        case node_t::NODE_SUBTRACT:
+            generate_additive(it);
+            break;
 
+        case node_t::NODE_ALMOST_EQUAL:
         case node_t::NODE_COMPARE:
+        case node_t::NODE_EQUAL:
+        case node_t::NODE_LESS:
+        case node_t::NODE_LESS_EQUAL:
+        case node_t::NODE_GREATER:
+        case node_t::NODE_GREATER_EQUAL:
+        case node_t::NODE_NOT_EQUAL:
+        case node_t::NODE_SMART_MATCH:
+        case node_t::NODE_STRICTLY_EQUAL:
+        case node_t::NODE_STRICTLY_NOT_EQUAL:
             {
-                generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-                generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_SUB);
-
-                // TODO: add proper support for Infinity & NaN
+                // a boolean only used by the next IF_TRUE/IF_FALSE or
+                // CONDITIONAL does not need to be saved, keep the compare
+                // for now
+                //
+                data::pointer_t result(it->get_result());
+                if(result != nullptr
+                && result->is_temporary()
+                && temporary_uses[result->get_node()->get_string()] == 1)
                 {
-                    std::uint8_t buf[] = {
-                        //0x33,       // XOR %eax, %eax (rax := 0)
-                        //0xC0,
+                    pending_compare = it;
+                }
+                else
+                {
+                    generate_compare(it);
+                }
+            }
+            break;
 
-                        0x66,       // REX.W MOVQ %xmm0, %rcx
-                        0x48,
-                        0x0F,
-                        0x7E,
-                        0xC1,
+        case node_t::NODE_ARRAY:
+            generate_array(it);
+            break;
 
-                        0x48,       // REX.W CMP $0, %rcx
-                        0x83,
-                        0xF9,
-                        0x00,
+        case node_t::NODE_ASSIGNMENT:
+            generate_assignment(it);
+            break;
 
-                        0x0F,       // SETG %al
-                        0x9F,
-                        0xC0,
+        case node_t::NODE_ASSIGNMENT_LOGICAL_AND:
+        case node_t::NODE_LOGICAL_AND:
+        case node_t::NODE_ASSIGNMENT_LOGICAL_OR:
+        case node_t::NODE_LOGICAL_OR:
+        case node_t::NODE_ASSIGNMENT_LOGICAL_XOR:
+        case node_t::NODE_LOGICAL_XOR:
+            generate_logical(it);
+            break;
 
-                        0x0F,       // SETL %cl
-                        0x9C,
-                        0xC1,
+        case node_t::NODE_ASSIGNMENT_BITWISE_AND:
+        case node_t::NODE_ASSIGNMENT_BITWISE_OR:
+        case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
+        case node_t::NODE_BITWISE_AND:
+        case node_t::NODE_BITWISE_OR:
+        case node_t::NODE_BITWISE_XOR:
+            generate_bitwise(it);
+            break;
 
-                        0x28,       // SUB %cl, %al
-                        0xC8,
+        case node_t::NODE_ASSIGNMENT_DIVIDE:
+        case node_t::NODE_ASSIGNMENT_MODULO:
+        case node_t::NODE_DIVIDE:
+        case node_t::NODE_MODULO:
+            generate_divide(it);
+            break;
 
-                        0x48,       // REX.W MOVSX %al, %rax
-                        0x0F,
-                        0xBE,
-                        0xC0,
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
+        case node_t::NODE_ASSIGNMENT_MAXIMUM:
+        case node_t::NODE_ASSIGNMENT_MINIMUM:
+        case node_t::NODE_MAXIMUM:
+        case node_t::NODE_MINIMUM:
+            generate_minmax(it);
+            break;
 
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            }
-            return;
+        case node_t::NODE_HYPOT:
+            generate_hypot(it);
+            break;
 
-        case node_t::NODE_EQUAL:
-        case node_t::NODE_SMART_MATCH:
-        case node_t::NODE_STRICTLY_EQUAL:
-            // for double, smart match is the same as equal
-            //
-            // no coersion here, so strictly equal is the same
-            //
-            // default cmp_code is EQUAL
+        case node_t::NODE_ASSIGNMENT_MULTIPLY:
+        case node_t::NODE_MULTIPLY:
+            generate_multiply(it);
             break;
 
-        case node_t::NODE_LESS:
-            cmp_code = 0x01;
+        case node_t::NODE_ATAN2:
+            generate_atan2(it);
             break;
 
-        case node_t::NODE_LESS_EQUAL:
-            cmp_code = 0x02;
+        case node_t::NODE_IMUL:
+            generate_imul(it);
             break;
 
-        case node_t::NODE_GREATER:
-            cmp_code = 0x01;
-            swapped = true;
+        case node_t::NODE_SIGN:
+            generate_sign(it);
             break;
 
-        case node_t::NODE_GREATER_EQUAL:
-            cmp_code = 0x02;
-            swapped = true;
+        case node_t::NODE_ASSIGNMENT_POWER:
+        case node_t::NODE_POWER:
+            generate_power(it);
             break;
 
-        case node_t::NODE_NOT_EQUAL:
-        case node_t::NODE_STRICTLY_NOT_EQUAL:
-            // no coersion here, so strictly not equal is the same
-            //
-            cmp_code = 0x04;
+        case node_t::NODE_ASSIGNMENT_ROTATE_LEFT:
+        case node_t::NODE_ASSIGNMENT_ROTATE_RIGHT:
+        case node_t::NODE_ASSIGNMENT_SHIFT_LEFT:
+        case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT:
+        case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT_UNSIGNED:
+        case node_t::NODE_ROTATE_LEFT:
+        case node_t::NODE_ROTATE_RIGHT:
+        case node_t::NODE_SHIFT_LEFT:
+        case node_t::NODE_SHIFT_RIGHT:
+        case node_t::NODE_SHIFT_RIGHT_UNSIGNED:
+            generate_shift(it);
             break;
 
-        default:
-            throw internal_error("generate_compare() called with the wrong operation.");
+        case node_t::NODE_BITWISE_NOT:
+            generate_bitwise_not(it);
+            break;
 
-        }
-        if(swapped)
-        {
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0);
-            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CMP, 1);
-        }
-        else
-        {
-            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CMP, 1);
-        }
-
-        {
-            std::uint8_t buf[] = {
-                cmp_code,   // this is part of the CMP??SD generated by generate_reg_mem_floating_point()
-
-                0x66,       // REX.W MOVQ %xmm0, %rax
-                0x48,
-                0x0F,
-                0x7E,
-                0xC0,
+        case node_t::NODE_CALL:
+            if(it->get_label().empty())
+            {
+                generate_call(it);
+            }
+            else
+            {
+                generate_user_call(it);
+            }
+            break;
 
-                0x48,       // REX.W SHR $63, %rax
-                0xC1,
-                0xE8,
-                0x3F,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+        case node_t::NODE_CLZ32:
+            generate_clz32(it);
+            break;
 
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-    }
-    else if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_INTEGER
-         || get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_BOOLEAN
-         || get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_INTEGER
-         || get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_BOOLEAN)
-    {
-        // TODO: if lhs or rhs is a string, we need to transform it to an
-        //       integer first (we may need to separate booleans?)
-        //
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RDX);
+        case node_t::NODE_CONDITIONAL:
+            generate_conditional(it);
+            break;
 
-        {
-            std::uint8_t buf[] = {       // XOR %eax, %eax (rax := 0)
-                0x33,
-                0xC0,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+        case node_t::NODE_DECREMENT:
+        case node_t::NODE_INCREMENT:
+        case node_t::NODE_POST_DECREMENT:
+        case node_t::NODE_POST_INCREMENT:
+            generate_increment(it);
+            break;
 
-        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX, 0x3B);
-        if(op->get_operation() == node_t::NODE_COMPARE)
-        {
-            // shortest code "found" here:
-            //    https://codegolf.stackexchange.com/questions/259087/write-the-smallest-possible-code-in-x86-64-to-implement-the-operator/259110#259110
-            //
-            std::uint8_t buf[] = {
-                0x0F,       // SETG %al
-                0x9F,
-                0xC0,
+        case node_t::NODE_GOTO:
+            generate_goto(it);
+            break;
 
-                0x0F,       // SETL %cl
-                0x9C,
-                0xC1,
+        case node_t::NODE_IF_FALSE:
+        case node_t::NODE_IF_TRUE:
+            generate_if(it);
+            break;
 
-                0x28,       // SUB %cl, %al
-                0xC8,
+        case node_t::NODE_IDENTITY:
+            generate_identity(it);
+            break;
 
-                0x48,       // REX.W MOVSX %al, %rax
-                0x0F,
-                0xBE,
-                0xC0,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-        else
-        {
-            std::uint8_t buf[] = {
-                0x0F,
-                0x00,       // SETcc r64
-                0xC0,       // r/m
-            };
+        case node_t::NODE_LABEL:
+            generate_label(it);
+            break;
 
-            switch(op->get_operation())
-            {
-            case node_t::NODE_ALMOST_EQUAL:
-            case node_t::NODE_EQUAL:
-            case node_t::NODE_SMART_MATCH:
-            case node_t::NODE_STRICTLY_EQUAL:
-                // for integer, almost equal & smart match are the same as equal
-                // also if coersion happens, it wouldn't be here so strictly
-                // equal is the same too
-                //
-                buf[1] = 0x94;
-                break;
+        case node_t::NODE_LIST:
+            generate_list(it);
+            break;
 
-            case node_t::NODE_LESS:
-                buf[1] = 0x9C;
-                break;
+        case node_t::NODE_LOGICAL_NOT:
+            generate_logical_not(it);
+            break;
 
-            case node_t::NODE_LESS_EQUAL:
-                buf[1] = 0x9E;
-                break;
+        case node_t::NODE_NEGATE:
+            generate_negate(it);
+            break;
 
-            case node_t::NODE_GREATER:
-                buf[1] = 0x9F;
-                break;
+        case node_t::NODE_PARAM:
+            generate_param(it);
+            break;
 
-            case node_t::NODE_GREATER_EQUAL:
-                buf[1] = 0x9D;
-                break;
+        case node_t::NODE_RANDOM:
+            generate_random(it);
+            break;
 
-            case node_t::NODE_NOT_EQUAL:
-            case node_t::NODE_STRICTLY_NOT_EQUAL:
-                // no coersion here, so strictly not equal is the same
-                //
-                buf[1] = 0x95;
-                break;
+        case node_t::NODE_RETURN:
+            generate_return(it);
+            break;
 
-            default:
-                throw internal_error("generate_compare() called with the wrong operation.");
+        case node_t::NODE_SWITCH:
+            generate_switch(it);
+            break;
 
-            }
-            f_file.add_text(buf, sizeof(buf));
-        }
+        default:
+            throw not_implemented(
+                  std::string("operation ")
+                + node::type_to_string(it->get_operation())
+                + " is not yet implemented.");
 
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-    }
-    else if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_STRING
-         && get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_STRING)
-    {
-        generate_reg_mem_string(lhs, register_t::REGISTER_RDI);
-        generate_reg_mem_string(rhs, register_t::REGISTER_RSI);
-        {
-            int const value(static_cast<int>(op->get_operation()));
-            std::uint8_t buf[] = {   // REX.W MOV $imm32, %rdx  (%rdx = operation)
-                0x48,
-                0xC7,
-                0xC2,
-                static_cast<std::uint8_t>(value >>  0),
-                static_cast<std::uint8_t>(value >>  8),
-                static_cast<std::uint8_t>(value >> 16),
-                static_cast<std::uint8_t>(value >> 24),
-            };
-            f_file.add_text(buf, sizeof(buf));
         }
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COMPARE);
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
     }
-    else
+    if(pending_compare != nullptr)
     {
-        throw internal_error("generate_compare() called with unsupported parameter types.");
+        generate_compare(pending_compare);
     }
 }
 
 
-void binary_assembler::generate_array(operation::pointer_t op)
+/** \brief Generate the code of a user function.
+ *
+ * User functions follow the System V calling convention: the Integer
+ * and Boolean parameters are passed in %rdi, %rsi, %rdx, %rcx, %r8,
+ * and %r9, the Double parameters in %xmm0 to %xmm7, and the result
+ * is returned in %rax or %xmm0.
+ *
+ * The pointer to the extern variables is in %rbx which is callee saved
+ * and never modified by a user function. The external functions are
+ * called through the table of the image (see
+ * generate_external_function_call()) so no hidden parameter is necessary.
+ *
+ * All the frames have the same layout as the main frame. So the
+ * temporaries of a function are accessed exactly like those of the
+ * main program, at the cost of reserving \p temp_size bytes on each
+ * call.
+ *
+ * \param[in] f  The function to generate.
+ * \param[in] saved_registers  The callee saved registers used by \p f.
+ * \param[in] temp_size  The size of the frame.
+ */
+void binary_assembler::generate_function(
+      user_function::pointer_t f
+    , std::vector<register_t> const & saved_registers
+    , offset_t temp_size)
 {
-    variable_type_t const type(get_type_of_node(op->get_node()));
-    data::pointer_t lhs(op->get_left_handside());
-    variable_type_t lhs_type(get_type_of_node(lhs->get_node()));
-    data::pointer_t rhs(op->get_right_handside());
+    f_file.add_label(f->get_label());
 
-    std::string type_name;
-    if(lhs_type == VARIABLE_TYPE_UNKNOWN)
+    std::uint8_t setup_frame[] = {
+        0x55,           // PUSH %rbp
+
+        0x48,           // MOV %rsp, %rbp
+        0x89,
+        0xE5,
+    };
+    f_file.add_text(setup_frame, sizeof(setup_frame));
+    generate_frame_size(temp_size, true);
+
+    for(auto const & reg : saved_registers)
     {
-        node::pointer_t type_node(lhs->get_node()->get_type_node());
-        if(type_node == nullptr)
+        generate_spill(
+                  f_file.find_temporary_variable("%saved_r" + std::to_string(static_cast<int>(reg)))
+                , reg);
+    }
+
+    // save the parameters in their temporaries
+    //
+    static register_t const integer_registers[] = {
+        register_t::REGISTER_RDI,
+        register_t::REGISTER_RSI,
+        register_t::REGISTER_RDX,
+        register_t::REGISTER_RCX,
+        register_t::REGISTER_R8,
+        register_t::REGISTER_R9,
+    };
+    std::size_t integer_count(0);
+    std::size_t floating_point_count(0);
+    for(auto const & param : f->get_parameters())
+    {
+        switch(get_type_of_node(param->get_node()))
         {
-            throw not_implemented("binary_assembler::generate_array(): could not determine object type.");
+        case VARIABLE_TYPE_BOOLEAN:
+        case VARIABLE_TYPE_INTEGER:
+            if(integer_count < std::size(integer_registers))
+            {
+                register_t reg(integer_registers[integer_count]);
+                ++integer_count;
+                if(reg >= register_t::REGISTER_R8)
+                {
+                    std::uint8_t const buf[] = {    // MOV %r8 or %r9, %rax
+                        0x4C,
+                        0x89,
+                        static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3)),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                    reg = register_t::REGISTER_RAX;
+                }
+                generate_store_integer(param, reg);
+                continue;
+            }
+            break;
+
+        case VARIABLE_TYPE_FLOATING_POINT:
+            if(floating_point_count < 8)
+            {
+                generate_store_floating_point(param, static_cast<register_t>(floating_point_count));
+                ++floating_point_count;
+                continue;
+            }
+            break;
+
+        default:
+            break;
+
         }
-        type_name = type_node->get_string();
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, param->get_node()->get_position());
+        msg << "binary compilation of parameter \""
+            << param->get_node()->get_string()
+            << "\" is not yet implemented (only up to 6 Integer/Boolean and 8 Double parameters are supported).";
+        throw not_implemented(msg.str());
     }
 
-    // if rhs is an identifier, then this is a field (the "b" in "a.b")
+    // the return value starts at zero (false, 0, 0.0), the locals are
+    // initialized by the flattened code
     //
-    if(rhs->get_data_type() == node_t::NODE_IDENTIFIER
-    || rhs->get_data_type() == node_t::NODE_STRING)
+    std::uint8_t const zero[] = {
+        0x31,           // XOR %eax, %eax
+        0xC0,
+
+        0x0F,           // XORPS %xmm0, %xmm0
+        0x57,
+        0xC0,
+    };
+    f_file.add_text(zero, sizeof(zero));
+    for(auto const & it : f->get_variables())
     {
-        std::string const & name(rhs->get_string());
-        if(name == "length"
-        && lhs_type == VARIABLE_TYPE_STRING
-        && type == VARIABLE_TYPE_INTEGER)
+        if(it.first.compare(0, 7, "%return") != 0)
         {
-            // directly move the string length to %rax
-            //
-            generate_load_string_size(lhs, register_t::REGISTER_RAX);
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
+            continue;
         }
-        if(name == "MAX_VALUE"
-        && lhs_type == VARIABLE_TYPE_INTEGER
-        && type == VARIABLE_TYPE_INTEGER)
+        temporary_variable * temp_var(f_file.find_temporary_variable(it.first));
+        if(temp_var == nullptr)
         {
-            // load maximum integer value in %rax
-            //
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0x7F,
-            };
-            f_file.add_text(buf, sizeof(buf));
-
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
+            throw internal_error("temporary not found in generate_function()");
         }
-        if(name == "MIN_VALUE"
-        && lhs_type == VARIABLE_TYPE_INTEGER
-        && type == VARIABLE_TYPE_INTEGER)
+        switch(get_type_of_node(it.second->get_node()))
         {
-            // load minimum integer value in %rax
-            //
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x80,
-            };
-            f_file.add_text(buf, sizeof(buf));
+        case VARIABLE_TYPE_BOOLEAN:
+            generate_store_integer(it.second, register_t::REGISTER_RAX);
+            break;
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
-        }
-        if(name == "MAX_VALUE"
-        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
-        && type == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            // load maximum floating point value in %rax
-            // and then save it as an integer in a floating point variable
-            //
-            // maximum value in a double represented in hex: 0x7fefffffffffffff
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xFF,
-                0xEF,
-                0x7F,
-            };
-            f_file.add_text(buf, sizeof(buf));
+        case VARIABLE_TYPE_INTEGER:
+            generate_spill(temp_var, register_t::REGISTER_RAX);
+            break;
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
-        }
-        if(name == "MIN_VALUE"
-        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
-        && type == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            // load minimum floating point value in %rax
-            // and then save it as an integer in a floating point variable
-            //
-            // minimum value in a double represented in hex: 0x0010000000000000
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x10,
-                0x00,
-            };
-            f_file.add_text(buf, sizeof(buf));
+        case VARIABLE_TYPE_FLOATING_POINT:
+            generate_spill(temp_var, register_t::REGISTER_XMM0);
+            break;
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
-        }
-        if(name == "NEGATIVE_INFINITY"
-        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
-        && type == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            // load minimum floating point value in %rax
-            // and then save it as an integer in a floating point variable
-            //
-            // -inf value in a double represented in hex: 0xFFF0000000000000
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0xF0,
-                0xFF,
-            };
-            f_file.add_text(buf, sizeof(buf));
+        default:
+            // strings are initialized below
+            break;
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
         }
-        if(name == "POSITIVE_INFINITY"
-        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
-        && type == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            // load minimum floating point value in %rax
-            // and then save it as an integer in a floating point variable
-            //
-            // +inf value in a double represented in hex: 0x7FF0000000000000
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0xF0,
-                0x7F,
-            };
-            f_file.add_text(buf, sizeof(buf));
+    }
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
-        }
-        if(name == "EPSILON"
-        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
-        && type == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            // load minimum floating point value in %rax
-            // and then save it as an integer in a floating point variable
-            //
-            // minimum value in a double represented in hex: 0x3CB0000000000000
-            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                0x48,
-                0xB8,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0x00,
-                0xB0,
-                0x3C,
-            };
-            f_file.add_text(buf, sizeof(buf));
+    generate_string_temporaries(f->get_variables(), external_function_t::EXTERNAL_FUNCTION_STRINGS_INITIALIZE);
 
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            return;
-        }
+    generate_operations(f->get_operations());
 
-        throw not_implemented(
-              "unknown field (\""
-            + name
-            + "\") / unsupported type for array operator.");
-    }
+    f_file.add_label(f->get_exit_label());
 
-    data::pointer_t range_end;
+    generate_string_temporaries(f->get_variables(), external_function_t::EXTERNAL_FUNCTION_STRINGS_FREE);
 
-    variable_type_t index_type(get_type_of_node(rhs->get_node()));
-    std::size_t has_range(op->get_parameter_size());
-    if(has_range != 0)
+    for(auto const & reg : saved_registers)
     {
-        range_end = op->get_parameter(0);
-        variable_type_t const range_end_type(get_type_of_node(range_end->get_node()));
-        if(index_type != range_end_type)
-        {
-            throw not_implemented("array range start & end conversion not yet implemented; they need to be of the same type for now.");
-        }
+        generate_spill(
+                  f_file.find_temporary_variable("%saved_r" + std::to_string(static_cast<int>(reg)))
+                , reg
+                , true);
     }
 
-    switch(type)
+    data::pointer_t return_value(f->get_return_value());
+    if(return_value != nullptr)
     {
-    case VARIABLE_TYPE_STRING:
-        switch(index_type)
+        if(get_type_of_node(return_value->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
         {
-        case VARIABLE_TYPE_INTEGER:
-        case VARIABLE_TYPE_FLOATING_POINT:
-            // if range is defined, do a subtr(), otherwise just retrieve that
-            // one character
-            //
-            generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
-            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_AT);
-            break;
-
-        case VARIABLE_TYPE_RANGE:
-            // TODO: the RANGE variable type is not yet supported
-            //
-            generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
-            generate_reg_mem_floating_point(range_end, register_t::REGISTER_RCX, sse_operation_t::SSE_OPERATION_CVT2I);
-            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_SUBSTR);
-            break;
-
-        default:
-            // we should probably have a toNumber() check first?
-            //
-            throw not_implemented("the string array operator only functions with Numbers.");
-
+            generate_reg_mem_floating_point(return_value, register_t::REGISTER_XMM0);
         }
-        break;
+        else
+        {
+            generate_reg_mem_integer(return_value, register_t::REGISTER_RAX);
+        }
+    }
 
-    default:
-        throw not_implemented("type not yet supported by the array operator");
+    generate_frame_size(temp_size, false);
+    std::uint8_t restore_frame[] = {  // POP %rbp  &  RET
+        0x5D,
+        0xC3,
+    };
+    f_file.add_text(restore_frame, sizeof(restore_frame));
 
-    }
+    generate_align8();
 }
 
 
-void binary_assembler::generate_assignment(operation::pointer_t op)
+/** \brief Load a number in an XMM register.
+ *
+ * Integers get converted to a Double with CVTSI2SD so an Integer can
+ * be passed to or returned as a Double.
+ *
+ * \param[in] d  The data to load.
+ * \param[in] reg  One of %xmm0 to %xmm7.
+ */
+void binary_assembler::generate_load_as_floating_point(data::pointer_t d, register_t reg)
 {
-    data::pointer_t lhs(op->get_left_handside());
-    data::pointer_t rhs(op->get_right_handside());
-    if(rhs == nullptr)
-    {
-        rhs = lhs;
-    }
-
-    // standard assignments are "inverted", we load the right handside
-    // and save it to the left handside
-    //
-    int const type(get_type_of_node(op->get_node()));
-    switch(type)
+    bool is_integer(false);
+    switch(d->get_data_type())
     {
-    case VARIABLE_TYPE_FLOATING_POINT:
-    case VARIABLE_TYPE_INTEGER:
-    case VARIABLE_TYPE_BOOLEAN:
-        generate_reg_mem_integer(rhs, register_t::REGISTER_RAX);
-        generate_store_integer(lhs, register_t::REGISTER_RAX);
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    case node_t::NODE_INTEGER:
+        is_integer = true;
         break;
 
-    case VARIABLE_TYPE_STRING:
-        generate_reg_mem_string(rhs, register_t::REGISTER_RSI);
-        generate_store_string(lhs, register_t::REGISTER_RSI);
-
-        // the generate_store_string() has a CALL which blows up RSI
-        //
-        generate_reg_mem_string(rhs, register_t::REGISTER_RSI);
-        generate_store_string(op->get_result(), register_t::REGISTER_RSI);
+    case node_t::NODE_VARIABLE:
+        is_integer = get_type_of_node(d->get_node()) == VARIABLE_TYPE_INTEGER;
         break;
 
     default:
-        throw not_implemented(
-              std::string("trying to generate_assignment() with an unknown node type \"")
-            + std::to_string(type)
-            + "\" which is not yet implemented.");
+        break;
 
     }
-}
 
-
-void binary_assembler::generate_bitwise(operation::pointer_t op)
-{
-    bool is_assignment(false);
-    std::uint8_t code_imm32(0); // RAX specific (i.e. OP RAX, imm32)
-    std::uint8_t code_r64(0);
-    std::uint8_t rm(0);
-    switch(op->get_operation())
-    {
-    case node_t::NODE_ASSIGNMENT_BITWISE_AND:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_BITWISE_AND:
-        code_imm32 = 0x25;
-        code_r64 = 0x23;
-        rm = 0xE0; // /4
-        break;
-
-    case node_t::NODE_ASSIGNMENT_BITWISE_OR:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_BITWISE_OR:
-        code_imm32 = 0x0D;
-        code_r64 = 0x0B;
-        rm = 0xC8; // /1
-        break;
-
-    case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_BITWISE_XOR:
-        code_imm32 = 0x35;
-        code_r64 = 0x33;
-        rm = 0xF0; // /6
-        break;
-
-    default:
-        throw internal_error("generate_bitwise() called with an unsupported operation");
-
-    }
-
-    data::pointer_t lhs(op->get_left_handside());
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    if(is_integer)
     {
-        // load double as an integer in RAX
-        //
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_RAX, sse_operation_t::SSE_OPERATION_CVT2I);
+        generate_reg_mem_integer(d, register_t::REGISTER_RAX);
+        std::uint8_t const buf[] = {    // CVTSI2SD %rax, %xmm
+            0xF2,
+            0x48,
+            0x0F,
+            0x2A,
+            static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3)),
+        };
+        f_file.add_text(buf, sizeof(buf));
     }
     else
     {
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        generate_reg_mem_floating_point(d, reg);
     }
+}
 
-    data::pointer_t rhs(op->get_right_handside());
-    switch(rhs->get_integer_size())
+
+void binary_assembler::generate_align8()
+{
+    switch(f_file.get_current_text_offset() & 7)
     {
-    case integer_size_t::INTEGER_SIZE_1BIT:
-    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+    case 0:
+        // already aligned
+        break;
+
+    case 8 - 1:
         {
-            std::uint8_t buf[] = {
-                0x48,           // AND/OR/XOR $imm8, %rax
-                0x83,
-                rm,
-                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get()),
+            std::uint8_t nop[] = {
+                0x90,
             };
-            f_file.add_text(buf, sizeof(buf));
+            f_file.add_text(nop, sizeof(nop));
         }
         break;
 
-    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 & imm16, use r64 & imm32 instead
-    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+    case 8 - 2:
         {
-            std::uint8_t buf[] = {
-                0x48,           // AND/OR/XOR $imm32, %rax
-                code_imm32,
-                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  0),
-                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  8),
-                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 16),
-                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 24),
+            std::uint8_t nop[] = {
+                0x66,
+                0x90,
             };
-            f_file.add_text(buf, sizeof(buf));
+            f_file.add_text(nop, sizeof(nop));
         }
         break;
 
-    case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
-    case integer_size_t::INTEGER_SIZE_64BITS:
+    case 8 - 3:
         {
-            generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
-            std::uint8_t buf[] = {
-                0x48,       // AND/OR/XOR %rdx, %rax
-                code_r64,
-                0xC2,
+            std::uint8_t nop[] = {
+                0x0F,
+                0x1F,
+                0x00,
             };
-            f_file.add_text(buf, sizeof(buf));
+            f_file.add_text(nop, sizeof(nop));
         }
         break;
 
-    case integer_size_t::INTEGER_SIZE_FLOATING_POINT:
+    case 8 - 4:
         {
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
-            std::uint8_t buf[] = {
-                0x48,       // AND/OR/XOR %rdx, %rax
-                code_r64,
-                0xC2,
+            std::uint8_t nop[] = {
+                0x0F,
+                0x1F,
+                0x40,
+                0x00,
             };
-            f_file.add_text(buf, sizeof(buf));
+            f_file.add_text(nop, sizeof(nop));
         }
         break;
 
-    default:
-        if(rhs->get_data_type() == node_t::NODE_VARIABLE)
-        {
-            if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
-            {
-                // if the variable is a floating point then it needs conversion
-                // before it can be used
-                //
-                generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
-                std::uint8_t buf[] = {
-                    0x48,       // AND/OR/XOR %rdx, %rax
-                    code_r64,
-                    0xC2,
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            else
-            {
-                // a variable needs to be loaded from memory so we need an AND
-                // which reads the variable location
-                //
-                generate_reg_mem_integer(rhs, register_t::REGISTER_RAX, code_r64);
-            }
-        }
-        else
+    case 8 - 5:
         {
-            if(rhs->get_data_type() != node_t::NODE_INTEGER)
-            {
-                throw not_implemented(
-                      std::string("trying to apply a bitwise operator on a \"")
-                    + node::type_to_string(rhs->get_data_type())
-                    + "\" which is not yet implemented.");
-            }
-            throw not_implemented(
-                  "found integer size "
-                + std::to_string(static_cast<int>(rhs->get_integer_size()))
-                + " which is not yet implemented in generate_bitwise().");
+            std::uint8_t nop[] = {
+                0x0F,
+                0x1F,
+                0x44,
+                0x00,
+                0x00,
+            };
+            f_file.add_text(nop, sizeof(nop));
         }
+        break;
 
-    }
-
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
-    {
-        // a convert is rather expensive, in this case do it just once
-        // ahead of time
-        //
-        std::uint8_t buf[] = {
-            0xF2,       // CVTSI2SD %rax, %xmm0
-            0x48,
-            0x0F,
-            0x2A,
-            0xC0,
-        };
-        f_file.add_text(buf, sizeof(buf));
-
-        if(is_assignment)
+    case 8 - 6:
         {
-            generate_store_floating_point(lhs, register_t::REGISTER_RAX);
+            std::uint8_t nop[] = {
+                0x66,
+                0x0F,
+                0x1F,
+                0x44,
+                0x00,
+                0x00,
+            };
+            f_file.add_text(nop, sizeof(nop));
         }
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_RAX);
-    }
-    else
-    {
-        if(is_assignment)
+        break;
+
+    case 8 - 7:
         {
-            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+            std::uint8_t nop[] = {
+                0x0F,
+                0x1F,
+                0x80,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+            };
+            f_file.add_text(nop, sizeof(nop));
         }
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        break;
+
     }
 }
 
 
-void binary_assembler::generate_bitwise_not(operation::pointer_t op)
+
+
+void binary_assembler::generate_reg_mem_integer(data::pointer_t d, register_t const reg, std::uint8_t code, int adjust_offset)
 {
-    data::pointer_t lhs(op->get_left_handside());
-    variable_type_t const type(get_type_of_node(op->get_node()));
-    switch(type)
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
     {
-    case VARIABLE_TYPE_FLOATING_POINT:
-    case VARIABLE_TYPE_INTEGER:
-        if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            generate_reg_mem_floating_point(lhs, register_t::REGISTER_RAX, sse_operation_t::SSE_OPERATION_CVT2I);
-        }
-        else
+    case node_t::NODE_INTEGER: // immediate integer
         {
-            generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-        }
+            std::int64_t const value(d->get_node()->get_integer().get());
+            switch(get_smallest_size(value))
+            {
+            case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
+            case integer_size_t::INTEGER_SIZE_64BITS:
+                {
+                    std::uint8_t buf[] = {   // REX.W MOV $imm64, %rn
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                        static_cast<std::uint8_t>(0xB8 | (static_cast<int>(reg) & 7)),
+                        static_cast<std::uint8_t>(value >>  0),
+                        static_cast<std::uint8_t>(value >>  8),
+                        static_cast<std::uint8_t>(value >> 16),
+                        static_cast<std::uint8_t>(value >> 24),
+                        static_cast<std::uint8_t>(value >> 32),
+                        static_cast<std::uint8_t>(value >> 40),
+                        static_cast<std::uint8_t>(value >> 48),
+                        static_cast<std::uint8_t>(value >> 56),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
 
-        {
-            std::uint8_t buf[] = {
-                0x48,       // REX.W NOT %rax
-                0xF7,
-                0xD0,
-            };
-            f_file.add_text(buf, sizeof(buf));
+            default:
+                // in 64bit the sign extend works with 32 bits so all others
+                // can make use of the 32 bit value
+                //
+                // on the other hand, the 16 & 8 bit immediate do not get
+                // extended; the upper part of the register remains unchanged
+                //
+                // Note: the MOVSX/MOVZX do not work with immediate values
+                {
+                    std::uint8_t buf[] = {   // REX.W MOV $imm32, %rn
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                        0xC7,
+                        static_cast<std::uint8_t>(0xC0 | (static_cast<int>(reg) & 7)),
+                        static_cast<std::uint8_t>(value >>  0),
+                        static_cast<std::uint8_t>(value >>  8),
+                        static_cast<std::uint8_t>(value >> 16),
+                        static_cast<std::uint8_t>(value >> 24),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
+
+            }
         }
+        break;
 
-        if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    case node_t::NODE_FLOATING_POINT: // immediate floating point to load as an integer
         {
-            // a convert is rather expensive, in this case do it just once
-            // ahead of time
-            //
-            std::uint8_t buf[] = {
-                0xF2,       // CVTSI2SD %rax, %xmm0
-                0x48,
-                0x0F,
-                0x2A,
-                0xC0,
+            double const floating_point(d->get_node()->get_floating_point().get());
+            double const * fp(&floating_point);
+            std::int64_t const value(*reinterpret_cast<std::int64_t const *>(fp));
+            std::uint8_t buf[] = {   // REX.W MOV $imm64, %rn
+                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                static_cast<std::uint8_t>(0xB8 | (static_cast<int>(reg) & 7)),
+                static_cast<std::uint8_t>(value >>  0),
+                static_cast<std::uint8_t>(value >>  8),
+                static_cast<std::uint8_t>(value >> 16),
+                static_cast<std::uint8_t>(value >> 24),
+                static_cast<std::uint8_t>(value >> 32),
+                static_cast<std::uint8_t>(value >> 40),
+                static_cast<std::uint8_t>(value >> 48),
+                static_cast<std::uint8_t>(value >> 56),
             };
             f_file.add_text(buf, sizeof(buf));
-
-            generate_store_floating_point(op->get_result(), register_t::REGISTER_RAX);
-        }
-        else
-        {
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
         }
         break;
 
-    case VARIABLE_TYPE_STRING:
-        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_FLIP_CASE);
-        break;
-
-    default:
-        throw not_implemented(
-              "bitwise not of type "
-            + std::to_string(static_cast<int>(type))
-            + " is not yet implemented.");
-
-    }
-}
-
-
-void binary_assembler::generate_call(operation::pointer_t op)
-{
-    // a call creates a list of parameters; here we have to transform
-    // that list in a vector and pass the vector to the function; there
-    // may be no list or the list may be empty when the function does
-    // not expect parameters
-    //
-    // also the call may reference a native function (an actual CALL
-    // in assembly) or a user function call
-    //
-    data::pointer_t lhs(op->get_left_handside());       // the function being called or a member left handside variable
-    data::pointer_t params(op->get_parameter(0));       // ARRAY variable where we create the list of parameters
-
-    // allocate a vector for the list of parameters
-    //
-    temporary_variable * const params_var(f_file.find_temporary_variable(params->get_string()));
-    if(params_var == nullptr)
-    {
-        throw internal_error("temporary for parameters not found in binary_assembler::generate_call()");
-    }
-    if(params_var->get_type() != node_t::NODE_ARRAY)
-    {
-        throw internal_error("temporary for parameters in binary_assembler::generate_call() was expected to be of type ARRAY");
-    }
-    generate_pointer_to_temporary(params_var, register_t::REGISTER_RDI);
-    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_ARRAY_INITIALIZE);
-
-    // add parameters found in list to the array
-    //
-    // TODO: verify that having a list just before a call does not disturb
-    //       the call (i.e. `b, c, d; callme();` should not see the `b, c, d;`
-    //       list as the list of parameters of `callme();`)
-    //
-    std::size_t const param_count(op->get_parameter_size()); // EXCLUDING PARAM [0] which is the ARRAY variable
-    for(std::size_t idx(1); idx < param_count; ++idx)
-    {
-        data::pointer_t item(op->get_parameter(idx));
-std::cerr << "--- pushing item to param array...\n";
-        generate_pointer_to_variable(item, register_t::REGISTER_RSI);
-std::cerr << "--- pointer ready...\n";
-        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDI);
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_ARRAY_PUSH);
-    }
-
-    // make the call
-    //
-    node::pointer_t member(op->get_node()->get_child(0));
-//std::cerr << "\n--- CALL node to transform in a function call:\n" << *member << "\n";
-    if(member->get_type() == node_t::NODE_MEMBER)
-    {
-        node::pointer_t function(member->get_instance());
-        if(function->get_type() != node_t::NODE_FUNCTION
-        || !function->get_attribute(attribute_t::NODE_ATTR_NATIVE))
-        {
-            throw not_implemented("binary_assembler::generate_call(): we only support native function calls at the moment.");
-        }
-        node::pointer_t field(member->get_child(1));
-        if(field->get_type() != node_t::NODE_IDENTIFIER)
-        {
-            throw not_implemented("binary_assembler::generate_call(): we only support identifiers for the field name.");
-        }
-        std::string const & field_name(field->get_string());
-        if(field_name.empty())
-        {
-            throw internal_error("binary_assembler::generate_call(): field name is somehow empty.");
-        }
-        node::pointer_t object(member->get_child(0));
-        node::pointer_t type_node(object->get_type_node());
-        if(type_node == nullptr)
-        {
-            throw not_implemented("binary_assembler::generate_call(): we only support typed objects.");
-        }
-        std::string const & type_name(type_node->get_string());
-        if(type_name.empty())
-        {
-            throw internal_error("binary_assembler::generate_call(): type name is somehow empty.");
-        }
-        bool found(true);
-        switch(type_name[0])
+    case node_t::NODE_VARIABLE:
+        if(d->is_temporary())
         {
-        case 'B':
-            if(type_name == "Boolean")
+            std::string const name(n->get_string());
+            temporary_variable * temp_var(f_file.find_temporary_variable(name));
+            if(temp_var == nullptr)
             {
-                switch(field_name[0])
+                throw internal_error("temporary not found in generate_reg_mem_integer()");
+            }
+            switch(temp_var->get_size())
+            {
+            case 1: // Boolean
                 {
-                case 't':
-                    if(field_name == "toString")
-                    {
-                        generate_reg_mem_integer(lhs, register_t::REGISTER_RSI);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_BOOLEANS_TO_STRING);
-                    }
-                    else
+                    ssize_t const offset(temp_var->get_offset());
+                    integer_size_t const offset_size(get_smallest_size(offset));
+                    std::uint8_t rm(0x45);
+                    switch(code)
                     {
-                        found = false;
-                    }
-                    break;
+                    case 0x8B:  // MOVSX 64bit -> MOV 8bit
+                        switch(offset_size)
+                        {
+                        case integer_size_t::INTEGER_SIZE_1BIT:
+                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                            {
+                                std::uint8_t buf[] = {          // REX.W MOV byte disp8(%rbp), %rn
+                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                    0x0F,
+                                    0xBE,
+                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                                    static_cast<std::uint8_t>(offset),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
 
-                case 'v':
-                    if(field_name == "valueOf")
-                    {
-                        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-                        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                            {
+                                std::uint8_t buf[] = {          // REX.W MOV disp32(%rbp), %rn
+                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                    0x0F,
+                                    0xBE,
+                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                                    static_cast<std::uint8_t>(offset >>  0),
+                                    static_cast<std::uint8_t>(offset >>  8),
+                                    static_cast<std::uint8_t>(offset >> 16),
+                                    static_cast<std::uint8_t>(offset >> 24),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
 
-                default:
-                    found = false;
-                    break;
+                        default:
+                            // x86-64 only supports disp8 and disp32
+                            //
+                            // for larger offsets we would need to use an
+                            // index register; but we should never go over
+                            // disp32 on the stack anyway since it's only 2Mb
+                            //
+                            throw not_implemented("offset size not yet supported for \""
+                                + temp_var->get_name()
+                                + "\" (type: "
+                                + std::to_string(static_cast<int>(offset_size))
+                                + " for size: "
+                                + std::to_string(offset)
+                                + ").");
 
-                }
-            }
-            else
-            {
-                found = false;
-            }
-            break;
+                        }
+                        return;
 
-        case 'D':
-            if(type_name == "Double")
-            {
-                goto number;
-            }
-            break;
+                    case 0x83:  // CMP 64bit, imm8 -> CMP 8bit, imm8
+                        code = 0x80;
+                        rm = 0x7D;
+                        break;
 
-        case 'I':
-            if(type_name == "Integer")
-            {
-                switch(field_name[0])
-                {
-                case 't':
-                    if(field_name == "toString")
-                    {
-                        generate_reg_mem_integer(lhs, register_t::REGISTER_RSI);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_INTEGERS_TO_STRING);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                    default:
+                        throw not_implemented(
+                              "8 bit code \""
+                            + std::to_string(static_cast<int>(code))
+                            + "\" in generate_reg_mem_integer() not yet supported (temporary variable).");
 
-                case 'v':
-                    if(field_name == "valueOf")
-                    {
-                        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-                        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
                     }
-                    else
+                    switch(offset_size)
                     {
-                        found = false;
-                    }
-                    break;
+                    case integer_size_t::INTEGER_SIZE_1BIT:
+                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                        if(reg >= register_t::REGISTER_RSP)
+                        {
+                            std::uint8_t buf[] = {          // REX.W MOV byte disp8(%rbp), %rn.b
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                code,
+                                static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        else
+                        {
+                            std::uint8_t buf[] = {          // MOV byte disp8(%rbp), %rn.b
+                                code,
+                                static_cast<std::uint8_t>(rm | (static_cast<int>(reg) << 3)),
+                                static_cast<std::uint8_t>(offset),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
 
-                default:
-                    found = false;
-                    break;
+                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                        if(reg >= register_t::REGISTER_RSP)
+                        {
+                            // rm = 0x45 -> 0x85 for 32 bit disp
+                            //
+                            std::uint8_t buf[] = {          // REX.W MOV disp32(%rbp), %r8
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                code,
+                                static_cast<std::uint8_t>((rm ^ 0xC0) | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset >>  0),
+                                static_cast<std::uint8_t>(offset >>  8),
+                                static_cast<std::uint8_t>(offset >> 16),
+                                static_cast<std::uint8_t>(offset >> 24),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        else
+                        {
+                            // rm = 0x45 -> 0x85 for 32 bit disp
+                            //
+                            std::uint8_t buf[] = {          // MOV disp32(%rbp), %r8
+                                code,
+                                static_cast<std::uint8_t>((rm ^ 0xC0) | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset >>  0),
+                                static_cast<std::uint8_t>(offset >>  8),
+                                static_cast<std::uint8_t>(offset >> 16),
+                                static_cast<std::uint8_t>(offset >> 24),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    default:
+                        // x86-64 only supports disp8 and disp32
+                        //
+                        // for larger offsets we would need to use an
+                        // index register; but we should never go over
+                        // disp32 on the stack anyway since it's only 2Mb
+                        //
+                        throw not_implemented("offset size not yet supported for \""
+                            + temp_var->get_name()
+                            + "\" (type: "
+                            + std::to_string(static_cast<int>(offset_size))
+                            + " for size: "
+                            + std::to_string(offset)
+                            + ").");
 
+                    }
                 }
-            }
-            else
-            {
-                found = false;
-            }
-            break;
+                break;
 
-        case 'M':
-            if(type_name == "Math")
-            {
-                switch(field_name[0])
+            case 8: // Integer / Double
+                if(temp_var->has_register())
                 {
-                case 'E':
-                    if(field_name == "E")
+                    int const r(static_cast<int>(temp_var->get_register()));
+                    if(temp_var->get_type() != node_t::NODE_DOUBLE)
                     {
-                        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RSI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_FLOATING_POINTS_TO_STRING);
+                        std::uint8_t buf[] = {    // REX.W <code> %rm, %rn
+                            static_cast<std::uint8_t>(0x48
+                                    | (reg >= register_t::REGISTER_R8 ? 0x04 : 0x00)
+                                    | (r >= 8 ? 0x01 : 0x00)),
+                            code,
+                            static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3) | (r & 7)),
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        break;
                     }
-                    else
+                    if(code == 0x8B)
                     {
-                        found = false;
+                        std::uint8_t buf[] = {    // MOVQ %xmm, %rn
+                            0x66,
+                            static_cast<std::uint8_t>(0x48
+                                    | (r >= 8 ? 0x04 : 0x00)
+                                    | (reg >= register_t::REGISTER_R8 ? 0x01 : 0x00)),
+                            0x0F,
+                            0x7E,
+                            static_cast<std::uint8_t>(0xC0 | ((r & 7) << 3) | (static_cast<int>(reg) & 7)),
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        break;
                     }
-                    break;
-
-                default:
-                    found = false;
-                    break;
 
+                    // other instructions read the value from the stack
+                    //
+                    generate_spill(temp_var, temp_var->get_register());
                 }
-            }
-            else
-            {
-                found = false;
-            }
-            break;
-
-        case 'N':
-            if(type_name == "Number")
-            {
-number:
-                switch(field_name[0])
                 {
-                case 't':
-                    if(field_name == "toString")
-                    {
-                        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RSI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_FLOATING_POINTS_TO_STRING);
-                    }
-                    else
+                    ssize_t const offset(temp_var->get_offset());
+                    integer_size_t const offset_size(get_smallest_size(offset));
+                    switch(offset_size)
                     {
-                        found = false;
-                    }
-                    break;
+                    case integer_size_t::INTEGER_SIZE_1BIT:
+                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                        {
+                            std::uint8_t buf[] = {    // REX.W MOV disp8(%rbp), %rn
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                code,
+                                static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
 
-                case 'v':
-                    if(field_name == "valueOf")
-                    {
-                        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-                        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                        {
+                            std::uint8_t buf[] = {   // REX.W MOV disp32(%rbp), %rn
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                code,
+                                static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset >>  0),
+                                static_cast<std::uint8_t>(offset >>  8),
+                                static_cast<std::uint8_t>(offset >> 16),
+                                static_cast<std::uint8_t>(offset >> 24),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
 
-                default:
-                    found = false;
-                    break;
+                    default:
+                        // x86-64 only supports disp8 and disp32
+                        //
+                        // for larger offsets we would need to use an
+                        // index register; but we should never go over
+                        // disp32 on the stack anyway since it's only 2Mb
+                        //
+                        throw not_implemented("offset size not yet supported for \""
+                            + temp_var->get_name()
+                            + "\" (type: "
+                            + std::to_string(static_cast<int>(offset_size))
+                            + " for size: "
+                            + std::to_string(offset)
+                            + ").");
 
+                    }
                 }
+                break;
+
+            default:
+                throw not_implemented("temporary size not yet supported in generate_reg_mem_integer()");
+
             }
-            else
-            {
-                found = false;
-            }
-            break;
+        }
+        else if(d->is_extern())
+        {
+            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
 
-        case 'S':
-            if(type_name == "String")
-            {
-                switch(field_name[0])
-                {
-                case 'c':
-                    if(field_name == "charAt")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CHAR_AT);
-                    }
-                    else if(field_name == "charCodeAt")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CHAR_CODE_AT);
-                    }
-                    else if(field_name == "concat")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CONCAT_PARAMS);
-                    }
-                    else
+            // I do not think this is correct, we probably need to check
+            // the type first? (i.e. strings have variable sizes and encoding
+            // that as 1 or 8 bytes is not going to work)
+            //
+            switch(var->f_data_size)
+            {
+            case 1:
+                {
+                    std::uint8_t rm(0x83);
+                    switch(code)
                     {
-                        found = false;
-                    }
-                    break;
+                    case 0x0B:  // OR (m8), %r8
+                        code = 0x0A;
+                        break;
 
-                case 'i':
-                    if(field_name == "indexOf")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_INDEX_OF);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                    case 0x23:  // AND (m8), %r8
+                        code = 0x22;
+                        break;
 
-                case 'l':
-                    if(field_name == "lastIndexOf")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_LAST_INDEX_OF);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                    case 0x33:  // XOR (m8), %r8
+                        code = 0x32;
+                        break;
 
-                case 'r':
-                    if(field_name == "replace")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_REPLACE);
-                    }
-                    else if(field_name == "replaceAll")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_REPLACE_ALL);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                    case 0x3B:  // CMP (m8), %r8
+                        code = 0x3A;
+                        break;
 
-                case 's':
-                    if(field_name == "slice")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_SLICE);
-                    }
-                    else if(field_name == "substring")
-                    {
-                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_SUBSTRING);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+                    case 0x8B:  // MOV (m8), %r8
+                        code = 0x8A;
+                        break;
+
+                    case 0x83:  // CMP $imm8, %r8
+                        code = 0x80;
+                        rm = 0xBB;
+                        break;
+
+                    default:
+                        throw not_implemented(
+                              "8 bit code \""
+                            + std::to_string(static_cast<int>(code))
+                            + "\" in generate_reg_mem_integer() not yet supported (external variable).");
 
-                case 't':
-                    if(field_name == "toLowerCase")
-                    {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TO_LOWERCASE);
-                    }
-                    else if(field_name == "toUpperCase")
-                    {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TO_UPPERCASE);
-                    }
-                    else if(field_name == "toString")
-                    {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
-                    }
-                    else if(field_name == "trim")
-                    {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TRIM);
-                    }
-                    else if(field_name == "trimStart" || field_name == "trimLeft")
-                    {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TRIM_START);
                     }
-                    else if(field_name == "trimEnd" || field_name == "trimRight")
+//std::cerr << " -- select reg [" << static_cast<int>(reg) << "]\n";
+                    if(reg >= register_t::REGISTER_RSP || code == 0x8A)
                     {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TRIM_END);
+                        std::size_t pos(f_file.get_current_text_offset());
+                        if(code == 0x8A)
+                        {
+                            // the MOV requires one more byte using the
+                            // MOVZX to clear all the upper bits...
+                            //
+                            std::uint8_t buf[] = {
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x4C : 0x48),
+                                0x0F,                       // REX.W MOVSBQ disp32(%rbx), %r64
+                                0xBE,
+                                static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
+                                0x00,
+                                0x00,
+                                0x00,
+                                0x00,
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                            pos += 4;
+                        }
+                        else
+                        {
+                            std::uint8_t buf[] = {          // CMP disp32(%rbx), %r8
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x4C : 0x48),
+                                code,
+                                static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
+                                0x00,                       // 32 bit offset
+                                0x00,
+                                0x00,
+                                0x00,
+                                // for CMP disp(%rbx), $imm8, the immediate
+                                // is added by the caller on return
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                            pos += 3;
+                        }
+                        f_file.add_relocation(
+                                  d->get_string()
+                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                , pos
+                                , f_file.get_current_text_offset() + adjust_offset);
                     }
                     else
                     {
-                        found = false;
+                        std::size_t const pos(f_file.get_current_text_offset());
+                        std::uint8_t buf[] = {          // MOV disp32(m8), r8
+                            code,
+                            static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
+                            0x00,                       // 32 bit offset
+                            0x00,
+                            0x00,
+                            0x00,
+                            // for CMP disp(%rbx), $imm8, the immediate
+                            // is added by the caller on return
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        f_file.add_relocation(
+                                  d->get_string()
+                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                , pos + 2
+                                , f_file.get_current_text_offset() + adjust_offset);
                     }
-                    break;
+                }
+                break;
+
+            case 8:
+                {
+                    std::size_t const pos(f_file.get_current_text_offset());
+                    std::uint8_t buf[] = {          // REX.W MOV disp32(%rbx), %r64
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x4C : 0x48),
+                        code,
+                        static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                    f_file.add_relocation(
+                              d->get_string()
+                            , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                            , pos + 3
+                            , f_file.get_current_text_offset() + adjust_offset);
+                }
+                break;
+
+            default:
+                throw not_implemented(
+                      "WARNING: generate_reg_mem_integer() hit an extern variable size ("
+                    + std::to_string(var->f_data_size)
+                    + ") not yet implemented...");
+
+            }
+        }
+        else
+        {
+            throw not_implemented("WARNING: generate_reg_mem_integer() hit a variable type not yet implemented...");
+        }
+        break;
+
+    default:
+        throw not_implemented("WARNING: generate_reg_mem_integer() hit a data type not yet implemented...");
+
+    }
+}
+
+
+void binary_assembler::generate_reg_mem_floating_point(data::pointer_t d, register_t const reg, sse_operation_t op, int adjust_offset)
+{
+    std::uint8_t code(0x8B);
+
+    std::uint8_t sse_code(0x10);    // code for MOVSD
+    switch(op)
+    {
+    case sse_operation_t::SSE_OPERATION_ADD:
+        sse_code = 0x58;
+        break;
+
+    case sse_operation_t::SSE_OPERATION_CMP:
+        sse_code = 0xC2;
+        break;
+
+    case sse_operation_t::SSE_OPERATION_DIV:
+        sse_code = 0x5E;
+        break;
+
+    case sse_operation_t::SSE_OPERATION_LOAD:
+    case sse_operation_t::SSE_OPERATION_CVT2I: // convert is used like a LOAD
+    case sse_operation_t::SSE_OPERATION_CVT2D: // convert is used like a LOAD
+        // sse_code is already set to MOVSD
+        break;
+
+    case sse_operation_t::SSE_OPERATION_MAX:
+        sse_code = 0x5F;
+        break;
+
+    case sse_operation_t::SSE_OPERATION_MIN:
+        sse_code = 0x5D;
+        break;
+
+    case sse_operation_t::SSE_OPERATION_MUL:
+        sse_code = 0x59;
+        break;
+
+    case sse_operation_t::SSE_OPERATION_SUB:
+        sse_code = 0x5C;
+        break;
+
+    default:
+        throw internal_error(
+                  "unknown SSE operation "
+                + std::to_string(static_cast<int>(op))
+                + " in generate_reg_mem_floating_point().");
+
+    }
+
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_INTEGER: // immediate integer
+        if(op == sse_operation_t::SSE_OPERATION_CVT2I)
+        {
+            // the caller wants the result as an integer in a regular
+            // register so do that with a generate_reg_mem_integer() call
+            //
+            generate_reg_mem_integer(d, reg, 0x8B, adjust_offset);
+            break;
+        }
+
+        {
+            double const value(static_cast<double>(d->get_node()->get_integer().get()));
+            std::string name;
+            f_file.add_constant(value, name);
+            d->set_data_name(name);
+        }
+        [[fallthrough]];
+    case node_t::NODE_FLOATING_POINT: // immediate double--use the copy in the private data section
+        {
+            offset_t const offset(f_file.get_constant_offset(d->get_data_name()));
+            switch(op)
+            {
+            case sse_operation_t::SSE_OPERATION_ADD:
+            case sse_operation_t::SSE_OPERATION_DIV:
+            case sse_operation_t::SSE_OPERATION_LOAD:
+            case sse_operation_t::SSE_OPERATION_CVT2D:
+            case sse_operation_t::SSE_OPERATION_MAX:
+            case sse_operation_t::SSE_OPERATION_MIN:
+            case sse_operation_t::SSE_OPERATION_MUL:
+            case sse_operation_t::SSE_OPERATION_SUB:
+                {
+                    std::size_t const pos(f_file.get_current_text_offset());
+                    std::uint8_t buf[] = {   // MOVSD disp32(%rip), %xmm
+                        0xF2,
+                        // TODO: add 0x44 if reg >= xmm8
+                        0x0F,
+                        sse_code,
+                        static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
+                        static_cast<std::uint8_t>(offset >>  0),
+                        static_cast<std::uint8_t>(offset >>  8),
+                        static_cast<std::uint8_t>(offset >> 16),
+                        static_cast<std::uint8_t>(offset >> 24),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                    f_file.add_relocation(
+                              d->get_data_name()
+                            , relocation_t::RELOCATION_CONSTANT_32BITS
+                            , pos + 4
+                            , f_file.get_current_text_offset() + adjust_offset);
+                }
+                break;
+
+            case sse_operation_t::SSE_OPERATION_CVT2I:
+                {
+                    // if we had an INTEGER, it was caught in the previous
+                    // case at the previous level so the following call
+                    // cannot fail because of that
+                    //
+                    double const floating_point(static_cast<double>(d->get_node()->get_floating_point().get()));
+                    std::int64_t const value(floating_point);
+                    switch(get_smallest_size(value))
+                    {
+                    case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_64BITS:
+                        {
+                            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rn
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),       // 64 bits
+                                static_cast<std::uint8_t>(0xB8 | (static_cast<int>(reg) & 7)),
+                                static_cast<std::uint8_t>(value >>  0),
+                                static_cast<std::uint8_t>(value >>  8),
+                                static_cast<std::uint8_t>(value >> 16),
+                                static_cast<std::uint8_t>(value >> 24),
+                                static_cast<std::uint8_t>(value >> 32),
+                                static_cast<std::uint8_t>(value >> 40),
+                                static_cast<std::uint8_t>(value >> 48),
+                                static_cast<std::uint8_t>(value >> 56),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    default:
+                        // in 64bit the sign extend works with 32 bits so all others
+                        // can make use of the 32 bit value
+                        //
+                        // on the other hand, the 16 & 8 bit immediate do not get
+                        // extended; the upper part of the register remains unchanged
+                        //
+                        // Note: the MOVSX/MOVZX do not work with immediate values
+                        {
+                            std::uint8_t buf[] = {   // REX.W MOV $imm32, %rn
+                                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                0xC7,
+                                static_cast<std::uint8_t>(0xC0 | (static_cast<int>(reg) & 7)),
+                                static_cast<std::uint8_t>(value >>  0),
+                                static_cast<std::uint8_t>(value >>  8),
+                                static_cast<std::uint8_t>(value >> 16),
+                                static_cast<std::uint8_t>(value >> 24),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    }
+                    //std::size_t const pos(f_file.get_current_text_offset());
+                    //std::uint8_t buf[] = {
+                    //    0xF2,       // REX.W CVTSD2SI disp32(%rip), %xmm
+                    //    0x48,
+                    //    0x0F,
+                    //    0x2D,
+                    //    static_cast<std::uint8_t>(0x05 | (reg << 3)),
+                    //    static_cast<std::uint8_t>(offset >>  0),
+                    //    static_cast<std::uint8_t>(offset >>  8),
+                    //    static_cast<std::uint8_t>(offset >> 16),
+                    //    static_cast<std::uint8_t>(offset >> 24),
+                    //};
+                    //f_file.add_text(buf, sizeof(buf));
+                    //f_file.add_relocation(
+                    //          d->get_data_name()
+                    //        , relocation_t::RELOCATION_CONSTANT_32BITS
+                    //        , pos + 5
+                    //        , f_file.get_current_text_offset() + adjust_offset);
+                }
+                break;
+
+            default:
+                throw not_implemented(
+                      "floating point operation ("
+                    + std::to_string(static_cast<int>(op))
+                    + ") not yet implemented in generate_reg_mem_floating_point()");
+
+            }
+        }
+        break;
+
+    case node_t::NODE_VARIABLE:
+        if(d->is_temporary())
+        {
+            std::string const name(n->get_string());
+            temporary_variable * temp_var(f_file.find_temporary_variable(name));
+            if(temp_var == nullptr)
+            {
+                throw internal_error("temporary not found in generate_reg_mem_floating_point()");
+            }
+            switch(temp_var->get_size())
+            {
+            case 1: // Boolean
+                {
+                    ssize_t const offset(temp_var->get_offset());
+                    integer_size_t const offset_size(get_smallest_size(offset));
+                    std::uint8_t rm(0x45);
+                    switch(op)
+                    {
+                    case sse_operation_t::SSE_OPERATION_LOAD:  // MOV 64bit -> MOV 8bit
+                    case sse_operation_t::SSE_OPERATION_CVT2D:
+                        code = 0x8A;
+                        break;
+
+                    case sse_operation_t::SSE_OPERATION_CMP:  // CMP 64bit, imm8 -> CMP 8bit, imm8
+                        code = 0x80;
+                        rm = 0x7D;
+                        break;
+
+                    default:
+                        throw not_implemented("8 bit code in generate_reg_mem_floating_point() not yet supported.");
+
+                    }
+                    switch(offset_size)
+                    {
+                    case integer_size_t::INTEGER_SIZE_1BIT:
+                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                        {
+                            std::uint8_t buf[] = {    // MOV disp8(%rbp), %r8
+                                code,
+                                static_cast<std::uint8_t>(rm | (static_cast<int>(reg) << 3)),
+                                static_cast<std::uint8_t>(offset),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                        {
+                            std::uint8_t buf[] = {    // MOV disp32(%rbp), %r8
+                                code,
+                                static_cast<std::uint8_t>((rm ^ 0xC0) | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset >>  0),
+                                static_cast<std::uint8_t>(offset >>  8),
+                                static_cast<std::uint8_t>(offset >> 16),
+                                static_cast<std::uint8_t>(offset >> 24),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    default:
+                        // x86-64 only supports disp8 and disp32
+                        //
+                        // for larger offsets we would need to use an
+                        // index register; but we should never go over
+                        // disp32 on the stack anyway since it's only 2Mb
+                        //
+                        throw not_implemented("offset size not yet supported for \""
+                            + temp_var->get_name()
+                            + "\" (type: "
+                            + std::to_string(static_cast<int>(offset_size))
+                            + " for size: "
+                            + std::to_string(offset)
+                            + ").");
+
+                    }
+                }
+                break;
+
+            case 8: // Integer / Double
+                if(temp_var->has_register())
+                {
+                    int const r(static_cast<int>(temp_var->get_register()));
+                    if(temp_var->get_type() == node_t::NODE_DOUBLE)
+                    {
+                        std::uint8_t const buf[] = {    // F2 [REX] 0F <sse_code> %xmm, %xmm
+                            0xF2,
+                            static_cast<std::uint8_t>(0x40
+                                    | (reg >= register_t::REGISTER_R8 ? 0x04 : 0x00)
+                                    | (r >= 8 ? 0x01 : 0x00)),
+                            0x0F,
+                            sse_code,
+                            static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3) | (r & 7)),
+                        };
+                        if(buf[1] == 0x40)
+                        {
+                            f_file.add_text(buf, 1);
+                            f_file.add_text(buf + 2, sizeof(buf) - 2);
+                        }
+                        else
+                        {
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+                    }
+                    if(sse_code == 0x10)
+                    {
+                        std::uint8_t buf[] = {    // MOVQ %rn, %xmm
+                            0x66,
+                            static_cast<std::uint8_t>(0x48
+                                    | (reg >= register_t::REGISTER_R8 ? 0x04 : 0x00)
+                                    | (r >= 8 ? 0x01 : 0x00)),
+                            0x0F,
+                            0x6E,
+                            static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3) | (r & 7)),
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        break;
+                    }
+
+                    // other instructions read the value from the stack
+                    //
+                    generate_spill(temp_var, temp_var->get_register());
+                }
+                {
+                    ssize_t const offset(temp_var->get_offset());
+                    integer_size_t const offset_size(get_smallest_size(offset));
+                    switch(offset_size)
+                    {
+                    case integer_size_t::INTEGER_SIZE_1BIT:
+                    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                        {
+                            std::uint8_t buf[] = {    // MOVSD disp8(%rbp), %xmm
+                                0xF2,
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        if(reg >= register_t::REGISTER_R8)
+                        {
+                            std::uint8_t buf[] = {
+                                0x44,
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        {
+                            std::uint8_t buf[] = {
+                                0x0F,
+                                sse_code,
+                                static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                        {
+                            std::uint8_t buf[] = {    // MOVSD disp32(%rbp), %xmm
+                                0xF2,
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        if(reg >= register_t::REGISTER_R8)
+                        {
+                            std::uint8_t buf[] = {
+                                0x44,
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        {
+                            std::uint8_t buf[] = {
+                                0x0F,
+                                0x10,
+                                static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
+                                static_cast<std::uint8_t>(offset >>  0),
+                                static_cast<std::uint8_t>(offset >>  8),
+                                static_cast<std::uint8_t>(offset >> 16),
+                                static_cast<std::uint8_t>(offset >> 24),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+
+                    default:
+                        // x86-64 only supports disp8 and disp32
+                        //
+                        // for larger offsets we would need to use an
+                        // index register; but we should never go over
+                        // disp32 on the stack anyway since it's only 2Mb
+                        //
+                        throw not_implemented("offset size not yet supported for \""
+                            + temp_var->get_name()
+                            + "\" (type: "
+                            + std::to_string(static_cast<int>(offset_size))
+                            + " for size: "
+                            + std::to_string(offset)
+                            + ").");
+
+                    }
+                }
+                break;
+
+            default:
+                throw not_implemented("temporary size not yet supported in generate_reg_mem_floating_point()");
+
+            }
+        }
+        else if(d->is_extern())
+        {
+            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
+            if(var == nullptr)
+            {
+                throw internal_error(
+                      "extern variable \""
+                    + d->get_string()
+                    + "\" not found in generate_reg_mem_floating_point()");
+            }
+            switch(var->f_type)
+            {
+            case VARIABLE_TYPE_BOOLEAN:
+                {
+                    std::uint8_t rm(0x83);
+                    switch(op)
+                    {
+                    case sse_operation_t::SSE_OPERATION_LOAD:  // MOV 64bit -> MOV 8bit
+                    case sse_operation_t::SSE_OPERATION_CVT2D:
+                        code = 0x8A;
+                        break;
+
+                    case sse_operation_t::SSE_OPERATION_CMP:  // CMP 64bit, imm8 -> CMP 8bit, imm8
+                        code = 0x80;
+                        rm = 0xBB;
+                        break;
+
+                    default:
+                        throw not_implemented("8 bit code in generate_reg_mem_floating_point() not yet supported.");
+
+                    }
+//std::cerr << " -- select reg [" << static_cast<int>(reg) << "]\n";
+                    std::size_t pos(f_file.get_current_text_offset());
+                    if(code == 0x8A)
+                    {
+                        // the MOV requires one more byte using the
+                        // MOVZX to clear all the upper bits
+                        //
+                        std::uint8_t buf[] = {      // REX.W MOVZBQ disp32(%rbx), %r64
+                            0x48,
+                            0x0F,
+                            0xB6,
+                            static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
+                            0x00,                       // 32 bit offset
+                            0x00,
+                            0x00,
+                            0x00,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        ++pos;
+                    }
+                    else
+                    {
+                        std::uint8_t buf[] = {      // REX.W CMP disp32(%rbx), %r8 (or $imm8?)
+                            0x48,
+                            code,
+                            static_cast<std::uint8_t>(rm | ((static_cast<int>(reg) & 7) << 3)),
+                            0x00,                       // 32 bit offset
+                            0x00,
+                            0x00,
+                            0x00,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                    }
+                    f_file.add_relocation(
+                              d->get_string()
+                            , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                            , pos + 3
+                            , f_file.get_current_text_offset() + adjust_offset);
+                }
+                break;
+
+            case VARIABLE_TYPE_INTEGER:
+                switch(op)
+                {
+                case sse_operation_t::SSE_OPERATION_LOAD:
+                case sse_operation_t::SSE_OPERATION_CVT2I:
+                    {
+                        std::size_t const pos(f_file.get_current_text_offset());
+                        std::uint8_t buf[] = {      // MOV disp32(%rbx), %rn
+                            0x48,
+                            code,
+                            static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                            0x00,       // 32 bit offset
+                            0x00,
+                            0x00,
+                            0x00,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        f_file.add_relocation(
+                                  d->get_string()
+                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                , pos + 3
+                                , f_file.get_current_text_offset() + adjust_offset);
+                    }
+                    break;
+
+                case sse_operation_t::SSE_OPERATION_CVT2D:
+                    {
+                        std::size_t const pos(f_file.get_current_text_offset());
+                        std::uint8_t buf[] = {     // REX.W CVTSI2SD disp32(%rbx), %xmmn
+                            0xF2,
+                            0x48,
+                            0x0F,
+                            0x2A,
+                            static_cast<std::uint8_t>(0x83 | (static_cast<int>(reg) << 3)),
+                            0x00,
+                            0x00,
+                            0x00,
+                            0x00,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        f_file.add_relocation(
+                                  d->get_string()
+                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                , pos + 5
+                                , f_file.get_current_text_offset() + adjust_offset);
+                    }
+                    break;
+
+                case sse_operation_t::SSE_OPERATION_MAX:
+                case sse_operation_t::SSE_OPERATION_MIN:
+                    {
+                        register_t const other_reg(
+                                reg == register_t::REGISTER_XMM0
+                                        ? register_t::REGISTER_XMM1
+                                        : register_t::REGISTER_XMM0);
+
+                        {
+                            std::size_t const pos(f_file.get_current_text_offset());
+                            std::uint8_t buf[] = {      // CVTSI2SD disp32(%rbx), %xmm1
+                                0xF2,
+                                0x48,
+                                0x0F,
+                                0x2A,
+                                static_cast<std::uint8_t>(0x83 | ((static_cast<int>(other_reg) & 7) << 3)),
+                                0x00,       // 32 bit offset
+                                0x00,
+                                0x00,
+                                0x00,
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                            f_file.add_relocation(
+                                      d->get_string()
+                                    , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                    , pos + 5
+                                    , f_file.get_current_text_offset() + adjust_offset);
+                        }
+
+                        {
+                            std::uint8_t buf[] = {      // MAXSD or MINSD %xmm1, %xmm0
+                                0xF2,
+                                0x0F,
+                                sse_code,
+                                static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3) | static_cast<int>(other_reg)),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                    }
+                    break;
+
+                default:
+                    throw not_implemented(
+                              "Integer/SSE operation "
+                            + std::to_string(static_cast<int>(op))
+                            + " not yet implemented in generate_reg_mem_floating_point() -- expected one of MOVSD/CVTD2I/MINSD/MAXSD");
+
+                }
+                break;
+
+            case VARIABLE_TYPE_FLOATING_POINT:
+                switch(op)
+                {
+                case sse_operation_t::SSE_OPERATION_ADD:
+                case sse_operation_t::SSE_OPERATION_CMP:
+                case sse_operation_t::SSE_OPERATION_DIV:
+                case sse_operation_t::SSE_OPERATION_LOAD:
+                case sse_operation_t::SSE_OPERATION_CVT2D:
+                case sse_operation_t::SSE_OPERATION_MAX:
+                case sse_operation_t::SSE_OPERATION_MIN:
+                case sse_operation_t::SSE_OPERATION_MUL:
+                case sse_operation_t::SSE_OPERATION_SUB:
+                    {
+                        std::size_t const pos(f_file.get_current_text_offset());
+                        std::uint8_t buf[] = {       // MOVSD disp32(%rbx), %xmm
+                            0xF2,
+                            0x0F,
+                            sse_code,
+                            static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                            0x00,       // 32 bit offset
+                            0x00,
+                            0x00,
+                            0x00,
+                            // CMP??SD uses an immediate as well, which is
+                            // added by the caller
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        f_file.add_relocation(
+                                  d->get_string()
+                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                , pos + 4
+                                , f_file.get_current_text_offset() + adjust_offset);
+                    }
+                    break;
+
+                case sse_operation_t::SSE_OPERATION_CVT2I:
+                    {
+                        std::size_t const pos(f_file.get_current_text_offset());
+                        std::uint8_t buf[] = {     // REX.W CVTSD2SI disp32(%rbx), %rn
+                            0xF2,
+                            0x48,
+                            0x0F,
+                            0x2D,
+                            static_cast<std::uint8_t>(0x83 | (static_cast<int>(reg) << 3)),
+                            0x00,
+                            0x00,
+                            0x00,
+                            0x00,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                        f_file.add_relocation(
+                                  d->get_string()
+                                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                                , pos + 5
+                                , f_file.get_current_text_offset() + adjust_offset);
+                    }
+                    break;
+
+                default:
+                    throw not_implemented("SSE operation not yet implemented in generate_reg_mem_floating_point()");
+
+                }
+                break;
+
+            default:
+                throw not_implemented("WARNING: generate_reg_mem_floating_point() hit an extern variable type not yet implemented...");
+
+            }
+        }
+        else
+        {
+            throw not_implemented("WARNING: generate_reg_mem_floating_point() hit a variable type not yet implemented...");
+        }
+        break;
+
+    default:
+        throw not_implemented("WARNING: generate_reg_mem_floating_point() hit a data type not yet implemented...");
+
+    }
+}
+
+
+void binary_assembler::generate_reg_mem_string(data::pointer_t d, register_t const reg, int adjust_offset)
+{
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_STRING: // immediate string, load pointer in reg
+        {
+            offset_t const offset(f_file.get_constant_offset(d->get_data_name()));
+            std::size_t const pos(f_file.get_current_text_offset());
+            std::uint8_t buf[] = {  // REX.W LEA disp32(%rip), %rn
+                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                0x8D,
+                static_cast<std::uint8_t>(0x05 | ((static_cast<int>(reg) & 7) << 3)),
+                static_cast<std::uint8_t>(offset >>  0),
+                static_cast<std::uint8_t>(offset >>  8),
+                static_cast<std::uint8_t>(offset >> 16),
+                static_cast<std::uint8_t>(offset >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
+            f_file.add_relocation(
+                      d->get_data_name()
+                    , relocation_t::RELOCATION_CONSTANT_32BITS
+                    , pos + 3
+                    , f_file.get_current_text_offset() + adjust_offset);
+        }
+        break;
+
+    case node_t::NODE_VARIABLE:
+        if(d->is_temporary())
+        {
+            std::string const name(n->get_string());
+            temporary_variable * temp_var(f_file.find_temporary_variable(name));
+            if(temp_var == nullptr)
+            {
+                throw internal_error("temporary \""
+                    + name
+                    + "\" not found in generate_reg_mem_string()");
+            }
+            if(temp_var->get_type() != node_t::NODE_STRING)
+            {
+                throw internal_error("temporary \""
+                    + name
+                    + "\" in generate_reg_mem_string() is of type "
+                    + node::type_to_string(temp_var->get_type())
+                    + " when the compiler expected it to be of type string.");
+            }
+            ssize_t const offset(temp_var->get_offset());
+            integer_size_t const offset_size(get_smallest_size(offset));
+            switch(offset_size)
+            {
+            case integer_size_t::INTEGER_SIZE_1BIT:
+            case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                {
+                    std::uint8_t buf[] = {  // REX.W LEA disp8(%rbp), %rn
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                        0x8D,
+                        static_cast<std::uint8_t>(0x45 | (static_cast<int>(reg) << 3)),
+                        static_cast<std::uint8_t>(offset),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
+
+            case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+            case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+            case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+            case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                {
+                    std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rn
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                        0x8D,
+                        static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                        static_cast<std::uint8_t>(offset >>  0),
+                        static_cast<std::uint8_t>(offset >>  8),
+                        static_cast<std::uint8_t>(offset >> 16),
+                        static_cast<std::uint8_t>(offset >> 24),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
+
+            default:
+                // x86-64 only supports disp8 and disp32
+                //
+                // for larger offsets we would need to use an
+                // index register; but we should never go over
+                // disp32 on the stack anyway since it's only 2Mb
+                //
+                throw not_implemented("offset size not yet supported for \""
+                    + temp_var->get_name()
+                    + "\" (type: "
+                    + std::to_string(static_cast<int>(offset_size))
+                    + " for size: "
+                    + std::to_string(offset)
+                    + ").");
+
+            }
+        }
+        else if(d->is_extern())
+        {
+            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
+            if(var == nullptr)
+            {
+                throw internal_error(
+                      "extern variable \""
+                    + d->get_string()
+                    + "\" not found in generate_reg_mem_string()");
+            }
+            // TODO: other variable types need an auto-cast (but that should
+            //       be done by the compiler ahead of time?)
+            //
+            switch(var->f_type)
+            {
+            case VARIABLE_TYPE_STRING:
+                {
+                    std::size_t pos(f_file.get_current_text_offset());
+                    std::uint8_t buf[] = {      // REX.W LEA disp32(%rbx), %rn
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x4C : 0x48),
+                        0x8D,
+                        static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                    f_file.add_relocation(
+                              d->get_string()
+                            , relocation_t::RELOCATION_VARIABLE_32BITS
+                            , pos + 3
+                            , f_file.get_current_text_offset() + adjust_offset);
+                }
+                break;
+
+            default:
+                throw not_implemented(
+                      std::string("WARNING: generate_reg_mem_string() hit an extern variable type \"")
+                    + variable_type_to_string(var->f_type)
+                    + "\" not yet implemented...");
+
+            }
+        }
+        else
+        {
+            throw not_implemented("WARNING: generate_reg_mem_string() hit a variable type not yet implemented...");
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              "WARNING: generate_reg_mem_string() hit data type "
+            + std::to_string(static_cast<int>(d->get_data_type()))
+            + "/"
+            + node::type_to_string(d->get_data_type())
+            + " not yet implemented...");
+
+    }
+}
+
+
+void binary_assembler::generate_load_string_size(data::pointer_t d, register_t const reg)
+{
+    node::pointer_t n(d->get_node());
+    if(d->is_temporary())
+    {
+        std::string const name(n->get_string());
+        temporary_variable * temp_var(f_file.find_temporary_variable(name));
+        if(temp_var == nullptr)
+        {
+            throw internal_error("temporary \""
+                + name
+                + "\" not found in generate_load_string_size()");
+        }
+        if(temp_var->get_type() != node_t::NODE_STRING)
+        {
+            throw internal_error("temporary \""
+                + name
+                + "\" in generate_load_string_size() is not of type string.");
+        }
+        ssize_t const offset(temp_var->get_offset() + offsetof(binary_variable, f_data_size));
+        integer_size_t const offset_size(get_smallest_size(offset));
+        switch(offset_size)
+        {
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {  // MOV disp8(%rbp), %eax
+                    0x8B,
+                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                    static_cast<std::uint8_t>(offset),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {  // MOV disp32(%rbp), %eax
+                    0x8B,
+                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                    static_cast<std::uint8_t>(offset >>  0),
+                    static_cast<std::uint8_t>(offset >>  8),
+                    static_cast<std::uint8_t>(offset >> 16),
+                    static_cast<std::uint8_t>(offset >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        default:
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not yet supported for \""
+                + name
+                + "\" (type: "
+                + std::to_string(static_cast<int>(offset_size))
+                + " for size: "
+                + std::to_string(offset)
+                + ").");
+
+        }
+    }
+    else if(d->is_extern())
+    {
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {      // MOV disp32(%rbx), %eax
+            0x8B,
+            static_cast<std::uint8_t>(0x83 + ((static_cast<int>(reg) & 7) << 3)),
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  d->get_string()
+                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA_SIZE
+                , pos + 2
+                , f_file.get_current_text_offset());
+    }
+    else
+    {
+        throw not_implemented("load string size not implemented for this data type?!");
+    }
+}
+
+
+void binary_assembler::generate_pointer_to_temporary(temporary_variable * temp_var, register_t reg)
+{
+    ssize_t const offset(temp_var->get_offset());
+    integer_size_t const offset_size(get_smallest_size(offset));
+    switch(offset_size)
+    {
+    case integer_size_t::INTEGER_SIZE_1BIT:
+    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+        {
+            std::uint8_t buf[] = {  // REX.W LEA disp8(%rbp), %rn
+                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                0x8D,
+                static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                static_cast<std::uint8_t>(offset),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        break;
+
+    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+        {
+            std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rn
+                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                0x8D,
+                static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                static_cast<std::uint8_t>(offset >>  0),
+                static_cast<std::uint8_t>(offset >>  8),
+                static_cast<std::uint8_t>(offset >> 16),
+                static_cast<std::uint8_t>(offset >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        break;
+
+    default:
+        // x86-64 only supports disp8 and disp32
+        //
+        // for larger offsets we would need to use an
+        // index register; but we should never go over
+        // disp32 on the stack anyway since it's only 2Mb
+        //
+        throw not_implemented("offset size not yet supported for \""
+            + temp_var->get_name()
+            + "\" (type: "
+            + std::to_string(static_cast<int>(offset_size))
+            + " for size: "
+            + std::to_string(offset)
+            + ").");
+
+    }
+}
+
+
+void binary_assembler::generate_pointer_to_variable(data::pointer_t d, register_t const reg, int adjust_offset)
+{
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_STRING:
+        generate_reg_mem_string(d, reg, adjust_offset);
+        break;
+
+    case node_t::NODE_VARIABLE:
+        if(d->is_temporary())
+        {
+            std::string const name(n->get_string());
+            temporary_variable * temp_var(f_file.find_temporary_variable(name));
+            if(temp_var == nullptr)
+            {
+                throw internal_error("temporary \""
+                    + name
+                    + "\" not found in generate_pointer_to_variable()");
+            }
+std::cerr << "--- generate pointer to temp var \"" << name << "\".\n";
+            generate_pointer_to_temporary(temp_var, reg);
+        }
+        else if(d->is_extern())
+        {
+            binary_variable const * var(f_file.get_extern_variable(d->get_string()));
+            if(var == nullptr)
+            {
+                throw internal_error(
+                      "extern variable \""
+                    + d->get_string()
+                    + "\" not found in generate_pointer_to_variable()");
+            }
+            std::size_t pos(f_file.get_current_text_offset());
+            std::uint8_t buf[] = {      // REX.W LEA disp32(%rbx), %rn
+                static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x4C : 0x48),
+                0x8D,
+                static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+            };
+            f_file.add_text(buf, sizeof(buf));
+            f_file.add_relocation(
+                      d->get_string()
+                    , relocation_t::RELOCATION_VARIABLE_32BITS
+                    , pos + 3
+                    , f_file.get_current_text_offset() + adjust_offset);
+        }
+        else
+        {
+            throw not_implemented("WARNING: generate_pointer_to_variable() hit a variable type not yet implemented...");
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              "WARNING: generate_pointer_to_variable() hit data type "
+            + std::to_string(static_cast<int>(d->get_data_type()))
+            + "/"
+            + node::type_to_string(d->get_data_type())
+            + " not yet implemented...");
+
+    }
+}
+
+
+/** \brief Copy a register to or from the stack slot of a temporary.
+ *
+ * This function is used to save and restore the callee saved registers
+ * used by the register allocator and to spill a temporary held in a
+ * register when an instruction needs its value in memory. The register
+ * itself is not modified when saving it.
+ *
+ * Double temporaries are held in XMM registers, the other temporaries
+ * are held in general purpose registers.
+ *
+ * \param[in] temp_var  The temporary variable with the stack slot to use.
+ * \param[in] reg  The register to save or load.
+ * \param[in] load  Load the register from the stack slot if true,
+ * save the register in the stack slot otherwise.
+ */
+void binary_assembler::generate_spill(temporary_variable const * temp_var, register_t reg, bool load)
+{
+    if(temp_var == nullptr)
+    {
+        throw internal_error("generate_spill() called without a temporary.");
+    }
+
+    ssize_t const offset(temp_var->get_offset());
+    int const r(static_cast<int>(reg));
+    if(temp_var->get_type() == node_t::NODE_DOUBLE)
+    {
+        std::uint8_t buf[] = {    // MOVSD %xmm, disp32(%rbp) or MOVSD disp32(%rbp), %xmm
+            0xF2,
+            0x44,
+            0x0F,
+            static_cast<std::uint8_t>(load ? 0x10 : 0x11),
+            static_cast<std::uint8_t>(0x85 | ((r & 7) << 3)),
+            static_cast<std::uint8_t>(offset >>  0),
+            static_cast<std::uint8_t>(offset >>  8),
+            static_cast<std::uint8_t>(offset >> 16),
+            static_cast<std::uint8_t>(offset >> 24),
+        };
+        if(r >= 8)
+        {
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else
+        {
+            // no REX prefix for %xmm0 to %xmm7
+            //
+            f_file.add_text(buf, 1);
+            f_file.add_text(buf + 2, sizeof(buf) - 2);
+        }
+    }
+    else
+    {
+        std::uint8_t buf[] = {    // REX.W MOV %rn, disp32(%rbp) or REX.W MOV disp32(%rbp), %rn
+            static_cast<std::uint8_t>(r >= 8 ? 0x4C : 0x48),
+            static_cast<std::uint8_t>(load ? 0x8B : 0x89),
+            static_cast<std::uint8_t>(0x85 | ((r & 7) << 3)),
+            static_cast<std::uint8_t>(offset >>  0),
+            static_cast<std::uint8_t>(offset >>  8),
+            static_cast<std::uint8_t>(offset >> 16),
+            static_cast<std::uint8_t>(offset >> 24),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+}
+
+
+void binary_assembler::generate_store_integer(data::pointer_t d, register_t const reg)
+{
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_VARIABLE:
+        {
+            std::string const name(n->get_string());
+            if(d->is_temporary())
+            {
+                // TODO: add a map so we can find these at once instead of
+                //       having a search through all those vars.
+                //
+                temporary_variable * temp_var(f_file.find_temporary_variable(name));
+                if(temp_var == nullptr)
+                {
+                    throw internal_error("temporary not found in generate_store_integer()");
+                }
+                switch(temp_var->get_size())
+                {
+                case 1: // Boolean
+                    {
+                        ssize_t const offset(temp_var->get_offset());
+                        integer_size_t const offset_size(get_smallest_size(offset));
+                        switch(offset_size)
+                        {
+                        case integer_size_t::INTEGER_SIZE_1BIT:
+                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                            if(reg >= register_t::REGISTER_RSP)
+                            {
+                                std::uint8_t buf[] = {    // MOV %rn.b, disp8(%rbp)
+                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                    0x88,
+                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                                                                // 'r' and disp(rbp) (r/m)
+                                    static_cast<std::uint8_t>(offset),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            else
+                            {
+                                std::uint8_t buf[] = {    // MOV %rn.b, disp8(%rbp)
+                                    0x88,
+                                    static_cast<std::uint8_t>(0x45 | (static_cast<int>(reg) << 3)),
+                                    static_cast<std::uint8_t>(offset),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
+
+                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                            if(reg >= register_t::REGISTER_RSP)
+                            {
+                                std::uint8_t buf[] = {    // REX.W MOV %rn.b, disp8(%rbp)
+                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                    0x88,
+                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                                    static_cast<std::uint8_t>(offset >>  0),
+                                    static_cast<std::uint8_t>(offset >>  8),
+                                    static_cast<std::uint8_t>(offset >> 16),
+                                    static_cast<std::uint8_t>(offset >> 24),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            else
+                            {
+                                std::uint8_t buf[] = {    // REX.W MOV %rn.b, disp32(%rbp)
+                                    0x88,
+                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                                    static_cast<std::uint8_t>(offset >>  0),
+                                    static_cast<std::uint8_t>(offset >>  8),
+                                    static_cast<std::uint8_t>(offset >> 16),
+                                    static_cast<std::uint8_t>(offset >> 24),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
+
+                        default:
+                            // x86-64 only supports disp8 and disp32
+                            //
+                            // for larger offsets we would need to use an
+                            // index register; but we should never go over
+                            // disp32 on the stack anyway since it's only 2Mb
+                            //
+                            throw not_implemented("offset size not supported yet in "
+                                + temp_var->get_name()
+                                + " (type: "
+                                + std::to_string(static_cast<int>(offset_size))
+                                + " for size: "
+                                + std::to_string(offset)
+                                + ").");
+
+                        }
+                    }
+                    break;
+
+                case 8: // Integer / Double
+                    if(temp_var->has_register())
+                    {
+                        int const r(static_cast<int>(temp_var->get_register()));
+                        if(temp_var->get_type() == node_t::NODE_DOUBLE)
+                        {
+                            std::uint8_t buf[] = {    // MOVQ %rn, %xmm
+                                0x66,
+                                static_cast<std::uint8_t>(0x48
+                                        | (r >= 8 ? 0x04 : 0x00)
+                                        | (reg >= register_t::REGISTER_R8 ? 0x01 : 0x00)),
+                                0x0F,
+                                0x6E,
+                                static_cast<std::uint8_t>(0xC0 | ((r & 7) << 3) | (static_cast<int>(reg) & 7)),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        else
+                        {
+                            std::uint8_t buf[] = {    // REX.W MOV %rn, %rm
+                                static_cast<std::uint8_t>(0x48
+                                        | (reg >= register_t::REGISTER_R8 ? 0x04 : 0x00)
+                                        | (r >= 8 ? 0x01 : 0x00)),
+                                0x89,
+                                static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(reg) & 7) << 3) | (r & 7)),
+                            };
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+                    }
+                    {
+                        ssize_t const offset(temp_var->get_offset());
+                        integer_size_t const offset_size(get_smallest_size(offset));
+                        switch(offset_size)
+                        {
+                        case integer_size_t::INTEGER_SIZE_1BIT:
+                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                            {
+                                std::uint8_t buf[] = {   // REX.W MOV %rn, disp8(%rbp)
+                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                    0x89,
+                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                                    static_cast<std::uint8_t>(offset),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
+
+                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                            {
+                                std::uint8_t buf[] = {   // REX.W MOV %rn, disp32(%rbp)
+                                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                                    0x89,
+                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                                    static_cast<std::uint8_t>(offset >>  0),
+                                    static_cast<std::uint8_t>(offset >>  8),
+                                    static_cast<std::uint8_t>(offset >> 16),
+                                    static_cast<std::uint8_t>(offset >> 24),
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
+
+                        default:
+                            // x86-64 only supports disp8 and disp32
+                            //
+                            // for larger offsets we would need to use an
+                            // index register; but we should never go over
+                            // disp32 on the stack anyway since it's only 2Mb
+                            //
+                            throw not_implemented("offset size not supported yet in "
+                                + temp_var->get_name()
+                                + " (type: "
+                                + std::to_string(static_cast<int>(offset_size))
+                                + " for size: "
+                                + std::to_string(offset)
+                                + ").");
+
+                        }
+                    }
+                    break;
+
+                case sizeof(binary_variable):
+                    if(!n->get_flag(flag_t::NODE_VARIABLE_FLAG_VARIABLE))
+                    {
+                        throw not_implemented("temporary size not supported yet (sizeof(binary_varible) when the NODE_VARIABLE_FLAG_VARIABLE is not set)");
+                    }
+                    generate_save_reg_in_binary_variable(temp_var, reg, get_type_of_node(d->get_node()));
+                    break;
+
+                default:
+                    throw not_implemented("temporary size not yet supported in generate_store_integer()");
+
+                }
+            }
+            else if(d->is_extern())
+            {
+                std::size_t const pos(f_file.get_current_text_offset());
+                std::uint8_t buf[] = {
+                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x4C : 0x48),
+                                                // 64 bits
+                    0x89,                       // MOV r := m
+                    static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                                                // 'r' and disp(rbx) (r/m)
+                    0x00,                       // 32 bit offset
+                    0x00,
+                    0x00,
+                    0x00,
+                };
+                f_file.add_text(buf, sizeof(buf));
+                f_file.add_relocation(
+                          d->get_string()
+                        , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                        , pos + 3
+                        , f_file.get_current_text_offset());
+            }
+            else
+            {
+                throw not_implemented("generate_store_integer() unhandled variable type.");
+            }
+        }
+        break;
+
+    default:
+        throw not_implemented("generate_store_integer() hit a data type other than already implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_store_floating_point(data::pointer_t d, register_t const reg)
+{
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_VARIABLE:
+        {
+            std::string const name(n->get_string());
+            if(d->is_temporary())
+            {
+                // TODO: add a map so we can find these at once instead of
+                //       having a search through all those vars.
+                //
+                temporary_variable * temp_var(f_file.find_temporary_variable(name));
+                if(temp_var == nullptr)
+                {
+                    throw internal_error("temporary not found in generate_store_floating_point()");
+                }
+                switch(temp_var->get_type())
+                {
+                case node_t::NODE_DOUBLE:
+                    if(temp_var->has_register())
+                    {
+                        int const r(static_cast<int>(temp_var->get_register()));
+                        std::uint8_t const buf[] = {    // MOVSD %xmm, %xmm
+                            0xF2,
+                            static_cast<std::uint8_t>(0x40
+                                    | (r >= 8 ? 0x04 : 0x00)
+                                    | (reg >= register_t::REGISTER_R8 ? 0x01 : 0x00)),
+                            0x0F,
+                            0x10,
+                            static_cast<std::uint8_t>(0xC0 | ((r & 7) << 3) | (static_cast<int>(reg) & 7)),
+                        };
+                        if(buf[1] == 0x40)
+                        {
+                            f_file.add_text(buf, 1);
+                            f_file.add_text(buf + 2, sizeof(buf) - 2);
+                        }
+                        else
+                        {
+                            f_file.add_text(buf, sizeof(buf));
+                        }
+                        break;
+                    }
+                    {
+                        ssize_t const offset(temp_var->get_offset());
+                        integer_size_t const offset_size(get_smallest_size(offset));
+                        switch(offset_size)
+                        {
+                        case integer_size_t::INTEGER_SIZE_1BIT:
+                        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                            {
+                                std::uint8_t buf[] = {    // MOVSD %xmm, disp8(%rbp)
+                                    0xF2,
+                                    // TODO: if reg >= 8 insert 0x44
+                                    0x0F,
+                                    0x11,
+                                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                                                                // 'r' and disp(rbp) (r/m)
+                                    static_cast<std::uint8_t>(offset),
+                                                                // 8 bit offset
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
+
+                        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+                        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                            {
+                                std::uint8_t buf[] = {    // MOVSD %xmm, disp32(%rbp)
+                                    0xF2,
+                                    // TODO: if reg >= 8 insert 0x44
+                                    0x0F,
+                                    0x11,
+                                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                                                                // 'r' and disp(rbp) (r/m)
+                                    static_cast<std::uint8_t>(offset >>  0),
+                                    static_cast<std::uint8_t>(offset >>  8),
+                                    static_cast<std::uint8_t>(offset >> 16),
+                                    static_cast<std::uint8_t>(offset >> 24),
+                                                                // 32 bit offset
+                                };
+                                f_file.add_text(buf, sizeof(buf));
+                            }
+                            break;
+
+                        default:
+                            // x86-64 only supports disp8 and disp32
+                            //
+                            // for larger offsets we would need to use an
+                            // index register; but we should never go over
+                            // disp32 on the stack anyway since it's only 2Mb
+                            //
+                            throw not_implemented("offset size not supported yet in "
+                                + temp_var->get_name()
+                                + " (type: "
+                                + std::to_string(static_cast<int>(offset_size))
+                                + " for size: "
+                                + std::to_string(offset)
+                                + ").");
+
+                        }
+                    }
+                    break;
+
+                default:
+                    throw not_implemented("temporary size not yet supported in generate_store_floating_point()");
+
+                }
+            }
+            else if(d->is_extern())
+            {
+                std::size_t const pos(f_file.get_current_text_offset());
+                std::uint8_t buf[] = {    // MOVSD %xmm, disp32(%rbx)
+                    0xF2,
+                    // TODO: if reg >= 8 insert 0x44
+                    0x0F,
+                    0x11,
+                    static_cast<std::uint8_t>(0x83 | ((static_cast<int>(reg) & 7) << 3)),
+                    0x00,
+                    0x00,
+                    0x00,
+                    0x00,
+                };
+                f_file.add_text(buf, sizeof(buf));
+                f_file.add_relocation(
+                          d->get_string()
+                        , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                        , pos + 4
+                        , f_file.get_current_text_offset());
+            }
+            else
+            {
+                throw not_implemented("generate_store_floating_point() unhandled variable type.");
+            }
+        }
+        break;
+
+    default:
+        throw not_implemented("generate_store_floating_point() hit a data type other than already implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_store_string(data::pointer_t d, register_t const reg)
+{
+    // reg is pointer to a variable_t to be copied
+    //
+    node::pointer_t n(d->get_node());
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_STRING:
+        throw not_implemented("generate_store_string() hit data type STRING which is a constant and you cannot store in a constant.");
+
+    case node_t::NODE_VARIABLE:
+        {
+            std::string const name(n->get_string());
+            if(d->is_temporary())
+            {
+                // TODO: add a map so we can find these at once instead of
+                //       having a search through all those vars.
+                //
+                temporary_variable * temp_var(f_file.find_temporary_variable(name));
+                if(temp_var == nullptr)
+                {
+                    throw internal_error("temporary not found in generate_store_string().");
+                }
+                if(temp_var->get_type() != node_t::NODE_STRING)
+                {
+                    throw internal_error("temporary in generate_store_string() is not of type string.");
+                }
+
+                // load source if not already RSI
+                //
+                if(reg != register_t::REGISTER_RSI)
+                {
+                    std::uint8_t buf[] = {       // MOV %rn, %rsi
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                        0x89,
+                        static_cast<std::uint8_t>(0xC6 | ((static_cast<int>(reg) & 7) << 3)),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                // load destination
+                //
+                ssize_t const offset(temp_var->get_offset());
+                switch(get_smallest_size(offset))
+                {
+                case integer_size_t::INTEGER_SIZE_1BIT:
+                case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                    {
+                        std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rdi
+                            0x48,
+                            0x8D,
+                            0x7D,
+                            static_cast<std::uint8_t>(offset),
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                    }
+                    break;
+
+                case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+                case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
+                case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+                case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                    {
+                        std::uint8_t buf[] = {  // REX.W LEA disp32(%rbp), %rdi
+                            0x48,
+                            0x8D,
+                            0xBD,
+                            static_cast<std::uint8_t>(offset >>  0),
+                            static_cast<std::uint8_t>(offset >>  8),
+                            static_cast<std::uint8_t>(offset >> 16),
+                            static_cast<std::uint8_t>(offset >> 24),
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                    }
+                    break;
+
+                default:
+                    throw not_implemented("generate_store_string() unhandled integer size for displacement.");
+
+                };
+
+                generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
+            }
+            else if(d->is_extern())
+            {
+                // load source if not already RSI
+                //
+                if(reg != register_t::REGISTER_RSI)
+                {
+                    std::uint8_t buf[] = {       // MOV %rn, %rsi
+                        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                        0x89,
+                        static_cast<std::uint8_t>(0xC6 | ((static_cast<int>(reg) & 7) << 3)),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                std::size_t const pos(f_file.get_current_text_offset());
+                std::uint8_t buf[] = {      // LEA disp32(%rbx), %rdi
+                    0x48,
+                    0x8D,
+                    0xBB,
+                    0x00,
+                    0x00,
+                    0x00,
+                    0x00,
+                };
+                f_file.add_text(buf, sizeof(buf));
+                f_file.add_relocation(
+                          d->get_string()
+                        , relocation_t::RELOCATION_VARIABLE_32BITS
+                        , pos + 3
+                        , f_file.get_current_text_offset());
+
+                generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
+            }
+            else
+            {
+                throw not_implemented("generate_store_string() unhandled variable type.");
+            }
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              "generate_store_string() hit data type "
+            + std::string(node::type_to_string(d->get_data_type()))
+            + " which is not yet implemented.");
+
+    }
+}
+
+
+/** \brief Call one of the external functions.
+ *
+ * The external functions live in libas2js so their address is only
+ * known once the image is loaded. The image includes a table with one
+ * slot per external function it uses; the loader saves the address of
+ * each function in its slot (see running_file::setup_image()).
+ *
+ * The call is therefore a single `CALL *disp32(%rip)`, the same
+ * instruction a compiler emits to call a function through the GOT. It
+ * does not need a register to hold the address of the table.
+ *
+ * \param[in] func  The external function to call.
+ */
+void binary_assembler::generate_external_function_call(external_function_t func)
+{
+    std::string name;
+    f_file.add_extern_function(func, name);
+
+    std::size_t const pos(f_file.get_current_text_offset());
+    std::uint8_t buf[] = {
+        0xFF,       // CALL *disp32(%rip)
+        0x15,
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+    };
+    f_file.add_text(buf, sizeof(buf));
+    f_file.add_relocation(
+              name
+            , relocation_t::RELOCATION_EXTERN_FUNCTION
+            , pos + 2
+            , f_file.get_current_text_offset());
+}
+
+
+void binary_assembler::generate_absolute_value(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+    //variable_type_t const type(get_type_of_node(lhs->get_node()));
+    node_t const type(lhs->get_node()->get_type());
+//std::cerr << "--- generate absolute value =\n"
+//<< *lhs->get_node()
+//<< "\n"
+//<< "--- with lhs type = " << static_cast<int>(type)
+//<< "\n";
+    switch(type)
+    {
+    case node_t::NODE_INTEGER:
+        {
+            variable_type_t const var_type(get_type_of_node(lhs->get_node()));
+            switch(var_type)
+            {
+            case VARIABLE_TYPE_INTEGER:
+                {
+                    // integers to integer (function abs(Integer) : Integer)
+                    //
+                    // TBD: err if integer is out of range? (i.e. MIN_INT)
+                    //
+                    std::int64_t const value(llabs(lhs->get_node()->get_integer().get()));
+                    std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                        0x48,
+                        0xB8,
+                        static_cast<std::uint8_t>(value >>  0),
+                        static_cast<std::uint8_t>(value >>  8),
+                        static_cast<std::uint8_t>(value >> 16),
+                        static_cast<std::uint8_t>(value >> 24),
+                        static_cast<std::uint8_t>(value >> 32),
+                        static_cast<std::uint8_t>(value >> 40),
+                        static_cast<std::uint8_t>(value >> 48),
+                        static_cast<std::uint8_t>(value >> 56),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+
+                    generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+                }
+                break;
+
+            default:
+                throw not_implemented("generate_absolute_value() unhandled result type for integers.");
+
+            }
+        }
+        break;
+
+    case node_t::NODE_FLOATING_POINT:
+        {
+            double const floating_point(fabs(lhs->get_node()->get_floating_point().get()));
+            double const * fp(&floating_point);
+            std::int64_t const value(*reinterpret_cast<std::int64_t const *>(fp));
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                static_cast<std::uint8_t>(value >>  0),
+                static_cast<std::uint8_t>(value >>  8),
+                static_cast<std::uint8_t>(value >> 16),
+                static_cast<std::uint8_t>(value >> 24),
+                static_cast<std::uint8_t>(value >> 32),
+                static_cast<std::uint8_t>(value >> 40),
+                static_cast<std::uint8_t>(value >> 48),
+                static_cast<std::uint8_t>(value >> 56),
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        }
+        break;
+
+    case node_t::NODE_VARIABLE:
+        {
+            variable_type_t const var_type(get_type_of_node(lhs->get_node()));
+            switch(var_type)
+            {
+            case VARIABLE_TYPE_INTEGER:
+                generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+                {
+                    // ABS %rax with three instructions
+                    std::uint8_t buf[] = {
+                        0x48,   // REX.W MOV %rax, %rcx
+                        0x8B,
+                        0xC8,
+
+                        0x48,   // REX.W SAR $63, %rcx
+                        0xC1,
+                        0xF9,
+                        0x3F,
+
+                        0x48,   // REX.W XOR %rcx, %rax
+                        0x31,
+                        0xC8,
+
+                        0x48,   // REX.W SUB %rcx, %rax
+                        0x29,
+                        0xC8,
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+                break;
+
+            case VARIABLE_TYPE_FLOATING_POINT:
+                generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+
+                // there is no ABSPD instruction, use integers instructions
+                // to remove the upper bit
+                {
+                    std::uint8_t buf[] = {
+                        0x66,   // PADDQ %xmm0, %xmm0
+                        0x0F,
+                        0xD4,
+                        0xC0,
+
+                        0x66,   // PSRLQ $1, %xmm0
+                        0x0F,
+                        0x73,
+                        0xD0,
+                        0x01,
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+                break;
+
+            default:
+                throw not_implemented("generate_absolute_value() unhandled variable type.");
+
+            }
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              "absolute value node type "
+            + std::to_string(static_cast<int>(type))
+            + " not implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_additive(operation::pointer_t op)
+{
+    bool is_add(false);
+    bool is_assignment(false);
+    switch(op->get_operation())
+    {
+    case node_t::NODE_ADD:
+        is_add = true;
+        break;
+
+    case node_t::NODE_ASSIGNMENT_ADD:
+        is_add = true;
+        is_assignment = true;
+        break;
+
+    case node_t::NODE_ASSIGNMENT_SUBTRACT:
+        is_assignment = true;
+        break;
+
+    default:
+        break;
+
+    }
+    data::pointer_t lhs(op->get_left_handside());
+    data::pointer_t rhs(op->get_right_handside());
+
+    variable_type_t const op_type(get_type_of_node(op->get_node()));
+    switch(op_type)
+    {
+    case VARIABLE_TYPE_FLOATING_POINT:
+        // floating points
+        //
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+
+        switch(rhs->get_integer_size())
+        {
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_64BITS:
+            //{
+            //    generate_reg_mem_floating_point(rhs, register_t::REGISTER_RCX);
+            //    std::uint8_t buf[] = {
+            //        0xF2,       // ADD or SUB %xmm1, %xmm0
+            //        0x0F,
+            //        static_cast<std::uint8_t>(is_add ? 0x58 : 0x5C),
+            //        0xC8,
+            //    };
+            //    f_file.add_text(buf, sizeof(buf));
+            //}
+            //break;
+
+        case integer_size_t::INTEGER_SIZE_FLOATING_POINT:
+            generate_reg_mem_floating_point(
+                      rhs
+                    , register_t::REGISTER_XMM0
+                    , is_add
+                        ? sse_operation_t::SSE_OPERATION_ADD
+                        : sse_operation_t::SSE_OPERATION_SUB);
+            break;
+
+        default:
+            if(rhs->get_data_type() == node_t::NODE_VARIABLE)
+            {
+                // a variable needs to be loaded from memory so we need an ADD
+                // which reads the variable location
+                //
+                generate_reg_mem_floating_point(
+                          rhs
+                        , register_t::REGISTER_XMM0
+                        , is_add
+                            ? sse_operation_t::SSE_OPERATION_ADD
+                            : sse_operation_t::SSE_OPERATION_SUB);
+            }
+            else
+            {
+                if(rhs->get_data_type() != node_t::NODE_INTEGER)
+                {
+                    throw not_implemented(
+                          std::string("trying to add/subtract a \"")
+                        + node::type_to_string(rhs->get_data_type())
+                        + "\" which is not yet implemented.");
+                }
+                throw not_implemented(
+                      "found integer size "
+                    + std::to_string(static_cast<int>(rhs->get_integer_size()))
+                    + " which is not yet implemented in generate_additive().");
+            }
+            break;
+
+        }
+
+        if(is_assignment)
+        {
+            generate_store_floating_point(op->get_left_handside(), register_t::REGISTER_RAX);
+        }
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_RAX);
+        break;
+
+    case VARIABLE_TYPE_INTEGER:
+        // integers
+        //
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+
+        switch(rhs->get_integer_size())
+        {
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {
+                    0x48,       // 64 bits
+                    0x83,       // ADD or SUB r64 +/-= imm8
+                    static_cast<std::uint8_t>(is_add ? 0xC0 : 0xE8),
+                                // r/m
+                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get()),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {
+                    0x48,       // 64 bits
+                    static_cast<std::uint8_t>(is_add ? 0x05 : 0x2D),
+                                // ADD or SUB rax +/-= imm32
+                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  0),
+                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  8),
+                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 16),
+                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_64BITS:
+            {
+                generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
+                std::uint8_t buf[] = {       // ADD or SUB %rdx, %rax
+                    0x48,
+                    static_cast<std::uint8_t>(is_add ? 0x01 : 0x29),
+                    0xD0,
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        default:
+            if(rhs->get_data_type() == node_t::NODE_VARIABLE)
+            {
+                // a variable needs to be loaded from memory so we need an ADD
+                // which reads the variable location
+                //
+                generate_reg_mem_integer(rhs, register_t::REGISTER_RAX, static_cast<std::uint8_t>(is_add ? 0x03 : 0x2B));
+            }
+            else
+            {
+                if(rhs->get_data_type() != node_t::NODE_INTEGER)
+                {
+                    throw not_implemented(
+                          std::string("trying to add/subtract a \"")
+                        + node::type_to_string(rhs->get_data_type())
+                        + "\" which is not yet implemented.");
+                }
+                throw not_implemented(
+                      "found integer size "
+                    + std::to_string(static_cast<int>(rhs->get_integer_size()))
+                    + " which is not yet implemented in generate_additive().");
+            }
+            break;
+
+        }
+
+        if(is_assignment)
+        {
+            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+        }
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        break;
+
+    case VARIABLE_TYPE_STRING:
+        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+        generate_reg_mem_string(rhs, register_t::REGISTER_RDX);
+
+        // TODO: this optimization works unless the next step makes use of
+        //       the temporary variable (which at least happens for the
+        //       last expression--a.k.a. the result)
+        //
+        //       I think those optimizations would have to happen in the
+        //       flattening step (output.cpp)
+        //
+        //if(is_assignment)
+        //{
+        //    // save the results in the same location (RSI == RDI)
+        //    //
+        //    //generate_reg_mem_string(lhs, register_t::REGISTER_RDI);
+        //    std::uint8_t buf[] = {       // MOV %rsi, %rdi
+        //        0x48,
+        //        0x89,
+        //        0xF7,
+        //    };
+        //    f_file.add_text(buf, sizeof(buf));
+        //}
+        //else
+        //{
+            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+        //}
+
+        if(is_add)
+        {
+            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CONCAT);
+        }
+        else
+        {
+            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_UNCONCAT);
+        }
+        if(is_assignment)
+        {
+            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RSI);
+            generate_store_string(lhs, register_t::REGISTER_RSI);
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              "additive node type "
+            + std::to_string(static_cast<int>(op_type))
+            + " not implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_compare(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+    data::pointer_t rhs(op->get_right_handside());
+
+    // if the left or right hand side are floating points then use the
+    // floating point compare mechanism
+    //
+    if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_FLOATING_POINT
+    || get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        // TODO: if lhs or rhs is a string, we need to transform it to a
+        //       floating point first
+        //
+        std::uint8_t cmp_code(0x00);
+        bool swapped(false);
+        switch(op->get_operation())
+        {
+        case node_t::NODE_ALMOST_EQUAL:
+            {
+                generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+                generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+
+                {
+                    // this is way too long as one single block of code!
+                    //
+                    // TODO: use an external function instead, especially
+                    //       if we want to support a variable epsilon
+                    //       (right now, we use 0.00001, hard coded)
+                    //
+                    std::uint8_t buf[] = {
+                        0xF2,       // MOVSD %xmm0, %xmm3
+                        0x0F,
+                        0x10,
+                        0xD8,
+
+                        0xF2,       // CMPORDSD %xmm1, %xmm3
+                        0x0F,
+                        0xC2,
+                        0xD9,
+                        0x07,
+
+                        0x66,       // REX.W MOVQ %xmm3, %rax
+                        0x48,
+                        0x0F,
+                        0x7E,
+                        0xD8,
+
+                        0x85,       // TEST %eax, %eax
+                        0xC0,
+
+                        0x74,       // JZ false
+                        0x53,
+
+                        0x66,       // COMISD %xmm0, %xmm1
+                        0x0F,
+                        0x2F,
+                        0xC8,
+
+                        0x74,       // JE true
+                        0x76,
+
+                        // here xmm3 is already 0xFFFFFFFF:FFFFFFFF
+                        //0xF2,       // CMPEQSD %xmm3, %xmm3
+                        //0x0F,
+                        //0xC2,
+                        //0xDB,
+                        //0x00,
+
+                        0x66,       // PSRLD $1, %xmm3
+                        0x0F,
+                        0x73,
+                        0xD3,
+                        0x01,
+
+                        0xF2,       // MOVSD %xmm0, %xmm2
+                        0x0F,
+                        0x10,
+                        0xD0,
+
+                        0xF2,       // SUBSD %xmm1, %xmm2
+                        0x0F,
+                        0x5C,
+                        0xD1,
+
+                        0x66,       // REX.W MOVQ %xmm0, %rax
+                        0x48,
+                        0x0F,
+                        0x7E,
+                        0xC0,
+
+                        0x66,       // REX.W MOVQ %xmm1, %rdx
+                        0x48,
+                        0x0F,
+                        0x7E,
+                        0xCA,
+
+                        0x66,       // ANDPD %xmm3, %xmm2 -- xmm2 = fabs(xmm0 - xmm1)
+                        0x0F,
+                        0x54,
+                        0xD3,
+
+                        0x48,       // REX.W AND %rdx, %rax  (xmm0 == 0 || xmm1 == 0)
+                        0x21,
+                        0xD0,
+
+                        0x48,       // REX.W ADD %rax, %rax (ignore sign)
+                        0x01,
+                        0xC0,
+
+                        0x74,       // JZ zero
+                        0x15,
+
+                        0x48,       // REX.W MOV $0x100000:00000000, %rax   (i.e. std::numeric_limits<double>::min())
+                        0xB8,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x10,
+                        0x00,
+
+                        0x66,       // MOVQ %rax, %xmm4
+                        0x48,
+                        0x0F,
+                        0x6E,
+                        0xE0,
+
+                        0x66,       // COMISD %xmm4, %xmm2
+                        0x0F,
+                        0x2F,
+                        0xD4,
+
+                        0x73,       // JNB full_cmp
+                        0x19,
+
+                    //zero: %xmm0 == 0 || %xmm1 == 0
+                        0x48,       // REX.W MOV $0xA7C5AC472, %rax   (i.e. epsilon * std::numeric_limits<double>::min())
+                        0xB8,
+                        0x72,
+                        0xC4,
+                        0x5A,
+                        0x7C,
+                        0x0A,
+                        0x00,
+                        0x00,
+                        0x00,
+
+                        0x66,       // MOVQ %rax, %xmm4
+                        0x48,
+                        0x0F,
+                        0x6E,
+                        0xE0,
+
+                        0x66,       // COMISD %xmm4, %xmm2
+                        0x0F,
+                        0x2F,
+                        0xD4,
+
+                        0x72,       // JB true
+                        0x29,
+
+                        //[[fallthrough]];
+
+                    //false:
+                        0x33,       // XOR $rax, $rax
+                        0xC0,
+
+                        0xEB,       // JMP done
+                        0x2A,
+
+                    //full_cmp:
+                        0x66,       // ANDPD %xmm3, %xmm0 -- xmm0 = fabs(xmm1)
+                        0x0F,
+                        0x54,
+                        0xC3,
+
+                        0x66,       // ANDPD %xmm3, %xmm1 -- xmm1 = fabs(xmm0)
+                        0x0F,
+                        0x54,
+                        0xCB,
+
+                        0xF2,       // ADDSD %xmm1, %xmm0
+                        0x0F,
+                        0x58,
+                        0xC1,
+
+                        0xF2,       // DIVSD %xmm0, %xmm2 -- %xmm2 = %xmm2 / %xmm0
+                        0x0F,
+                        0x5E,
+                        0xD0,
+
+                        0x48,       // REX.W MOV $0x3EE4F8B588E368F1, %rax   (i.e. epsilon)
+                        0xB8,
+                        0xF1,
+                        0x68,
+                        0xE3,
+                        0x88,
+                        0xB5,
+                        0xF8,
+                        0xE4,
+                        0x3E,
+
+                        0x66,       // MOVQ %rax, %xmm1
+                        0x48,
+                        0x0F,
+                        0x6E,
+                        0xC8,
+
+                        0x66,       // COMISD %xmm1, %xmm2
+                        0x0F,
+                        0x2F,
+                        0xD1,
+
+                        0x73,       // JBN false
+                        0xD7,
+
+                        //[[fallthrough]];
+
+                    //true:
+                        0xB8,       // MOV $1, $eax
+                        0x01,
+                        0x00,
+                        0x00,
+                        0x00,
+                    //done:
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            }
+            return;
+
+        case node_t::NODE_COMPARE:
+            {
+                generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+                generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_SUB);
+
+                // TODO: add proper support for Infinity & NaN
+                {
+                    std::uint8_t buf[] = {
+                        //0x33,       // XOR %eax, %eax (rax := 0)
+                        //0xC0,
+
+                        0x66,       // REX.W MOVQ %xmm0, %rcx
+                        0x48,
+                        0x0F,
+                        0x7E,
+                        0xC1,
+
+                        0x48,       // REX.W CMP $0, %rcx
+                        0x83,
+                        0xF9,
+                        0x00,
+
+                        0x0F,       // SETG %al
+                        0x9F,
+                        0xC0,
+
+                        0x0F,       // SETL %cl
+                        0x9C,
+                        0xC1,
+
+                        0x28,       // SUB %cl, %al
+                        0xC8,
+
+                        0x48,       // REX.W MOVSX %al, %rax
+                        0x0F,
+                        0xBE,
+                        0xC0,
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            }
+            return;
+
+        case node_t::NODE_EQUAL:
+        case node_t::NODE_SMART_MATCH:
+        case node_t::NODE_STRICTLY_EQUAL:
+            // for double, smart match is the same as equal
+            //
+            // no coersion here, so strictly equal is the same
+            //
+            // default cmp_code is EQUAL
+            break;
+
+        case node_t::NODE_LESS:
+            cmp_code = 0x01;
+            break;
+
+        case node_t::NODE_LESS_EQUAL:
+            cmp_code = 0x02;
+            break;
+
+        case node_t::NODE_GREATER:
+            cmp_code = 0x01;
+            swapped = true;
+            break;
+
+        case node_t::NODE_GREATER_EQUAL:
+            cmp_code = 0x02;
+            swapped = true;
+            break;
+
+        case node_t::NODE_NOT_EQUAL:
+        case node_t::NODE_STRICTLY_NOT_EQUAL:
+            // no coersion here, so strictly not equal is the same
+            //
+            cmp_code = 0x04;
+            break;
+
+        default:
+            throw internal_error("generate_compare() called with the wrong operation.");
+
+        }
+        if(swapped)
+        {
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0);
+            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CMP, 1);
+        }
+        else
+        {
+            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CMP, 1);
+        }
+
+        {
+            std::uint8_t buf[] = {
+                cmp_code,   // this is part of the CMP??SD generated by generate_reg_mem_floating_point()
+
+                0x66,       // REX.W MOVQ %xmm0, %rax
+                0x48,
+                0x0F,
+                0x7E,
+                0xC0,
+
+                0x48,       // REX.W SHR $63, %rax
+                0xC1,
+                0xE8,
+                0x3F,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+    else if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_INTEGER
+         || get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_BOOLEAN
+         || get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_INTEGER
+         || get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_BOOLEAN)
+    {
+        // TODO: if lhs or rhs is a string, we need to transform it to an
+        //       integer first (we may need to separate booleans?)
+        //
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RDX);
+
+        {
+            std::uint8_t buf[] = {       // XOR %eax, %eax (rax := 0)
+                0x33,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX, 0x3B);
+        if(op->get_operation() == node_t::NODE_COMPARE)
+        {
+            // shortest code "found" here:
+            //    https://codegolf.stackexchange.com/questions/259087/write-the-smallest-possible-code-in-x86-64-to-implement-the-operator/259110#259110
+            //
+            std::uint8_t buf[] = {
+                0x0F,       // SETG %al
+                0x9F,
+                0xC0,
+
+                0x0F,       // SETL %cl
+                0x9C,
+                0xC1,
+
+                0x28,       // SUB %cl, %al
+                0xC8,
+
+                0x48,       // REX.W MOVSX %al, %rax
+                0x0F,
+                0xBE,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else
+        {
+            std::uint8_t buf[] = {
+                0x0F,
+                0x00,       // SETcc r64
+                0xC0,       // r/m
+            };
+
+            switch(op->get_operation())
+            {
+            case node_t::NODE_ALMOST_EQUAL:
+            case node_t::NODE_EQUAL:
+            case node_t::NODE_SMART_MATCH:
+            case node_t::NODE_STRICTLY_EQUAL:
+                // for integer, almost equal & smart match are the same as equal
+                // also if coersion happens, it wouldn't be here so strictly
+                // equal is the same too
+                //
+                buf[1] = 0x94;
+                break;
+
+            case node_t::NODE_LESS:
+                buf[1] = 0x9C;
+                break;
+
+            case node_t::NODE_LESS_EQUAL:
+                buf[1] = 0x9E;
+                break;
+
+            case node_t::NODE_GREATER:
+                buf[1] = 0x9F;
+                break;
+
+            case node_t::NODE_GREATER_EQUAL:
+                buf[1] = 0x9D;
+                break;
+
+            case node_t::NODE_NOT_EQUAL:
+            case node_t::NODE_STRICTLY_NOT_EQUAL:
+                // no coersion here, so strictly not equal is the same
+                //
+                buf[1] = 0x95;
+                break;
+
+            default:
+                throw internal_error("generate_compare() called with the wrong operation.");
+
+            }
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+    else if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_STRING
+         && get_type_of_node(rhs->get_node()) == VARIABLE_TYPE_STRING)
+    {
+        generate_reg_mem_string(lhs, register_t::REGISTER_RDI);
+        generate_reg_mem_string(rhs, register_t::REGISTER_RSI);
+        {
+            int const value(static_cast<int>(op->get_operation()));
+            std::uint8_t buf[] = {   // REX.W MOV $imm32, %rdx  (%rdx = operation)
+                0x48,
+                0xC7,
+                0xC2,
+                static_cast<std::uint8_t>(value >>  0),
+                static_cast<std::uint8_t>(value >>  8),
+                static_cast<std::uint8_t>(value >> 16),
+                static_cast<std::uint8_t>(value >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COMPARE);
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+    else
+    {
+        throw internal_error("generate_compare() called with unsupported parameter types.");
+    }
+}
+
+
+/** \brief Generate a comparison followed by a conditional jump.
+ *
+ * When a comparison result is only used by the IF_TRUE or IF_FALSE
+ * operation that follows, the boolean does not need to be computed.
+ * Instead, the CMP (or UCOMISD) is directly followed by the Jcc
+ * instruction matching the comparison. See get_compare_condition()
+ * for the comparisons which can be fused.
+ *
+ * \param[in] compare  The comparison operation.
+ * \param[in] branch  The operation following the comparison.
+ *
+ * \return true if the code was generated, false if the operations
+ * cannot be fused, in which case nothing was generated.
+ */
+bool binary_assembler::generate_compare_and_branch(
+      operation::pointer_t compare
+    , operation::pointer_t branch)
+{
+    if((branch->get_operation() != node_t::NODE_IF_TRUE
+            && branch->get_operation() != node_t::NODE_IF_FALSE)
+    || branch->get_left_handside() != compare->get_result())
+    {
+        return false;
+    }
+
+    int const condition(get_compare_condition(compare));
+    if(condition < 0)
+    {
+        return false;
+    }
+
+    generate_compare_flags(compare);
+
+    // the opposite condition is obtained by flipping bit 0
+    //
+    std::size_t const pos(f_file.get_current_text_offset());
+    std::uint8_t buf[] = {
+        0x0F,       // Jcc disp32
+        static_cast<std::uint8_t>(0x80
+                | (branch->get_operation() == node_t::NODE_IF_TRUE
+                        ? condition
+                        : condition ^ 1)),
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+    };
+    f_file.add_text(buf, sizeof(buf));
+    f_file.add_relocation(
+              branch->get_label()
+            , relocation_t::RELOCATION_LABEL_32BITS
+            , pos + 2
+            , f_file.get_current_text_offset());
+
+    return true;
+}
+
+
+/** \brief Generate a comparison followed by a conditional move.
+ *
+ * When a comparison result is only used by the CONDITIONAL operation
+ * that follows, the boolean does not need to be computed. The two values
+ * get loaded first, then the CMP sets the flags used by the CMOVcc.
+ *
+ * This is limited to integer comparisons since the floating point
+ * operands may require %rax to be converted.
+ *
+ * \param[in] compare  The comparison operation.
+ * \param[in] select  The operation following the comparison.
+ *
+ * \return true if the code was generated, false if the operations
+ * cannot be fused, in which case nothing was generated.
+ */
+bool binary_assembler::generate_compare_and_select(
+      operation::pointer_t compare
+    , operation::pointer_t select)
+{
+    if(select->get_operation() != node_t::NODE_CONDITIONAL
+    || select->get_left_handside() != compare->get_result())
+    {
+        return false;
+    }
+
+    variable_type_t const lhs_type(get_type_of_node(compare->get_left_handside()->get_node()));
+    variable_type_t const rhs_type(get_type_of_node(compare->get_right_handside()->get_node()));
+    if(lhs_type == VARIABLE_TYPE_FLOATING_POINT
+    || rhs_type == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        return false;
+    }
+
+    int const condition(get_compare_condition(compare));
+    if(condition < 0)
+    {
+        return false;
+    }
+
+    generate_select_value(select->get_parameter(0), register_t::REGISTER_RAX);
+    generate_select_value(select->get_right_handside(), register_t::REGISTER_RCX);
+    generate_compare_flags(compare);
+    generate_select(select->get_result(), condition);
+
+    return true;
+}
+
+
+/** \brief Get the condition code of a comparison.
+ *
+ * The condition code is the low nibble of the Jcc, SETcc, and CMOVcc
+ * instructions which are true when the comparison holds once the flags
+ * were set by generate_compare_flags(). The opposite condition is
+ * obtained by flipping bit 0.
+ *
+ * The floating point EQUAL and NOT_EQUAL comparisons are not supported
+ * because of the NaN special case (it requires two tests). The
+ * relational operators use A/AE with the operands swapped as required
+ * so an unordered result (NaN) is always viewed as false.
+ *
+ * \param[in] compare  The comparison operation.
+ *
+ * \return The condition code or -1 if the comparison is not supported.
+ */
+int binary_assembler::get_compare_condition(operation::pointer_t compare)
+{
+    variable_type_t const lhs_type(get_type_of_node(compare->get_left_handside()->get_node()));
+    variable_type_t const rhs_type(get_type_of_node(compare->get_right_handside()->get_node()));
+
+    if(lhs_type == VARIABLE_TYPE_FLOATING_POINT
+    || rhs_type == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        switch(compare->get_operation())
+        {
+        case node_t::NODE_GREATER:
+        case node_t::NODE_LESS:
+            return 0x07;    // A
+
+        case node_t::NODE_GREATER_EQUAL:
+        case node_t::NODE_LESS_EQUAL:
+            return 0x03;    // AE
+
+        default:
+            return -1;
+
+        }
+    }
+
+    if(lhs_type == VARIABLE_TYPE_INTEGER
+    || lhs_type == VARIABLE_TYPE_BOOLEAN
+    || rhs_type == VARIABLE_TYPE_INTEGER
+    || rhs_type == VARIABLE_TYPE_BOOLEAN)
+    {
+        switch(compare->get_operation())
+        {
+        case node_t::NODE_ALMOST_EQUAL:
+        case node_t::NODE_EQUAL:
+        case node_t::NODE_SMART_MATCH:
+        case node_t::NODE_STRICTLY_EQUAL:
+            return 0x04;    // E
+
+        case node_t::NODE_NOT_EQUAL:
+        case node_t::NODE_STRICTLY_NOT_EQUAL:
+            return 0x05;    // NE
+
+        case node_t::NODE_LESS:
+            return 0x0C;    // L
+
+        case node_t::NODE_LESS_EQUAL:
+            return 0x0E;    // LE
+
+        case node_t::NODE_GREATER:
+            return 0x0F;    // G
+
+        case node_t::NODE_GREATER_EQUAL:
+            return 0x0D;    // GE
+
+        default:
+            return -1;
+
+        }
+    }
+
+    return -1;
+}
+
+
+/** \brief Set the flags according to a comparison.
+ *
+ * This function generates the CMP (or UCOMISD) of a comparison for
+ * which get_compare_condition() returned a valid condition code. It
+ * only makes use of %rdx, %xmm0, and %xmm1.
+ *
+ * \param[in] compare  The comparison operation.
+ */
+void binary_assembler::generate_compare_flags(operation::pointer_t compare)
+{
+    data::pointer_t lhs(compare->get_left_handside());
+    data::pointer_t rhs(compare->get_right_handside());
+    variable_type_t const lhs_type(get_type_of_node(lhs->get_node()));
+    variable_type_t const rhs_type(get_type_of_node(rhs->get_node()));
+
+    if(lhs_type == VARIABLE_TYPE_FLOATING_POINT
+    || rhs_type == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        bool const swapped(compare->get_operation() == node_t::NODE_LESS
+                        || compare->get_operation() == node_t::NODE_LESS_EQUAL);
+
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+        generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+
+        std::uint8_t buf[] = {
+            0x66,       // UCOMISD %xmm1, %xmm0 (or %xmm0, %xmm1 if swapped)
+            0x0F,
+            0x2E,
+            static_cast<std::uint8_t>(swapped ? 0xC8 : 0xC1),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    else
+    {
+        // CMP <rhs>, %rdx
+        //
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RDX);
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX, 0x3B);
+    }
+}
+
+
+/** \brief Generate a branchless select.
+ *
+ * The CONDITIONAL operation is created by flatten_nodes for a `?:`
+ * which arms are cheap and without side effects. Both values are
+ * already computed so the select loads the false value in %rax, the
+ * true value in %rcx, and uses a CMOVNE to keep the true value when
+ * the condition is not zero.
+ *
+ * The Double values are selected as their bit pattern so the same
+ * code applies to all the numeric types.
+ *
+ * \param[in] op  The CONDITIONAL operation.
+ */
+void binary_assembler::generate_conditional(operation::pointer_t op)
+{
+    generate_select_value(op->get_parameter(0), register_t::REGISTER_RAX);
+    generate_select_value(op->get_right_handside(), register_t::REGISTER_RCX);
+
+    // CMP $0, <condition>
+    // (use RAX since it is 0 and will have no effect on the encoding)
+    //
+    generate_reg_mem_integer(op->get_left_handside(), register_t::REGISTER_RAX, 0x83, 1);
+    {
+        std::uint8_t buf[] = {
+            0x00,       // ib (the 0 in the CMP instruction we just generated)
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+
+    generate_select(op->get_result(), 0x05);    // NE
+}
+
+
+/** \brief Load one of the values of a select.
+ *
+ * The generate_reg_mem_integer() function does not support the Boolean
+ * literals which are valid arms of a `?:`.
+ *
+ * \param[in] d  The value to load.
+ * \param[in] reg  The register where the value gets loaded.
+ */
+void binary_assembler::generate_select_value(data::pointer_t d, register_t const reg)
+{
+    bool value(false);
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_TRUE:
+        value = true;
+        break;
+
+    case node_t::NODE_FALSE:
+        break;
+
+    case node_t::NODE_BOOLEAN:
+        value = d->get_boolean();
+        break;
+
+    default:
+        generate_reg_mem_integer(d, reg);
+        return;
+
+    }
+
+    std::uint8_t buf[] = {   // REX.W MOV $imm32, %rn
+        static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+        0xC7,
+        static_cast<std::uint8_t>(0xC0 | (static_cast<int>(reg) & 7)),
+        static_cast<std::uint8_t>(value ? 1 : 0),
+        0x00,
+        0x00,
+        0x00,
+    };
+    f_file.add_text(buf, sizeof(buf));
+}
+
+
+/** \brief Select the value and save the result.
+ *
+ * The false value is expected in %rax and the true value in %rcx.
+ * The flags were set by the caller.
+ *
+ * \param[in] result  Where the selected value gets saved.
+ * \param[in] condition  The condition code when %rcx gets selected.
+ */
+void binary_assembler::generate_select(data::pointer_t result, int condition)
+{
+    std::uint8_t buf[] = {
+        0x48,       // REX.W CMOVcc %rcx, %rax
+        0x0F,
+        static_cast<std::uint8_t>(0x40 | (condition & 0x0F)),
+        0xC1,
+    };
+    f_file.add_text(buf, sizeof(buf));
+
+    generate_store_integer(result, register_t::REGISTER_RAX);
+}
+
+
+void binary_assembler::generate_array(operation::pointer_t op)
+{
+    variable_type_t const type(get_type_of_node(op->get_node()));
+    data::pointer_t lhs(op->get_left_handside());
+    variable_type_t lhs_type(get_type_of_node(lhs->get_node()));
+    data::pointer_t rhs(op->get_right_handside());
+
+    std::string type_name;
+    if(lhs_type == VARIABLE_TYPE_UNKNOWN)
+    {
+        node::pointer_t type_node(lhs->get_node()->get_type_node());
+        if(type_node == nullptr)
+        {
+            throw not_implemented("binary_assembler::generate_array(): could not determine object type.");
+        }
+        type_name = type_node->get_string();
+    }
+
+    // if rhs is an identifier, then this is a field (the "b" in "a.b")
+    //
+    if(rhs->get_data_type() == node_t::NODE_IDENTIFIER
+    || rhs->get_data_type() == node_t::NODE_STRING)
+    {
+        std::string const & name(rhs->get_string());
+        if(name == "length"
+        && lhs_type == VARIABLE_TYPE_STRING
+        && type == VARIABLE_TYPE_INTEGER)
+        {
+            // directly move the string length to %rax
+            //
+            generate_load_string_size(lhs, register_t::REGISTER_RAX);
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "MAX_VALUE"
+        && lhs_type == VARIABLE_TYPE_INTEGER
+        && type == VARIABLE_TYPE_INTEGER)
+        {
+            // load maximum integer value in %rax
+            //
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0x7F,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "MIN_VALUE"
+        && lhs_type == VARIABLE_TYPE_INTEGER
+        && type == VARIABLE_TYPE_INTEGER)
+        {
+            // load minimum integer value in %rax
+            //
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x80,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "MAX_VALUE"
+        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
+        && type == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            // load maximum floating point value in %rax
+            // and then save it as an integer in a floating point variable
+            //
+            // maximum value in a double represented in hex: 0x7fefffffffffffff
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xFF,
+                0xEF,
+                0x7F,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "MIN_VALUE"
+        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
+        && type == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            // load minimum floating point value in %rax
+            // and then save it as an integer in a floating point variable
+            //
+            // minimum value in a double represented in hex: 0x0010000000000000
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x10,
+                0x00,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "NEGATIVE_INFINITY"
+        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
+        && type == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            // load minimum floating point value in %rax
+            // and then save it as an integer in a floating point variable
+            //
+            // -inf value in a double represented in hex: 0xFFF0000000000000
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0xF0,
+                0xFF,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "POSITIVE_INFINITY"
+        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
+        && type == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            // load minimum floating point value in %rax
+            // and then save it as an integer in a floating point variable
+            //
+            // +inf value in a double represented in hex: 0x7FF0000000000000
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0xF0,
+                0x7F,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+        if(name == "EPSILON"
+        && lhs_type == VARIABLE_TYPE_FLOATING_POINT
+        && type == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            // load minimum floating point value in %rax
+            // and then save it as an integer in a floating point variable
+            //
+            // minimum value in a double represented in hex: 0x3CB0000000000000
+            std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                0x48,
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0xB0,
+                0x3C,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+
+        throw not_implemented(
+              "unknown field (\""
+            + name
+            + "\") / unsupported type for array operator.");
+    }
+
+    data::pointer_t range_end;
+
+    variable_type_t index_type(get_type_of_node(rhs->get_node()));
+    std::size_t has_range(op->get_parameter_size());
+    if(has_range != 0)
+    {
+        range_end = op->get_parameter(0);
+        variable_type_t const range_end_type(get_type_of_node(range_end->get_node()));
+        if(index_type != range_end_type)
+        {
+            throw not_implemented("array range start & end conversion not yet implemented; they need to be of the same type for now.");
+        }
+    }
+
+    switch(type)
+    {
+    case VARIABLE_TYPE_STRING:
+        switch(index_type)
+        {
+        case VARIABLE_TYPE_INTEGER:
+        case VARIABLE_TYPE_FLOATING_POINT:
+            // if range is defined, do a subtr(), otherwise just retrieve that
+            // one character
+            //
+            generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
+            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_AT);
+            break;
+
+        case VARIABLE_TYPE_RANGE:
+            // TODO: the RANGE variable type is not yet supported
+            //
+            generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
+            generate_reg_mem_floating_point(range_end, register_t::REGISTER_RCX, sse_operation_t::SSE_OPERATION_CVT2I);
+            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_SUBSTR);
+            break;
+
+        default:
+            // we should probably have a toNumber() check first?
+            //
+            throw not_implemented("the string array operator only functions with Numbers.");
+
+        }
+        break;
+
+    default:
+        throw not_implemented("type not yet supported by the array operator");
+
+    }
+}
+
+
+void binary_assembler::generate_assignment(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+    data::pointer_t rhs(op->get_right_handside());
+    if(rhs == nullptr)
+    {
+        rhs = lhs;
+    }
+
+    // standard assignments are "inverted", we load the right handside
+    // and save it to the left handside
+    //
+    int const type(get_type_of_node(op->get_node()));
+    switch(type)
+    {
+    case VARIABLE_TYPE_FLOATING_POINT:
+    case VARIABLE_TYPE_INTEGER:
+    case VARIABLE_TYPE_BOOLEAN:
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RAX);
+        generate_store_integer(lhs, register_t::REGISTER_RAX);
+        if(op->get_result() != nullptr)
+        {
+            // the result is dropped by flatten_nodes::optimize() when unused
+            //
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        }
+        break;
+
+    case VARIABLE_TYPE_STRING:
+        generate_reg_mem_string(rhs, register_t::REGISTER_RSI);
+        generate_store_string(lhs, register_t::REGISTER_RSI);
+
+        if(op->get_result() != nullptr)
+        {
+            // the generate_store_string() has a CALL which blows up RSI
+            //
+            generate_reg_mem_string(rhs, register_t::REGISTER_RSI);
+            generate_store_string(op->get_result(), register_t::REGISTER_RSI);
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              std::string("trying to generate_assignment() with an unknown node type \"")
+            + std::to_string(type)
+            + "\" which is not yet implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_bitwise(operation::pointer_t op)
+{
+    bool is_assignment(false);
+    std::uint8_t code_imm32(0); // RAX specific (i.e. OP RAX, imm32)
+    std::uint8_t code_r64(0);
+    std::uint8_t rm(0);
+    switch(op->get_operation())
+    {
+    case node_t::NODE_ASSIGNMENT_BITWISE_AND:
+        is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_BITWISE_AND:
+        code_imm32 = 0x25;
+        code_r64 = 0x23;
+        rm = 0xE0; // /4
+        break;
+
+    case node_t::NODE_ASSIGNMENT_BITWISE_OR:
+        is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_BITWISE_OR:
+        code_imm32 = 0x0D;
+        code_r64 = 0x0B;
+        rm = 0xC8; // /1
+        break;
+
+    case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
+        is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_BITWISE_XOR:
+        code_imm32 = 0x35;
+        code_r64 = 0x33;
+        rm = 0xF0; // /6
+        break;
+
+    default:
+        throw internal_error("generate_bitwise() called with an unsupported operation");
+
+    }
+
+    data::pointer_t lhs(op->get_left_handside());
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        // load double as an integer in RAX
+        //
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_RAX, sse_operation_t::SSE_OPERATION_CVT2I);
+    }
+    else
+    {
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+    }
+
+    data::pointer_t rhs(op->get_right_handside());
+    switch(rhs->get_integer_size())
+    {
+    case integer_size_t::INTEGER_SIZE_1BIT:
+    case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+        {
+            std::uint8_t buf[] = {
+                0x48,           // AND/OR/XOR $imm8, %rax
+                0x83,
+                rm,
+                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get()),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        break;
+
+    case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+    case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 & imm16, use r64 & imm32 instead
+    case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+    case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+        {
+            std::uint8_t buf[] = {
+                0x48,           // AND/OR/XOR $imm32, %rax
+                code_imm32,
+                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  0),
+                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  8),
+                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 16),
+                static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        break;
+
+    case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
+    case integer_size_t::INTEGER_SIZE_64BITS:
+        {
+            generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
+            std::uint8_t buf[] = {
+                0x48,       // AND/OR/XOR %rdx, %rax
+                code_r64,
+                0xC2,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        break;
+
+    case integer_size_t::INTEGER_SIZE_FLOATING_POINT:
+        {
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
+            std::uint8_t buf[] = {
+                0x48,       // AND/OR/XOR %rdx, %rax
+                code_r64,
+                0xC2,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        break;
+
+    default:
+        if(rhs->get_data_type() == node_t::NODE_VARIABLE)
+        {
+            if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+            {
+                // if the variable is a floating point then it needs conversion
+                // before it can be used
+                //
+                generate_reg_mem_floating_point(rhs, register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
+                std::uint8_t buf[] = {
+                    0x48,       // AND/OR/XOR %rdx, %rax
+                    code_r64,
+                    0xC2,
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            else
+            {
+                // a variable needs to be loaded from memory so we need an AND
+                // which reads the variable location
+                //
+                generate_reg_mem_integer(rhs, register_t::REGISTER_RAX, code_r64);
+            }
+        }
+        else
+        {
+            if(rhs->get_data_type() != node_t::NODE_INTEGER)
+            {
+                throw not_implemented(
+                      std::string("trying to apply a bitwise operator on a \"")
+                    + node::type_to_string(rhs->get_data_type())
+                    + "\" which is not yet implemented.");
+            }
+            throw not_implemented(
+                  "found integer size "
+                + std::to_string(static_cast<int>(rhs->get_integer_size()))
+                + " which is not yet implemented in generate_bitwise().");
+        }
+
+    }
+
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        // a convert is rather expensive, in this case do it just once
+        // ahead of time
+        //
+        std::uint8_t buf[] = {
+            0xF2,       // CVTSI2SD %rax, %xmm0
+            0x48,
+            0x0F,
+            0x2A,
+            0xC0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+
+        if(is_assignment)
+        {
+            generate_store_floating_point(lhs, register_t::REGISTER_RAX);
+        }
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_RAX);
+    }
+    else
+    {
+        if(is_assignment)
+        {
+            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+        }
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+}
+
+
+void binary_assembler::generate_bitwise_not(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+    variable_type_t const type(get_type_of_node(op->get_node()));
+    switch(type)
+    {
+    case VARIABLE_TYPE_FLOATING_POINT:
+    case VARIABLE_TYPE_INTEGER:
+        if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            generate_reg_mem_floating_point(lhs, register_t::REGISTER_RAX, sse_operation_t::SSE_OPERATION_CVT2I);
+        }
+        else
+        {
+            generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        }
+
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W NOT %rax
+                0xF7,
+                0xD0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            // a convert is rather expensive, in this case do it just once
+            // ahead of time
+            //
+            std::uint8_t buf[] = {
+                0xF2,       // CVTSI2SD %rax, %xmm0
+                0x48,
+                0x0F,
+                0x2A,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+
+            generate_store_floating_point(op->get_result(), register_t::REGISTER_RAX);
+        }
+        else
+        {
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        }
+        break;
+
+    case VARIABLE_TYPE_STRING:
+        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_FLIP_CASE);
+        break;
+
+    default:
+        throw not_implemented(
+              "bitwise not of type "
+            + std::to_string(static_cast<int>(type))
+            + " is not yet implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_call(operation::pointer_t op)
+{
+    // a call creates a list of parameters; here we have to transform
+    // that list in a vector and pass the vector to the function; there
+    // may be no list or the list may be empty when the function does
+    // not expect parameters
+    //
+    // also the call may reference a native function (an actual CALL
+    // in assembly) or a user function call
+    //
+    data::pointer_t lhs(op->get_left_handside());       // the function being called or a member left handside variable
+    data::pointer_t params(op->get_parameter(0));       // ARRAY variable where we create the list of parameters
+
+    // allocate a vector for the list of parameters
+    //
+    temporary_variable * const params_var(f_file.find_temporary_variable(params->get_string()));
+    if(params_var == nullptr)
+    {
+        throw internal_error("temporary for parameters not found in binary_assembler::generate_call()");
+    }
+    if(params_var->get_type() != node_t::NODE_ARRAY)
+    {
+        throw internal_error("temporary for parameters in binary_assembler::generate_call() was expected to be of type ARRAY");
+    }
+    generate_pointer_to_temporary(params_var, register_t::REGISTER_RDI);
+    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_ARRAY_INITIALIZE);
+
+    // add parameters found in list to the array
+    //
+    // TODO: verify that having a list just before a call does not disturb
+    //       the call (i.e. `b, c, d; callme();` should not see the `b, c, d;`
+    //       list as the list of parameters of `callme();`)
+    //
+    std::size_t const param_count(op->get_parameter_size()); // EXCLUDING PARAM [0] which is the ARRAY variable
+    for(std::size_t idx(1); idx < param_count; ++idx)
+    {
+        data::pointer_t item(op->get_parameter(idx));
+std::cerr << "--- pushing item to param array...\n";
+        generate_pointer_to_variable(item, register_t::REGISTER_RSI);
+std::cerr << "--- pointer ready...\n";
+        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDI);
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_ARRAY_PUSH);
+    }
+
+    // make the call
+    //
+    node::pointer_t member(op->get_node()->get_child(0));
+//std::cerr << "\n--- CALL node to transform in a function call:\n" << *member << "\n";
+    if(member->get_type() == node_t::NODE_MEMBER)
+    {
+        node::pointer_t function(member->get_instance());
+        if(function->get_type() != node_t::NODE_FUNCTION
+        || !function->get_attribute(attribute_t::NODE_ATTR_NATIVE))
+        {
+            throw not_implemented("binary_assembler::generate_call(): we only support native function calls at the moment.");
+        }
+        node::pointer_t field(member->get_child(1));
+        if(field->get_type() != node_t::NODE_IDENTIFIER)
+        {
+            throw not_implemented("binary_assembler::generate_call(): we only support identifiers for the field name.");
+        }
+        std::string const & field_name(field->get_string());
+        if(field_name.empty())
+        {
+            throw internal_error("binary_assembler::generate_call(): field name is somehow empty.");
+        }
+        node::pointer_t object(member->get_child(0));
+        node::pointer_t type_node(object->get_type_node());
+        if(type_node == nullptr)
+        {
+            throw not_implemented("binary_assembler::generate_call(): we only support typed objects.");
+        }
+        std::string const & type_name(type_node->get_string());
+        if(type_name.empty())
+        {
+            throw internal_error("binary_assembler::generate_call(): type name is somehow empty.");
+        }
+        bool found(true);
+        switch(type_name[0])
+        {
+        case 'B':
+            if(type_name == "Boolean")
+            {
+                switch(field_name[0])
+                {
+                case 't':
+                    if(field_name == "toString")
+                    {
+                        generate_reg_mem_integer(lhs, register_t::REGISTER_RSI);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_BOOLEANS_TO_STRING);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'v':
+                    if(field_name == "valueOf")
+                    {
+                        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+                        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                default:
+                    found = false;
+                    break;
+
+                }
+            }
+            else
+            {
+                found = false;
+            }
+            break;
+
+        case 'D':
+            if(type_name == "Double")
+            {
+                goto number;
+            }
+            break;
+
+        case 'I':
+            if(type_name == "Integer")
+            {
+                switch(field_name[0])
+                {
+                case 't':
+                    if(field_name == "toString")
+                    {
+                        generate_reg_mem_integer(lhs, register_t::REGISTER_RSI);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_INTEGERS_TO_STRING);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'v':
+                    if(field_name == "valueOf")
+                    {
+                        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+                        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                default:
+                    found = false;
+                    break;
+
+                }
+            }
+            else
+            {
+                found = false;
+            }
+            break;
+
+        case 'M':
+            if(type_name == "Math")
+            {
+                switch(field_name[0])
+                {
+                case 'E':
+                    if(field_name == "E")
+                    {
+                        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RSI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_FLOATING_POINTS_TO_STRING);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                default:
+                    found = false;
+                    break;
+
+                }
+            }
+            else
+            {
+                found = false;
+            }
+            break;
+
+        case 'N':
+            if(type_name == "Number")
+            {
+number:
+                switch(field_name[0])
+                {
+                case 't':
+                    if(field_name == "toString")
+                    {
+                        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RSI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_FLOATING_POINTS_TO_STRING);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'v':
+                    if(field_name == "valueOf")
+                    {
+                        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+                        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                default:
+                    found = false;
+                    break;
+
+                }
+            }
+            else
+            {
+                found = false;
+            }
+            break;
+
+        case 'S':
+            if(type_name == "String")
+            {
+                switch(field_name[0])
+                {
+                case 'c':
+                    if(field_name == "charAt")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CHAR_AT);
+                    }
+                    else if(field_name == "charCodeAt")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CHAR_CODE_AT);
+                    }
+                    else if(field_name == "concat")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_CONCAT_PARAMS);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'i':
+                    if(field_name == "indexOf")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_INDEX_OF);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'l':
+                    if(field_name == "lastIndexOf")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_LAST_INDEX_OF);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'r':
+                    if(field_name == "replace")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_REPLACE);
+                    }
+                    else if(field_name == "replaceAll")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_REPLACE_ALL);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 's':
+                    if(field_name == "slice")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_SLICE);
+                    }
+                    else if(field_name == "substring")
+                    {
+                        generate_pointer_to_temporary(params_var, register_t::REGISTER_RDX);
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_SUBSTRING);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 't':
+                    if(field_name == "toLowerCase")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TO_LOWERCASE);
+                    }
+                    else if(field_name == "toUpperCase")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TO_UPPERCASE);
+                    }
+                    else if(field_name == "toString")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
+                    }
+                    else if(field_name == "trim")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TRIM);
+                    }
+                    else if(field_name == "trimStart" || field_name == "trimLeft")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TRIM_START);
+                    }
+                    else if(field_name == "trimEnd" || field_name == "trimRight")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_pointer_to_variable(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_TRIM_END);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                case 'v':
+                    if(field_name == "valueOf")
+                    {
+                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
+                    }
+                    else
+                    {
+                        found = false;
+                    }
+                    break;
+
+                default:
+                    found = false;
+                    break;
+
+                }
+            }
+            else
+            {
+                found = false;
+            }
+            break;
+
+        default:
+            found = false;
+            break;
+
+        }
+
+        if(!found)
+        {
+            throw not_implemented(
+                  "binary_assembler::generate_call(): it looks like function \""
+                + std::string(function->get_attribute(attribute_t::NODE_ATTR_NATIVE) ? "native " : "")
+                + type_name
+                + "::"
+                + field_name
+                + "()\" is not yet implemented.");
+        }
+    }
+    else
+    {
+        throw not_implemented(
+              "binary_assembler::generate_call(): we only support member calls at the moment.");
+    }
+
+    // done with those parameters, free them
+    //
+    generate_pointer_to_temporary(params_var, register_t::REGISTER_RDI);
+    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_ARRAY_FREE);
+}
+
+
+void binary_assembler::generate_clz32(operation::pointer_t op)
+{
+    generate_reg_mem_floating_point(op->get_left_handside(), register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
+
+    {
+        std::uint8_t buf[] = {
+            0xB8,       // MOV $31, %eax
+            0x1F,
+            0x00,
+            0x00,
+            0x00,
+
+            0x0F,       // BSR %edx, %edx
+            0xBD,
+            0xD2,
+
+            0x75,       // JNZ done
+            0x02,
+
+            0xB0,       // MOV $32, %al  -- since %rax is 31, this is an optimization to load %rax with 2 bytes
+            0x20,
+        // done:
+
+            0x29,       // SUB %edx, %eax
+            0xD0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+
+    generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+}
+
+
+void binary_assembler::generate_goto(operation::pointer_t op)
+{
+    std::size_t const pos(f_file.get_current_text_offset());
+    std::uint8_t jcc[] = {
+        0xE9,       // JMP disp32
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+    };
+    f_file.add_text(jcc, sizeof(jcc));
+    f_file.add_relocation(
+              op->get_label()
+            , relocation_t::RELOCATION_LABEL_32BITS
+            , pos + 1
+            , f_file.get_current_text_offset());
+}
+
+
+void binary_assembler::generate_identity(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+
+    switch(lhs->get_data_type())
+    {
+    case node_t::NODE_INTEGER:
+    case node_t::NODE_FLOATING_POINT:
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        break;
+
+    case node_t::NODE_STRING:
+        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+        generate_store_string(op->get_result(), register_t::REGISTER_RSI);
+        break;
+
+    case node_t::NODE_VARIABLE:
+        {
+            variable_type_t const type(get_type_of_node(lhs->get_node()));
+            switch(type)
+            {
+            case VARIABLE_TYPE_INTEGER:
+            case VARIABLE_TYPE_FLOATING_POINT:
+                generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+                break;
+
+            case VARIABLE_TYPE_STRING:
+                generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+                generate_store_string(op->get_result(), register_t::REGISTER_RSI);
+                break;
+
+            default:
+                throw not_implemented(
+                      "identity of type "
+                    + std::to_string(static_cast<int>(type))
+                    + " is not yet implemented.");
+                break;
+
+            }
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              std::string("identity of type ")
+            + node::type_to_string(lhs->get_data_type())
+            + " is not yet implemented.");
+
+    }
+}
+
+
+void binary_assembler::generate_if(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+    switch(lhs->get_data_type())
+    {
+    case node_t::NODE_BOOLEAN:
+    case node_t::NODE_INTEGER:
+    case node_t::NODE_FLOATING_POINT:
+    case node_t::NODE_STRING:
+        throw internal_error("somehow a conditional was not optimized properly.");
+
+    default:
+        break;
+
+    }
+
+    // with Intel we can use CMP 0, mem
+    // (use RAX since it is 0 and will have no effect on the encoding)
+    //
+    generate_reg_mem_integer(lhs, register_t::REGISTER_RAX, 0x83, 1);
+    {
+        std::uint8_t buf[] = {
+            0x00,       // ib (the 0 in the CMP instruction we just generated)
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+
+    {
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t const code(op->get_operation() == node_t::NODE_IF_TRUE ? 0x85 : 0x84);
+        std::uint8_t buf[] = {
+            0x0F,       // JNE or JE disp32
+            code,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  op->get_label()
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos + 2
+                , f_file.get_current_text_offset());
+    }
+}
+
+
+void binary_assembler::generate_divide(operation::pointer_t op)
+{
+    // TODO: support exception for DIV by 0
+    //
+    bool is_divide(false);
+    bool is_assignment(false);
+    switch(op->get_operation())
+    {
+    case node_t::NODE_DIVIDE:
+        is_divide = true;
+        break;
+
+    case node_t::NODE_ASSIGNMENT_DIVIDE:
+        is_divide = true;
+        is_assignment = true;
+        break;
+
+    case node_t::NODE_ASSIGNMENT_MODULO:
+        is_assignment = true;
+        break;
+
+    default:
+        break;
+
+    }
+
+    data::pointer_t lhs(op->get_left_handside());
+    data::pointer_t rhs(op->get_right_handside());
+
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        double reciprocal(0.0);
+        if(rhs->get_data_type() == node_t::NODE_FLOATING_POINT)
+        {
+            // dividing by a power of two is exactly the same as
+            // multiplying by its reciprocal, which is much faster
+            //
+            int exponent(0);
+            double const value(rhs->get_node()->get_floating_point().get());
+            if(std::isfinite(value)
+            && std::fabs(std::frexp(value, &exponent)) == 0.5)
+            {
+                reciprocal = 1.0 / value;
+                if(!std::isfinite(reciprocal)
+                || std::fabs(std::frexp(reciprocal, &exponent)) != 0.5)
+                {
+                    reciprocal = 0.0;
+                }
+            }
+        }
+
+        if(is_divide && reciprocal != 0.0)
+        {
+            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+
+            std::string name;
+            f_file.add_constant(reciprocal, name);
+
+            std::size_t const pos(f_file.get_current_text_offset());
+            std::uint8_t buf[] = {          // MULSD disp32[%rip], %xmm0
+                0xF2,
+                0x0F,
+                0x59,
+                0x05,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+            };
+            f_file.add_text(buf, sizeof(buf));
+            f_file.add_relocation(
+                      name
+                    , relocation_t::RELOCATION_CONSTANT_32BITS
+                    , pos + 4
+                    , f_file.get_current_text_offset());
+        }
+        else if(is_divide)
+        {
+            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_DIV);
+        }
+        else
+        {
+            // there is no easy remainder in SSE
+            //
+            // just call the system function, it's faster and much more
+            // reliable
+            //
+            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+
+            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_FMOD);
+        }
+
+        if(is_assignment)
+        {
+            generate_store_floating_point(lhs, register_t::REGISTER_XMM0);
+        }
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+    }
+    else
+    {
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+
+        if(rhs->get_data_type() == node_t::NODE_INTEGER
+        && generate_divide_by_constant(rhs->get_integer().get(), is_divide))
+        {
+            if(is_assignment)
+            {
+                generate_store_integer(lhs, register_t::REGISTER_RAX);
+            }
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            return;
+        }
+
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RCX);
+
+        // TODO: add support for the reg/mem instead of using RCX
+        {
+            std::uint8_t buf[] = {
+                0x48,       // CQO (extend rax sign to rdx)
+                0x99,
+
+                0x48,       // REX.W IDIV %rcx
+                0xF7,
+                static_cast<std::uint8_t>(0xF8 | static_cast<int>(register_t::REGISTER_RCX)),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        if(is_assignment)
+        {
+            generate_store_integer(
+                      op->get_left_handside()
+                    , is_divide ? register_t::REGISTER_RAX : register_t::REGISTER_RDX);
+        }
+        generate_store_integer(
+                  op->get_result()
+                , is_divide ? register_t::REGISTER_RAX : register_t::REGISTER_RDX);
+
+        if(!is_divide)
+        {
+            // we need the result in RAX, with the modulo, it is still in
+            // the RDX register
+            //
+            // TODO: once we optimize, this could be done only if we need the
+            //       value in RAX which many times may not be the case
+            //
+            std::uint8_t buf[] = {       // REX.W MOV %rdx, %rax
+                0x48,
+                0x89,
+                0xD0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+    }
+}
+
+
+/** \brief Divide %rax by a constant.
+ *
+ * IDIV is very slow so a division by a constant is transformed in a
+ * multiplication by a "magic number" keeping the high 64 bits of the
+ * result (see signed_division_magic()). A division by a power of two
+ * is transformed in an arithmetic shift and the modulo in a mask; in
+ * both cases, negative numbers get biased first so the result is
+ * truncated toward zero like with IDIV.
+ *
+ * The dividend is expected in %rax and the result is saved in %rax.
+ * %rcx and %rdx are clobbered.
+ *
+ * \param[in] value  The divisor.
+ * \param[in] is_divide  true for a division, false for a modulo.
+ *
+ * \return false if nothing was generated (i.e. \p value is 0) in which
+ * case the caller has to use IDIV.
+ */
+bool binary_assembler::generate_divide_by_constant(std::int64_t value, bool is_divide)
+{
+    if(value == 0)
+    {
+        // keep the IDIV and its exception
+        //
+        return false;
+    }
+
+    if(value == 1 || value == -1)
+    {
+        if(!is_divide)
+        {
+            std::uint8_t buf[] = {
+                0x31,       // XOR %eax, %eax
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else if(value == -1)
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W NEG %rax
+                0xF7,
+                0xD8,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        return true;
+    }
+
+    std::uint64_t const magnitude(value < 0
+                        ? -static_cast<std::uint64_t>(value)
+                        : static_cast<std::uint64_t>(value));
+    if((magnitude & (magnitude - 1)) == 0)
+    {
+        std::uint8_t const k(__builtin_ctzll(magnitude));
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W MOV %rax, %rdx
+                0x89,
+                0xC2,
+
+                0x48,       // REX.W SAR $63, %rdx
+                0xC1,
+                0xFA,
+                0x3F,
+
+                0x48,       // REX.W SHR $(64 - k), %rdx -- bias = 2^k - 1 if negative
+                0xC1,
+                0xEA,
+                static_cast<std::uint8_t>(64 - k),
+
+                0x48,       // REX.W ADD %rax, %rdx
+                0x01,
+                0xC2,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        if(is_divide)
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W SAR $k, %rdx
+                0xC1,
+                0xFA,
+                k,
+
+                0x48,       // REX.W MOV %rdx, %rax
+                0x89,
+                0xD0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+            if(value < 0)
+            {
+                std::uint8_t neg[] = {
+                    0x48,       // REX.W NEG %rax
+                    0xF7,
+                    0xD8,
+                };
+                f_file.add_text(neg, sizeof(neg));
+            }
+        }
+        else
+        {
+            // the remainder has the sign of the dividend whatever the
+            // sign of the divisor
+            //
+            std::int64_t const mask(-static_cast<std::int64_t>(magnitude - 1) - 1);
+            if(k < 32)
+            {
+                std::uint8_t buf[] = {
+                    0x48,       // REX.W AND $imm32, %rdx
+                    0x81,
+                    0xE2,
+                    static_cast<std::uint8_t>(mask >>  0),
+                    static_cast<std::uint8_t>(mask >>  8),
+                    static_cast<std::uint8_t>(mask >> 16),
+                    static_cast<std::uint8_t>(mask >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            else
+            {
+                std::uint8_t buf[] = {
+                    0x48,       // REX.W MOV $imm64, %rcx
+                    0xB9,
+                    static_cast<std::uint8_t>(mask >>  0),
+                    static_cast<std::uint8_t>(mask >>  8),
+                    static_cast<std::uint8_t>(mask >> 16),
+                    static_cast<std::uint8_t>(mask >> 24),
+                    static_cast<std::uint8_t>(mask >> 32),
+                    static_cast<std::uint8_t>(mask >> 40),
+                    static_cast<std::uint8_t>(mask >> 48),
+                    static_cast<std::uint8_t>(mask >> 56),
+
+                    0x48,       // REX.W AND %rcx, %rdx
+                    0x21,
+                    0xCA,
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            std::uint8_t buf[] = {
+                0x48,       // REX.W SUB %rdx, %rax
+                0x29,
+                0xD0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        return true;
+    }
+
+    std::int64_t magic(0);
+    int shift(0);
+    signed_division_magic(value, magic, shift);
+
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W MOV %rax, %rcx
+            0x89,
+            0xC1,
+
+            0x48,       // REX.W MOV $imm64, %rax
+            0xB8,
+            static_cast<std::uint8_t>(magic >>  0),
+            static_cast<std::uint8_t>(magic >>  8),
+            static_cast<std::uint8_t>(magic >> 16),
+            static_cast<std::uint8_t>(magic >> 24),
+            static_cast<std::uint8_t>(magic >> 32),
+            static_cast<std::uint8_t>(magic >> 40),
+            static_cast<std::uint8_t>(magic >> 48),
+            static_cast<std::uint8_t>(magic >> 56),
+
+            0x48,       // REX.W IMUL %rcx -- %rdx:%rax = %rax * %rcx
+            0xF7,
+            0xE9,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    if(value > 0 && magic < 0)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W ADD %rcx, %rdx
+            0x01,
+            0xCA,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    else if(value < 0 && magic > 0)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W SUB %rcx, %rdx
+            0x29,
+            0xCA,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    if(shift > 0)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W SAR $shift, %rdx
+            0xC1,
+            0xFA,
+            static_cast<std::uint8_t>(shift),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W MOV %rdx, %rax
+            0x89,
+            0xD0,
+
+            0x48,       // REX.W SHR $63, %rax
+            0xC1,
+            0xE8,
+            0x3F,
+
+            0x48,       // REX.W ADD %rdx, %rax -- add 1 if negative
+            0x01,
+            0xD0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+
+    if(!is_divide)
+    {
+        // remainder = dividend - quotient * divisor
+        //
+        if(value >= -0x80000000LL && value <= 0x7FFFFFFFLL)
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W IMUL $imm32, %rax, %rax
+                0x69,
+                0xC0,
+                static_cast<std::uint8_t>(value >>  0),
+                static_cast<std::uint8_t>(value >>  8),
+                static_cast<std::uint8_t>(value >> 16),
+                static_cast<std::uint8_t>(value >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W MOV $imm64, %rdx
+                0xBA,
+                static_cast<std::uint8_t>(value >>  0),
+                static_cast<std::uint8_t>(value >>  8),
+                static_cast<std::uint8_t>(value >> 16),
+                static_cast<std::uint8_t>(value >> 24),
+                static_cast<std::uint8_t>(value >> 32),
+                static_cast<std::uint8_t>(value >> 40),
+                static_cast<std::uint8_t>(value >> 48),
+                static_cast<std::uint8_t>(value >> 56),
+
+                0x48,       // REX.W IMUL %rdx, %rax
+                0x0F,
+                0xAF,
+                0xC2,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        std::uint8_t buf[] = {
+            0x48,       // REX.W SUB %rax, %rcx
+            0x29,
+            0xC1,
+
+            0x48,       // REX.W MOV %rcx, %rax
+            0x89,
+            0xC8,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+
+    return true;
+}
+
+
+/** \brief Multiply %rax by a constant.
+ *
+ * Multiplications by 0, 1, -1, powers of two, and 3, 5, or 9 times a
+ * power of two (and their negation) are done with XOR, NEG, SHL, and
+ * LEA which are faster than IMUL.
+ *
+ * \param[in] value  The constant to multiply %rax by.
+ *
+ * \return false if nothing was generated in which case the caller has
+ * to use IMUL.
+ */
+bool binary_assembler::generate_multiply_by_constant(std::int64_t value)
+{
+    if(value == 0)
+    {
+        std::uint8_t buf[] = {
+            0x31,       // XOR %eax, %eax
+            0xC0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        return true;
+    }
+
+    std::uint64_t magnitude(value < 0
+                        ? -static_cast<std::uint64_t>(value)
+                        : static_cast<std::uint64_t>(value));
+    std::uint8_t const k(__builtin_ctzll(magnitude));
+    magnitude >>= k;
+
+    std::uint8_t scale(0);
+    switch(magnitude)
+    {
+    case 1:
+        break;
+
+    case 3:
+        scale = 0x40;
+        break;
+
+    case 5:
+        scale = 0x80;
+        break;
+
+    case 9:
+        scale = 0xC0;
+        break;
+
+    default:
+        return false;
+
+    }
+
+    if(scale != 0)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W LEA (%rax,%rax,scale), %rax
+            0x8D,
+            0x04,
+            scale,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    if(k == 1)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W ADD %rax, %rax
+            0x01,
+            0xC0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    else if(k != 0)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W SHL $k, %rax
+            0xC1,
+            0xE0,
+            k,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    if(value < 0)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W NEG %rax
+            0xF7,
+            0xD8,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+
+    return true;
+}
+
+
+void binary_assembler::generate_increment(operation::pointer_t op)
+{
+    data::pointer_t lhs(op->get_left_handside());
+
+    node_t type(op->get_operation());
+    bool const is_post(type == node_t::NODE_POST_DECREMENT
+                    || type == node_t::NODE_POST_INCREMENT);
+
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    {
+        // we have to load the value in this case since there are not
+        // INC/DEC for floating points
+        //
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+
+        // make sure we have a 1.0 number somewhere
+        //
+        double const value(1.0);
+        std::string name;
+        f_file.add_constant(value, name);
+        lhs->set_data_name(name);
+
+        std::uint8_t const code(type == node_t::NODE_INCREMENT
+                             || type == node_t::NODE_POST_INCREMENT
+                                    ? 0x58
+                                    : 0x5C);
+
+        if(is_post)
+        {
+            // in this case xmm0 must not be changed so we move it xmm1
+            //
+            std::uint8_t buf[] = {           // MOVQ %xmm0, %xmm1
+                0xF3,
+                0x0F,
+                0x7E,
+                0xC8,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        {
+            std::size_t const pos(f_file.get_current_text_offset());
+            std::uint8_t buf[] = {          // ADDPS or SUBPS disp32[%rip], %xmm0|1
+                0xF2,
+                0x0F,
+                code,
+                static_cast<std::uint8_t>(is_post ? 0x0D : 0x05),
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+            };
+            f_file.add_text(buf, sizeof(buf));
+            f_file.add_relocation(
+                      name
+                    , relocation_t::RELOCATION_CONSTANT_32BITS
+                    , pos + 4
+                    , f_file.get_current_text_offset());
+        }
+
+        // store back inside input & temp
+        //
+        generate_store_floating_point(lhs, is_post ? register_t::REGISTER_XMM1 : register_t::REGISTER_XMM0);
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+    }
+    else
+    {
+        if(is_post)
+        {
+            generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        }
+
+        std::uint8_t const code(type == node_t::NODE_INCREMENT
+                             || type == node_t::NODE_POST_INCREMENT
+                                    ? 0x83 | (0 << 3)
+                                    : 0x83 | (1 << 3));
+
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {          // REX.W INC disp32(%rbx)
+            0x48,
+            0xFF,
+            code,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  lhs->get_string()
+                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
+                , pos + 3
+                , f_file.get_current_text_offset());
 
-                case 'v':
-                    if(field_name == "valueOf")
-                    {
-                        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-                        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COPY);
-                    }
-                    else
-                    {
-                        found = false;
-                    }
-                    break;
+        if(!is_post)
+        {
+            generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        }
 
-                default:
-                    found = false;
-                    break;
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+}
 
-                }
-            }
-            else
-            {
-                found = false;
-            }
+
+void binary_assembler::generate_label(operation::pointer_t op)
+{
+    f_file.add_label(op->get_label());
+}
+
+
+void binary_assembler::generate_list(operation::pointer_t op)
+{
+    data::pointer_t result(op->get_result());
+
+    // for a list the result is the last item in the list
+    // so here we copy that last item's result in the list's result
+    //
+    std::size_t const max(op->get_parameter_size());
+    if(max > 0)
+    {
+        data::pointer_t d(op->get_parameter(max - 1));
+
+        switch(get_type_of_node(d->get_node()))
+        {
+        case VARIABLE_TYPE_INTEGER:
+        case VARIABLE_TYPE_BOOLEAN:
+            generate_reg_mem_integer(d, register_t::REGISTER_RAX);
+            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
             break;
 
-        default:
-            found = false;
+        case VARIABLE_TYPE_FLOATING_POINT:
+            generate_reg_mem_floating_point(d, register_t::REGISTER_XMM0);
+            generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
             break;
 
-        }
+        case VARIABLE_TYPE_STRING:
+            generate_reg_mem_string(d, register_t::REGISTER_RSI);
+            generate_store_string(op->get_result(), register_t::REGISTER_RSI);
+            break;
 
-        if(!found)
-        {
+        default:
             throw not_implemented(
-                  "binary_assembler::generate_call(): it looks like function \""
-                + std::string(function->get_attribute(attribute_t::NODE_ATTR_NATIVE) ? "native " : "")
-                + type_name
-                + "::"
-                + field_name
-                + "()\" is not yet implemented.");
+                  "found a list item with a type not yet implemented in generate_list().");
+
         }
     }
-    else
-    {
-        throw not_implemented(
-              "binary_assembler::generate_call(): we only support member calls at the moment.");
-    }
 
-    // done with those parameters, free them
-    //
-    generate_pointer_to_temporary(params_var, register_t::REGISTER_RDI);
-    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_ARRAY_FREE);
 }
 
 
-void binary_assembler::generate_clz32(operation::pointer_t op)
+void binary_assembler::generate_logical(operation::pointer_t op)
 {
-    generate_reg_mem_floating_point(op->get_left_handside(), register_t::REGISTER_RDX, sse_operation_t::SSE_OPERATION_CVT2I);
-
+    bool is_assignment(false);
+    std::uint8_t code(0);
+    switch(op->get_operation())
     {
-        std::uint8_t buf[] = {
-            0xB8,       // MOV $31, %eax
-            0x1F,
-            0x00,
-            0x00,
-            0x00,
+    case node_t::NODE_ASSIGNMENT_LOGICAL_AND:
+        is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_LOGICAL_AND:
+        code = 0x23;
+        break;
 
-            0x0F,       // BSR %edx, %edx
-            0xBD,
-            0xD2,
+    case node_t::NODE_ASSIGNMENT_LOGICAL_OR:
+        is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_LOGICAL_OR:
+        code = 0x0B;
+        break;
 
-            0x75,       // JNZ done
-            0x02,
+    case node_t::NODE_ASSIGNMENT_LOGICAL_XOR:
+        is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_LOGICAL_XOR:
+        code = 0x33;
+        break;
 
-            0xB0,       // MOV $32, %al  -- since %rax is 31, this is an optimization to load %rax with 2 bytes
-            0x20,
-        // done:
+    default:
+        throw internal_error("generate_logical() called with an unsupported operation");
 
-            0x29,       // SUB %edx, %eax
-            0xD0,
-        };
-        f_file.add_text(buf, sizeof(buf));
     }
 
-    generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-}
+    data::pointer_t lhs(op->get_left_handside());
+    generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
 
+    data::pointer_t rhs(op->get_right_handside());
+    if(rhs->get_data_type() != node_t::NODE_VARIABLE)
+    {
+        throw not_implemented(
+              "found a literal which is not yet implemented in generate_logical().");
+    }
+    generate_reg_mem_integer(rhs, register_t::REGISTER_RAX, code);
 
-void binary_assembler::generate_goto(operation::pointer_t op)
-{
-    std::size_t const pos(f_file.get_current_text_offset());
-    std::uint8_t jcc[] = {
-        0xE9,       // JMP disp32
-        0x00,
-        0x00,
-        0x00,
-        0x00,
-    };
-    f_file.add_text(jcc, sizeof(jcc));
-    f_file.add_relocation(
-              op->get_label()
-            , relocation_t::RELOCATION_LABEL_32BITS
-            , pos + 1
-            , f_file.get_current_text_offset());
+    if(is_assignment)
+    {
+        generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+    }
+    generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
 }
 
 
-void binary_assembler::generate_identity(operation::pointer_t op)
+void binary_assembler::generate_logical_not(operation::pointer_t op)
 {
     data::pointer_t lhs(op->get_left_handside());
-
-    switch(lhs->get_data_type())
+    switch(get_type_of_node(lhs->get_node()))
     {
-    case node_t::NODE_INTEGER:
-    case node_t::NODE_FLOATING_POINT:
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-        break;
+    case VARIABLE_TYPE_FLOATING_POINT:
+    case VARIABLE_TYPE_INTEGER:
+    case VARIABLE_TYPE_BOOLEAN:
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RDI);
 
-    case node_t::NODE_STRING:
-        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-        generate_store_string(op->get_result(), register_t::REGISTER_RSI);
-        break;
+        {
+            std::uint8_t buf[] = {
+                0x33,       // XOR %eax, %eax (rax := 0)
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
 
-    case node_t::NODE_VARIABLE:
+        if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
         {
-            variable_type_t const type(get_type_of_node(lhs->get_node()));
-            switch(type)
-            {
-            case VARIABLE_TYPE_INTEGER:
-            case VARIABLE_TYPE_FLOATING_POINT:
-                generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-                break;
+            // to check for NaNs (because the test is flipped in that case)
+            //
+            std::uint64_t const nan_exponent_x2(0x7FF0000000000000ULL * 2 + 1ULL);
 
-            case VARIABLE_TYPE_STRING:
-                generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-                generate_store_string(op->get_result(), register_t::REGISTER_RSI);
-                break;
+            // ignore the sign if floating point (important for -0.0 and -NaN)
+            //
+            std::uint8_t buf[] = {
+                0x48,       // REX.W ADD $rdi, %rdi
+                0x03,
+                0xFF,
 
-            default:
-                throw not_implemented(
-                      "identity of type "
-                    + std::to_string(static_cast<int>(type))
-                    + " is not yet implemented.");
-                break;
+                // next we want to test for the NaN special case
+                // the number is a NaN if the mantissa != 0 and the exponent
+                // is all 1s so we can use a simple compare for this test
+                //
+                // TBD: look at using a constant instead of loading 64 bits
+                //      each time?
+                //
+                0x49,       // REX.W MOV $nan_exponent_x2, %r11
+                static_cast<std::uint8_t>(0xB8 | (static_cast<int>(register_t::REGISTER_R11) & 7)),
+                static_cast<std::uint8_t>(nan_exponent_x2 >>  0),
+                static_cast<std::uint8_t>(nan_exponent_x2 >>  8),
+                static_cast<std::uint8_t>(nan_exponent_x2 >> 16),
+                static_cast<std::uint8_t>(nan_exponent_x2 >> 24),
+                static_cast<std::uint8_t>(nan_exponent_x2 >> 32),
+                static_cast<std::uint8_t>(nan_exponent_x2 >> 40),
+                static_cast<std::uint8_t>(nan_exponent_x2 >> 48),
+                static_cast<std::uint8_t>(nan_exponent_x2 >> 56),
+
+                0x4C,       // REX.W CMP %r11, %rdi
+                0x39,
+                static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(register_t::REGISTER_R11) & 7) << 3) | (static_cast<int>(register_t::REGISTER_RDI) & 7)),
+
+                0x48,       // REX.W CMOVG %rax, %rdi
+                0x0F,
+                0x4F,
+                0xF8,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
 
-            }
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W TEST %rdi, %rdi
+                0x85,
+                0xFF,
+
+                0x0F,       // SETZ %al
+                0x94,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
         }
+
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
         break;
 
-    default:
-        throw not_implemented(
-              std::string("identity of type ")
-            + node::type_to_string(lhs->get_data_type())
-            + " is not yet implemented.");
+    case VARIABLE_TYPE_STRING:
+        // directly move the string length in %rdx
+        //
+        generate_load_string_size(lhs, register_t::REGISTER_RDX);
 
-    }
-}
+        {
+            std::uint8_t buf[] = {
+                0x33,       // XOR %eax, %eax   (%rax := 0)
+                0xC0,
 
+                0x85,       // TEST %edx, %edx
+                0xD2,
 
-void binary_assembler::generate_if(operation::pointer_t op)
-{
-    data::pointer_t lhs(op->get_left_handside());
-    switch(lhs->get_data_type())
-    {
-    case node_t::NODE_BOOLEAN:
-    case node_t::NODE_INTEGER:
-    case node_t::NODE_FLOATING_POINT:
-    case node_t::NODE_STRING:
-        throw internal_error("somehow a conditional was not optimized properly.");
+                0x0F,       // SETZ %al
+                0x94,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
 
-    default:
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
         break;
 
-    }
-
-    // with Intel we can use CMP 0, mem
-    // (use RAX since it is 0 and will have no effect on the encoding)
-    //
-    generate_reg_mem_integer(lhs, register_t::REGISTER_RAX, 0x83, 1);
-    {
-        std::uint8_t buf[] = {
-            0x00,       // ib (the 0 in the CMP instruction we just generated)
-        };
-        f_file.add_text(buf, sizeof(buf));
-    }
+    default:
+        throw not_implemented("node type not yet handled in generate_logical_not().");
 
-    {
-        std::size_t const pos(f_file.get_current_text_offset());
-        std::uint8_t const code(op->get_operation() == node_t::NODE_IF_TRUE ? 0x85 : 0x84);
-        std::uint8_t buf[] = {
-            0x0F,       // JNE or JE disp32
-            code,
-            0x00,
-            0x00,
-            0x00,
-            0x00,
-        };
-        f_file.add_text(buf, sizeof(buf));
-        f_file.add_relocation(
-                  op->get_label()
-                , relocation_t::RELOCATION_LABEL_32BITS
-                , pos + 2
-                , f_file.get_current_text_offset());
     }
 }
 
 
-void binary_assembler::generate_divide(operation::pointer_t op)
+void binary_assembler::generate_minmax(operation::pointer_t op)
 {
-    // TODO: support exception for DIV by 0
-    //
-    bool is_divide(false);
     bool is_assignment(false);
+    std::uint8_t code(0x4F);
+    std::uint8_t fp_code(0x5D);
     switch(op->get_operation())
     {
-    case node_t::NODE_DIVIDE:
-        is_divide = true;
-        break;
-
-    case node_t::NODE_ASSIGNMENT_DIVIDE:
-        is_divide = true;
+    case node_t::NODE_ASSIGNMENT_MAXIMUM:
         is_assignment = true;
+        [[fallthrough]];
+    case node_t::NODE_MAXIMUM:
+        code = 0x4C;
+        fp_code = 0x5F;
         break;
 
-    case node_t::NODE_ASSIGNMENT_MODULO:
+    case node_t::NODE_ASSIGNMENT_MINIMUM:
         is_assignment = true;
         break;
 
@@ -8925,1615 +14498,2410 @@ void binary_assembler::generate_divide(operation::pointer_t op)
 
     }
 
-    data::pointer_t lhs(op->get_left_handside());
-    data::pointer_t rhs(op->get_right_handside());
+    variable_type_t const type(get_type_of_node(op->get_node()));
 
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    data::pointer_t lhs(op->get_left_handside());
+    if(lhs == nullptr)
     {
-        if(is_divide)
-        {
-            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_DIV);
-        }
-        else
+        // this is a Math.min() or Math.max() instead, so we need to handle
+        // the list of parameters instead of a simple binary operator
+        //
+
+        std::size_t const max(op->get_parameter_size());
+        switch(type)
         {
-            // there is no easy remainder in SSE
-            //
-            // just call the system function, it's faster and much more
-            // reliable
-            //
-            generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+        case VARIABLE_TYPE_FLOATING_POINT:
+            if(max == 0)
+            {
+                {
+                    // load minimum floating point value in %rax
+                    // and then save it as an integer in a floating point variable
+                    //
+                    // +/-inf value in a double represented in hex:
+                    //      0x7FF0000000000000 (+inf)
+                    //      0xFFF0000000000000 (-inf)
+                    std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                        0x48,
+                        0xB8,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0x00,
+                        0xF0,
+                        static_cast<std::uint8_t>(code == 0x4C ? 0xFF : 0x7F),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            }
+            else
+            {
+                generate_reg_mem_floating_point(op->get_parameter(0), register_t::REGISTER_XMM0);
+                for(std::size_t idx(1); idx < max; ++idx)
+                {
+                    generate_reg_mem_floating_point(
+                          op->get_parameter(idx)
+                        , register_t::REGISTER_XMM0
+                        , code == 0x4C
+                            ? sse_operation_t::SSE_OPERATION_MAX
+                            : sse_operation_t::SSE_OPERATION_MIN);
+                }
+
+                generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+            }
+            break;
+
+        case VARIABLE_TYPE_INTEGER:
+            if(max == 0)
+            {
+                // WARNING: this case does not happen, it selects the
+                //          Number version automatically... (since there
+                //          are 0 parameters, we cannot really chose one
+                //          function over the other, yet that part works
+                //          but we choose the first function)
+                {
+                    // load minimum/maximum integer value in %rax
+                    // and then save it as an integer in a floating point variable
+                    //
+                    // "+/-inf" value for an integer...
+                    //      0x8000000000000000 (INT_MIN)
+                    //      0x7FFFFFFFFFFFFFFF (INT_MAX)
+                    std::int64_t const value(code == 0x4C ? INT_MIN : INT_MAX);
+                    std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
+                        0x48,
+                        0xB8,
+                        static_cast<std::uint8_t>(value >>  0),
+                        static_cast<std::uint8_t>(value >>  8),
+                        static_cast<std::uint8_t>(value >> 16),
+                        static_cast<std::uint8_t>(value >> 24),
+                        static_cast<std::uint8_t>(value >> 32),
+                        static_cast<std::uint8_t>(value >> 40),
+                        static_cast<std::uint8_t>(value >> 48),
+                        static_cast<std::uint8_t>(value >> 56),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            }
+            else
+            {
+                generate_reg_mem_integer(op->get_parameter(0), register_t::REGISTER_RAX);
+                for(std::size_t idx(1); idx < max; ++idx)
+                {
+                    generate_reg_mem_integer(op->get_parameter(idx), register_t::REGISTER_RDX);
+
+                    {
+                        std::uint8_t buf[] = {
+                            0x48,       // REX.W CMP %rax, %rdx
+                            0x39,
+                            0xD0,
+
+                            0x48,       // REX.W CMOVL or CMOVG %rdx, %rax
+                            0x0F,
+                            code,
+                            0xC2,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                    }
+                }
+
+                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+            }
+            break;
+
+        default:
+            throw not_implemented(
+                  "minimum/maximum of type "
+                + std::to_string(static_cast<int>(type))
+                + " is not yet implemented.");
 
-            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_FMOD);
         }
 
+        return;
+    }
+
+    data::pointer_t rhs(op->get_right_handside());
+
+    switch(type)
+    {
+    case VARIABLE_TYPE_FLOATING_POINT:
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+        generate_reg_mem_floating_point(
+              rhs
+            , register_t::REGISTER_XMM0
+            , code == 0x4C
+                ? sse_operation_t::SSE_OPERATION_MAX
+                : sse_operation_t::SSE_OPERATION_MIN);
+
         if(is_assignment)
         {
-            generate_store_floating_point(lhs, register_t::REGISTER_XMM0);
+            generate_store_floating_point(op->get_left_handside(), register_t::REGISTER_XMM0);
         }
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-    }
-    else
-    {
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        break;
+
+    case VARIABLE_TYPE_INTEGER:
         generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-        generate_reg_mem_integer(rhs, register_t::REGISTER_RCX);
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
 
-        // TODO: add support for the reg/mem instead of using RCX
         {
             std::uint8_t buf[] = {
-                0x48,       // CQO (extend rax sign to rdx)
-                0x99,
+                0x48,       // REX.W CMP %rax, %rdx
+                0x39,
+                0xD0,
 
-                0x48,       // REX.W IDIV %rcx
-                0xF7,
-                static_cast<std::uint8_t>(0xF8 | static_cast<int>(register_t::REGISTER_RCX)),
+                0x48,       // REX.W CMOVL or CMOVG %rdx, %rax
+                0x0F,
+                code,
+                0xC2,
             };
             f_file.add_text(buf, sizeof(buf));
         }
 
         if(is_assignment)
         {
-            generate_store_integer(
-                      op->get_left_handside()
-                    , is_divide ? register_t::REGISTER_RAX : register_t::REGISTER_RDX);
+            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
         }
-        generate_store_integer(
-                  op->get_result()
-                , is_divide ? register_t::REGISTER_RAX : register_t::REGISTER_RDX);
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        break;
+
+    case VARIABLE_TYPE_STRING:
+        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+        generate_reg_mem_string(rhs, register_t::REGISTER_RDX);
+        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
 
-        if(!is_divide)
         {
-            // we need the result in RAX, with the modulo, it is still in
-            // the RDX register
-            //
-            // TODO: once we optimize, this could be done only if we need the
-            //       value in RAX which many times may not be the case
-            //
-            std::uint8_t buf[] = {       // REX.W MOV %rdx, %rax
-                0x48,
-                0x89,
-                0xD0,
+            std::uint8_t buf[] = {   // MOV $imm8, %rcx  (%rcx = 1 or -1)
+                0xB1,
+                static_cast<std::uint8_t>(code == 0x4C ? 1 : -1),
             };
             f_file.add_text(buf, sizeof(buf));
         }
+
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_MINMAX);
+        if(is_assignment)
+        {
+            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RSI);
+            generate_store_string(lhs, register_t::REGISTER_RSI);
+        }
+        break;
+
+    default:
+        throw not_implemented(
+              "minimum/maximum of type "
+            + std::to_string(static_cast<int>(type))
+            + " is not yet implemented.");
+
     }
 }
 
 
-void binary_assembler::generate_increment(operation::pointer_t op)
+void binary_assembler::generate_hypot(operation::pointer_t op)
 {
-    data::pointer_t lhs(op->get_left_handside());
-
-    node_t type(op->get_operation());
-    bool const is_post(type == node_t::NODE_POST_DECREMENT
-                    || type == node_t::NODE_POST_INCREMENT);
-
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    std::size_t const max(op->get_parameter_size());
+    if(max == 0)
     {
-        // we have to load the value in this case since there are not
-        // INC/DEC for floating points
-        //
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-
-        // make sure we have a 1.0 number somewhere
-        //
-        double const value(1.0);
-        std::string name;
-        f_file.add_constant(value, name);
-        lhs->set_data_name(name);
-
-        std::uint8_t const code(type == node_t::NODE_INCREMENT
-                             || type == node_t::NODE_POST_INCREMENT
-                                    ? 0x58
-                                    : 0x5C);
-
-        if(is_post)
         {
-            // in this case xmm0 must not be changed so we move it xmm1
+            // no parameters means we return 0.0
             //
-            std::uint8_t buf[] = {           // MOVQ %xmm0, %xmm1
-                0xF3,
+            std::uint8_t buf[] = {      // XORSD %xmm0, %xmm0
+                0x66,
                 0x0F,
-                0x7E,
-                0xC8,
+                0x57,
+                0xC0,
             };
             f_file.add_text(buf, sizeof(buf));
         }
+    }
+    else if(max == 1)
+    {
+        // avoid the sqrt(n ** 2), we can just return n, we still need
+        // an abs(), which is way faster than an sqrt()
+        //
+        generate_reg_mem_floating_point(op->get_parameter(0), register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CVT2D);
 
         {
-            std::size_t const pos(f_file.get_current_text_offset());
-            std::uint8_t buf[] = {          // ADDPS or SUBPS disp32[%rip], %xmm0|1
-                0xF2,
+            std::uint8_t buf[] = {
+                0x66,   // PADDQ %xmm0, %xmm0
                 0x0F,
-                code,
-                static_cast<std::uint8_t>(is_post ? 0x0D : 0x05),
-                0x00,
-                0x00,
-                0x00,
-                0x00,
+                0xD4,
+                0xC0,
+
+                0x66,   // PSRLQ $1, %xmm0
+                0x0F,
+                0x73,
+                0xD0,
+                0x01,
             };
             f_file.add_text(buf, sizeof(buf));
-            f_file.add_relocation(
-                      name
-                    , relocation_t::RELOCATION_CONSTANT_32BITS
-                    , pos + 4
-                    , f_file.get_current_text_offset());
         }
-
-        // store back inside input & temp
-        //
-        generate_store_floating_point(lhs, is_post ? register_t::REGISTER_XMM1 : register_t::REGISTER_XMM0);
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
     }
     else
     {
-        if(is_post)
+        generate_reg_mem_floating_point(op->get_parameter(0), register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CVT2D);
+
         {
-            generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+            std::uint8_t buf[] = {      // MULPD %xmm0, %xmm0
+                0x66,
+                0x0F,
+                0x59,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
         }
 
-        std::uint8_t const code(type == node_t::NODE_INCREMENT
-                             || type == node_t::NODE_POST_INCREMENT
-                                    ? 0x05 | (0 << 3)
-                                    : 0x05 | (1 << 3));
+        for(std::size_t idx(1); idx < max; ++idx)
+        {
+            generate_reg_mem_floating_point(op->get_parameter(idx), register_t::REGISTER_XMM1, sse_operation_t::SSE_OPERATION_CVT2D);
 
-        std::size_t const pos(f_file.get_current_text_offset());
-        std::uint8_t buf[] = {          // REX.W INC disp32(%rip)
-            0x48,
-            0xFF,
-            code,
-            0x00,
-            0x00,
-            0x00,
-            0x00,
-        };
-        f_file.add_text(buf, sizeof(buf));
-        f_file.add_relocation(
-                  lhs->get_string()
-                , relocation_t::RELOCATION_VARIABLE_32BITS_DATA
-                , pos + 3
-                , f_file.get_current_text_offset());
+            {
+                std::uint8_t buf[] = {
+                    0x66,       // MULPD %xmm1, %xmm1
+                    0x0F,
+                    0x59,
+                    0xC9,
 
-        if(!is_post)
-        {
-            generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+                    0x66,       // ADD %xmm1, %xmm0
+                    0x0F,
+                    0x58,
+                    0xC1,
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
         }
 
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_SQRT);
     }
-}
-
 
-void binary_assembler::generate_label(operation::pointer_t op)
-{
-    f_file.add_label(op->get_label());
+    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
 }
 
 
-void binary_assembler::generate_list(operation::pointer_t op)
+void binary_assembler::generate_multiply(operation::pointer_t op)
 {
-    data::pointer_t result(op->get_result());
+    bool const is_assignment(op->get_operation() == node_t::NODE_ASSIGNMENT_MULTIPLY);
 
-    // for a list the result is the last item in the list
-    // so here we copy that last item's result in the list's result
-    //
-    std::size_t const max(op->get_parameter_size());
-    if(max > 0)
+    data::pointer_t lhs(op->get_left_handside());
+    data::pointer_t rhs(op->get_right_handside());
+
+    variable_type_t const type(get_type_of_node(op->get_node()));
+    switch(type)
     {
-        data::pointer_t d(op->get_parameter(max - 1));
+    case VARIABLE_TYPE_FLOATING_POINT:
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+        generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_MUL);
+
+        if(is_assignment)
+        {
+            generate_store_floating_point(lhs, register_t::REGISTER_XMM0);
+        }
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        break;
+
+    case VARIABLE_TYPE_INTEGER:
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+
+        if(rhs->get_data_type() != node_t::NODE_INTEGER
+        || !generate_multiply_by_constant(rhs->get_integer().get()))
+        {
+            switch(rhs->get_integer_size())
+            {
+            case integer_size_t::INTEGER_SIZE_1BIT:
+            case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+                {
+                    std::uint8_t buf[] = {
+                        0x48,       // 64 bits
+                        0x6B,       // IMUL r64 *= imm8
+                        0xC0,       // r/m
+                        static_cast<std::uint8_t>(rhs->get_node()->get_integer().get()),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
+
+            case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+            case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
+            case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+            case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+                {
+                    std::uint8_t buf[] = {
+                        0x48,       // 64 bits
+                        0x69,       // IMUL r64 *= imm32
+                        0xC0,       // r/m
+                        static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  0),
+                        static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  8),
+                        static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 16),
+                        static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 24),
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
+
+            case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
+            case integer_size_t::INTEGER_SIZE_64BITS:
+                {
+                    generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
+                    std::uint8_t buf[] = {
+                        0x48,       // IMUL rax *= rdx
+                        0x0F,
+                        0xAF,
+                        0xC2,
+                    };
+                    f_file.add_text(buf, sizeof(buf));
+                }
+                break;
 
-        switch(get_type_of_node(d->get_node()))
-        {
-        case VARIABLE_TYPE_INTEGER:
-        case VARIABLE_TYPE_BOOLEAN:
-            generate_reg_mem_integer(d, register_t::REGISTER_RAX);
-            generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-            break;
+            case integer_size_t::INTEGER_SIZE_UNKNOWN:
+                // rhs is not an integer
+                //
+                switch(rhs->get_data_type())
+                {
+                case node_t::NODE_VARIABLE:
+                    {
+                        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
+                        std::uint8_t buf[] = {
+                            0x48,       // IMUL rax *= rdx
+                            0x0F,
+                            0xAF,
+                            0xC2,
+                        };
+                        f_file.add_text(buf, sizeof(buf));
+                    }
+                    break;
 
-        case VARIABLE_TYPE_FLOATING_POINT:
-            generate_reg_mem_floating_point(d, register_t::REGISTER_XMM0);
-            generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-            break;
+                default:
+                    throw not_implemented("non-integer node not yet handled in generate_multiply().");
 
-        case VARIABLE_TYPE_STRING:
-            generate_reg_mem_string(d, register_t::REGISTER_RSI);
-            generate_store_string(op->get_result(), register_t::REGISTER_RSI);
-            break;
+                }
+                break;
 
-        default:
-            throw not_implemented(
-                  "found a list item with a type not yet implemented in generate_list().");
+            default:
+                throw not_implemented("integer size not yet implemented in generate_multiply().");
 
+            }
         }
-    }
-
-}
-
-
-void binary_assembler::generate_logical(operation::pointer_t op)
-{
-    bool is_assignment(false);
-    std::uint8_t code(0);
-    switch(op->get_operation())
-    {
-    case node_t::NODE_ASSIGNMENT_LOGICAL_AND:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_LOGICAL_AND:
-        code = 0x23;
-        break;
 
-    case node_t::NODE_ASSIGNMENT_LOGICAL_OR:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_LOGICAL_OR:
-        code = 0x0B;
+        if(is_assignment)
+        {
+            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+        }
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
         break;
 
-    case node_t::NODE_ASSIGNMENT_LOGICAL_XOR:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_LOGICAL_XOR:
-        code = 0x33;
+    case VARIABLE_TYPE_STRING:
+        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
+        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_MULTIPLY);
+        if(is_assignment)
+        {
+            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RSI);
+            generate_store_string(lhs, register_t::REGISTER_RSI);
+        }
         break;
 
     default:
-        throw internal_error("generate_logical() called with an unsupported operation");
+        throw not_implemented(
+              "multiply of type "
+            + std::to_string(static_cast<int>(type))
+            + " is not yet implemented.");
 
     }
+}
+
 
+void binary_assembler::generate_negate(operation::pointer_t op)
+{
     data::pointer_t lhs(op->get_left_handside());
     generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
 
-    data::pointer_t rhs(op->get_right_handside());
-    if(rhs->get_data_type() != node_t::NODE_VARIABLE)
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
     {
-        throw not_implemented(
-              "found a literal which is not yet implemented in generate_logical().");
+        // to negate a double just flip the sign bit
+        //
+        std::uint8_t buf[] = {
+            0x48,       // REX.W BTC $63, %rax
+            0x0F,
+            0xBA,
+            0xF8,
+            0x3F,
+        };
+        f_file.add_text(buf, sizeof(buf));
     }
-    generate_reg_mem_integer(rhs, register_t::REGISTER_RAX, code);
-
-    if(is_assignment)
+    else
     {
-        generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
+        std::uint8_t buf[] = {
+            0x48,       // REX.W NEG %rax
+            0xF7,
+            0xD8,
+        };
+        f_file.add_text(buf, sizeof(buf));
     }
+
     generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
 }
 
 
-void binary_assembler::generate_logical_not(operation::pointer_t op)
+void binary_assembler::generate_param(operation::pointer_t op)
 {
+    // a NODE_PARAM here means we got an integer, floating point, or
+    // boolean that needs to be converted in a binary_variable; this
+    // is done this way because at the moment CALL is only expecting
+    // such variables
+
+    // load data to copy in RAX or XMM0
+    //
     data::pointer_t lhs(op->get_left_handside());
-    switch(get_type_of_node(lhs->get_node()))
+    variable_type_t const binary_variable_type(get_type_of_node(lhs->get_node()));
+    switch(binary_variable_type)
     {
-    case VARIABLE_TYPE_FLOATING_POINT:
     case VARIABLE_TYPE_INTEGER:
     case VARIABLE_TYPE_BOOLEAN:
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RDI);
-
-        {
-            std::uint8_t buf[] = {
-                0x33,       // XOR %eax, %eax (rax := 0)
-                0xC0,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+    case VARIABLE_TYPE_FLOATING_POINT:
+        break;
 
-        if(get_type_of_node(lhs->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
-        {
-            // to check for NaNs (because the test is flipped in that case)
-            //
-            std::uint64_t const nan_exponent_x2(0x7FF0000000000000ULL * 2 + 1ULL);
+    default:
+        throw not_implemented(
+              "found a param item with a type not yet implemented in generate_param().");
 
-            // ignore the sign if floating point (important for -0.0 and -NaN)
-            //
-            std::uint8_t buf[] = {
-                0x48,       // REX.W ADD $rdi, %rdi
-                0x03,
-                0xFF,
+    }
+    generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
 
-                // next we want to test for the NaN special case
-                // the number is a NaN if the mantissa != 0 and the exponent
-                // is all 1s so we can use a simple compare for this test
-                //
-                // TBD: look at using a constant instead of loading 64 bits
-                //      each time?
-                //
-                0x49,       // REX.W MOV $nan_exponent_x2, %r11
-                static_cast<std::uint8_t>(0xB8 | (static_cast<int>(register_t::REGISTER_R11) & 7)),
-                static_cast<std::uint8_t>(nan_exponent_x2 >>  0),
-                static_cast<std::uint8_t>(nan_exponent_x2 >>  8),
-                static_cast<std::uint8_t>(nan_exponent_x2 >> 16),
-                static_cast<std::uint8_t>(nan_exponent_x2 >> 24),
-                static_cast<std::uint8_t>(nan_exponent_x2 >> 32),
-                static_cast<std::uint8_t>(nan_exponent_x2 >> 40),
-                static_cast<std::uint8_t>(nan_exponent_x2 >> 48),
-                static_cast<std::uint8_t>(nan_exponent_x2 >> 56),
+    // now save the result in the binary variable defined in "result"
+    //
+    data::pointer_t result(op->get_result());
+    if(result->get_data_type() != node_t::NODE_VARIABLE)
+    {
+        throw not_implemented(
+              "generate_param() only supports results of type NODE_VARIABLE.");
+    }
+    if(!result->is_temporary())
+    {
+        throw not_implemented(
+              "generate_param() only supports temporary variables for their results.");
+    }
 
-                0x4C,       // REX.W CMP %r11, %rdi
-                0x39,
-                static_cast<std::uint8_t>(0xC0 | ((static_cast<int>(register_t::REGISTER_R11) & 7) << 3) | (static_cast<int>(register_t::REGISTER_RDI) & 7)),
+    node::pointer_t n(result->get_node());
+    std::string const name(n->get_string());
+    temporary_variable * temp_var(f_file.find_temporary_variable(name));
+    if(temp_var == nullptr)
+    {
+        throw internal_error("temporary not found in generate_param()");
+    }
+    if(temp_var->get_size() != sizeof(binary_variable))
+    {
+        throw internal_error("temporary was expected to be exactly sizeof(binary_variable) in size in generate_param()");
+    }
 
-                0x48,       // REX.W CMOVG %rax, %rdi
-                0x0F,
-                0x4F,
-                0xF8,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+    generate_save_reg_in_binary_variable(temp_var, register_t::REGISTER_RAX, binary_variable_type);
+}
 
-        {
-            std::uint8_t buf[] = {
-                0x48,       // REX.W TEST %rdi, %rdi
-                0x85,
-                0xFF,
 
-                0x0F,       // SETZ %al
-                0x94,
-                0xC0,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+void binary_assembler::generate_random(operation::pointer_t op)
+{
+    // get 64 random bits and transform the top 52 bits in a double
+    // in [1.0, 2.0) then subtract 1.0
+    //
+    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_RANDOM_BITS);
+
+    std::uint8_t buf[] = {
+        0x48,       // SHR RAX, 12
+        0xC1,
+        0xE8,
+        12,
+        0x48,       // MOV RDX, 1.0
+        0xBA,
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+        0xF0,
+        0x3F,
+        0x48,       // OR RAX, RDX
+        0x09,
+        0xD0,
+        0x66,       // MOVQ XMM0, RAX
+        0x48,
+        0x0F,
+        0x6E,
+        0xC0,
+        0x66,       // MOVQ XMM1, RDX
+        0x48,
+        0x0F,
+        0x6E,
+        0xCA,
+        0xF2,       // SUBSD XMM0, XMM1
+        0x0F,
+        0x5C,
+        0xC1,
+    };
+    f_file.add_text(buf, sizeof(buf));
 
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-        break;
+    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+}
 
-    case VARIABLE_TYPE_STRING:
-        // directly move the string length in %rdx
-        //
-        generate_load_string_size(lhs, register_t::REGISTER_RDX);
 
+/** \brief Return from a user function.
+ *
+ * The value gets saved in the return temporary and the code jumps to
+ * the exit of the function where the epilogue loads it in %rax or %xmm0.
+ *
+ * \param[in] op  The NODE_RETURN operation.
+ */
+void binary_assembler::generate_return(operation::pointer_t op)
+{
+    data::pointer_t result(op->get_result());
+    if(result != nullptr)
+    {
+        data::pointer_t value(op->get_left_handside());
+        switch(get_type_of_node(result->get_node()))
         {
-            std::uint8_t buf[] = {
-                0x33,       // XOR %eax, %eax   (%rax := 0)
-                0xC0,
-
-                0x85,       // TEST %edx, %edx
-                0xD2,
-
-                0x0F,       // SETZ %al
-                0x94,
-                0xC0,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
+        case VARIABLE_TYPE_BOOLEAN:
+        case VARIABLE_TYPE_INTEGER:
+            generate_reg_mem_integer(value, register_t::REGISTER_RAX);
+            generate_store_integer(result, register_t::REGISTER_RAX);
+            break;
 
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-        break;
+        case VARIABLE_TYPE_FLOATING_POINT:
+            generate_load_as_floating_point(value, register_t::REGISTER_XMM0);
+            generate_store_floating_point(result, register_t::REGISTER_XMM0);
+            break;
 
-    default:
-        throw not_implemented("node type not yet handled in generate_logical_not().");
+        default:
+            {
+                message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, op->get_node()->get_position());
+                msg << "binary compilation of a function returning \""
+                    << result->get_node()->get_type_node()->get_string()
+                    << "\" is not yet implemented.";
+                throw not_implemented(msg.str());
+            }
 
+        }
     }
+
+    generate_jump(0, op->get_label());
 }
 
 
-void binary_assembler::generate_minmax(operation::pointer_t op)
+void binary_assembler::generate_save_reg_in_binary_variable(temporary_variable * temp_var, register_t reg, variable_type_t const binary_variable_type)
 {
-    bool is_assignment(false);
-    std::uint8_t code(0x4F);
-    std::uint8_t fp_code(0x5D);
-    switch(op->get_operation())
+    if(reg == register_t::REGISTER_RCX)
     {
-    case node_t::NODE_ASSIGNMENT_MAXIMUM:
-        is_assignment = true;
-        [[fallthrough]];
-    case node_t::NODE_MAXIMUM:
-        code = 0x4C;
-        fp_code = 0x5F;
+        throw not_implemented("generate_save_reg_in_binary_variable() does not support reg parameter as RCX just yet");
+    }
+
+    // at this point the variable is consider uninitialized if it is an
+    // integer, a boolean, or a floating point variable; this means we
+    // not only save the RAX (reg) value in the f_data field, we also want to
+    // set the f_type, f_flag, f_data_size properly (also clear the
+    // f_name/f_name_size too, for forward compatibility)
+    //
+    ssize_t const offset(temp_var->get_offset());
+
+    std::size_t size(0);
+    switch(binary_variable_type)
+    {
+    case VARIABLE_TYPE_INTEGER:
+        size = sizeof(std::int64_t);
         break;
 
-    case node_t::NODE_ASSIGNMENT_MINIMUM:
-        is_assignment = true;
+    case VARIABLE_TYPE_BOOLEAN:
+        size = sizeof(std::uint8_t);
         break;
 
-    default:
+    case VARIABLE_TYPE_FLOATING_POINT:
+        size = sizeof(double);
         break;
 
+    default:
+        throw not_implemented(
+              "found a param item with a type not yet implemented in generate_param().");
+
     }
 
-    variable_type_t const type(get_type_of_node(op->get_node()));
+    { // zero to clear a few fields
+        std::uint8_t buf[] = {    // XOR %rcx, %rcx
+            0x33,
+            static_cast<std::uint8_t>(0xC9),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
 
-    data::pointer_t lhs(op->get_left_handside());
-    if(lhs == nullptr)
+    // save type in var.f_type
     {
-        // this is a Math.min() or Math.max() instead, so we need to handle
-        // the list of parameters instead of a simple binary operator
-        //
-
-        std::size_t const max(op->get_parameter_size());
-        switch(type)
+        ssize_t const o(offset + offsetof(binary_variable, f_type));
+        switch(get_smallest_size(o))
         {
-        case VARIABLE_TYPE_FLOATING_POINT:
-            if(max == 0)
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
             {
-                {
-                    // load minimum floating point value in %rax
-                    // and then save it as an integer in a floating point variable
-                    //
-                    // +/-inf value in a double represented in hex:
-                    //      0x7FF0000000000000 (+inf)
-                    //      0xFFF0000000000000 (-inf)
-                    std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                        0x48,
-                        0xB8,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0x00,
-                        0xF0,
-                        static_cast<std::uint8_t>(code == 0x4C ? 0xFF : 0x7F),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+                std::uint8_t buf[] = {    // MOVW $imm16, disp8(%rbp)
+                    0x66,
+                    0xC7,
+                    static_cast<std::uint8_t>(0x45),
+                    static_cast<std::uint8_t>(o),
+                    static_cast<std::uint8_t>(binary_variable_type >> 0),
+                    static_cast<std::uint8_t>(binary_variable_type >> 8),
+                };
+                f_file.add_text(buf, sizeof(buf));
             }
-            else
-            {
-                generate_reg_mem_floating_point(op->get_parameter(0), register_t::REGISTER_XMM0);
-                for(std::size_t idx(1); idx < max; ++idx)
-                {
-                    generate_reg_mem_floating_point(
-                          op->get_parameter(idx)
-                        , register_t::REGISTER_XMM0
-                        , code == 0x4C
-                            ? sse_operation_t::SSE_OPERATION_MAX
-                            : sse_operation_t::SSE_OPERATION_MIN);
-                }
+            break;
 
-                generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOVW $imm16, disp32(%rbp)
+                    0x66,
+                    0xC7,
+                    static_cast<std::uint8_t>(0x85),
+                    static_cast<std::uint8_t>(o >>  0),
+                    static_cast<std::uint8_t>(o >>  8),
+                    static_cast<std::uint8_t>(o >> 16),
+                    static_cast<std::uint8_t>(o >> 24),
+                    static_cast<std::uint8_t>(binary_variable_type >> 0),
+                    static_cast<std::uint8_t>(binary_variable_type >> 8),
+                };
+                f_file.add_text(buf, sizeof(buf));
             }
             break;
 
-        case VARIABLE_TYPE_INTEGER:
-            if(max == 0)
-            {
-                // WARNING: this case does not happen, it selects the
-                //          Number version automatically... (since there
-                //          are 0 parameters, we cannot really chose one
-                //          function over the other, yet that part works
-                //          but we choose the first function)
-                {
-                    // load minimum/maximum integer value in %rax
-                    // and then save it as an integer in a floating point variable
-                    //
-                    // "+/-inf" value for an integer...
-                    //      0x8000000000000000 (INT_MIN)
-                    //      0x7FFFFFFFFFFFFFFF (INT_MAX)
-                    std::int64_t const value(code == 0x4C ? INT_MIN : INT_MAX);
-                    std::uint8_t buf[] = {      // REX.W MOV $imm64, %rax
-                        0x48,
-                        0xB8,
-                        static_cast<std::uint8_t>(value >>  0),
-                        static_cast<std::uint8_t>(value >>  8),
-                        static_cast<std::uint8_t>(value >> 16),
-                        static_cast<std::uint8_t>(value >> 24),
-                        static_cast<std::uint8_t>(value >> 32),
-                        static_cast<std::uint8_t>(value >> 40),
-                        static_cast<std::uint8_t>(value >> 48),
-                        static_cast<std::uint8_t>(value >> 56),
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
+        default:
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not supported yet in "
+                + temp_var->get_name()
+                + " (type: "
+                + std::to_string(static_cast<int>(get_smallest_size(o)))
+                + " for size: "
+                + std::to_string(o)
+                + ").");
 
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        }
+    }
+
+    // clear flags in var.f_flags
+    {
+        ssize_t const o(offset + offsetof(binary_variable, f_flags));
+        switch(get_smallest_size(o))
+        {
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOVW %cx, disp8(%rbp)
+                    0x66,
+                    0x89,
+                    static_cast<std::uint8_t>(0x4D),
+                    static_cast<std::uint8_t>(o),
+                };
+                f_file.add_text(buf, sizeof(buf));
             }
-            else
+            break;
+
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
             {
-                generate_reg_mem_integer(op->get_parameter(0), register_t::REGISTER_RAX);
-                for(std::size_t idx(1); idx < max; ++idx)
-                {
-                    generate_reg_mem_integer(op->get_parameter(idx), register_t::REGISTER_RDX);
+                std::uint8_t buf[] = {    // MOVW %cx, disp32(%rbp)
+                    0x66,
+                    0x89,
+                    static_cast<std::uint8_t>(0x8D),
+                    static_cast<std::uint8_t>(o >>  0),
+                    static_cast<std::uint8_t>(o >>  8),
+                    static_cast<std::uint8_t>(o >> 16),
+                    static_cast<std::uint8_t>(o >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
 
-                    {
-                        std::uint8_t buf[] = {
-                            0x48,       // REX.W CMP %rax, %rdx
-                            0x39,
-                            0xD0,
+        default:
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not supported yet in "
+                + temp_var->get_name()
+                + " (type: "
+                + std::to_string(static_cast<int>(get_smallest_size(o)))
+                + " for size: "
+                + std::to_string(o)
+                + ").");
 
-                            0x48,       // REX.W CMOVL or CMOVG %rdx, %rax
-                            0x0F,
-                            code,
-                            0xC2,
-                        };
-                        f_file.add_text(buf, sizeof(buf));
-                    }
-                }
+        }
+    }
+
+    // clear name size (no name specified) in var.f_name_size
+    {
+        ssize_t const o(offset + offsetof(binary_variable, f_name_size));
+        switch(get_smallest_size(o))
+        {
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOVW %cx, disp8(%rbp)
+                    0x66,
+                    0x89,
+                    static_cast<std::uint8_t>(0x4D),
+                    static_cast<std::uint8_t>(o),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
 
-                generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOVW %cx, disp32(%rbp)
+                    0x66,
+                    0x89,
+                    static_cast<std::uint8_t>(0x8D),
+                    static_cast<std::uint8_t>(o >>  0),
+                    static_cast<std::uint8_t>(o >>  8),
+                    static_cast<std::uint8_t>(o >> 16),
+                    static_cast<std::uint8_t>(o >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
             }
             break;
 
         default:
-            throw not_implemented(
-                  "minimum/maximum of type "
-                + std::to_string(static_cast<int>(type))
-                + " is not yet implemented.");
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not supported yet in "
+                + temp_var->get_name()
+                + " (type: "
+                + std::to_string(static_cast<int>(get_smallest_size(o)))
+                + " for size: "
+                + std::to_string(o)
+                + ").");
 
         }
-
-        return;
     }
 
-    data::pointer_t rhs(op->get_right_handside());
-
-    switch(type)
+    // clear name offset (no name specified) in var.f_name
     {
-    case VARIABLE_TYPE_FLOATING_POINT:
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-        generate_reg_mem_floating_point(
-              rhs
-            , register_t::REGISTER_XMM0
-            , code == 0x4C
-                ? sse_operation_t::SSE_OPERATION_MAX
-                : sse_operation_t::SSE_OPERATION_MIN);
-
-        if(is_assignment)
+        ssize_t const o(offset + offsetof(binary_variable, f_name));
+        switch(get_smallest_size(o))
         {
-            generate_store_floating_point(op->get_left_handside(), register_t::REGISTER_XMM0);
-        }
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-        break;
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOV %ecx, disp8(%rbp)
+                    0x89,
+                    static_cast<std::uint8_t>(0x4D),
+                    static_cast<std::uint8_t>(o),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
 
-    case VARIABLE_TYPE_INTEGER:
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
-        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOV %ecx, disp32(%rbp)
+                    0x89,
+                    static_cast<std::uint8_t>(0x8D),
+                    static_cast<std::uint8_t>(o >>  0),
+                    static_cast<std::uint8_t>(o >>  8),
+                    static_cast<std::uint8_t>(o >> 16),
+                    static_cast<std::uint8_t>(o >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
 
-        {
-            std::uint8_t buf[] = {
-                0x48,       // REX.W CMP %rax, %rdx
-                0x39,
-                0xD0,
+        default:
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not supported yet in "
+                + temp_var->get_name()
+                + " (type: "
+                + std::to_string(static_cast<int>(get_smallest_size(o)))
+                + " for size: "
+                + std::to_string(o)
+                + ").");
 
-                0x48,       // REX.W CMOVL or CMOVG %rdx, %rax
-                0x0F,
-                code,
-                0xC2,
-            };
-            f_file.add_text(buf, sizeof(buf));
         }
+    }
 
-        if(is_assignment)
+    // save size in var.f_data_size
+    {
+        ssize_t const o(offset + offsetof(binary_variable, f_data_size));
+        switch(get_smallest_size(o))
         {
-            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
-        }
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-        break;
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOV $imm32, disp8(%rbp)
+                    0xC7,
+                    static_cast<std::uint8_t>(0x45),
+                    static_cast<std::uint8_t>(o),
+                    static_cast<std::uint8_t>(size >>  0),
+                    static_cast<std::uint8_t>(size >>  8),
+                    static_cast<std::uint8_t>(size >> 16),
+                    static_cast<std::uint8_t>(size >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
 
-    case VARIABLE_TYPE_STRING:
-        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-        generate_reg_mem_string(rhs, register_t::REGISTER_RDX);
-        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // MOV $imm32, disp32(%rbp)
+                    0xC7,
+                    static_cast<std::uint8_t>(0x85),
+                    static_cast<std::uint8_t>(o >>  0),
+                    static_cast<std::uint8_t>(o >>  8),
+                    static_cast<std::uint8_t>(o >> 16),
+                    static_cast<std::uint8_t>(o >> 24),
+                    static_cast<std::uint8_t>(size >>  0),
+                    static_cast<std::uint8_t>(size >>  8),
+                    static_cast<std::uint8_t>(size >> 16),
+                    static_cast<std::uint8_t>(size >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        default:
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not supported yet in "
+                + temp_var->get_name()
+                + " (type: "
+                + std::to_string(static_cast<int>(get_smallest_size(o)))
+                + " for size: "
+                + std::to_string(o)
+                + ").");
 
-        {
-            std::uint8_t buf[] = {   // MOV $imm8, %rcx  (%rcx = 1 or -1)
-                0xB1,
-                static_cast<std::uint8_t>(code == 0x4C ? 1 : -1),
-            };
-            f_file.add_text(buf, sizeof(buf));
         }
+    }
 
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_MINMAX);
-        if(is_assignment)
+    // now save the value in var.f_data
+    {
+        ssize_t const o(offset + offsetof(binary_variable, f_data));
+        switch(get_smallest_size(o))
         {
-            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RSI);
-            generate_store_string(lhs, register_t::REGISTER_RSI);
-        }
-        break;
+        case integer_size_t::INTEGER_SIZE_1BIT:
+        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // REX.W MOV %rn, disp8(%rbp)
+                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                    0x89,
+                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
+                    static_cast<std::uint8_t>(o),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
 
-    default:
-        throw not_implemented(
-              "minimum/maximum of type "
-            + std::to_string(static_cast<int>(type))
-            + " is not yet implemented.");
+        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
+        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
+        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+            {
+                std::uint8_t buf[] = {    // REX.W MOV %rn, disp32(%rbp)
+                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
+                    0x89,
+                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
+                    static_cast<std::uint8_t>(o >>  0),
+                    static_cast<std::uint8_t>(o >>  8),
+                    static_cast<std::uint8_t>(o >> 16),
+                    static_cast<std::uint8_t>(o >> 24),
+                };
+                f_file.add_text(buf, sizeof(buf));
+            }
+            break;
+
+        default:
+            // x86-64 only supports disp8 and disp32
+            //
+            // for larger offsets we would need to use an
+            // index register; but we should never go over
+            // disp32 on the stack anyway since it's only 2Mb
+            //
+            throw not_implemented("offset size not supported yet in "
+                + temp_var->get_name()
+                + " (type: "
+                + std::to_string(static_cast<int>(get_smallest_size(o)))
+                + " for size: "
+                + std::to_string(o)
+                + ").");
 
+        }
     }
 }
 
 
-void binary_assembler::generate_hypot(operation::pointer_t op)
+void binary_assembler::generate_math_function(operation::pointer_t op)
 {
-    std::size_t const max(op->get_parameter_size());
-    if(max == 0)
+    data::pointer_t lhs(op->get_left_handside());
+    generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CVT2D);
+
+    // a few functions are directly available as SSE2 instructions
+    //
+    switch(op->get_operation())
     {
+    case node_t::NODE_FROUND:
         {
-            // no parameters means we return 0.0
+            // the conversion uses the current rounding mode (nearest) and
+            // returns an infinity on overflow
             //
-            std::uint8_t buf[] = {      // XORSD %xmm0, %xmm0
-                0x66,
-                0x0F,
-                0x57,
-                0xC0,
-            };
-            f_file.add_text(buf, sizeof(buf));
-        }
-    }
-    else if(max == 1)
-    {
-        // avoid the sqrt(n ** 2), we can just return n, we still need
-        // an abs(), which is way faster than an sqrt()
-        //
-        generate_reg_mem_floating_point(op->get_parameter(0), register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CVT2D);
-
-        {
             std::uint8_t buf[] = {
-                0x66,   // PADDQ %xmm0, %xmm0
+                0xF2,       // CVTSD2SS %xmm0, %xmm0
                 0x0F,
-                0xD4,
+                0x5A,
                 0xC0,
 
-                0x66,   // PSRLQ $1, %xmm0
+                0xF3,       // CVTSS2SD %xmm0, %xmm0
                 0x0F,
-                0x73,
-                0xD0,
-                0x01,
+                0x5A,
+                0xC0,
             };
             f_file.add_text(buf, sizeof(buf));
         }
-    }
-    else
-    {
-        generate_reg_mem_floating_point(op->get_parameter(0), register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CVT2D);
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        return;
 
+    case node_t::NODE_SQRT:
         {
-            std::uint8_t buf[] = {      // MULPD %xmm0, %xmm0
-                0x66,
+            std::uint8_t buf[] = {
+                0xF2,       // SQRTSD %xmm0, %xmm0
                 0x0F,
-                0x59,
+                0x51,
                 0xC0,
             };
             f_file.add_text(buf, sizeof(buf));
         }
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        return;
 
-        for(std::size_t idx(1); idx < max; ++idx)
-        {
-            generate_reg_mem_floating_point(op->get_parameter(idx), register_t::REGISTER_XMM1, sse_operation_t::SSE_OPERATION_CVT2D);
-
-            {
-                std::uint8_t buf[] = {
-                    0x66,       // MULPD %xmm1, %xmm1
-                    0x0F,
-                    0x59,
-                    0xC9,
-
-                    0x66,       // ADD %xmm1, %xmm0
-                    0x0F,
-                    0x58,
-                    0xC1,
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-        }
+    default:
+        break;
 
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_SQRT);
     }
 
-    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-}
-
-
-void binary_assembler::generate_multiply(operation::pointer_t op)
-{
-    bool const is_assignment(op->get_operation() == node_t::NODE_ASSIGNMENT_MULTIPLY);
+    // ROUNDSD immediate: bits 0-1 are the rounding mode and bit 3
+    // suppresses the precision exception; 0 means no ROUNDSD
+    //
+    std::uint8_t rounding(0);
+    external_function_t func(external_function_t::EXTERNAL_FUNCTION_UNKNOWN);
+    switch(op->get_operation())
+    {
+    case node_t::NODE_ACOS:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ACOS;
+        break;
 
-    data::pointer_t lhs(op->get_left_handside());
-    data::pointer_t rhs(op->get_right_handside());
+    case node_t::NODE_ACOSH:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ACOSH;
+        break;
 
-    variable_type_t const type(get_type_of_node(op->get_node()));
-    switch(type)
-    {
-    case VARIABLE_TYPE_FLOATING_POINT:
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-        generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_MUL);
+    case node_t::NODE_ASIN:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ASIN;
+        break;
 
-        if(is_assignment)
-        {
-            generate_store_floating_point(lhs, register_t::REGISTER_XMM0);
-        }
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+    case node_t::NODE_ASINH:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ASINH;
         break;
 
-    case VARIABLE_TYPE_INTEGER:
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+    case node_t::NODE_ATAN:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ATAN;
+        break;
 
-        switch(rhs->get_integer_size())
-        {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {
-                    0x48,       // 64 bits
-                    0x6B,       // IMUL r64 *= imm8
-                    0xC0,       // r/m
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get()),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+    case node_t::NODE_ATANH:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ATANH;
+        break;
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:        // there is no r64 + imm16, use r64 + imm32 instead
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {
-                    0x48,       // 64 bits
-                    0x69,       // IMUL r64 *= imm32
-                    0xC0,       // r/m
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  0),
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >>  8),
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 16),
-                    static_cast<std::uint8_t>(rhs->get_node()->get_integer().get() >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+    case node_t::NODE_CBRT:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_CBRT;
+        break;
 
-        case integer_size_t::INTEGER_SIZE_32BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_64BITS:
-            {
-                generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
-                std::uint8_t buf[] = {
-                    0x48,       // IMUL rax *= rdx
-                    0x0F,
-                    0xAF,
-                    0xC2,
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+    case node_t::NODE_CEIL:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_CEIL;
+        rounding = 0x0A;
+        break;
 
-        case integer_size_t::INTEGER_SIZE_UNKNOWN:
-            // rhs is not an integer
-            //
-            switch(rhs->get_data_type())
-            {
-            case node_t::NODE_VARIABLE:
-                {
-                    generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
-                    std::uint8_t buf[] = {
-                        0x48,       // IMUL rax *= rdx
-                        0x0F,
-                        0xAF,
-                        0xC2,
-                    };
-                    f_file.add_text(buf, sizeof(buf));
-                }
-                break;
+    case node_t::NODE_COS:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_COS;
+        break;
 
-            default:
-                throw not_implemented("non-integer node not yet handled in generate_multiply().");
+    case node_t::NODE_COSH:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_COSH;
+        break;
 
-            }
-            break;
+    case node_t::NODE_EXP:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_EXP;
+        break;
 
-        default:
-            throw not_implemented("integer size not yet implemented in generate_multiply().");
+    case node_t::NODE_EXPM1:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_EXPM1;
+        break;
 
-        }
+    case node_t::NODE_FLOOR:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_FLOOR;
+        rounding = 0x09;
+        break;
 
-        if(is_assignment)
-        {
-            generate_store_integer(op->get_left_handside(), register_t::REGISTER_RAX);
-        }
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    case node_t::NODE_FROUND:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_FROUND;
         break;
 
-    case VARIABLE_TYPE_STRING:
-        generate_reg_mem_string(lhs, register_t::REGISTER_RSI);
-        generate_reg_mem_integer(rhs, register_t::REGISTER_RDX);
-        generate_reg_mem_string(op->get_result(), register_t::REGISTER_RDI);
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_MULTIPLY);
-        if(is_assignment)
-        {
-            generate_reg_mem_string(op->get_result(), register_t::REGISTER_RSI);
-            generate_store_string(lhs, register_t::REGISTER_RSI);
-        }
+    case node_t::NODE_LOG:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG;
         break;
 
-    default:
-        throw not_implemented(
-              "multiply of type "
-            + std::to_string(static_cast<int>(type))
-            + " is not yet implemented.");
+    case node_t::NODE_LOG1P:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG1P;
+        break;
 
-    }
-}
+    case node_t::NODE_LOG10:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG10;
+        break;
 
+    case node_t::NODE_LOG2:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG2;
+        break;
 
-void binary_assembler::generate_negate(operation::pointer_t op)
-{
-    data::pointer_t lhs(op->get_left_handside());
-    generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+    case node_t::NODE_ROUND:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_ROUND;
+        rounding = 0x0B;
+        break;
 
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
-    {
-        // to negate a double just flip the sign bit
-        //
-        std::uint8_t buf[] = {
-            0x48,       // REX.W BTC $63, %rax
-            0x0F,
-            0xBA,
-            0xF8,
-            0x3F,
-        };
-        f_file.add_text(buf, sizeof(buf));
-    }
-    else
-    {
-        std::uint8_t buf[] = {
-            0x48,       // REX.W NEG %rax
-            0xF7,
-            0xD8,
-        };
-        f_file.add_text(buf, sizeof(buf));
-    }
+    case node_t::NODE_SIN:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_SIN;
+        break;
 
-    generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-}
+    case node_t::NODE_SINH:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_SINH;
+        break;
 
+    case node_t::NODE_SQRT:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_SQRT;
+        break;
 
-void binary_assembler::generate_param(operation::pointer_t op)
-{
-    // a NODE_PARAM here means we got an integer, floating point, or
-    // boolean that needs to be converted in a binary_variable; this
-    // is done this way because at the moment CALL is only expecting
-    // such variables
+    case node_t::NODE_TAN:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_TAN;
+        break;
 
-    // load data to copy in RAX or XMM0
-    //
-    data::pointer_t lhs(op->get_left_handside());
-    variable_type_t const binary_variable_type(get_type_of_node(lhs->get_node()));
-    switch(binary_variable_type)
-    {
-    case VARIABLE_TYPE_INTEGER:
-    case VARIABLE_TYPE_BOOLEAN:
-    case VARIABLE_TYPE_FLOATING_POINT:
+    case node_t::NODE_TANH:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_TANH;
+        break;
+
+    case node_t::NODE_TRUNC:
+        func = external_function_t::EXTERNAL_FUNCTION_MATH_TRUNC;
+        rounding = 0x0B;
         break;
 
     default:
-        throw not_implemented(
-              "found a param item with a type not yet implemented in generate_param().");
+        throw internal_error("generate_math_function() called with an invalid operator");
 
     }
-    generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
 
-    // now save the result in the binary variable defined in "result"
-    //
-    data::pointer_t result(op->get_result());
-    if(result->get_data_type() != node_t::NODE_VARIABLE)
-    {
-        throw not_implemented(
-              "generate_param() only supports results of type NODE_VARIABLE.");
-    }
-    if(!result->is_temporary())
+    if(rounding == 0)
     {
-        throw not_implemented(
-              "generate_param() only supports temporary variables for their results.");
+        generate_external_function_call(func);
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        return;
     }
 
-    node::pointer_t n(result->get_node());
-    std::string const name(n->get_string());
-    temporary_variable * temp_var(f_file.find_temporary_variable(name));
-    if(temp_var == nullptr)
+    // ROUNDSD requires SSE4.1 which we check at runtime; when not
+    // available, call the C library function instead
+    //
+    ++f_next_label;
+    std::string const fallback("%math" + std::to_string(f_next_label));
+    ++f_next_label;
+    std::string const done("%math" + std::to_string(f_next_label));
+
     {
-        throw internal_error("temporary not found in generate_param()");
+        std::string name;
+        f_file.add_extern_function(external_function_t::EXTERNAL_FUNCTION_CPU_FEATURES, name);
+
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {
+            0xF6,       // TEST $imm8, disp32(%rip)
+            0x05,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+            static_cast<std::uint8_t>(CPU_FEATURE_SSE4_1),
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  name
+                , relocation_t::RELOCATION_EXTERN_FUNCTION
+                , pos + 2
+                , f_file.get_current_text_offset());
     }
-    if(temp_var->get_size() != sizeof(binary_variable))
     {
-        throw internal_error("temporary was expected to be exactly sizeof(binary_variable) in size in generate_param()");
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {
+            0x0F,       // JE disp32
+            0x84,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  fallback
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos + 2
+                , f_file.get_current_text_offset());
     }
 
-    generate_save_reg_in_binary_variable(temp_var, register_t::REGISTER_RAX, binary_variable_type);
-}
-
-
-void binary_assembler::generate_random(operation::pointer_t op)
-{
-    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_RANDOM);
-    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-}
-
-
-void binary_assembler::generate_save_reg_in_binary_variable(temporary_variable * temp_var, register_t reg, variable_type_t const binary_variable_type)
-{
-    if(reg == register_t::REGISTER_RCX)
+    if(op->get_operation() == node_t::NODE_ROUND)
     {
-        throw not_implemented("generate_save_reg_in_binary_variable() does not support reg parameter as RCX just yet");
-    }
+        // Math.round() rounds half-way cases away from zero, which is
+        // trunc(x + copysign(0.49999999999999994, x)); using the largest
+        // double below 0.5 avoids rounding 0.49999999999999994 up
+        //
+        std::uint8_t buf[] = {
+            0x48,       // REX.W MOV $0x8000000000000000, %rax
+            0xB8,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+            0x80,
 
-    // at this point the variable is consider uninitialized if it is an
-    // integer, a boolean, or a floating point variable; this means we
-    // not only save the RAX (reg) value in the f_data field, we also want to
-    // set the f_type, f_flag, f_data_size properly (also clear the
-    // f_name/f_name_size too, for forward compatibility)
-    //
-    ssize_t const offset(temp_var->get_offset());
+            0x66,       // MOVQ %rax, %xmm1
+            0x48,
+            0x0F,
+            0x6E,
+            0xC8,
 
-    std::size_t size(0);
-    switch(binary_variable_type)
-    {
-    case VARIABLE_TYPE_INTEGER:
-        size = sizeof(std::int64_t);
-        break;
+            0x66,       // ANDPD %xmm0, %xmm1
+            0x0F,
+            0x54,
+            0xC8,
 
-    case VARIABLE_TYPE_BOOLEAN:
-        size = sizeof(std::uint8_t);
-        break;
+            0x48,       // REX.W MOV $0x3FDFFFFFFFFFFFFF, %rax
+            0xB8,
+            0xFF,
+            0xFF,
+            0xFF,
+            0xFF,
+            0xFF,
+            0xFF,
+            0xDF,
+            0x3F,
 
-    case VARIABLE_TYPE_FLOATING_POINT:
-        size = sizeof(double);
-        break;
+            0x66,       // MOVQ %rax, %xmm2
+            0x48,
+            0x0F,
+            0x6E,
+            0xD0,
 
-    default:
-        throw not_implemented(
-              "found a param item with a type not yet implemented in generate_param().");
+            0x66,       // ORPD %xmm2, %xmm1
+            0x0F,
+            0x56,
+            0xCA,
 
+            0xF2,       // ADDSD %xmm1, %xmm0
+            0x0F,
+            0x58,
+            0xC1,
+        };
+        f_file.add_text(buf, sizeof(buf));
     }
 
-    { // zero to clear a few fields
-        std::uint8_t buf[] = {    // XOR %rcx, %rcx
-            0x33,
-            static_cast<std::uint8_t>(0xC9),
+    {
+        std::uint8_t buf[] = {
+            0x66,       // ROUNDSD $imm8, %xmm0, %xmm0
+            0x0F,
+            0x3A,
+            0x0B,
+            0xC0,
+            rounding,
         };
         f_file.add_text(buf, sizeof(buf));
     }
-
-    // save type in var.f_type
     {
-        ssize_t const o(offset + offsetof(binary_variable, f_type));
-        switch(get_smallest_size(o))
-        {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOVW $imm16, disp8(%rbp)
-                    0x66,
-                    0xC7,
-                    static_cast<std::uint8_t>(0x45),
-                    static_cast<std::uint8_t>(o),
-                    static_cast<std::uint8_t>(binary_variable_type >> 0),
-                    static_cast<std::uint8_t>(binary_variable_type >> 8),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {
+            0xE9,       // JMP disp32
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  done
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos + 1
+                , f_file.get_current_text_offset());
+    }
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOVW $imm16, disp32(%rbp)
-                    0x66,
-                    0xC7,
-                    static_cast<std::uint8_t>(0x85),
-                    static_cast<std::uint8_t>(o >>  0),
-                    static_cast<std::uint8_t>(o >>  8),
-                    static_cast<std::uint8_t>(o >> 16),
-                    static_cast<std::uint8_t>(o >> 24),
-                    static_cast<std::uint8_t>(binary_variable_type >> 0),
-                    static_cast<std::uint8_t>(binary_variable_type >> 8),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+    f_file.add_label(fallback);
+    generate_external_function_call(func);
+    f_file.add_label(done);
 
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
-            //
-            throw not_implemented("offset size not supported yet in "
-                + temp_var->get_name()
-                + " (type: "
-                + std::to_string(static_cast<int>(get_smallest_size(o)))
-                + " for size: "
-                + std::to_string(o)
-                + ").");
+    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+}
 
-        }
-    }
 
-    // clear flags in var.f_flags
-    {
-        ssize_t const o(offset + offsetof(binary_variable, f_flags));
-        switch(get_smallest_size(o))
-        {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOVW %cx, disp8(%rbp)
-                    0x66,
-                    0x89,
-                    static_cast<std::uint8_t>(0x4D),
-                    static_cast<std::uint8_t>(o),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+void binary_assembler::generate_power(operation::pointer_t op)
+{
+    bool const is_assignment(op->get_operation() == node_t::NODE_ASSIGNMENT_POWER);
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
+    data::pointer_t lhs(op->get_left_handside());
+    data::pointer_t rhs(op->get_right_handside());
+
+    // x ** 2 and x ** 3 are done with multiplications
+    //
+    std::int64_t exponent(0);
+    switch(rhs->get_data_type())
+    {
+    case node_t::NODE_INTEGER:
+        exponent = rhs->get_integer().get();
+        break;
+
+    case node_t::NODE_FLOATING_POINT:
+        {
+            double const value(rhs->get_node()->get_floating_point().get());
+            if(value == 2.0 || value == 3.0)
             {
-                std::uint8_t buf[] = {    // MOVW %cx, disp32(%rbp)
-                    0x66,
-                    0x89,
-                    static_cast<std::uint8_t>(0x8D),
-                    static_cast<std::uint8_t>(o >>  0),
-                    static_cast<std::uint8_t>(o >>  8),
-                    static_cast<std::uint8_t>(o >> 16),
-                    static_cast<std::uint8_t>(o >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
+                exponent = static_cast<std::int64_t>(value);
             }
-            break;
+        }
+        break;
 
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
-            //
-            throw not_implemented("offset size not supported yet in "
-                + temp_var->get_name()
-                + " (type: "
-                + std::to_string(static_cast<int>(get_smallest_size(o)))
-                + " for size: "
-                + std::to_string(o)
-                + ").");
+    default:
+        break;
 
-        }
     }
 
-    // clear name size (no name specified) in var.f_name_size
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
     {
-        ssize_t const o(offset + offsetof(binary_variable, f_name_size));
-        switch(get_smallest_size(o))
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
+
+        // x * x is rounded once, exactly like pow(), but x * x * x is
+        // rounded twice so it may differ from pow() by one ULP
+        //
+        if(exponent == 3
+        && (f_options == nullptr
+            || f_options->get_option(option_t::OPTION_UNSAFE_MATH) == 0))
         {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOVW %cx, disp8(%rbp)
-                    0x66,
-                    0x89,
-                    static_cast<std::uint8_t>(0x4D),
-                    static_cast<std::uint8_t>(o),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+            exponent = 0;
+        }
+        if(exponent == 2)
+        {
+            std::uint8_t buf[] = {
+                0xF2,       // MULSD %xmm0, %xmm0
+                0x0F,
+                0x59,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else if(exponent == 3)
+        {
+            std::uint8_t buf[] = {
+                0x66,       // MOVAPD %xmm0, %xmm1
+                0x0F,
+                0x28,
+                0xC8,
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOVW %cx, disp32(%rbp)
-                    0x66,
-                    0x89,
-                    static_cast<std::uint8_t>(0x8D),
-                    static_cast<std::uint8_t>(o >>  0),
-                    static_cast<std::uint8_t>(o >>  8),
-                    static_cast<std::uint8_t>(o >> 16),
-                    static_cast<std::uint8_t>(o >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+                0xF2,       // MULSD %xmm0, %xmm0
+                0x0F,
+                0x59,
+                0xC0,
 
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
-            //
-            throw not_implemented("offset size not supported yet in "
-                + temp_var->get_name()
-                + " (type: "
-                + std::to_string(static_cast<int>(get_smallest_size(o)))
-                + " for size: "
-                + std::to_string(o)
-                + ").");
+                0xF2,       // MULSD %xmm1, %xmm0
+                0x0F,
+                0x59,
+                0xC1,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else
+        {
+            generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+            generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_POW);
+        }
 
+        if(is_assignment)
+        {
+            generate_store_floating_point(lhs, register_t::REGISTER_XMM0);
         }
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
     }
-
-    // clear name offset (no name specified) in var.f_name
+    else if(exponent == 2 || exponent == 3)
     {
-        ssize_t const o(offset + offsetof(binary_variable, f_name));
-        switch(get_smallest_size(o))
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        if(exponent == 2)
         {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOV %ecx, disp8(%rbp)
-                    0x89,
-                    static_cast<std::uint8_t>(0x4D),
-                    static_cast<std::uint8_t>(o),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+            std::uint8_t buf[] = {
+                0x48,       // REX.W IMUL %rax, %rax
+                0x0F,
+                0xAF,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W MOV %rax, %rcx
+                0x89,
+                0xC1,
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOV %ecx, disp32(%rbp)
-                    0x89,
-                    static_cast<std::uint8_t>(0x8D),
-                    static_cast<std::uint8_t>(o >>  0),
-                    static_cast<std::uint8_t>(o >>  8),
-                    static_cast<std::uint8_t>(o >> 16),
-                    static_cast<std::uint8_t>(o >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+                0x48,       // REX.W IMUL %rax, %rax
+                0x0F,
+                0xAF,
+                0xC0,
 
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
-            //
-            throw not_implemented("offset size not supported yet in "
-                + temp_var->get_name()
-                + " (type: "
-                + std::to_string(static_cast<int>(get_smallest_size(o)))
-                + " for size: "
-                + std::to_string(o)
-                + ").");
+                0x48,       // REX.W IMUL %rcx, %rax
+                0x0F,
+                0xAF,
+                0xC1,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
 
+        if(is_assignment)
+        {
+            generate_store_integer(lhs, register_t::REGISTER_RAX);
         }
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
     }
-
-    // save size in var.f_data_size
+    else
     {
-        ssize_t const o(offset + offsetof(binary_variable, f_data_size));
-        switch(get_smallest_size(o))
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RDI);
+        generate_reg_mem_integer(rhs, register_t::REGISTER_RSI);
+
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_IPOW);
+
+        //f_file.add_rt_function(f_rt_functions_oar, "ipow");
+        //std::size_t const pos(f_file.get_current_text_offset());
+        //std::uint8_t buf[] = {
+        //    0xE8,       // CALL disp32(rip)
+        //    0x00,
+        //    0x00,
+        //    0x00,
+        //    0x00,
+        //};
+        //f_file.add_text(buf, sizeof(buf));
+        //f_file.add_relocation(
+        //          "ipow"
+        //        , relocation_t::RELOCATION_RT_32BITS
+        //        , pos + 1
+        //        , f_file.get_current_text_offset());
+
+        if(is_assignment)
         {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOV $imm32, disp8(%rbp)
-                    0xC7,
-                    static_cast<std::uint8_t>(0x45),
-                    static_cast<std::uint8_t>(o),
-                    static_cast<std::uint8_t>(size >>  0),
-                    static_cast<std::uint8_t>(size >>  8),
-                    static_cast<std::uint8_t>(size >> 16),
-                    static_cast<std::uint8_t>(size >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+            generate_store_integer(lhs, register_t::REGISTER_RAX);
+        }
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+}
+
+
+void binary_assembler::generate_atan2(operation::pointer_t op)
+{
+    generate_reg_mem_floating_point(op->get_left_handside(), register_t::REGISTER_XMM0);
+    generate_reg_mem_floating_point(op->get_right_handside(), register_t::REGISTER_XMM1);
+    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_ATAN2);
+    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+}
+
+
+void binary_assembler::generate_imul(operation::pointer_t op)
+{
+    // right now the generate_reg_mem_floating_point() SSE multiply operation
+    // will not properly multiply two integers, just load & convert to integer
+    // and do the product here instead
+    //
+    // we also need to truncate to the integers so we use the MXCSR register
+    // for the feat to be "automatic"
+    //
+    temporary_variable * temp_var(f_file.find_temporary_variable("%mxcsr"));
+    if(temp_var == nullptr)
+    {
+        throw internal_error("temporary \"%mxcsr\" not found in generate_imul()");
+    }
+    if(temp_var->get_size() != sizeof(std::uint32_t) * 2)
+    {
+        throw internal_error("temporary \"%mxcsr\" is not exactly 8 bytes in generate_imul()");
+    }
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // MOV $imm32, disp32(%rbp)
-                    0xC7,
-                    static_cast<std::uint8_t>(0x85),
-                    static_cast<std::uint8_t>(o >>  0),
-                    static_cast<std::uint8_t>(o >>  8),
-                    static_cast<std::uint8_t>(o >> 16),
-                    static_cast<std::uint8_t>(o >> 24),
-                    static_cast<std::uint8_t>(size >>  0),
-                    static_cast<std::uint8_t>(size >>  8),
-                    static_cast<std::uint8_t>(size >> 16),
-                    static_cast<std::uint8_t>(size >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+    // TODO: we may want to add support for disp8, to simplify, at the moment
+    //       I just use disp32 which works in all cases
+    //
+    ssize_t const offset(temp_var->get_offset());
 
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
-            //
-            throw not_implemented("offset size not supported yet in "
-                + temp_var->get_name()
-                + " (type: "
-                + std::to_string(static_cast<int>(get_smallest_size(o)))
-                + " for size: "
-                + std::to_string(o)
-                + ").");
+    {
+        std::uint8_t buf[] = {
+            0x0F,    // STMXCSR %mxcsr, disp32(%rbp)
+            0xAE,
+            0x9D,
+            static_cast<std::uint8_t>(offset >>  0),
+            static_cast<std::uint8_t>(offset >>  8),
+            static_cast<std::uint8_t>(offset >> 16),
+            static_cast<std::uint8_t>(offset >> 24),
 
-        }
+            0x8B,    // MOV disp32(%rbp), %eax
+            0x85,
+            static_cast<std::uint8_t>(offset >>  0),
+            static_cast<std::uint8_t>(offset >>  8),
+            static_cast<std::uint8_t>(offset >> 16),
+            static_cast<std::uint8_t>(offset >> 24),
+
+            0x0D,    // ORW $0x6000, %eax
+            0x00,
+            0x60,
+            0x00,
+            0x00,
+
+            0x89,    // MOV %eax, disp32+4(%rbp)
+            0x85,
+            static_cast<std::uint8_t>((offset + 4) >>  0),
+            static_cast<std::uint8_t>((offset + 4) >>  8),
+            static_cast<std::uint8_t>((offset + 4) >> 16),
+            static_cast<std::uint8_t>((offset + 4) >> 24),
+
+            0x0F,    // LDMXCSR disp32+4(%rip), %mxcsr
+            0xAE,
+            0x95,
+            static_cast<std::uint8_t>((offset + 4) >>  0),
+            static_cast<std::uint8_t>((offset + 4) >>  8),
+            static_cast<std::uint8_t>((offset + 4) >> 16),
+            static_cast<std::uint8_t>((offset + 4) >> 24),
+        };
+        f_file.add_text(buf, sizeof(buf));
     }
 
-    // now save the value in var.f_data
+    generate_reg_mem_floating_point(op->get_left_handside(), register_t::REGISTER_RAX, sse_operation_t::SSE_OPERATION_CVT2I);
+    generate_reg_mem_floating_point(op->get_right_handside(), register_t::REGISTER_RCX, sse_operation_t::SSE_OPERATION_CVT2I);
+
     {
-        ssize_t const o(offset + offsetof(binary_variable, f_data));
-        switch(get_smallest_size(o))
-        {
-        case integer_size_t::INTEGER_SIZE_1BIT:
-        case integer_size_t::INTEGER_SIZE_8BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // REX.W MOV %rn, disp8(%rbp)
-                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                    0x89,
-                    static_cast<std::uint8_t>(0x45 | ((static_cast<int>(reg) & 7) << 3)),
-                    static_cast<std::uint8_t>(o),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+        std::uint8_t buf[] = {
+            0x0F,    // LDMXCSR disp32(%rbp), %mxcsr
+            0xAE,
+            0x95,
+            static_cast<std::uint8_t>(offset >>  0),
+            static_cast<std::uint8_t>(offset >>  8),
+            static_cast<std::uint8_t>(offset >> 16),
+            static_cast<std::uint8_t>(offset >> 24),
 
-        case integer_size_t::INTEGER_SIZE_8BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_SIGNED:
-        case integer_size_t::INTEGER_SIZE_16BITS_UNSIGNED:
-        case integer_size_t::INTEGER_SIZE_32BITS_SIGNED:
-            {
-                std::uint8_t buf[] = {    // REX.W MOV %rn, disp32(%rbp)
-                    static_cast<std::uint8_t>(reg >= register_t::REGISTER_R8 ? 0x49 : 0x48),
-                    0x89,
-                    static_cast<std::uint8_t>(0x85 | ((static_cast<int>(reg) & 7) << 3)),
-                    static_cast<std::uint8_t>(o >>  0),
-                    static_cast<std::uint8_t>(o >>  8),
-                    static_cast<std::uint8_t>(o >> 16),
-                    static_cast<std::uint8_t>(o >> 24),
-                };
-                f_file.add_text(buf, sizeof(buf));
-            }
-            break;
+            0xF7,       // IMUL $ecx, %eax, %edx:%eax   (ignore %edx)
+            0xE9,
 
-        default:
-            // x86-64 only supports disp8 and disp32
-            //
-            // for larger offsets we would need to use an
-            // index register; but we should never go over
-            // disp32 on the stack anyway since it's only 2Mb
+            // TODO: have a store floating point that supports this directly to memory
+            //       i.e. CVTSI2SD %eax, disp(%rip | %rbp)
             //
-            throw not_implemented("offset size not supported yet in "
-                + temp_var->get_name()
-                + " (type: "
-                + std::to_string(static_cast<int>(get_smallest_size(o)))
-                + " for size: "
-                + std::to_string(o)
-                + ").");
-
-        }
+            0xF2,       // CVTSI2SD %eax, %xmm0
+            0x0F,
+            0x2A,
+            0xC0,
+        };
+        f_file.add_text(buf, sizeof(buf));
     }
+
+    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
 }
 
 
-void binary_assembler::generate_math_function(operation::pointer_t op)
+void binary_assembler::generate_sign(operation::pointer_t op)
 {
     data::pointer_t lhs(op->get_left_handside());
-    generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0, sse_operation_t::SSE_OPERATION_CVT2D);
-    external_function_t func(external_function_t::EXTERNAL_FUNCTION_UNKNOWN);
-    switch(op->get_operation())
+
+    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
     {
-    case node_t::NODE_ACOS:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ACOS;
-        break;
+        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
 
-    case node_t::NODE_ACOSH:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ACOSH;
-        break;
+        // NaN and zeroes are returned as is, other numbers return 1.0
+        // with the sign of the input
+        //
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W MOV $0x8000000000000000, %rax
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x80,
 
-    case node_t::NODE_ASIN:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ASIN;
-        break;
+                0x66,       // MOVQ %rax, %xmm1
+                0x48,
+                0x0F,
+                0x6E,
+                0xC8,
 
-    case node_t::NODE_ASINH:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ASINH;
-        break;
+                0x66,       // ANDPD %xmm0, %xmm1       -- sign of input
+                0x0F,
+                0x54,
+                0xC8,
 
-    case node_t::NODE_ATAN:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ATAN;
-        break;
+                0x66,       // MOVAPD %xmm0, %xmm3
+                0x0F,
+                0x28,
+                0xD8,
 
-    case node_t::NODE_ATANH:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ATANH;
-        break;
+                0x66,       // XORPD %xmm1, %xmm3       -- absolute value
+                0x0F,
+                0x57,
+                0xD9,
 
-    case node_t::NODE_CBRT:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_CBRT;
-        break;
+                0x48,       // REX.W MOV $0x3FF0000000000000, %rax
+                0xB8,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0x00,
+                0xF0,
+                0x3F,
 
-    case node_t::NODE_CEIL:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_CEIL;
-        break;
+                0x66,       // MOVQ %rax, %xmm2
+                0x48,
+                0x0F,
+                0x6E,
+                0xD0,
 
-    case node_t::NODE_COS:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_COS;
-        break;
+                0x66,       // ORPD %xmm1, %xmm2        -- +1.0 or -1.0
+                0x0F,
+                0x56,
+                0xD1,
 
-    case node_t::NODE_COSH:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_COSH;
-        break;
+                0x66,       // XORPD %xmm4, %xmm4
+                0x0F,
+                0x57,
+                0xE4,
+
+                0xF2,       // CMPLTSD %xmm3, %xmm4     -- 0.0 < |x| (false for NaN)
+                0x0F,
+                0xC2,
+                0xE3,
+                0x01,
+
+                0x66,       // ANDPD %xmm4, %xmm2
+                0x0F,
+                0x54,
+                0xD4,
+
+                0x66,       // ANDNPD %xmm0, %xmm4
+                0x0F,
+                0x55,
+                0xE0,
+
+                0x66,       // ORPD %xmm2, %xmm4
+                0x0F,
+                0x56,
+                0xE2,
+
+                0x66,       // MOVAPD %xmm4, %xmm0
+                0x0F,
+                0x28,
+                0xC4,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+
+        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+    }
+    else
+    {
+        // this is exactly the same as:
+        //
+        //     lhs <=> 0
+        //
+        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W TEST %rax, %rax
+                0x85,
+                0xC0,
 
-    case node_t::NODE_EXP:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_EXP;
-        break;
+                0x0F,       // SETG %al  --  ((SF XOR OF) OR ZF) = 0
+                0x9F,
+                0xC0,
 
-    case node_t::NODE_EXPM1:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_EXPM1;
-        break;
+                0x0F,       // SETL %cl  --  (SF XOR OF) = 1
+                0x9C,
+                0xC1,
 
-    case node_t::NODE_FLOOR:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_FLOOR;
-        break;
+                0x28,       // SUB %cl, %al
+                0xC8,
 
-    case node_t::NODE_FROUND:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_FROUND;
-        break;
+                0x48,       // REX.W MOVSX %al, %rax
+                0x0F,
+                0xBE,
+                0xC0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
 
-    case node_t::NODE_LOG:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG;
-        break;
+        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    }
+}
 
-    case node_t::NODE_LOG1P:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG1P;
-        break;
 
-    case node_t::NODE_LOG10:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG10;
-        break;
+/** \brief Generate a jump to a label.
+ *
+ * The \p code is the second byte of a Jcc disp32 instruction (i.e. 0x84
+ * for JE). Use 0 to generate an unconditional JMP.
+ *
+ * \param[in] code  The Jcc code or 0 for JMP.
+ * \param[in] label  The label to jump to.
+ */
+void binary_assembler::generate_jump(std::uint8_t code, std::string const & label)
+{
+    std::size_t const pos(f_file.get_current_text_offset());
+    if(code == 0)
+    {
+        std::uint8_t buf[] = {
+            0xE9,       // JMP disp32
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  label
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos + 1
+                , f_file.get_current_text_offset());
+    }
+    else
+    {
+        std::uint8_t buf[] = {
+            0x0F,       // Jcc disp32
+            code,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  label
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos + 2
+                , f_file.get_current_text_offset());
+    }
+}
 
-    case node_t::NODE_LOG2:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_LOG2;
-        break;
 
-    case node_t::NODE_ROUND:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_ROUND;
-        break;
+void binary_assembler::generate_cmp_rax_immediate(std::int64_t value)
+{
+    if(value >= -0x80000000LL && value <= 0x7FFFFFFFLL)
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W CMP $imm32, %rax
+            0x3D,
+            static_cast<std::uint8_t>(value >>  0),
+            static_cast<std::uint8_t>(value >>  8),
+            static_cast<std::uint8_t>(value >> 16),
+            static_cast<std::uint8_t>(value >> 24),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    else
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W MOV $imm64, %rdx
+            0xBA,
+            static_cast<std::uint8_t>(value >>  0),
+            static_cast<std::uint8_t>(value >>  8),
+            static_cast<std::uint8_t>(value >> 16),
+            static_cast<std::uint8_t>(value >> 24),
+            static_cast<std::uint8_t>(value >> 32),
+            static_cast<std::uint8_t>(value >> 40),
+            static_cast<std::uint8_t>(value >> 48),
+            static_cast<std::uint8_t>(value >> 56),
+
+            0x48,       // REX.W CMP %rdx, %rax
+            0x39,
+            0xD0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+}
 
-    case node_t::NODE_SIN:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_SIN;
-        break;
 
-    case node_t::NODE_SINH:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_SINH;
-        break;
+/** \brief Jump through a table.
+ *
+ * The index in %rax must already be known to be valid. The table is
+ * saved in the text section, right after the indirect JMP, and each
+ * entry is the offset of the label relative to the start of the table.
+ * This way the table does not need to be patched when the image is
+ * loaded.
+ *
+ * \param[in] labels  The labels, one per index.
+ */
+void binary_assembler::generate_jump_table(std::vector<std::string> const & labels)
+{
+    ++f_next_label;
+    std::string const table("%switch" + std::to_string(f_next_label));
 
-    case node_t::NODE_SQRT:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_SQRT;
-        break;
+    {
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {
+            0x48,       // REX.W LEA disp32(%rip), %rdx
+            0x8D,
+            0x15,
+            0x00,
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  table
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos + 3
+                , f_file.get_current_text_offset());
+    }
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W MOVSXD (%rdx,%rax,4), %rax
+            0x63,
+            0x04,
+            0x82,
 
-    case node_t::NODE_TAN:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_TAN;
-        break;
+            0x48,       // REX.W ADD %rdx, %rax
+            0x01,
+            0xD0,
 
-    case node_t::NODE_TANH:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_TANH;
-        break;
+            0xFF,       // JMP *%rax
+            0xE0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
 
-    case node_t::NODE_TRUNC:
-        func = external_function_t::EXTERNAL_FUNCTION_MATH_TRUNC;
-        break;
+    f_file.add_label(table);
+    std::size_t const start(f_file.get_current_text_offset());
+    for(auto const & l : labels)
+    {
+        std::size_t const pos(f_file.get_current_text_offset());
+        std::uint8_t buf[] = {
+            0x00,       // label - table
+            0x00,
+            0x00,
+            0x00,
+        };
+        f_file.add_text(buf, sizeof(buf));
+        f_file.add_relocation(
+                  l
+                , relocation_t::RELOCATION_LABEL_32BITS
+                , pos
+                , start);
+    }
+}
 
-    default:
-        throw internal_error("generate_math_function() called with an invalid operator");
 
+/** \brief Generate a binary decision tree.
+ *
+ * The value is expected in %rax and the \p ranges sorted and disjoint.
+ * The tree compares against the middle range and recursively handles
+ * each half. Once only a few ranges remain, they get tested one after
+ * the other.
+ *
+ * \param[in] ranges  The sorted list of ranges.
+ * \param[in] start  The first range to handle.
+ * \param[in] end  The range after the last range to handle.
+ * \param[in] default_label  Where to go when no range matches.
+ */
+void binary_assembler::generate_switch_tree(
+      switch_range::vector_t const & ranges
+    , std::size_t start
+    , std::size_t end
+    , std::string const & default_label)
+{
+    if(end - start <= 3)
+    {
+        for(std::size_t idx(start); idx < end; ++idx)
+        {
+            switch_range const & r(ranges[idx]);
+            if(r.f_low == r.f_high)
+            {
+                generate_cmp_rax_immediate(r.f_low);
+                generate_jump(0x84, r.f_label);     // JE
+            }
+            else
+            {
+                ++f_next_label;
+                std::string const next("%switch" + std::to_string(f_next_label));
+                generate_cmp_rax_immediate(r.f_low);
+                generate_jump(0x8C, next);          // JL
+                generate_cmp_rax_immediate(r.f_high);
+                generate_jump(0x8E, r.f_label);     // JLE
+                f_file.add_label(next);
+            }
+        }
+        generate_jump(0, default_label);
+        return;
     }
-    generate_external_function_call(func);
-    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+
+    std::size_t const middle(start + (end - start) / 2);
+    ++f_next_label;
+    std::string const lower("%switch" + std::to_string(f_next_label));
+    generate_cmp_rax_immediate(ranges[middle].f_low);
+    generate_jump(0x8C, lower);                     // JL
+    generate_switch_tree(ranges, middle, end, default_label);
+    f_file.add_label(lower);
+    generate_switch_tree(ranges, start, middle, default_label);
 }
 
 
-void binary_assembler::generate_power(operation::pointer_t op)
+void binary_assembler::generate_switch_string(
+      data::pointer_t value
+    , data::pointer_t str
+    , std::string const & label)
 {
-    bool const is_assignment(op->get_operation() == node_t::NODE_ASSIGNMENT_POWER);
+    generate_reg_mem_string(value, register_t::REGISTER_RDI);
+    generate_reg_mem_string(str, register_t::REGISTER_RSI);
+    {
+        int const op(static_cast<int>(node_t::NODE_STRICTLY_EQUAL));
+        std::uint8_t buf[] = {   // REX.W MOV $imm32, %rdx  (%rdx = operation)
+            0x48,
+            0xC7,
+            0xC2,
+            static_cast<std::uint8_t>(op >>  0),
+            static_cast<std::uint8_t>(op >>  8),
+            static_cast<std::uint8_t>(op >> 16),
+            static_cast<std::uint8_t>(op >> 24),
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_COMPARE);
+    {
+        std::uint8_t buf[] = {
+            0x48,       // REX.W TEST %rax, %rax
+            0x85,
+            0xC0,
+        };
+        f_file.add_text(buf, sizeof(buf));
+    }
+    generate_jump(0x85, label);     // JNE
+}
 
-    data::pointer_t lhs(op->get_left_handside());
-    data::pointer_t rhs(op->get_right_handside());
 
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
-    {
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-        generate_reg_mem_floating_point(rhs, register_t::REGISTER_XMM1);
+/** \brief Generate the dispatch of a switch() statement.
+ *
+ * The cases of a switch() with constant integers are sorted and:
+ *
+ * \li when dense enough, the value is bounds checked and used as an
+ * index in a jump table;
+ * \li otherwise a balanced binary decision tree is used.
+ *
+ * The cases of a switch() with constant strings are dispatched through
+ * a perfect hash computed here, at compile time: the string gets hashed
+ * at runtime with the selected seed, the hash is used as an index in a
+ * jump table, and the one string found in that slot is compared to make
+ * sure it is a match. With only a few strings, they are compared one
+ * after the other.
+ *
+ * The first case matching a value wins, so duplicates and overlapping
+ * ranges found later are ignored.
+ *
+ * \param[in] op  The NODE_SWITCH operation.
+ */
+void binary_assembler::generate_switch(operation::pointer_t op)
+{
+    constexpr std::size_t const minimum_table_cases = 4;
+    constexpr std::int64_t const maximum_table_size = 4096;
 
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_POW);
+    data::pointer_t value(op->get_left_handside());
+    std::string const & default_label(op->get_label());
+    operation::switch_case::vector_t const & cases(op->get_cases());
+    if(cases.empty())
+    {
+        generate_jump(0, default_label);
+        return;
+    }
 
-        if(is_assignment)
+    bool integers(true);
+    bool strings(true);
+    for(auto const & c : cases)
+    {
+        if(c.f_low->get_data_type() != node_t::NODE_INTEGER
+        || c.f_high->get_data_type() != node_t::NODE_INTEGER)
         {
-            generate_store_floating_point(lhs, register_t::REGISTER_XMM0);
+            integers = false;
+        }
+        if(c.f_low->get_data_type() != node_t::NODE_STRING
+        || c.f_low != c.f_high)
+        {
+            strings = false;
         }
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
     }
-    else
+    if(!integers && !strings)
     {
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RDI);
-        generate_reg_mem_integer(rhs, register_t::REGISTER_RSI);
+        throw not_implemented("switch() with case values other than constant integers or strings is not yet implemented.");
+    }
 
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_IPOW);
+    variable_type_t const type(get_type_of_node(value->get_node()));
+    if(strings)
+    {
+        if(type != VARIABLE_TYPE_STRING)
+        {
+            // a strict equality with a string is always false
+            //
+            generate_jump(0, default_label);
+            return;
+        }
 
-        //f_file.add_rt_function(f_rt_functions_oar, "ipow");
-        //std::size_t const pos(f_file.get_current_text_offset());
-        //std::uint8_t buf[] = {
-        //    0xE8,       // CALL disp32(rip)
-        //    0x00,
-        //    0x00,
-        //    0x00,
-        //    0x00,
-        //};
-        //f_file.add_text(buf, sizeof(buf));
-        //f_file.add_relocation(
-        //          "ipow"
-        //        , relocation_t::RELOCATION_RT_32BITS
-        //        , pos + 1
-        //        , f_file.get_current_text_offset());
+        std::vector<std::pair<std::string, operation::switch_case const *>> keys;
+        for(auto const & c : cases)
+        {
+            std::string const & s(c.f_low->get_string());
+            if(std::find_if(
+                      keys.begin()
+                    , keys.end()
+                    , [&s](auto const & k)
+                    {
+                        return k.first == s;
+                    }) == keys.end())
+            {
+                keys.push_back({s, &c});
+            }
+        }
+
+        // search for a seed giving a perfect hash, try a larger table
+        // if the set is difficult
+        //
+        std::size_t size(1);
+        while(size < keys.size())
+        {
+            size <<= 1;
+        }
+        std::uint64_t seed(0);
+        bool found(false);
+        if(keys.size() >= minimum_table_cases)
+        {
+            std::vector<bool> used;
+            for(std::size_t attempt(0); attempt < 3 && !found; ++attempt, size <<= 1)
+            {
+                for(std::uint64_t idx(1); idx <= 256 && !found; ++idx)
+                {
+                    seed = idx * 0x9E3779B97F4A7C15ULL;
+                    used.assign(size, false);
+                    found = true;
+                    for(auto const & k : keys)
+                    {
+                        std::size_t const slot(hash_switch_string(k.first.c_str(), k.first.length(), seed) & (size - 1));
+                        if(used[slot])
+                        {
+                            found = false;
+                            break;
+                        }
+                        used[slot] = true;
+                    }
+                }
+                if(found)
+                {
+                    break;
+                }
+            }
+        }
+
+        if(!found)
+        {
+            for(auto const & k : keys)
+            {
+                generate_switch_string(value, k.second->f_low, k.second->f_label);
+            }
+            generate_jump(0, default_label);
+            return;
+        }
 
-        if(is_assignment)
+        generate_reg_mem_string(value, register_t::REGISTER_RDI);
         {
-            generate_store_integer(lhs, register_t::REGISTER_RAX);
+            std::uint8_t buf[] = {
+                0x48,       // REX.W MOV $imm64, %rsi
+                0xBE,
+                static_cast<std::uint8_t>(seed >>  0),
+                static_cast<std::uint8_t>(seed >>  8),
+                static_cast<std::uint8_t>(seed >> 16),
+                static_cast<std::uint8_t>(seed >> 24),
+                static_cast<std::uint8_t>(seed >> 32),
+                static_cast<std::uint8_t>(seed >> 40),
+                static_cast<std::uint8_t>(seed >> 48),
+                static_cast<std::uint8_t>(seed >> 56),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_STRINGS_HASH);
+        {
+            std::uint32_t const mask(size - 1);
+            std::uint8_t buf[] = {
+                0x48,       // REX.W AND $imm32, %rax
+                0x25,
+                static_cast<std::uint8_t>(mask >>  0),
+                static_cast<std::uint8_t>(mask >>  8),
+                static_cast<std::uint8_t>(mask >> 16),
+                static_cast<std::uint8_t>(mask >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
         }
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
-    }
-}
-
 
-void binary_assembler::generate_atan2(operation::pointer_t op)
-{
-    generate_reg_mem_floating_point(op->get_left_handside(), register_t::REGISTER_XMM0);
-    generate_reg_mem_floating_point(op->get_right_handside(), register_t::REGISTER_XMM1);
-    generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_ATAN2);
-    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
-}
+        std::vector<std::string> labels(size, default_label);
+        std::vector<operation::switch_case const *> slots(size, nullptr);
+        for(auto const & k : keys)
+        {
+            std::size_t const slot(hash_switch_string(k.first.c_str(), k.first.length(), seed) & (size - 1));
+            ++f_next_label;
+            labels[slot] = "%switch" + std::to_string(f_next_label);
+            slots[slot] = k.second;
+        }
+        generate_jump_table(labels);
 
+        for(std::size_t slot(0); slot < size; ++slot)
+        {
+            if(slots[slot] != nullptr)
+            {
+                f_file.add_label(labels[slot]);
+                generate_switch_string(value, slots[slot]->f_low, slots[slot]->f_label);
+                generate_jump(0, default_label);
+            }
+        }
+        return;
+    }
 
-void binary_assembler::generate_imul(operation::pointer_t op)
-{
-    // right now the generate_reg_mem_floating_point() SSE multiply operation
-    // will not properly multiply two integers, just load & convert to integer
-    // and do the product here instead
-    //
-    // we also need to truncate to the integers so we use the MXCSR register
-    // for the feat to be "automatic"
+    // integer cases: first make the ranges disjoint, the first case
+    // wins so we only keep the parts not already covered
     //
-    temporary_variable * temp_var(f_file.find_temporary_variable("%mxcsr"));
-    if(temp_var == nullptr)
+    std::map<std::int64_t, switch_range> covered;
+    for(auto const & c : cases)
     {
-        throw internal_error("temporary \"%mxcsr\" not found in generate_imul()");
+        std::int64_t low(c.f_low->get_integer().get());
+        std::int64_t const high(c.f_high->get_integer().get());
+        while(low <= high)
+        {
+            auto next(covered.upper_bound(low));
+            if(next != covered.begin())
+            {
+                auto const previous(std::prev(next));
+                if(previous->second.f_high >= low)
+                {
+                    if(previous->second.f_high >= high)
+                    {
+                        break;
+                    }
+                    low = previous->second.f_high + 1;
+                    continue;
+                }
+            }
+            std::int64_t end(high);
+            if(next != covered.end()
+            && next->first <= high)
+            {
+                end = next->first - 1;
+            }
+            covered[low] = { low, end, c.f_label };
+            if(end == high)
+            {
+                break;
+            }
+            low = end + 1;
+        }
     }
-    if(temp_var->get_size() != sizeof(std::uint32_t) * 2)
+    switch_range::vector_t ranges;
+    for(auto const & r : covered)
     {
-        throw internal_error("temporary \"%mxcsr\" is not exactly 8 bytes in generate_imul()");
+        ranges.push_back(r.second);
     }
 
-    // TODO: we may want to add support for disp8, to simplify, at the moment
-    //       I just use disp32 which works in all cases
-    //
-    ssize_t const offset(temp_var->get_offset());
-
+    switch(type)
     {
-        std::uint8_t buf[] = {
-            0x0F,    // STMXCSR %mxcsr, disp32(%rbp)
-            0xAE,
-            0x9D,
-            static_cast<std::uint8_t>(offset >>  0),
-            static_cast<std::uint8_t>(offset >>  8),
-            static_cast<std::uint8_t>(offset >> 16),
-            static_cast<std::uint8_t>(offset >> 24),
+    case VARIABLE_TYPE_INTEGER:
+        generate_reg_mem_integer(value, register_t::REGISTER_RAX);
+        break;
 
-            0x8B,    // MOV disp32(%rbp), %eax
-            0x85,
-            static_cast<std::uint8_t>(offset >>  0),
-            static_cast<std::uint8_t>(offset >>  8),
-            static_cast<std::uint8_t>(offset >> 16),
-            static_cast<std::uint8_t>(offset >> 24),
+    case VARIABLE_TYPE_FLOATING_POINT:
+        // a number matches only if it is an exact integer
+        //
+        generate_reg_mem_floating_point(value, register_t::REGISTER_XMM0);
+        {
+            std::uint8_t buf[] = {
+                0xF2,       // REX.W CVTTSD2SI %xmm0, %rax
+                0x48,
+                0x0F,
+                0x2C,
+                0xC0,
 
-            0x0D,    // ORW $0x6000, %eax
-            0x00,
-            0x60,
-            0x00,
-            0x00,
+                0xF2,       // REX.W CVTSI2SD %rax, %xmm1
+                0x48,
+                0x0F,
+                0x2A,
+                0xC8,
 
-            0x89,    // MOV %eax, disp32+4(%rbp)
-            0x85,
-            static_cast<std::uint8_t>((offset + 4) >>  0),
-            static_cast<std::uint8_t>((offset + 4) >>  8),
-            static_cast<std::uint8_t>((offset + 4) >> 16),
-            static_cast<std::uint8_t>((offset + 4) >> 24),
+                0x66,       // UCOMISD %xmm1, %xmm0
+                0x0F,
+                0x2E,
+                0xC1,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        generate_jump(0x85, default_label);     // JNE
+        generate_jump(0x8A, default_label);     // JP (NaN)
+        break;
+
+    default:
+        // a strict equality with a number is always false
+        //
+        generate_jump(0, default_label);
+        return;
 
-            0x0F,    // LDMXCSR disp32+4(%rip), %mxcsr
-            0xAE,
-            0x95,
-            static_cast<std::uint8_t>((offset + 4) >>  0),
-            static_cast<std::uint8_t>((offset + 4) >>  8),
-            static_cast<std::uint8_t>((offset + 4) >> 16),
-            static_cast<std::uint8_t>((offset + 4) >> 24),
-        };
-        f_file.add_text(buf, sizeof(buf));
     }
 
-    generate_reg_mem_floating_point(op->get_left_handside(), register_t::REGISTER_RAX, sse_operation_t::SSE_OPERATION_CVT2I);
-    generate_reg_mem_floating_point(op->get_right_handside(), register_t::REGISTER_RCX, sse_operation_t::SSE_OPERATION_CVT2I);
+    // use unsigned math to avoid overflows: the span of very large
+    // ranges wraps and we just do not use a table in that case
+    //
+    std::uint64_t const span(static_cast<std::uint64_t>(ranges.back().f_high)
+                           - static_cast<std::uint64_t>(ranges.front().f_low));
+    std::uint64_t count(0);
+    for(auto const & r : ranges)
+    {
+        count += static_cast<std::uint64_t>(r.f_high) - static_cast<std::uint64_t>(r.f_low) + 1;
+    }
+    if(ranges.size() < minimum_table_cases
+    || span >= static_cast<std::uint64_t>(maximum_table_size)
+    || count * 3 < span + 1)
+    {
+        generate_switch_tree(ranges, 0, ranges.size(), default_label);
+        return;
+    }
 
+    std::int64_t const minimum(ranges.front().f_low);
+    if(minimum != 0)
     {
-        std::uint8_t buf[] = {
-            0x0F,    // LDMXCSR disp32(%rbp), %mxcsr
-            0xAE,
-            0x95,
-            static_cast<std::uint8_t>(offset >>  0),
-            static_cast<std::uint8_t>(offset >>  8),
-            static_cast<std::uint8_t>(offset >> 16),
-            static_cast<std::uint8_t>(offset >> 24),
+        if(minimum >= -0x80000000LL && minimum <= 0x7FFFFFFFLL)
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W SUB $imm32, %rax
+                0x2D,
+                static_cast<std::uint8_t>(minimum >>  0),
+                static_cast<std::uint8_t>(minimum >>  8),
+                static_cast<std::uint8_t>(minimum >> 16),
+                static_cast<std::uint8_t>(minimum >> 24),
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+        else
+        {
+            std::uint8_t buf[] = {
+                0x48,       // REX.W MOV $imm64, %rdx
+                0xBA,
+                static_cast<std::uint8_t>(minimum >>  0),
+                static_cast<std::uint8_t>(minimum >>  8),
+                static_cast<std::uint8_t>(minimum >> 16),
+                static_cast<std::uint8_t>(minimum >> 24),
+                static_cast<std::uint8_t>(minimum >> 32),
+                static_cast<std::uint8_t>(minimum >> 40),
+                static_cast<std::uint8_t>(minimum >> 48),
+                static_cast<std::uint8_t>(minimum >> 56),
+
+                0x48,       // REX.W SUB %rdx, %rax
+                0x29,
+                0xD0,
+            };
+            f_file.add_text(buf, sizeof(buf));
+        }
+    }
 
-            0xF7,       // IMUL $ecx, %eax, %edx:%eax   (ignore %edx)
-            0xE9,
+    // values below the minimum wrapped around and are caught by the
+    // unsigned comparison
+    //
+    generate_cmp_rax_immediate(static_cast<std::int64_t>(span));
+    generate_jump(0x87, default_label);     // JA
 
-            // TODO: have a store floating point that supports this directly to memory
-            //       i.e. CVTSI2SD %eax, disp(%rip | %rbp)
-            //
-            0xF2,       // CVTSI2SD %eax, %xmm0
-            0x0F,
-            0x2A,
-            0xC0,
-        };
-        f_file.add_text(buf, sizeof(buf));
+    std::vector<std::string> labels(span + 1, default_label);
+    for(auto const & r : ranges)
+    {
+        for(std::uint64_t v(static_cast<std::uint64_t>(r.f_low) - static_cast<std::uint64_t>(minimum));
+            v <= static_cast<std::uint64_t>(r.f_high) - static_cast<std::uint64_t>(minimum);
+            ++v)
+        {
+            labels[v] = r.f_label;
+        }
     }
-
-    generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+    generate_jump_table(labels);
 }
 
 
-void binary_assembler::generate_sign(operation::pointer_t op)
+/** \brief Call a user function.
+ *
+ * The arguments are loaded in registers as expected by the System V
+ * calling convention (see generate_function()) and the function gets
+ * called with a direct CALL rel32.
+ *
+ * The Double arguments are loaded first since an Integer passed as a
+ * Double goes through %rax. The %r8 and %r9 arguments also go through
+ * %rax, then %rdi to %rcx get loaded directly.
+ *
+ * \param[in] op  The NODE_CALL operation with the function label.
+ */
+void binary_assembler::generate_user_call(operation::pointer_t op)
 {
-    data::pointer_t lhs(op->get_left_handside());
-
-    if(get_type_of_node(op->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+    node::pointer_t function_node(op->get_node()->get_instance());
+    std::vector<variable_type_t> param_types;
+    std::size_t const count(function_node->get_children_size());
+    for(std::size_t idx(0); idx < count; ++idx)
     {
-        generate_reg_mem_floating_point(lhs, register_t::REGISTER_XMM0);
-        generate_external_function_call(external_function_t::EXTERNAL_FUNCTION_MATH_SIGN);
-        generate_store_floating_point(op->get_result(), register_t::REGISTER_XMM0);
+        node::pointer_t parameters(function_node->get_child(idx));
+        if(parameters->get_type() != node_t::NODE_PARAMETERS)
+        {
+            continue;
+        }
+        std::size_t const max(parameters->get_children_size());
+        for(std::size_t p(0); p < max; ++p)
+        {
+            node::pointer_t param(parameters->get_child(p));
+            if(param->get_type() == node_t::NODE_PARAM)
+            {
+                param_types.push_back(get_type_of_node(param));
+            }
+        }
+        break;
     }
-    else
+
+    std::size_t const max(op->get_parameter_size());
+    if(max != param_types.size())
     {
-        // this is exactly the same as:
-        //
-        //     lhs <=> 0
-        //
-        generate_reg_mem_integer(lhs, register_t::REGISTER_RAX);
+        throw internal_error("the number of arguments does not match the number of parameters in generate_user_call().");
+    }
 
+    static register_t const integer_registers[] = {
+        register_t::REGISTER_RDI,
+        register_t::REGISTER_RSI,
+        register_t::REGISTER_RDX,
+        register_t::REGISTER_RCX,
+        register_t::REGISTER_R8,
+        register_t::REGISTER_R9,
+    };
+    std::vector<std::pair<data::pointer_t, register_t>> integer_args;
+    std::size_t floating_point_count(0);
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        data::pointer_t arg(op->get_parameter(idx));
+        switch(param_types[idx])
         {
-            std::uint8_t buf[] = {
-                0x48,       // REX.W TEST %rax, %rax
-                0x85,
-                0xC0,
+        case VARIABLE_TYPE_BOOLEAN:
+        case VARIABLE_TYPE_INTEGER:
+            if(integer_args.size() < std::size(integer_registers))
+            {
+                integer_args.push_back({arg, integer_registers[integer_args.size()]});
+                continue;
+            }
+            break;
 
-                0x0F,       // SETG %al  --  ((SF XOR OF) OR ZF) = 0
-                0x9F,
-                0xC0,
+        case VARIABLE_TYPE_FLOATING_POINT:
+            if(floating_point_count < 8)
+            {
+                generate_load_as_floating_point(arg, static_cast<register_t>(floating_point_count));
+                ++floating_point_count;
+                continue;
+            }
+            break;
 
-                0x0F,       // SETL %cl  --  (SF XOR OF) = 1
-                0x9C,
-                0xC1,
+        default:
+            break;
 
-                0x28,       // SUB %cl, %al
-                0xC8,
+        }
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, op->get_node()->get_position());
+        msg << "binary compilation of argument #"
+            << idx + 1
+            << " of a user function call is not yet implemented (only up to 6 Integer/Boolean and 8 Double parameters are supported).";
+        throw not_implemented(msg.str());
+    }
 
-                0x48,       // REX.W MOVSX %al, %rax
-                0x0F,
-                0xBE,
-                0xC0,
+    for(auto const & it : integer_args)
+    {
+        if(it.second >= register_t::REGISTER_R8)
+        {
+            generate_reg_mem_integer(it.first, register_t::REGISTER_RAX);
+            std::uint8_t const buf[] = {    // MOV %rax, %r8 or %r9
+                0x49,
+                0x89,
+                static_cast<std::uint8_t>(0xC0 | (static_cast<int>(it.second) & 7)),
             };
             f_file.add_text(buf, sizeof(buf));
         }
+    }
+    for(auto const & it : integer_args)
+    {
+        if(it.second < register_t::REGISTER_R8)
+        {
+            generate_reg_mem_integer(it.first, it.second);
+        }
+    }
 
-        generate_store_integer(op->get_result(), register_t::REGISTER_RAX);
+    std::size_t const pos(f_file.get_current_text_offset());
+    std::uint8_t call[] = {
+        0xE8,       // CALL disp32
+        0x00,
+        0x00,
+        0x00,
+        0x00,
+    };
+    f_file.add_text(call, sizeof(call));
+    f_file.add_relocation(
+              op->get_label()
+            , relocation_t::RELOCATION_LABEL_32BITS
+            , pos + 1
+            , f_file.get_current_text_offset());
+
+    data::pointer_t result(op->get_result());
+    if(result != nullptr)
+    {
+        if(get_type_of_node(result->get_node()) == VARIABLE_TYPE_FLOATING_POINT)
+        {
+            generate_store_floating_point(result, register_t::REGISTER_XMM0);
+        }
+        else
+        {
+            generate_store_integer(result, register_t::REGISTER_RAX);
+        }
     }
 }
 
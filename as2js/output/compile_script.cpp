@@ -0,0 +1,123 @@
+// Copyright (c) 2005-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/as2js
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// self
+//
+#include    "as2js/binary.h"
+
+#include    "as2js/compiler.h"
+#include    "as2js/message.h"
+#include    "as2js/parser.h"
+
+
+// C++
+//
+#include    <sstream>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace as2js
+{
+
+
+
+/** \brief Compile a script in memory.
+ *
+ * This function parses, compiles, and assembles \p source and returns
+ * a running_file ready to run. The binary is never saved to a file.
+ * This is useful for services compiling small expressions at runtime.
+ *
+ * The returned running_file is used like one loaded from a file: set
+ * the variables, then call run(), or create one execution context per
+ * thread with create_context().
+ *
+ * \param[in] source  The source of the script.
+ * \param[in] o  The options used to compile the script. If null, the
+ * default options are used.
+ *
+ * \return The running_file or a null pointer if the script has errors.
+ */
+running_file::pointer_t compile_script(std::string const & source, options::pointer_t o)
+{
+    if(o == nullptr)
+    {
+        o = std::make_shared<options>();
+    }
+
+    input_stream<std::stringstream>::pointer_t in(std::make_shared<input_stream<std::stringstream>>());
+    in->str(source);
+
+    int const save_errcnt(error_count());
+    parser::pointer_t p(std::make_shared<parser>(in, o));
+    node::pointer_t root(p->parse());
+    if(root == nullptr
+    || error_count() != save_errcnt)
+    {
+        return running_file::pointer_t();
+    }
+
+    return compile_script(root, o);
+}
+
+
+/** \brief Compile a parsed script in memory.
+ *
+ * This function compiles and assembles the tree returned by the parser
+ * and returns a running_file ready to run.
+ *
+ * \param[in] root  The tree returned by parser::parse().
+ * \param[in] o  The options used to compile the script. If null, the
+ * default options are used.
+ *
+ * \return The running_file or a null pointer if the script has errors.
+ */
+running_file::pointer_t compile_script(node::pointer_t root, options::pointer_t o)
+{
+    if(o == nullptr)
+    {
+        o = std::make_shared<options>();
+    }
+
+    compiler::pointer_t c(std::make_shared<compiler>(o));
+    if(c->compile(root) != 0)
+    {
+        return running_file::pointer_t();
+    }
+
+    binary_assembler::pointer_t binary(std::make_shared<binary_assembler>(
+                                          base_stream::pointer_t()
+                                        , o
+                                        , c));
+    running_file::pointer_t file(std::make_shared<running_file>());
+    if(binary->output(root, *file) != 0)
+    {
+        return running_file::pointer_t();
+    }
+
+    return file;
+}
+
+
+
+} // namespace as2js
+// vim: ts=4 sw=4 et
@@ -0,0 +1,329 @@
+// Copyright (c) 2005-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/as2js
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// self
+//
+#include    "as2js/output.h"
+
+#include    "as2js/optimizer.h"
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace as2js
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Size of the expressions which get inlined.
+ *
+ * An expression function with more nodes than this limit only gets
+ * inlined when marked with the "inline" attribute.
+ */
+constexpr std::size_t const     INLINE_EXPRESSION_MAX_NODES = 24;
+
+
+std::size_t count_nodes(node::pointer_t n)
+{
+    std::size_t result(1);
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        result += count_nodes(n->get_child(idx));
+    }
+    return result;
+}
+
+
+std::size_t count_uses(node::pointer_t n, node::pointer_t param)
+{
+    if(n->get_type() == node_t::NODE_IDENTIFIER)
+    {
+        return n->get_instance() == param ? 1 : 0;
+    }
+
+    std::size_t result(0);
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        result += count_uses(n->get_child(idx), param);
+    }
+    return result;
+}
+
+
+/** \brief Replace the parameters with the arguments.
+ *
+ * \param[in] n  The expression being inlined.
+ * \param[in] params  The parameters of the function.
+ * \param[in] args  The arguments of the call, one per parameter.
+ *
+ * \return \p n or the argument replacing \p n.
+ */
+node::pointer_t substitute(
+      node::pointer_t n
+    , node::vector_of_pointers_t const & params
+    , node::pointer_t args)
+{
+    if(n->get_type() == node_t::NODE_IDENTIFIER)
+    {
+        node::pointer_t instance(n->get_instance());
+        for(std::size_t idx(0); idx < params.size(); ++idx)
+        {
+            if(params[idx] == instance)
+            {
+                return args->get_child(idx)->clone_tree();
+            }
+        }
+        return n;
+    }
+
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        node::pointer_t child(n->get_child(idx));
+        node::pointer_t replacement(substitute(child, params, args));
+        if(replacement != child)
+        {
+            n->set_child(idx, replacement);
+        }
+    }
+    return n;
+}
+
+
+/** \brief Give a type to the literals created by the optimizer.
+ *
+ * The optimizer creates new literals when it folds an expression.
+ * Those do not have a type yet and the binary assembler needs one.
+ *
+ * \param[in] n  The node to check.
+ * \param[in] c  The compiler used to resolve the internal types.
+ */
+void type_literals(node::pointer_t n, compiler::pointer_t c)
+{
+    if(n->get_type_node() == nullptr)
+    {
+        char const * type(nullptr);
+        switch(n->get_type())
+        {
+        case node_t::NODE_FALSE:
+        case node_t::NODE_TRUE:
+            type = "Boolean";
+            break;
+
+        case node_t::NODE_INTEGER:
+            type = "Integer";
+            break;
+
+        case node_t::NODE_FLOATING_POINT:
+            type = "Double";
+            break;
+
+        case node_t::NODE_STRING:
+            type = "String";
+            break;
+
+        default:
+            break;
+
+        }
+        if(type != nullptr)
+        {
+            node::pointer_t resolution;
+            c->resolve_internal_type(n, type, resolution);
+            n->set_type_node(resolution);
+        }
+    }
+
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        type_literals(n->get_child(idx), c);
+    }
+}
+
+
+/** \brief Inline a call to an expression function.
+ *
+ * An expression function is a function which body is a single
+ * `return <expression>;` statement. The call gets replaced by a copy
+ * of the expression where the parameters are replaced with the
+ * arguments. The result then goes through the optimizer so calls with
+ * literal arguments get folded (i.e. `to_cm(3)` becomes `7.62`).
+ *
+ * The call is left alone if:
+ *
+ * \li the expression or one of the arguments has side effects;
+ * \li an argument which is not a literal or a variable is used more
+ *     than once (it would be computed more than once);
+ * \li the type of an argument or of the expression does not exactly
+ *     match the type of the parameter or of the call since the inlined
+ *     expression would not be computed the same way;
+ * \li the expression is larger than INLINE_EXPRESSION_MAX_NODES and
+ *     the function is not marked "inline".
+ *
+ * \param[in] call  The NODE_CALL to inline.
+ * \param[in] c  The compiler used to resolve the internal types.
+ */
+void inline_call(node::pointer_t call, compiler::pointer_t c)
+{
+    if(call->get_children_size() != 2
+    || call->get_child(0)->get_type() != node_t::NODE_IDENTIFIER)
+    {
+        return;
+    }
+
+    node::pointer_t function_node(call->get_instance());
+    if(function_node == nullptr
+    || function_node->get_type() != node_t::NODE_FUNCTION
+    || function_node->get_attribute(attribute_t::NODE_ATTR_NATIVE))
+    {
+        return;
+    }
+
+    node::pointer_t body(function_node->find_first_child(node_t::NODE_DIRECTIVE_LIST));
+    if(body == nullptr
+    || body->get_children_size() != 1)
+    {
+        return;
+    }
+    node::pointer_t return_node(body->get_child(0));
+    if(return_node->get_type() != node_t::NODE_RETURN
+    || return_node->get_children_size() != 1)
+    {
+        return;
+    }
+    node::pointer_t expr(return_node->get_child(0));
+    if(expr->has_side_effects()
+    || expr->get_type_node() == nullptr
+    || expr->get_type_node() != call->get_type_node())
+    {
+        return;
+    }
+    if(!function_node->get_attribute(attribute_t::NODE_ATTR_INLINE)
+    && count_nodes(expr) > INLINE_EXPRESSION_MAX_NODES)
+    {
+        return;
+    }
+
+    node::vector_of_pointers_t params;
+    node::pointer_t parameters(function_node->find_first_child(node_t::NODE_PARAMETERS));
+    if(parameters != nullptr)
+    {
+        std::size_t const max(parameters->get_children_size());
+        for(std::size_t idx(0); idx < max; ++idx)
+        {
+            node::pointer_t param(parameters->get_child(idx));
+            if(param->get_type() != node_t::NODE_PARAM)
+            {
+                continue;
+            }
+            if(param->get_flag(flag_t::NODE_PARAM_FLAG_REST))
+            {
+                return;
+            }
+            params.push_back(param);
+        }
+    }
+
+    node::pointer_t args(call->get_child(1));
+    if(args->get_children_size() != params.size())
+    {
+        return;
+    }
+    for(std::size_t idx(0); idx < params.size(); ++idx)
+    {
+        node::pointer_t arg(args->get_child(idx));
+        if(arg->has_side_effects()
+        || arg->get_type_node() != params[idx]->get_type_node())
+        {
+            return;
+        }
+        if(!arg->is_literal()
+        && arg->get_type() != node_t::NODE_IDENTIFIER
+        && count_uses(expr, params[idx]) > 1)
+        {
+            return;
+        }
+    }
+
+    node::pointer_t parent(call->get_parent());
+    std::size_t const offset(call->get_offset());
+
+    call->replace_with(substitute(expr->clone_tree(), params, args));
+
+    node::pointer_t replacement(parent->get_child(offset));
+    optimizer::optimize(replacement);
+    type_literals(parent->get_child(offset), c);
+}
+
+
+void inline_tree(node::pointer_t n, compiler::pointer_t c)
+{
+    // replacing a call does not change the number of children
+    //
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        inline_tree(n->get_child(idx), c);
+    }
+
+    if(n->get_type() == node_t::NODE_CALL)
+    {
+        inline_call(n, c);
+    }
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Inline the small expression functions.
+ *
+ * This pass runs on the compiled tree, just before flatten(). It
+ * replaces the calls to small functions written as a single return
+ * statement (getters, unit conversions, etc.) with their expression.
+ *
+ * The larger functions marked "inline" or called with literal arguments
+ * get inlined by flatten_nodes instead, since their statements need
+ * to be renamed in their new scope.
+ *
+ * \param[in] root  The root of the tree to optimize.
+ * \param[in] c  The compiler which was used to compile \p root.
+ */
+void inline_functions(node::pointer_t root, compiler::pointer_t c)
+{
+    inline_tree(root, c);
+}
+
+
+
+} // namespace as2js
+// vim: ts=4 sw=4 et
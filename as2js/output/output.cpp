@@ -29,6 +29,12 @@
 #include    <snapdev/not_reached.h>
 
 
+// C++
+//
+#include    <algorithm>
+#include    <cmath>
+
+
 // last include
 //
 #include    <snapdev/poison.h>
@@ -40,6 +46,232 @@ namespace as2js
 
 
 
+namespace
+{
+
+
+
+/** \brief Size of the functions which get inlined.
+ *
+ * A function with a body of at most INLINE_MAX_NODES nodes gets
+ * inlined. When at least one of the arguments is a literal, the
+ * function gets specialized with up to INLINE_SPECIALIZE_MAX_NODES
+ * nodes since the literal often makes a good part of the code go away.
+ * A function marked "inline" always gets inlined.
+ */
+constexpr std::size_t const     INLINE_MAX_NODES = 40;
+constexpr std::size_t const     INLINE_SPECIALIZE_MAX_NODES = 160;
+
+
+std::size_t count_nodes(node::pointer_t n)
+{
+    std::size_t result(1);
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        result += count_nodes(n->get_child(idx));
+    }
+    return result;
+}
+
+
+bool is_modified(node::pointer_t n, node::pointer_t param)
+{
+    switch(n->get_type())
+    {
+    case node_t::NODE_ASSIGNMENT:
+    case node_t::NODE_ASSIGNMENT_ADD:
+    case node_t::NODE_ASSIGNMENT_BITWISE_AND:
+    case node_t::NODE_ASSIGNMENT_BITWISE_OR:
+    case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
+    case node_t::NODE_ASSIGNMENT_DIVIDE:
+    case node_t::NODE_ASSIGNMENT_LOGICAL_AND:
+    case node_t::NODE_ASSIGNMENT_LOGICAL_OR:
+    case node_t::NODE_ASSIGNMENT_LOGICAL_XOR:
+    case node_t::NODE_ASSIGNMENT_MAXIMUM:
+    case node_t::NODE_ASSIGNMENT_MINIMUM:
+    case node_t::NODE_ASSIGNMENT_MODULO:
+    case node_t::NODE_ASSIGNMENT_MULTIPLY:
+    case node_t::NODE_ASSIGNMENT_POWER:
+    case node_t::NODE_ASSIGNMENT_ROTATE_LEFT:
+    case node_t::NODE_ASSIGNMENT_ROTATE_RIGHT:
+    case node_t::NODE_ASSIGNMENT_SHIFT_LEFT:
+    case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT:
+    case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT_UNSIGNED:
+    case node_t::NODE_ASSIGNMENT_SUBTRACT:
+    case node_t::NODE_DECREMENT:
+    case node_t::NODE_INCREMENT:
+    case node_t::NODE_POST_DECREMENT:
+    case node_t::NODE_POST_INCREMENT:
+        if(n->get_children_size() > 0
+        && n->get_child(0)->get_type() == node_t::NODE_IDENTIFIER
+        && n->get_child(0)->get_instance() == param)
+        {
+            return true;
+        }
+        break;
+
+    default:
+        break;
+
+    }
+
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        if(is_modified(n->get_child(idx), param))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/** \brief Size of the arms of a `?:` computed without a branch.
+ *
+ * When both arms of a conditional are cheap, both get computed and the
+ * result gets selected with a CMOVcc. A mispredicted branch costs more
+ * than computing a few additional operations. Larger arms keep the
+ * branches.
+ */
+constexpr std::size_t const     CONDITIONAL_SELECT_MAX_NODES = 8;
+
+
+bool is_numeric_type(node::pointer_t n)
+{
+    node::pointer_t type(n->get_type_node());
+    if(type == nullptr)
+    {
+        return false;
+    }
+    std::string const & name(type->get_string());
+    return name == "Integer"
+        || name == "Double"
+        || name == "Number"
+        || name == "Boolean";
+}
+
+
+/** \brief Check whether an expression can be computed unconditionally.
+ *
+ * The expression must only be composed of literals, variables, and
+ * operators which cannot fail. The division and modulo are excluded
+ * since a division by zero in the arm which is not selected would
+ * trap. The calls, the power, and the member accesses are expensive
+ * (or may call a getter) so they also keep the branches.
+ *
+ * \param[in] n  The expression to check.
+ * \param[in,out] count  The number of nodes found so far.
+ *
+ * \return true if the expression is cheap.
+ */
+bool is_cheap_expression(node::pointer_t n, std::size_t & count)
+{
+    ++count;
+    if(count > CONDITIONAL_SELECT_MAX_NODES
+    || !is_numeric_type(n))
+    {
+        return false;
+    }
+
+    switch(n->get_type())
+    {
+    case node_t::NODE_FALSE:
+    case node_t::NODE_FLOATING_POINT:
+    case node_t::NODE_INTEGER:
+    case node_t::NODE_TRUE:
+        return true;
+
+    case node_t::NODE_IDENTIFIER:
+        {
+            node::pointer_t instance(n->get_instance());
+            return instance != nullptr
+                && (instance->get_type() == node_t::NODE_VARIABLE
+                    || instance->get_type() == node_t::NODE_PARAM);
+        }
+
+    case node_t::NODE_ADD:
+    case node_t::NODE_BITWISE_AND:
+    case node_t::NODE_BITWISE_NOT:
+    case node_t::NODE_BITWISE_OR:
+    case node_t::NODE_BITWISE_XOR:
+    case node_t::NODE_EQUAL:
+    case node_t::NODE_GREATER:
+    case node_t::NODE_GREATER_EQUAL:
+    case node_t::NODE_LESS:
+    case node_t::NODE_LESS_EQUAL:
+    case node_t::NODE_LOGICAL_NOT:
+    case node_t::NODE_MAXIMUM:
+    case node_t::NODE_MINIMUM:
+    case node_t::NODE_MULTIPLY:
+    case node_t::NODE_NOT_EQUAL:
+    case node_t::NODE_ROTATE_LEFT:
+    case node_t::NODE_ROTATE_RIGHT:
+    case node_t::NODE_SHIFT_LEFT:
+    case node_t::NODE_SHIFT_RIGHT:
+    case node_t::NODE_SHIFT_RIGHT_UNSIGNED:
+    case node_t::NODE_STRICTLY_EQUAL:
+    case node_t::NODE_STRICTLY_NOT_EQUAL:
+    case node_t::NODE_SUBTRACT:
+        break;
+
+    default:
+        return false;
+
+    }
+
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        if(!is_cheap_expression(n->get_child(idx), count))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** \brief Check whether a `?:` can be transformed in a select.
+ *
+ * Both arms must be cheap, without side effects, and of the same
+ * numeric type. The condition must be a Boolean which is not a
+ * literal (the optimizer already removes those conditionals).
+ *
+ * \param[in] n  The NODE_CONDITIONAL to check.
+ *
+ * \return true if the conditional can be computed without branches.
+ */
+bool is_select_candidate(node::pointer_t n)
+{
+    if(n->get_children_size() != 3)
+    {
+        return false;
+    }
+
+    node::pointer_t condition(n->get_child(0));
+    node::pointer_t if_true(n->get_child(1));
+    node::pointer_t if_false(n->get_child(2));
+    if(condition->is_literal()
+    || condition->get_type_node() == nullptr
+    || condition->get_type_node()->get_string() != "Boolean"
+    || if_true->get_type_node() != if_false->get_type_node()
+    || if_true->has_side_effects()
+    || if_false->has_side_effects())
+    {
+        return false;
+    }
+
+    std::size_t count(0);
+    return is_cheap_expression(if_true, count)
+        && is_cheap_expression(if_false, count);
+}
+
+
+
+} // no name namespace
+
 
 
 
@@ -59,10 +291,18 @@ void flatten_nodes::run()
     // that case -- since we are in control of handling the result
     // in the run() function, from the outside, this is transparent
     //
-    if(!f_operations.empty())
+    // (labels and branches do not have a result, skip them)
+    //
+    auto last_operation(std::find_if(
+              f_operations.rbegin()
+            , f_operations.rend()
+            , [](operation::pointer_t const & op)
+            {
+                return op->get_result() != nullptr;
+            }));
+    if(last_operation != f_operations.rend())
     {
-        operation::pointer_t last_operation(f_operations.back());
-        data::pointer_t result(last_operation->get_result());
+        data::pointer_t result((*last_operation)->get_result());
         node::pointer_t var(result->get_node());
         var->set_flag(flag_t::NODE_VARIABLE_FLAG_TEMPORARY, false);
         var->set_attribute(attribute_t::NODE_ATTR_EXTERN, true);
@@ -98,22 +338,12 @@ data::pointer_t flatten_nodes::node_to_operation(node::pointer_t n, bool force_f
     //       to know which one we're referring (i.e. we can have many
     //       variables with the same name, just different scopes)
     //
-    std::size_t const max_variables(n->get_variable_size());
-    for(std::size_t idx(0); idx < max_variables; ++idx)
+    // the variables of a function are declared once its scope was
+    // created, see function_directive()
+    //
+    if(n->get_type() != node_t::NODE_FUNCTION)
     {
-        node::pointer_t var(n->get_variable(idx));
-        std::string const & name(var->get_string());
-        if(f_variables.find(name) != f_variables.end())
-        {
-            message msg(message_level_t::MESSAGE_LEVEL_ERROR, err_code_t::AS_ERR_INVALID_EXPRESSION, n->get_position());
-            msg << "found multiple declarations of variable \""
-                << name
-                << "\".";
-        }
-        else
-        {
-            f_variables[name] = std::make_shared<data>(var);
-        }
+        declare_variables(n);
     }
 
     switch(n->get_type())
@@ -431,6 +661,46 @@ std::cerr << "--------------------------------------------- this print ends\n";
         //       <true expr> and <false expr> respectively so we
         //       cannot have it just once after the 'after:' label
         //       (the expr could return something else than rax too)
+        //
+        // when both expressions are cheap and without side effects, they
+        // both get computed and a single NODE_CONDITIONAL operation selects
+        // the result (see is_select_candidate())
+        //
+        if(is_select_candidate(n))
+        {
+            std::string temp("%temp");
+            ++f_next_temp_var;
+            temp += std::to_string(f_next_temp_var);
+            node::pointer_t var(n->create_replacement(node_t::NODE_VARIABLE));
+            var->set_flag(flag_t::NODE_VARIABLE_FLAG_TEMPORARY, true);
+            if(force_full_variable)
+            {
+                var->set_flag(flag_t::NODE_VARIABLE_FLAG_VARIABLE, true);
+            }
+            var->set_type_node(n->get_child(1)->get_type_node());
+            var->set_string(temp);
+            data::pointer_t result(std::make_shared<data>(var));
+            f_variables[temp] = result;
+
+            // compute the condition last so a comparison can be fused
+            // with the select; it has to be first if it has side effects
+            //
+            operation::pointer_t op(std::make_shared<operation>(node_t::NODE_CONDITIONAL, n));
+            bool const condition_first(n->get_child(0)->has_side_effects());
+            if(condition_first)
+            {
+                op->set_left_handside(node_to_operation(n->get_child(0)));
+            }
+            op->set_right_handside(node_to_operation(n->get_child(1)));
+            op->add_additional_parameter(node_to_operation(n->get_child(2)));
+            if(!condition_first)
+            {
+                op->set_left_handside(node_to_operation(n->get_child(0)));
+            }
+            op->set_result(result);
+            f_operations.push_back(op);
+            return result;
+        }
         {
             std::string after(".L");
             ++f_next_label;
@@ -568,6 +838,17 @@ std::cerr << "--------------------------------------------- this print ends\n";
             node::pointer_t lhs(n->get_child(0));
             node::pointer_t rhs(n->get_child(1));
 
+            if(lhs->get_type() == node_t::NODE_IDENTIFIER)
+            {
+                node::pointer_t function_node(n->get_instance());
+                if(function_node != nullptr
+                && function_node->get_type() == node_t::NODE_FUNCTION
+                && !function_node->get_attribute(attribute_t::NODE_ATTR_NATIVE))
+                {
+                    return user_call(n, function_node);
+                }
+            }
+
             node::pointer_t object;
             node::pointer_t object_instance;
             node::pointer_t field;
@@ -1074,7 +1355,6 @@ std::cerr << "--------------------------------------------- this print ends\n";
     case node_t::NODE_ARRAY_LITERAL:
     case node_t::NODE_ASYNC:
     case node_t::NODE_AWAIT:
-    case node_t::NODE_BREAK:
     case node_t::NODE_BYTE:
     case node_t::NODE_CASE:
     case node_t::NODE_CATCH:
@@ -1082,15 +1362,10 @@ std::cerr << "--------------------------------------------- this print ends\n";
     case node_t::NODE_CLASS:
     case node_t::NODE_COALESCE:
     case node_t::NODE_CONST:
-    case node_t::NODE_CONTINUE:
     case node_t::NODE_DEBUGGER:
     case node_t::NODE_DEFAULT:
     case node_t::NODE_DELETE:
-    case node_t::NODE_DO:
-    case node_t::NODE_FOR:
-    case node_t::NODE_FUNCTION:
     case node_t::NODE_GOTO:
-    case node_t::NODE_IF:
     case node_t::NODE_IMPLEMENTS:
     case node_t::NODE_IMPORT:
     case node_t::NODE_IN:
@@ -1100,7 +1375,6 @@ std::cerr << "--------------------------------------------- this print ends\n";
     case node_t::NODE_INTERFACE:
     case node_t::NODE_INVARIANT:
     case node_t::NODE_IS:
-    case node_t::NODE_LABEL:
     case node_t::NODE_LONG:
     case node_t::NODE_MATCH:
     case node_t::NODE_NAME:
@@ -1119,7 +1393,49 @@ std::cerr << "--------------------------------------------- this print ends\n";
         }
 
     case node_t::NODE_VAR:
-        // just ignore these nodes
+        // the variables were declared by their parent, here we only
+        // need to initialize them
+        //
+        var_directive(n);
+        break;
+
+    case node_t::NODE_LABEL:
+        // a break or continue referencing this label was already
+        // attached to its loop by the compiler (see get_goto_exit())
+        //
+        break;
+
+    case node_t::NODE_IF:
+        if_directive(n);
+        break;
+
+    case node_t::NODE_WHILE:
+        while_directive(n);
+        break;
+
+    case node_t::NODE_DO:
+        do_directive(n);
+        break;
+
+    case node_t::NODE_FOR:
+        for_directive(n);
+        break;
+
+    case node_t::NODE_SWITCH:
+        switch_directive(n);
+        break;
+
+    case node_t::NODE_FUNCTION:
+        function_directive(n);
+        break;
+
+    case node_t::NODE_RETURN:
+        return_directive(n);
+        break;
+
+    case node_t::NODE_BREAK:
+    case node_t::NODE_CONTINUE:
+        break_continue(n);
         break;
 
     case node_t::NODE_ABSOLUTE_VALUE:   // we generate one of those from here, but not the compiler so we should never see it here
@@ -1186,7 +1502,6 @@ std::cerr << "--------------------------------------------- this print ends\n";
     case node_t::NODE_REGULAR_EXPRESSION:
     case node_t::NODE_REQUIRE:
     case node_t::NODE_REST:
-    case node_t::NODE_RETURN:
     case node_t::NODE_ROUND:
     case node_t::NODE_SCOPE:
     case node_t::NODE_SEMICOLON:
@@ -1198,7 +1513,6 @@ std::cerr << "--------------------------------------------- this print ends\n";
     case node_t::NODE_SQRT:
     case node_t::NODE_STATIC:
     case node_t::NODE_SUPER:
-    case node_t::NODE_SWITCH:
     case node_t::NODE_SYNCHRONIZED:
     case node_t::NODE_TAN:
     case node_t::NODE_TANH:
@@ -1223,7 +1537,6 @@ std::cerr << "--------------------------------------------- this print ends\n";
     case node_t::NODE_VIDENTIFIER:
     case node_t::NODE_VOID:
     case node_t::NODE_VOLATILE:
-    case node_t::NODE_WHILE:
     case node_t::NODE_WITH:
     case node_t::NODE_YIELD:
     case node_t::NODE_other:
@@ -1239,25 +1552,987 @@ std::cerr << "--------------------------------------------- this print ends\n";
 }
 
 
-node::pointer_t flatten_nodes::get_root() const
-{
-    return f_root;
-}
-
-
-operation::list_t const & flatten_nodes::get_operations() const
-{
-    return f_operations;
-}
-
-
-data::list_t const & flatten_nodes::get_data() const
+void flatten_nodes::declare_variables(node::pointer_t n)
 {
-    return f_data;
-}
-
-
-void flatten_nodes::add_variable(data::pointer_t var)
+    std::size_t const max_variables(n->get_variable_size());
+    for(std::size_t idx(0); idx < max_variables; ++idx)
+    {
+        node::pointer_t var(n->get_variable(idx));
+        std::string const & name(var->get_string());
+        if(f_current_function != nullptr)
+        {
+            // local variables live in the stack frame of the function
+            // (a local may shadow a variable of the same name, including
+            // one of the caller when the function gets inlined)
+            //
+            data::pointer_t local(new_temporary(var, "%local", var->get_type_node()));
+            f_variables[name] = local;
+            zero_local(var, local);
+        }
+        else if(f_variables.find(name) != f_variables.end())
+        {
+            message msg(message_level_t::MESSAGE_LEVEL_ERROR, err_code_t::AS_ERR_INVALID_EXPRESSION, n->get_position());
+            msg << "found multiple declarations of variable \""
+                << name
+                << "\".";
+        }
+        else
+        {
+            f_variables[name] = std::make_shared<data>(var);
+        }
+    }
+}
+
+
+/** \brief Initialize a local number to zero.
+ *
+ * The locals of a function are temporaries on the stack so they have
+ * to be initialized explicitly. Locals with an initializer and
+ * non-numeric locals (i.e. strings get initialized by the binary
+ * assembler) are ignored.
+ *
+ * \param[in] var  The NODE_VARIABLE declaring the local.
+ * \param[in] local  The temporary representing the local.
+ */
+void flatten_nodes::zero_local(node::pointer_t var, data::pointer_t local)
+{
+    node::pointer_t type(var->get_type_node());
+    if(type == nullptr
+    || var->find_first_child(node_t::NODE_SET) != nullptr)
+    {
+        return;
+    }
+
+    node::pointer_t zero;
+    std::string const & type_name(type->get_string());
+    if(type_name == "Integer")
+    {
+        zero = var->create_replacement(node_t::NODE_INTEGER);
+        zero->set_integer(0);
+    }
+    else if(type_name == "Double" || type_name == "Number")
+    {
+        zero = var->create_replacement(node_t::NODE_FLOATING_POINT);
+        zero->set_floating_point(0.0);
+    }
+    else if(type_name == "Boolean")
+    {
+        zero = var->create_replacement(node_t::NODE_FALSE);
+    }
+    else
+    {
+        return;
+    }
+    zero->set_type_node(type);
+
+    add_assignment(var, local, node_to_operation(zero));
+}
+
+
+/** \brief Add an assignment operation.
+ *
+ * \code
+ *     lhs := rhs
+ * \endcode
+ *
+ * \param[in] n  The node used for the position and the type.
+ * \param[in] lhs  The variable being assigned.
+ * \param[in] rhs  The value to assign.
+ */
+void flatten_nodes::add_assignment(node::pointer_t n, data::pointer_t lhs, data::pointer_t rhs)
+{
+    data::pointer_t result(new_temporary(n, "%temp", lhs->get_node()->get_type_node()));
+
+    node::pointer_t assignment(n->create_replacement(node_t::NODE_ASSIGNMENT));
+    assignment->set_type_node(lhs->get_node()->get_type_node());
+    operation::pointer_t op(std::make_shared<operation>(node_t::NODE_ASSIGNMENT, assignment));
+    op->set_left_handside(lhs);
+    op->set_right_handside(rhs);
+    op->set_result(result);
+    f_operations.push_back(op);
+}
+
+
+std::string flatten_nodes::new_label()
+{
+    ++f_next_label;
+    return ".L" + std::to_string(f_next_label);
+}
+
+
+void flatten_nodes::add_label(node::pointer_t n, std::string const & label)
+{
+    node::pointer_t label_node(n->create_replacement(node_t::NODE_LABEL));
+    operation::pointer_t op(std::make_shared<operation>(node_t::NODE_LABEL, label_node));
+    op->set_label(label);
+    f_operations.push_back(op);
+}
+
+
+void flatten_nodes::add_goto(node::pointer_t n, std::string const & label)
+{
+    node::pointer_t goto_node(n->create_replacement(node_t::NODE_GOTO));
+    operation::pointer_t op(std::make_shared<operation>(node_t::NODE_GOTO, goto_node));
+    op->set_label(label);
+    f_operations.push_back(op);
+}
+
+
+/** \brief Add a conditional branch.
+ *
+ * This function computes \p condition and jumps to \p label when the
+ * result is \p jump_when.
+ *
+ * When the condition is a constant, the branch is resolved here: either
+ * an unconditional GOTO or nothing at all gets added.
+ *
+ * The binary assembler fuses a comparison immediately followed by the
+ * IF_TRUE or IF_FALSE testing its result in a single compare and jump.
+ *
+ * \param[in] n  The statement node (used to create replacement nodes).
+ * \param[in] condition  The expression to test.
+ * \param[in] label  The label to jump to.
+ * \param[in] jump_when  Whether to jump when the condition is true or false.
+ */
+void flatten_nodes::add_branch(
+      node::pointer_t n
+    , node::pointer_t condition
+    , std::string const & label
+    , bool jump_when)
+{
+    data::pointer_t d(node_to_operation(condition));
+    bool value(false);
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_TRUE:
+        value = true;
+        break;
+
+    case node_t::NODE_FALSE:
+    case node_t::NODE_NULL:
+        value = false;
+        break;
+
+    case node_t::NODE_BOOLEAN:
+        value = d->get_boolean();
+        break;
+
+    case node_t::NODE_INTEGER:
+        value = d->get_integer().get() != 0;
+        break;
+
+    case node_t::NODE_FLOATING_POINT:
+        {
+            double const v(d->get_floating_point().get());
+            value = v != 0.0 && !std::isnan(v);
+        }
+        break;
+
+    case node_t::NODE_STRING:
+        value = !d->get_string().empty();
+        break;
+
+    default:
+        {
+            node_t const type(jump_when ? node_t::NODE_IF_TRUE : node_t::NODE_IF_FALSE);
+            node::pointer_t if_node(n->create_replacement(type));
+            operation::pointer_t op(std::make_shared<operation>(type, if_node));
+            op->set_label(label);
+            op->set_left_handside(d);
+            f_operations.push_back(op);
+        }
+        return;
+
+    }
+
+    if(value == jump_when)
+    {
+        add_goto(n, label);
+    }
+}
+
+
+void flatten_nodes::var_directive(node::pointer_t n)
+{
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        node::pointer_t variable_node(n->get_child(idx));
+        if(variable_node->get_type() != node_t::NODE_VARIABLE
+        || variable_node->get_type_node() == nullptr)
+        {
+            continue;
+        }
+        node::pointer_t set;
+        std::size_t const count(variable_node->get_children_size());
+        for(std::size_t j(0); j < count; ++j)
+        {
+            node::pointer_t child(variable_node->get_child(j));
+            if(child->get_type() == node_t::NODE_SET
+            && child->get_children_size() == 1)
+            {
+                set = child;
+                break;
+            }
+        }
+        if(set == nullptr)
+        {
+            continue;
+        }
+        auto it(f_variables.find(variable_node->get_string()));
+        if(it == f_variables.end())
+        {
+            continue;
+        }
+
+        // same as an assignment: variable := <initializer>
+        //
+        add_assignment(set, it->second, node_to_operation(set->get_child(0)));
+    }
+}
+
+
+/** \brief Generate an if() statement.
+ *
+ * \code
+ *         if_false <condition>, else
+ *         <then directives>
+ *         goto after                  // only if there is an else
+ *     else:
+ *         <else directives>
+ *     after:
+ * \endcode
+ *
+ * \param[in] n  The NODE_IF node.
+ */
+void flatten_nodes::if_directive(node::pointer_t n)
+{
+    std::size_t const max(n->get_children_size());
+    if(max < 2)
+    {
+        return;
+    }
+
+    std::string const else_label(new_label());
+    add_branch(n, n->get_child(0), else_label, false);
+    node_to_operation(n->get_child(1));
+    if(max == 3)
+    {
+        std::string const after(new_label());
+        add_goto(n, after);
+        add_label(n, else_label);
+        node_to_operation(n->get_child(2));
+        add_label(n, after);
+    }
+    else
+    {
+        add_label(n, else_label);
+    }
+}
+
+
+/** \brief Generate a while() loop.
+ *
+ * The condition is placed at the bottom of the loop so each iteration
+ * only executes one branch:
+ *
+ * \code
+ *         goto continue
+ *     body:
+ *         <directives>
+ *     continue:
+ *         if_true <condition>, body
+ *     break:
+ * \endcode
+ *
+ * \param[in] n  The NODE_WHILE node.
+ */
+void flatten_nodes::while_directive(node::pointer_t n)
+{
+    if(n->get_children_size() != 2)
+    {
+        return;
+    }
+
+    loop_labels & labels(f_loop_labels[n]);
+    std::string const body(new_label());
+    labels.f_continue = new_label();
+    labels.f_break = new_label();
+
+    add_goto(n, labels.f_continue);
+    add_label(n, body);
+    node_to_operation(n->get_child(1));
+    add_label(n, labels.f_continue);
+    add_branch(n, n->get_child(0), body, true);
+    add_label(n, labels.f_break);
+}
+
+
+void flatten_nodes::do_directive(node::pointer_t n)
+{
+    if(n->get_children_size() != 2)
+    {
+        return;
+    }
+
+    loop_labels & labels(f_loop_labels[n]);
+    std::string const body(new_label());
+    labels.f_continue = new_label();
+    labels.f_break = new_label();
+
+    add_label(n, body);
+    node_to_operation(n->get_child(0));
+    add_label(n, labels.f_continue);
+    add_branch(n, n->get_child(1), body, true);
+    add_label(n, labels.f_break);
+}
+
+
+/** \brief Generate a for() loop.
+ *
+ * \code
+ *         <initializer>
+ *         goto test
+ *     body:
+ *         <directives>
+ *     continue:
+ *         <increment>
+ *     test:
+ *         if_true <condition>, body   // or "goto body" without a condition
+ *     break:
+ * \endcode
+ *
+ * The for(... in ...) form is not yet supported.
+ *
+ * \param[in] n  The NODE_FOR node.
+ */
+void flatten_nodes::for_directive(node::pointer_t n)
+{
+    if(n->get_flag(flag_t::NODE_FOR_FLAG_IN)
+    || n->get_flag(flag_t::NODE_FOR_FLAG_FOREACH)
+    || n->get_children_size() != 4)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_INVALID_EXPRESSION, n->get_position());
+        msg << "binary compilation of \"for(... in ...)\" is not yet implemented.";
+        throw not_implemented(msg.str());
+    }
+
+    loop_labels & labels(f_loop_labels[n]);
+    std::string const body(new_label());
+    std::string const test(new_label());
+    labels.f_continue = new_label();
+    labels.f_break = new_label();
+
+    if(n->get_child(0)->get_type() != node_t::NODE_EMPTY)
+    {
+        node_to_operation(n->get_child(0));
+    }
+    add_goto(n, test);
+    add_label(n, body);
+    node_to_operation(n->get_child(3));
+    add_label(n, labels.f_continue);
+    if(n->get_child(2)->get_type() != node_t::NODE_EMPTY)
+    {
+        node_to_operation(n->get_child(2));
+    }
+    add_label(n, test);
+    if(n->get_child(1)->get_type() == node_t::NODE_EMPTY)
+    {
+        add_goto(n, body);
+    }
+    else
+    {
+        add_branch(n, n->get_child(1), body, true);
+    }
+    add_label(n, labels.f_break);
+}
+
+
+/** \brief Generate a switch() statement.
+ *
+ * The switch value is computed once and a NODE_SWITCH operation is
+ * added with the list of cases and their labels. The binary assembler
+ * chooses how to dispatch (jump table, binary decision tree, or string
+ * hashing) depending on the case values. The default label is the
+ * operation label; it is the "break" label when there is no "default:".
+ *
+ * \code
+ *         switch <value>, default, [case1, case2, ...]
+ *     case1:
+ *         <directives>
+ *     case2:
+ *         <directives>
+ *     default:
+ *         <directives>
+ *     break:
+ * \endcode
+ *
+ * Only the strict equality (the default) and, for ranges, the "in"
+ * operators are supported.
+ *
+ * \param[in] n  The NODE_SWITCH node.
+ */
+void flatten_nodes::switch_directive(node::pointer_t n)
+{
+    if(n->get_children_size() != 2)
+    {
+        return;
+    }
+
+    node_t const switch_operator(n->get_switch_operator());
+    switch(switch_operator)
+    {
+    case node_t::NODE_UNKNOWN:
+    case node_t::NODE_DEFAULT:
+    case node_t::NODE_STRICTLY_EQUAL:
+    case node_t::NODE_IN:
+        break;
+
+    default:
+        {
+            message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_INVALID_EXPRESSION, n->get_position());
+            msg << "binary compilation of \"switch() with("
+                << node::type_to_string(switch_operator)
+                << ")\" is not yet implemented.";
+            throw not_implemented(msg.str());
+        }
+
+    }
+
+    loop_labels & labels(f_loop_labels[n]);
+    labels.f_break = new_label();
+
+    data::pointer_t value(node_to_operation(n->get_child(0)));
+
+    node::pointer_t list(n->get_child(1));
+    std::size_t const max(list->get_children_size());
+    std::vector<std::string> case_labels(max);
+    std::string default_label(labels.f_break);
+    node::pointer_t switch_node(n->create_replacement(node_t::NODE_SWITCH));
+    operation::pointer_t op(std::make_shared<operation>(node_t::NODE_SWITCH, switch_node));
+    op->set_left_handside(value);
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        node::pointer_t child(list->get_child(idx));
+        switch(child->get_type())
+        {
+        case node_t::NODE_CASE:
+            case_labels[idx] = new_label();
+            if(child->get_children_size() == 1)
+            {
+                data::pointer_t d(node_to_operation(child->get_child(0)));
+                op->add_case(d, d, case_labels[idx]);
+            }
+            else if(child->get_children_size() == 2)
+            {
+                op->add_case(
+                      node_to_operation(child->get_child(0))
+                    , node_to_operation(child->get_child(1))
+                    , case_labels[idx]);
+            }
+            break;
+
+        case node_t::NODE_DEFAULT:
+            case_labels[idx] = new_label();
+            default_label = case_labels[idx];
+            break;
+
+        default:
+            break;
+
+        }
+    }
+    op->set_label(default_label);
+    f_operations.push_back(op);
+
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        if(!case_labels[idx].empty())
+        {
+            add_label(n, case_labels[idx]);
+        }
+        else
+        {
+            node_to_operation(list->get_child(idx));
+        }
+    }
+
+    add_label(n, labels.f_break);
+}
+
+
+/** \brief Flatten a user function.
+ *
+ * The operations of a user function are saved in a user_function object
+ * instead of the main list of operations. The parameters, the locals,
+ * and the return value become temporaries so they live in the stack
+ * frame of the function:
+ *
+ * \code
+ *     function:
+ *         <directives>
+ *     exit:
+ * \endcode
+ *
+ * A "return" saves its value in the return temporary and jumps to the
+ * exit label. The binary assembler generates the prologue and epilogue
+ * around these operations.
+ *
+ * Native functions and functions without a body (i.e. declarations)
+ * are ignored. Nested functions and member functions are not yet
+ * supported.
+ *
+ * \param[in] n  The NODE_FUNCTION node.
+ */
+void flatten_nodes::function_directive(node::pointer_t n)
+{
+    if(n->get_attribute(attribute_t::NODE_ATTR_NATIVE))
+    {
+        return;
+    }
+
+    node::pointer_t parameters;
+    node::pointer_t body;
+    std::size_t const max(n->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        node::pointer_t child(n->get_child(idx));
+        switch(child->get_type())
+        {
+        case node_t::NODE_PARAMETERS:
+            parameters = child;
+            break;
+
+        case node_t::NODE_DIRECTIVE_LIST:
+            body = child;
+            break;
+
+        default:
+            break;
+
+        }
+    }
+    if(body == nullptr)
+    {
+        return;
+    }
+
+    if(f_current_function != nullptr
+    || n->get_parent()->get_type() != node_t::NODE_DIRECTIVE_LIST
+    || n->get_flag(flag_t::NODE_FUNCTION_FLAG_GETTER)
+    || n->get_flag(flag_t::NODE_FUNCTION_FLAG_SETTER))
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, n->get_position());
+        msg << "binary compilation of nested functions, getters, and setters (\""
+            << n->get_string()
+            << "\") is not yet implemented.";
+        throw not_implemented(msg.str());
+    }
+    for(node::pointer_t p(n->get_parent()); p != nullptr; p = p->get_parent())
+    {
+        if(p->get_type() == node_t::NODE_CLASS
+        || p->get_type() == node_t::NODE_INTERFACE)
+        {
+            message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, n->get_position());
+            msg << "binary compilation of member functions (\""
+                << n->get_string()
+                << "\") is not yet implemented.";
+            throw not_implemented(msg.str());
+        }
+    }
+
+    user_function::pointer_t f(std::make_shared<user_function>(n, function_label(n)));
+
+    // the function operations and variables are kept separate
+    //
+    operation::list_t saved_operations;
+    std::swap(saved_operations, f_operations);
+    data::map_t const saved_variables(f_variables);
+    f_current_function = f;
+
+    if(parameters != nullptr)
+    {
+        std::size_t const count(parameters->get_children_size());
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            node::pointer_t param(parameters->get_child(idx));
+            if(param->get_type() != node_t::NODE_PARAM)
+            {
+                continue;
+            }
+            if(param->get_flag(flag_t::NODE_PARAM_FLAG_REST)
+            || param->get_type_node() == nullptr)
+            {
+                message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, param->get_position());
+                msg << "binary compilation of untyped and rest parameters (\""
+                    << param->get_string()
+                    << "\") is not yet implemented.";
+                throw not_implemented(msg.str());
+            }
+            data::pointer_t d(new_temporary(param, "%param", param->get_type_node()));
+            f_variables[param->get_string()] = d;
+            f->add_parameter(d);
+        }
+    }
+
+    node::pointer_t return_type(n->get_type_node());
+    if(return_type != nullptr
+    && return_type->get_type() == node_t::NODE_CLASS
+    && !n->get_flag(flag_t::NODE_FUNCTION_FLAG_VOID)
+    && !n->get_flag(flag_t::NODE_FUNCTION_FLAG_NEVER))
+    {
+        f->set_return_value(new_temporary(n, "%return", return_type));
+    }
+
+    declare_variables(n);
+    node_to_operation(body);
+
+    f->get_operations() = std::move(f_operations);
+    for(auto const & it : f_variables)
+    {
+        auto const v(saved_variables.find(it.first));
+        if(v == saved_variables.end()
+        || v->second != it.second)
+        {
+            if(it.second->is_temporary())
+            {
+                f->get_variables()[it.second->get_string()] = it.second;
+            }
+        }
+    }
+
+    f_operations = std::move(saved_operations);
+    f_variables = saved_variables;
+    f_current_function.reset();
+
+    f_functions.push_back(f);
+}
+
+
+void flatten_nodes::return_directive(node::pointer_t n)
+{
+    if(f_current_function == nullptr)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_SUPPORTED, n->get_position());
+        msg << "binary compilation of \"return\" outside of a function is not yet implemented.";
+        throw not_implemented(msg.str());
+    }
+
+    operation::pointer_t op(std::make_shared<operation>(node_t::NODE_RETURN, n));
+    if(n->get_children_size() > 0)
+    {
+        data::pointer_t value(node_to_operation(n->get_child(0)));
+        if(f_current_function->get_return_value() != nullptr)
+        {
+            op->set_left_handside(value);
+            op->set_result(f_current_function->get_return_value());
+        }
+    }
+    op->set_label(f_current_function->get_exit_label());
+    f_operations.push_back(op);
+}
+
+
+/** \brief Call a user function.
+ *
+ * The arguments are saved as the additional parameters of the NODE_CALL
+ * operation and the label of the function is the operation label. The
+ * binary assembler passes them in registers.
+ *
+ * \param[in] n  The NODE_CALL node.
+ * \param[in] function_node  The function being called.
+ *
+ * \return The temporary receiving the returned value or a null pointer
+ * if the function returns Void.
+ */
+data::pointer_t flatten_nodes::user_call(node::pointer_t n, node::pointer_t function_node)
+{
+    if(can_inline(n, function_node))
+    {
+        return inline_call(n, function_node);
+    }
+
+    operation::pointer_t op(std::make_shared<operation>(node_t::NODE_CALL, n));
+    op->set_label(function_label(function_node));
+
+    node::pointer_t args(n->get_child(1));
+    std::size_t const max(args->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        op->add_additional_parameter(node_to_operation(args->get_child(idx)));
+    }
+
+    data::pointer_t result;
+    node::pointer_t type(n->get_type_node());
+    if(type != nullptr
+    && type->get_type() == node_t::NODE_CLASS
+    && !function_node->get_flag(flag_t::NODE_FUNCTION_FLAG_VOID)
+    && !function_node->get_flag(flag_t::NODE_FUNCTION_FLAG_NEVER))
+    {
+        result = new_temporary(n, "%temp", type);
+        op->set_result(result);
+    }
+    f_operations.push_back(op);
+
+    return result;
+}
+
+
+/** \brief Check whether a call gets inlined.
+ *
+ * Small functions, functions marked "inline", and not too large
+ * functions called with at least one literal argument get inlined.
+ * A function is never inlined within itself and functions with nested
+ * functions or parameters which cannot be compiled are not inlined.
+ *
+ * \param[in] n  The NODE_CALL node.
+ * \param[in] function_node  The function being called.
+ *
+ * \return true if the call gets inlined.
+ */
+bool flatten_nodes::can_inline(node::pointer_t n, node::pointer_t function_node)
+{
+    if(f_inlining.find(function_node) != f_inlining.end())
+    {
+        return false;
+    }
+
+    node::pointer_t body(function_node->find_first_child(node_t::NODE_DIRECTIVE_LIST));
+    if(body == nullptr
+    || body->find_descendent(
+              node_t::NODE_FUNCTION
+            , [](node::pointer_t)
+            {
+                return true;
+            }) != nullptr)
+    {
+        return false;
+    }
+
+    node::pointer_t parameters(function_node->find_first_child(node_t::NODE_PARAMETERS));
+    if(parameters != nullptr)
+    {
+        std::size_t const max(parameters->get_children_size());
+        for(std::size_t idx(0); idx < max; ++idx)
+        {
+            node::pointer_t param(parameters->get_child(idx));
+            if(param->get_type() == node_t::NODE_PARAM
+            && (param->get_flag(flag_t::NODE_PARAM_FLAG_REST)
+                || param->get_type_node() == nullptr))
+            {
+                return false;
+            }
+        }
+    }
+
+    if(function_node->get_attribute(attribute_t::NODE_ATTR_INLINE))
+    {
+        return true;
+    }
+
+    std::size_t const size(count_nodes(body));
+    if(size <= INLINE_MAX_NODES)
+    {
+        return true;
+    }
+    if(size > INLINE_SPECIALIZE_MAX_NODES)
+    {
+        return false;
+    }
+
+    node::pointer_t args(n->get_child(1));
+    std::size_t const max(args->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        if(args->get_child(idx)->is_literal())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/** \brief Inline a call to a user function.
+ *
+ * The body of the function gets flattened at the place of the call:
+ *
+ * \code
+ *         <arguments>
+ *         param1 := <argument1>
+ *         ...
+ *         <directives>
+ *     exit:
+ * \endcode
+ *
+ * A "return" saves its value in the result temporary and jumps to the
+ * exit label, exactly like in a compiled function.
+ *
+ * A literal argument is used directly in place of its parameter
+ * (specialization) unless the function modifies that parameter, so
+ * the code of the function works with an immediate value and branches
+ * on constant conditions disappear.
+ *
+ * \param[in] n  The NODE_CALL node.
+ * \param[in] function_node  The function being called.
+ *
+ * \return The temporary receiving the returned value or a null pointer
+ * if the function returns Void.
+ */
+data::pointer_t flatten_nodes::inline_call(node::pointer_t n, node::pointer_t function_node)
+{
+    // the arguments are computed in the scope of the caller
+    //
+    node::pointer_t args(n->get_child(1));
+    data::vector_t values;
+    std::size_t const max(args->get_children_size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        values.push_back(node_to_operation(args->get_child(idx)));
+    }
+
+    node::pointer_t body(function_node->find_first_child(node_t::NODE_DIRECTIVE_LIST));
+
+    user_function::pointer_t const saved_function(f_current_function);
+    data::map_t const saved_variables(f_variables);
+    f_current_function = std::make_shared<user_function>(function_node, new_label());
+    f_inlining.insert(function_node);
+
+    node::pointer_t parameters(function_node->find_first_child(node_t::NODE_PARAMETERS));
+    if(parameters != nullptr)
+    {
+        std::size_t idx(0);
+        std::size_t const count(parameters->get_children_size());
+        for(std::size_t p(0); p < count; ++p)
+        {
+            node::pointer_t param(parameters->get_child(p));
+            if(param->get_type() != node_t::NODE_PARAM)
+            {
+                continue;
+            }
+            if(idx >= values.size())
+            {
+                throw internal_error("missing argument in flatten_nodes::inline_call().");
+            }
+            data::pointer_t value(values[idx]);
+            ++idx;
+
+            if(value->get_node()->is_literal()
+            && value->get_node()->get_type_node() == param->get_type_node()
+            && !is_modified(body, param))
+            {
+                f_variables[param->get_string()] = value;
+            }
+            else
+            {
+                data::pointer_t d(new_temporary(param, "%param", param->get_type_node()));
+                f_variables[param->get_string()] = d;
+                add_assignment(param, d, value);
+            }
+        }
+    }
+
+    node::pointer_t type(n->get_type_node());
+    if(type != nullptr
+    && type->get_type() == node_t::NODE_CLASS
+    && !function_node->get_flag(flag_t::NODE_FUNCTION_FLAG_VOID)
+    && !function_node->get_flag(flag_t::NODE_FUNCTION_FLAG_NEVER))
+    {
+        f_current_function->set_return_value(new_temporary(n, "%temp", type));
+    }
+
+    declare_variables(function_node);
+    node_to_operation(body);
+    add_label(n, f_current_function->get_exit_label());
+
+    data::pointer_t result(f_current_function->get_return_value());
+
+    // restore the scope of the caller, keep the new temporaries
+    //
+    data::map_t inlined;
+    std::swap(inlined, f_variables);
+    f_variables = saved_variables;
+    for(auto const & it : inlined)
+    {
+        if(it.first[0] == '%')
+        {
+            f_variables.insert(it);
+        }
+    }
+    f_inlining.erase(function_node);
+    f_current_function = saved_function;
+
+    return result;
+}
+
+
+std::string const & flatten_nodes::function_label(node::pointer_t function_node)
+{
+    std::string & label(f_function_labels[function_node]);
+    if(label.empty())
+    {
+        label = "%function" + std::to_string(f_function_labels.size());
+    }
+    return label;
+}
+
+
+data::pointer_t flatten_nodes::new_temporary(node::pointer_t n, std::string const & prefix, node::pointer_t type)
+{
+    node::pointer_t var(n->create_replacement(node_t::NODE_VARIABLE));
+    var->set_flag(flag_t::NODE_VARIABLE_FLAG_TEMPORARY, true);
+    var->set_type_node(type);
+    std::string temp(prefix);
+    ++f_next_temp_var;
+    temp += std::to_string(f_next_temp_var);
+    var->set_string(temp);
+    data::pointer_t result(std::make_shared<data>(var));
+    f_variables[temp] = result;
+    return result;
+}
+
+
+void flatten_nodes::break_continue(node::pointer_t n)
+{
+    node::pointer_t target(n->get_goto_exit());
+    auto it(f_loop_labels.find(target));
+    if(target == nullptr
+    || it == f_loop_labels.end()
+    || (n->get_type() == node_t::NODE_CONTINUE && it->second.f_continue.empty()))
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_INVALID_EXPRESSION, n->get_position());
+        msg << "binary compilation of \""
+            << n->get_type_name()
+            << "\" outside of a loop or switch is not yet implemented.";
+        throw not_implemented(msg.str());
+    }
+
+    add_goto(n, n->get_type() == node_t::NODE_BREAK
+                        ? it->second.f_break
+                        : it->second.f_continue);
+}
+
+
+node::pointer_t flatten_nodes::get_root() const
+{
+    return f_root;
+}
+
+
+operation::list_t const & flatten_nodes::get_operations() const
+{
+    return f_operations;
+}
+
+
+data::list_t const & flatten_nodes::get_data() const
+{
+    return f_data;
+}
+
+
+void flatten_nodes::add_variable(data::pointer_t var)
 {
     f_variables[var->get_string()] = var;
 }
@@ -1270,6 +2545,91 @@ data::map_t const & flatten_nodes::get_variables() const
 
 
 
+user_function::vector_t const & flatten_nodes::get_functions() const
+{
+    return f_functions;
+}
+
+
+
+
+
+
+user_function::user_function(node::pointer_t n, std::string const & label)
+    : f_node(n)
+    , f_label(label)
+    , f_exit_label(label + "_exit")
+{
+}
+
+
+node::pointer_t user_function::get_node() const
+{
+    return f_node;
+}
+
+
+std::string const & user_function::get_label() const
+{
+    return f_label;
+}
+
+
+std::string const & user_function::get_exit_label() const
+{
+    return f_exit_label;
+}
+
+
+void user_function::add_parameter(data::pointer_t d)
+{
+    f_parameters.push_back(d);
+}
+
+
+data::vector_t const & user_function::get_parameters() const
+{
+    return f_parameters;
+}
+
+
+void user_function::set_return_value(data::pointer_t d)
+{
+    f_return_value = d;
+}
+
+
+data::pointer_t user_function::get_return_value() const
+{
+    return f_return_value;
+}
+
+
+operation::list_t & user_function::get_operations()
+{
+    return f_operations;
+}
+
+
+operation::list_t const & user_function::get_operations() const
+{
+    return f_operations;
+}
+
+
+data::map_t & user_function::get_variables()
+{
+    return f_variables;
+}
+
+
+data::map_t const & user_function::get_variables() const
+{
+    return f_variables;
+}
+
+
+
 
 
 
@@ -1427,6 +2787,12 @@ data::pointer_t operation::get_parameter(int idx) const
 }
 
 
+void operation::set_parameter(int idx, data::pointer_t d)
+{
+    f_additional_parameters.at(idx) = d;
+}
+
+
 void operation::set_result(data::pointer_t d)
 {
     f_result = d;
@@ -1451,6 +2817,27 @@ std::string const & operation::get_label() const
 }
 
 
+/** \brief Add a case to a NODE_SWITCH operation.
+ *
+ * The cases are kept in the order they appear in the source since the
+ * first matching case wins.
+ *
+ * \param[in] low  The case value or the start of the range.
+ * \param[in] high  The end of the range (same as \p low if not a range).
+ * \param[in] label  The label to jump to when the switch value matches.
+ */
+void operation::add_case(data::pointer_t low, data::pointer_t high, std::string const & label)
+{
+    f_cases.push_back({ low, high, label });
+}
+
+
+operation::switch_case::vector_t const & operation::get_cases() const
+{
+    return f_cases;
+}
+
+
 std::string operation::to_string() const
 {
     std::stringstream ss;
@@ -1565,6 +2952,11 @@ std::string operation::to_string() const
 
         }
     }
+    if(!f_cases.empty())
+    {
+        ss << " cases:"
+           << f_cases.size();
+    }
     if(f_result != nullptr)
     {
         ss << " result: "
@@ -1693,6 +3085,8 @@ flatten_nodes::pointer_t flatten(node::pointer_t root, compiler::pointer_t c)
 {
     int const save_errcnt(error_count());
 
+    inline_functions(root, c);
+
     flatten_nodes::pointer_t fn(std::make_shared<flatten_nodes>(root, c));
     fn->run();
 
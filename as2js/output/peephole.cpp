@@ -0,0 +1,424 @@
+// Copyright (c) 2005-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/as2js
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// self
+//
+#include    "as2js/binary.h"
+
+#include    "as2js/message.h"
+
+
+// C++
+//
+#include    <algorithm>
+#include    <set>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace as2js
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Check whether a block is a `MOV %rn, disp(%rbp)` or the reverse.
+ *
+ * The \p opcode is 0x89 for a store and 0x8B for a load. Only the 64 bit
+ * versions are accepted (REX.W) since a 32 bit load also clears the
+ * upper 32 bits of the register.
+ *
+ * \param[in] text  The start of the block.
+ * \param[in] size  The size of the block.
+ * \param[in] opcode  The opcode to check for.
+ *
+ * \return true if the block is exactly that one instruction.
+ */
+bool is_rbp_move(std::uint8_t const * text, offset_t size, std::uint8_t opcode)
+{
+    if(size != 4 && size != 7)
+    {
+        return false;
+    }
+    if((text[0] != 0x48 && text[0] != 0x4C)
+    || text[1] != opcode)
+    {
+        return false;
+    }
+    std::uint8_t const mod_rm(size == 4 ? 0x45 : 0x85);
+    return (text[2] & 0xC7) == mod_rm;
+}
+
+
+/** \brief Check whether a block is a `MOV %rn, %rn`.
+ *
+ * \param[in] text  The start of the block.
+ * \param[in] size  The size of the block.
+ *
+ * \return true if the block moves a 64 bit register to itself.
+ */
+bool is_self_move(std::uint8_t const * text, offset_t size)
+{
+    if(size != 3
+    || (text[0] != 0x48 && text[0] != 0x4D)
+    || (text[1] != 0x89 && text[1] != 0x8B))
+    {
+        return false;
+    }
+    std::uint8_t const mod_rm(text[2]);
+    return (mod_rm & 0xC0) == 0xC0
+        && ((mod_rm >> 3) & 7) == (mod_rm & 7);
+}
+
+
+/** \brief Get the size of a jump instruction.
+ *
+ * \param[in] text  The start of the block.
+ * \param[in] size  The size of the block.
+ *
+ * \return 5 for a `JMP disp32`, 6 for a `Jcc disp32`, 0 otherwise.
+ */
+offset_t jump_size(std::uint8_t const * text, offset_t size)
+{
+    if(size == 5 && text[0] == 0xE9)
+    {
+        return 5;
+    }
+    if(size == 6 && text[0] == 0x0F && (text[1] & 0xF0) == 0x80)
+    {
+        return 6;
+    }
+    return 0;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Optimize the text before it gets saved.
+ *
+ * The binary assembler generates the code one operation at a time and
+ * never revisits it. This function removes the most common redundancies
+ * found at the junction of two operations:
+ *
+ * \li a load of a temporary right after it was stored from the same
+ *     register (i.e. `MOV %rax, -8(%rbp)` followed by `MOV -8(%rbp), %rax`);
+ * \li moves of a register to itself;
+ * \li jumps to the instruction right after the jump.
+ *
+ * Then it replaces the `JMP disp32` and `Jcc disp32` with their 8 bit
+ * version whenever the destination is close enough.
+ *
+ * The function works on the blocks added with add_text() before the
+ * relocations get resolved. Only blocks which are exactly one of the
+ * instructions above are considered. The other blocks may include
+ * short jumps within themselves so bytes are never removed from the
+ * middle of them. The labels and relocations are moved along the code.
+ */
+void build_file::peephole()
+{
+    std::size_t const original_size(f_text.size());
+
+    remove_redundant_instructions();
+    while(shorten_jumps())
+    {
+        // shortening jumps brings more labels within range
+    }
+
+    if(f_text.size() != original_size)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_DEBUG, err_code_t::AS_ERR_NONE);
+        msg << "peephole optimizer saved "
+            << original_size - f_text.size()
+            << " bytes of .text ("
+            << original_size
+            << " -> "
+            << f_text.size()
+            << ").";
+    }
+}
+
+
+void build_file::remove_redundant_instructions()
+{
+    std::set<offset_t> labels;
+    for(auto const & l : f_label_offsets)
+    {
+        labels.insert(l.second);
+    }
+
+    std::map<offset_t, relocation const *> jumps;
+    for(auto const & r : f_relocations)
+    {
+        if(r.get_relocation() == relocation_t::RELOCATION_LABEL_32BITS)
+        {
+            jumps[r.get_position()] = &r;
+        }
+    }
+
+    text_ranges_t ranges;
+    std::size_t store(static_cast<std::size_t>(-1));
+    std::size_t const max(f_instructions.size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        offset_t const start(f_instructions[idx]);
+        offset_t const end(idx + 1 < max ? f_instructions[idx + 1] : f_text.size());
+        offset_t const size(end - start);
+        std::uint8_t const * text(f_text.data() + start);
+
+        bool remove(false);
+        if(is_self_move(text, size))
+        {
+            remove = true;
+        }
+        else if(store != static_cast<std::size_t>(-1)
+             && labels.find(start) == labels.end()
+             && is_rbp_move(text, size, 0x8B))
+        {
+            // the store must be the previous block or only removed
+            // blocks can separate the two
+            //
+            offset_t const store_start(f_instructions[store]);
+            std::uint8_t const * s(f_text.data() + store_start);
+            remove = f_instructions[store + 1] - store_start == size
+                  && s[0] == text[0]
+                  && std::equal(s + 2, s + size, text + 2);
+        }
+        else
+        {
+            offset_t const jump(jump_size(text, size));
+            if(jump != 0)
+            {
+                auto const it(jumps.find(end - 4));
+                if(it != jumps.end())
+                {
+                    auto const label(f_label_offsets.find(it->second->get_name()));
+                    remove = label != f_label_offsets.end()
+                          && label->second == end;
+                }
+            }
+        }
+
+        if(remove)
+        {
+            ranges.push_back(std::make_pair(start, size));
+            if(labels.find(start) != labels.end())
+            {
+                store = static_cast<std::size_t>(-1);
+            }
+        }
+        else if(is_rbp_move(text, size, 0x89))
+        {
+            store = idx;
+        }
+        else
+        {
+            store = static_cast<std::size_t>(-1);
+        }
+    }
+
+    if(!ranges.empty())
+    {
+        remove_text(ranges);
+    }
+}
+
+
+bool build_file::shorten_jumps()
+{
+    std::map<offset_t, relocation *> jumps;
+    for(auto & r : f_relocations)
+    {
+        if(r.get_relocation() == relocation_t::RELOCATION_LABEL_32BITS)
+        {
+            jumps[r.get_position()] = &r;
+        }
+    }
+
+    text_ranges_t ranges;
+    std::size_t const max(f_instructions.size());
+    for(std::size_t idx(0); idx < max; ++idx)
+    {
+        offset_t const start(f_instructions[idx]);
+        offset_t const end(idx + 1 < max ? f_instructions[idx + 1] : f_text.size());
+        offset_t const size(jump_size(f_text.data() + start, end - start));
+        if(size == 0)
+        {
+            continue;
+        }
+        auto const it(jumps.find(end - 4));
+        if(it == jumps.end())
+        {
+            continue;
+        }
+        auto const label(f_label_offsets.find(it->second->get_name()));
+        if(label == f_label_offsets.end())
+        {
+            continue;
+        }
+
+        // removing bytes only brings the labels closer so if the jump
+        // is in range now, it remains in range once shortened
+        //
+        std::int64_t const disp(static_cast<std::int64_t>(label->second) - end);
+        if(disp < -128 || disp > 127)
+        {
+            continue;
+        }
+
+        if(size == 5)
+        {
+            f_text[start] = 0xEB;   // JMP disp8
+        }
+        else
+        {
+            f_text[start] = 0x70 | (f_text[start + 1] & 0x0F);     // Jcc disp8
+        }
+        f_text[start + 1] = 0x00;
+        it->second->set_relocation(relocation_t::RELOCATION_LABEL_8BITS);
+        it->second->set_position(start + 1);
+        it->second->set_offset(start + 2);
+        ranges.push_back(std::make_pair(start + 2, size - 2));
+    }
+
+    if(ranges.empty())
+    {
+        return false;
+    }
+    remove_text(ranges);
+    return true;
+}
+
+
+/** \brief Remove bytes from the text.
+ *
+ * The labels, relocations, and blocks found after a removed range get
+ * moved back. Relocations found inside a removed range are dropped.
+ *
+ * \param[in] ranges  The sorted list of ranges to remove.
+ */
+void build_file::remove_text(text_ranges_t const & ranges)
+{
+    // total number of bytes removed before each range
+    //
+    std::vector<offset_t> removed(ranges.size() + 1, 0);
+    for(std::size_t idx(0); idx < ranges.size(); ++idx)
+    {
+        removed[idx + 1] = removed[idx] + ranges[idx].second;
+    }
+
+    auto const find = [&ranges](offset_t offset)
+    {
+        return std::lower_bound(
+                  ranges.begin()
+                , ranges.end()
+                , offset
+                , [](auto const & r, offset_t o)
+                {
+                    return r.first < o;
+                }) - ranges.begin();
+    };
+    auto const move = [&ranges, &removed, &find](offset_t offset)
+    {
+        std::size_t const idx(find(offset));
+        if(idx > 0
+        && offset < ranges[idx - 1].first + ranges[idx - 1].second)
+        {
+            return ranges[idx - 1].first - removed[idx - 1];
+        }
+        return offset - removed[idx];
+    };
+    auto const is_removed = [&ranges, &find](offset_t offset)
+    {
+        std::size_t const idx(find(offset + 1));
+        return idx > 0
+            && offset < ranges[idx - 1].first + ranges[idx - 1].second;
+    };
+
+    text_t text;
+    text.reserve(f_text.size() - removed.back());
+    offset_t pos(0);
+    for(auto const & r : ranges)
+    {
+        text.insert(text.end(), f_text.begin() + pos, f_text.begin() + r.first);
+        pos = r.first + r.second;
+    }
+    text.insert(text.end(), f_text.begin() + pos, f_text.end());
+    f_text.swap(text);
+
+    for(auto & l : f_label_offsets)
+    {
+        l.second = move(l.second);
+    }
+
+    relocation::vector_t relocations;
+    relocations.reserve(f_relocations.size());
+    for(auto & r : f_relocations)
+    {
+        if(is_removed(r.get_position()))
+        {
+            continue;
+        }
+        r.set_position(move(r.get_position()));
+        switch(r.get_relocation())
+        {
+        case relocation_t::RELOCATION_CONSTANT_32BITS:
+        case relocation_t::RELOCATION_LABEL_32BITS:
+        case relocation_t::RELOCATION_LABEL_8BITS:
+        case relocation_t::RELOCATION_EXTERN_FUNCTION:
+            // the offset is the position of %rip or of the jump table
+            //
+            r.set_offset(move(r.get_offset()));
+            break;
+
+        default:
+            break;
+
+        }
+        relocations.push_back(r);
+    }
+    f_relocations.swap(relocations);
+
+    for(auto & i : f_instructions)
+    {
+        i = move(i);
+    }
+    f_instructions.erase(
+              std::unique(f_instructions.begin(), f_instructions.end())
+            , f_instructions.end());
+    while(!f_instructions.empty()
+       && f_instructions.back() >= f_text.size())
+    {
+        f_instructions.pop_back();
+    }
+}
+
+
+
+} // namespace as2js
+// vim: ts=4 sw=4 et
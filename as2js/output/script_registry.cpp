@@ -0,0 +1,536 @@
+// Copyright (c) 2005-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/as2js
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// self
+//
+#include    "as2js/script_registry.h"
+
+#include    "as2js/exception.h"
+#include    "as2js/message.h"
+
+
+// C++
+//
+#include    <sstream>
+
+
+// C
+//
+#include    <string.h>
+#include    <sys/stat.h>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace as2js
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Find the external function table of an image.
+ *
+ * The loader saves the address of the external functions in the table
+ * of the image. Those bytes differ between the file and the loaded image
+ * (and between processes) so they are not part of the identity of the
+ * image.
+ *
+ * \param[in] data  The image.
+ * \param[in] size  The size of the image in bytes.
+ * \param[out] start  The offset of the table.
+ * \param[out] end  The offset right after the table.
+ */
+void extern_function_table(std::uint8_t const * data, std::size_t size, std::size_t & start, std::size_t & end)
+{
+    start = size;
+    end = size;
+    if(size < sizeof(binary_header))
+    {
+        return;
+    }
+
+    binary_header header;
+    memcpy(&header, data, sizeof(header));
+    std::size_t const table_end(header.f_extern_functions
+                        + header.f_extern_function_count * sizeof(std::uint64_t));
+    if(header.f_extern_function_count == 0
+    || header.f_extern_functions < sizeof(binary_header)
+    || table_end > size)
+    {
+        return;
+    }
+    start = header.f_extern_functions;
+    end = table_end;
+}
+
+
+/** \brief Check whether an image has the specified contents.
+ *
+ * The hash of an image is only used to find a candidate. Two different
+ * images may have the same hash so the contents get compared before
+ * the candidate is used.
+ *
+ * \param[in] file  The loaded image.
+ * \param[in] data  The contents to compare with.
+ * \param[in] size  The size of \p data in bytes.
+ *
+ * \return true if the image of \p file has the contents \p data.
+ */
+bool same_image(running_file const & file, std::uint8_t const * data, std::size_t size)
+{
+    if(file.get_image_size() != size)
+    {
+        return false;
+    }
+
+    std::size_t start(0);
+    std::size_t end(0);
+    extern_function_table(data, size, start, end);
+
+    std::uint8_t const * image(file.get_image());
+    return memcmp(image, data, start) == 0
+        && memcmp(image + end, data + end, size - end) == 0;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Initialize a script registry.
+ *
+ * The registry starts empty. Scripts get added by calling get() with
+ * a filename or get_from_content() with the contents of a binary file.
+ *
+ * \param[in] memory_limit  The maximum amount of memory used by all the
+ * images kept in this registry.
+ */
+script_registry::script_registry(std::size_t memory_limit)
+    : f_memory_limit(memory_limit)
+{
+}
+
+
+/** \brief Change the memory limit.
+ *
+ * If the new limit is smaller than the current usage, the least recently
+ * used images get evicted immediately.
+ *
+ * Note that images still referenced by a caller remain in memory until
+ * that caller releases its pointer. The limit only applies to the images
+ * held by the registry.
+ *
+ * \param[in] memory_limit  The new limit in bytes.
+ */
+void script_registry::set_memory_limit(std::size_t memory_limit)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    f_memory_limit = memory_limit;
+    evict();
+}
+
+
+std::size_t script_registry::get_memory_limit() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return f_memory_limit;
+}
+
+
+std::size_t script_registry::get_memory_usage() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return f_memory_usage;
+}
+
+
+/** \brief Number of images currently held by the registry.
+ *
+ * \return The number of images in the registry.
+ */
+std::size_t script_registry::size() const
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+    return f_images.size();
+}
+
+
+/** \brief Get the running_file of a binary file.
+ *
+ * This function returns the running_file of the named binary file. The
+ * first time it gets called with that name, the file is mapped in memory
+ * with running_file::map(). The following calls return the same image
+ * as long as the file modification time, size, and inode do not change.
+ *
+ * When the file changes, it is mapped again. If the new contents are
+ * the same as before, the existing image is kept. Otherwise the old
+ * image is removed from the registry (callers still holding a pointer
+ * can continue to use it) and the new image is returned.
+ *
+ * Two files with the exact same contents share the same image. The
+ * images are found by hash and their contents compared, an image which
+ * has the same hash as another one but different contents is returned
+ * without being kept in the registry.
+ *
+ * \warning
+ * The image is mapped so a file must be replaced (i.e. write a new file
+ * and rename() it) and not overwritten in place. Truncating a mapped
+ * file makes the process crash when it accesses the old image.
+ *
+ * The returned running_file is shared between all the callers. To
+ * execute it from several threads, each thread must create its own
+ * execution context with running_file::create_context() and only use
+ * the run() functions accepting that context.
+ *
+ * \exception cannot_open_file
+ * If the file does not exist or cannot be opened, this exception is
+ * raised.
+ *
+ * \param[in] filename  The name of the binary file to load.
+ *
+ * \return The running_file or a null pointer if the file is not a valid
+ * binary file.
+ */
+running_file::pointer_t script_registry::get(std::string const & filename)
+{
+    // the file system is accessed and the image mapped and hashed without
+    // holding the lock so the other threads do not wait on that I/O
+
+    struct stat st;
+    if(stat(filename.c_str(), &st) != 0)
+    {
+        invalidate(filename);
+        message msg(message_level_t::MESSAGE_LEVEL_FATAL, err_code_t::AS_ERR_NOT_FOUND);
+        msg << "could not open binary file \""
+            << filename
+            << "\".";
+        throw cannot_open_file(msg.str());
+    }
+
+    file_entry entry;
+    entry.f_mtime_sec = st.st_mtim.tv_sec;
+    entry.f_mtime_nsec = st.st_mtim.tv_nsec;
+    entry.f_size = st.st_size;
+    entry.f_inode = st.st_ino;
+
+    {
+        std::lock_guard<std::mutex> lock(f_mutex);
+
+        file_map_t::iterator it(f_files.find(filename));
+        if(it != f_files.end()
+        && it->second.f_mtime_sec == entry.f_mtime_sec
+        && it->second.f_mtime_nsec == entry.f_mtime_nsec
+        && it->second.f_size == entry.f_size
+        && it->second.f_inode == entry.f_inode)
+        {
+            image_map_t::iterator image(f_images.find(it->second.f_hash));
+            if(image != f_images.end())
+            {
+                touch(image->second);
+                return image->second.f_file;
+            }
+            // the image was evicted, load it again
+        }
+    }
+
+    running_file::pointer_t file(std::make_shared<running_file>());
+    if(!file->map(filename))
+    {
+        invalidate(filename);
+        return running_file::pointer_t();
+    }
+    entry.f_hash = hash(file->get_image(), file->get_image_size());
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    // another thread may have updated the entry in the meantime
+    //
+    file_map_t::iterator it(f_files.find(filename));
+    if(it != f_files.end()
+    && it->second.f_hash != entry.f_hash)
+    {
+        // the contents changed, the old image is not valid anymore
+        //
+        forget_file(it);
+        it = f_files.end();
+    }
+
+    running_file::pointer_t result(add_image(entry.f_hash, file));
+    if(result == nullptr)
+    {
+        // another image has the same hash, this one cannot be shared
+        // and it gets mapped again on each call
+        //
+        if(it != f_files.end())
+        {
+            forget_file(it);
+        }
+        return file;
+    }
+    f_images[entry.f_hash].f_filenames.insert(filename);
+    if(it == f_files.end())
+    {
+        f_files[filename] = entry;
+    }
+    else
+    {
+        it->second = entry;
+    }
+
+    evict();
+
+    return result;
+}
+
+
+/** \brief Get the running_file from the contents of a binary file.
+ *
+ * This function is used when the binary is not in a file (i.e. it was
+ * saved in a database). The \p image parameter is the entire binary
+ * file. The image is found by its hash and the contents are compared so
+ * calling this function again with the same contents returns the same
+ * running_file.
+ *
+ * \param[in] image  The contents of a binary file.
+ *
+ * \return The running_file or a null pointer if the contents are not
+ * a valid binary file.
+ */
+running_file::pointer_t script_registry::get_from_content(std::string const & image)
+{
+    std::uint8_t const * data(reinterpret_cast<std::uint8_t const *>(image.data()));
+    hash_t const h(hash(data, image.length()));
+
+    {
+        std::lock_guard<std::mutex> lock(f_mutex);
+
+        image_map_t::iterator it(f_images.find(h));
+        if(it != f_images.end()
+        && same_image(*it->second.f_file, data, image.length()))
+        {
+            it->second.f_by_content = true;
+            touch(it->second);
+            return it->second.f_file;
+        }
+    }
+
+    input_stream<std::stringstream>::pointer_t in(std::make_shared<input_stream<std::stringstream>>());
+    in->str(image);
+    running_file::pointer_t file(std::make_shared<running_file>());
+    if(!file->load(in))
+    {
+        return running_file::pointer_t();
+    }
+
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    running_file::pointer_t result(add_image(h, file));
+    if(result == nullptr)
+    {
+        // another image has the same hash, this one cannot be shared
+        //
+        return file;
+    }
+    f_images[h].f_by_content = true;
+
+    evict();
+
+    return result;
+}
+
+
+/** \brief Search an image by hash.
+ *
+ * The hash is the one returned by the hash() function applied to the
+ * contents of a binary file.
+ *
+ * \param[in] hash  The hash of the image to search.
+ *
+ * \return The running_file or a null pointer if no image with that
+ * hash is currently held by the registry.
+ */
+running_file::pointer_t script_registry::find(hash_t hash)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    image_map_t::iterator it(f_images.find(hash));
+    if(it == f_images.end())
+    {
+        return running_file::pointer_t();
+    }
+    touch(it->second);
+    return it->second.f_file;
+}
+
+
+/** \brief Forget about a file.
+ *
+ * The next get() of that file is going to load it again. If no other
+ * file uses the same image, the image is removed from the registry.
+ *
+ * \param[in] filename  The name of the file to forget.
+ */
+void script_registry::invalidate(std::string const & filename)
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    file_map_t::iterator it(f_files.find(filename));
+    if(it != f_files.end())
+    {
+        forget_file(it);
+    }
+}
+
+
+void script_registry::clear()
+{
+    std::lock_guard<std::mutex> lock(f_mutex);
+
+    f_files.clear();
+    f_images.clear();
+    f_lru.clear();
+    f_memory_usage = 0;
+}
+
+
+/** \brief Compute the hash of a binary image.
+ *
+ * This is the 64 bit FNV-1a hash of the data. It is used to find
+ * candidates for identical images; the registry compares the contents
+ * before sharing an image since different images can have the same hash.
+ *
+ * The external function table is not included since the loader changes
+ * it. So the file and the loaded image have the same hash.
+ *
+ * \param[in] data  The data to hash.
+ * \param[in] size  The number of bytes in \p data.
+ *
+ * \return The hash of the data.
+ */
+script_registry::hash_t script_registry::hash(void const * data, std::size_t size)
+{
+    std::uint8_t const * s(reinterpret_cast<std::uint8_t const *>(data));
+    std::size_t start(0);
+    std::size_t end(0);
+    extern_function_table(s, size, start, end);
+
+    hash_t result(0xCBF29CE484222325ULL);
+    auto const add = [s, &result](std::size_t from, std::size_t to)
+    {
+        for(std::size_t idx(from); idx < to; ++idx)
+        {
+            result ^= s[idx];
+            result *= 0x100000001B3ULL;
+        }
+    };
+    add(0, start);
+    add(end, size);
+    return result;
+}
+
+
+// the following functions expect the mutex to be locked by the caller
+
+running_file::pointer_t script_registry::add_image(hash_t hash, running_file::pointer_t file)
+{
+    image_map_t::iterator it(f_images.find(hash));
+    if(it != f_images.end())
+    {
+        if(!same_image(*it->second.f_file, file->get_image(), file->get_image_size()))
+        {
+            // same hash, different contents
+            //
+            return running_file::pointer_t();
+        }
+
+        // identical contents, share the existing image
+        //
+        touch(it->second);
+        return it->second.f_file;
+    }
+
+    image_entry & image(f_images[hash]);
+    image.f_file = file;
+    image.f_memory_size = file->get_memory_size();
+    f_lru.push_front(hash);
+    image.f_lru = f_lru.begin();
+    f_memory_usage += image.f_memory_size;
+
+    return file;
+}
+
+
+void script_registry::touch(image_entry & image)
+{
+    f_lru.splice(f_lru.begin(), f_lru, image.f_lru);
+}
+
+
+void script_registry::forget_file(file_map_t::iterator it)
+{
+    image_map_t::iterator image(f_images.find(it->second.f_hash));
+    if(image != f_images.end())
+    {
+        image->second.f_filenames.erase(it->first);
+        if(image->second.f_filenames.empty()
+        && !image->second.f_by_content)
+        {
+            erase_image(image);
+        }
+    }
+    f_files.erase(it);
+}
+
+
+void script_registry::erase_image(image_map_t::iterator it)
+{
+    for(auto const & filename : it->second.f_filenames)
+    {
+        f_files.erase(filename);
+    }
+    f_memory_usage -= it->second.f_memory_size;
+    f_lru.erase(it->second.f_lru);
+    f_images.erase(it);
+}
+
+
+void script_registry::evict()
+{
+    // always keep the most recently used image, the caller is about
+    // to use it
+    //
+    while(f_memory_usage > f_memory_limit
+       && f_lru.size() > 1)
+    {
+        erase_image(f_images.find(f_lru.back()));
+    }
+}
+
+
+
+} // namespace as2js
+// vim: ts=4 sw=4 et
@@ -0,0 +1,1457 @@
+// Copyright (c) 2005-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/as2js
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// self
+//
+#include    "as2js/output.h"
+
+#include    "as2js/message.h"
+
+
+// C++
+//
+#include    <cstring>
+#include    <iostream>
+
+
+// last include
+//
+#include    <snapdev/poison.h>
+
+
+
+namespace as2js
+{
+
+
+
+namespace
+{
+
+
+
+/** \brief Information about a constant variable.
+ *
+ * A constant variable is either never written by the script (i.e. an
+ * `extern const` which value is supplied by the caller) or written
+ * once by its initializer. In the latter case, the initializer has to
+ * be found before the first branch of the main program so it is known
+ * to be executed before any of the reads.
+ */
+struct constant_variable
+{
+    operation::pointer_t    f_initializer = operation::pointer_t();
+};
+
+typedef std::map<std::string, constant_variable>    constant_variable_t;
+
+
+bool is_literal(data::pointer_t d)
+{
+    if(d == nullptr)
+    {
+        return false;
+    }
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_BOOLEAN:
+    case node_t::NODE_FALSE:
+    case node_t::NODE_FLOATING_POINT:
+    case node_t::NODE_INTEGER:
+    case node_t::NODE_TRUE:
+        return true;
+
+    default:
+        return false;
+
+    }
+}
+
+
+bool is_number(data::pointer_t d)
+{
+    node::pointer_t type(d->get_node()->get_type_node());
+    if(type == nullptr
+    || type->get_type() != node_t::NODE_CLASS)
+    {
+        return false;
+    }
+    std::string const & name(type->get_string());
+    return name == "Integer"
+        || name == "Double"
+        || name == "Number"
+        || name == "Boolean"
+        || name == "CompareResult";
+}
+
+
+/** \brief Check whether a literal can replace a variable.
+ *
+ * The binary assembler loads the bits of the literal as is, so the
+ * literal has to be of the exact same type as the variable.
+ *
+ * \param[in] literal  The literal value.
+ * \param[in] var  The variable to replace.
+ *
+ * \return true if \p literal can be used in place of \p var.
+ */
+bool literal_matches(data::pointer_t literal, data::pointer_t var)
+{
+    node::pointer_t type(var->get_node()->get_type_node());
+    if(type == nullptr)
+    {
+        return false;
+    }
+    std::string const & name(type->get_string());
+    switch(literal->get_data_type())
+    {
+    case node_t::NODE_INTEGER:
+        return name == "Integer";
+
+    case node_t::NODE_FLOATING_POINT:
+        return name == "Double" || name == "Number";
+
+    case node_t::NODE_BOOLEAN:
+    case node_t::NODE_FALSE:
+    case node_t::NODE_TRUE:
+        return name == "Boolean";
+
+    default:
+        return false;
+
+    }
+}
+
+
+/** \brief Operations which only compute their result.
+ *
+ * These operations do not modify any variable other than their result
+ * and their result only depends on their operands. The NODE_ARRAY
+ * operation is the array and member access (i.e. `a.length`) and the
+ * NODE_CONDITIONAL is the branchless select of a `?:`.
+ */
+bool is_pure(node_t op)
+{
+    switch(op)
+    {
+    case node_t::NODE_ADD:
+    case node_t::NODE_ALMOST_EQUAL:
+    case node_t::NODE_ARRAY:
+    case node_t::NODE_BITWISE_AND:
+    case node_t::NODE_BITWISE_NOT:
+    case node_t::NODE_BITWISE_OR:
+    case node_t::NODE_BITWISE_XOR:
+    case node_t::NODE_COMPARE:
+    case node_t::NODE_CONDITIONAL:
+    case node_t::NODE_DIVIDE:
+    case node_t::NODE_EQUAL:
+    case node_t::NODE_GREATER:
+    case node_t::NODE_GREATER_EQUAL:
+    case node_t::NODE_IDENTITY:
+    case node_t::NODE_LESS:
+    case node_t::NODE_LESS_EQUAL:
+    case node_t::NODE_LOGICAL_AND:
+    case node_t::NODE_LOGICAL_NOT:
+    case node_t::NODE_LOGICAL_OR:
+    case node_t::NODE_LOGICAL_XOR:
+    case node_t::NODE_MAXIMUM:
+    case node_t::NODE_MINIMUM:
+    case node_t::NODE_MODULO:
+    case node_t::NODE_MULTIPLY:
+    case node_t::NODE_NEGATE:
+    case node_t::NODE_NOT_EQUAL:
+    case node_t::NODE_POWER:
+    case node_t::NODE_ROTATE_LEFT:
+    case node_t::NODE_ROTATE_RIGHT:
+    case node_t::NODE_SHIFT_LEFT:
+    case node_t::NODE_SHIFT_RIGHT:
+    case node_t::NODE_SHIFT_RIGHT_UNSIGNED:
+    case node_t::NODE_STRICTLY_EQUAL:
+    case node_t::NODE_STRICTLY_NOT_EQUAL:
+    case node_t::NODE_SUBTRACT:
+        return true;
+
+    default:
+        return false;
+
+    }
+}
+
+
+/** \brief Operations which give the same result with swapped operands.
+ *
+ * The minimum and maximum are not included because MINSD and MAXSD
+ * return their second operand when one of them is a NaN.
+ */
+bool is_commutative(node_t op)
+{
+    switch(op)
+    {
+    case node_t::NODE_ADD:
+    case node_t::NODE_BITWISE_AND:
+    case node_t::NODE_BITWISE_OR:
+    case node_t::NODE_BITWISE_XOR:
+    case node_t::NODE_EQUAL:
+    case node_t::NODE_MULTIPLY:
+    case node_t::NODE_NOT_EQUAL:
+    case node_t::NODE_STRICTLY_EQUAL:
+    case node_t::NODE_STRICTLY_NOT_EQUAL:
+        return true;
+
+    default:
+        return false;
+
+    }
+}
+
+
+bool writes_left_handside(node_t op)
+{
+    switch(op)
+    {
+    case node_t::NODE_ASSIGNMENT:
+    case node_t::NODE_ASSIGNMENT_ADD:
+    case node_t::NODE_ASSIGNMENT_BITWISE_AND:
+    case node_t::NODE_ASSIGNMENT_BITWISE_OR:
+    case node_t::NODE_ASSIGNMENT_BITWISE_XOR:
+    case node_t::NODE_ASSIGNMENT_COALESCE:
+    case node_t::NODE_ASSIGNMENT_DIVIDE:
+    case node_t::NODE_ASSIGNMENT_LOGICAL_AND:
+    case node_t::NODE_ASSIGNMENT_LOGICAL_OR:
+    case node_t::NODE_ASSIGNMENT_LOGICAL_XOR:
+    case node_t::NODE_ASSIGNMENT_MAXIMUM:
+    case node_t::NODE_ASSIGNMENT_MINIMUM:
+    case node_t::NODE_ASSIGNMENT_MODULO:
+    case node_t::NODE_ASSIGNMENT_MULTIPLY:
+    case node_t::NODE_ASSIGNMENT_POWER:
+    case node_t::NODE_ASSIGNMENT_ROTATE_LEFT:
+    case node_t::NODE_ASSIGNMENT_ROTATE_RIGHT:
+    case node_t::NODE_ASSIGNMENT_SHIFT_LEFT:
+    case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT:
+    case node_t::NODE_ASSIGNMENT_SHIFT_RIGHT_UNSIGNED:
+    case node_t::NODE_ASSIGNMENT_SUBTRACT:
+    case node_t::NODE_DECREMENT:
+    case node_t::NODE_INCREMENT:
+    case node_t::NODE_POST_DECREMENT:
+    case node_t::NODE_POST_INCREMENT:
+        return true;
+
+    default:
+        return false;
+
+    }
+}
+
+
+bool is_temporary_variable(data::pointer_t d)
+{
+    return d != nullptr
+        && d->get_data_type() == node_t::NODE_VARIABLE
+        && d->is_temporary();
+}
+
+
+bool is_named_variable(data::pointer_t d)
+{
+    return d != nullptr
+        && d->get_data_type() == node_t::NODE_VARIABLE
+        && !d->is_temporary();
+}
+
+
+/** \brief Check whether an operation ends the straight code of a list.
+ *
+ * Operations found before the first of these in the main program are
+ * executed exactly once, before anything else, including the user
+ * functions.
+ */
+bool ends_prologue(operation::pointer_t op)
+{
+    switch(op->get_operation())
+    {
+    case node_t::NODE_GOTO:
+    case node_t::NODE_IF_FALSE:
+    case node_t::NODE_IF_TRUE:
+    case node_t::NODE_LABEL:
+    case node_t::NODE_RETURN:
+    case node_t::NODE_SWITCH:
+        return true;
+
+    case node_t::NODE_CALL:
+        return !op->get_label().empty();
+
+    default:
+        return false;
+
+    }
+}
+
+
+/** \brief Find what an operation may change.
+ *
+ * The result of an operation and the named variable it writes are added
+ * to \p writes. Any operation which may have other side effects (i.e. a
+ * call) may change all the variables. The temporaries defined once and
+ * the constants are never affected.
+ *
+ * \param[in] op  The operation to check.
+ * \param[in,out] writes  The set of variables written by \p op.
+ *
+ * \return true if \p op may change any variable.
+ */
+bool side_effect(operation::pointer_t op, std::set<std::string> & writes)
+{
+    node_t const type(op->get_operation());
+    switch(type)
+    {
+    case node_t::NODE_GOTO:
+    case node_t::NODE_IF_FALSE:
+    case node_t::NODE_IF_TRUE:
+    case node_t::NODE_LABEL:
+        return false;
+
+    default:
+        break;
+
+    }
+
+    data::pointer_t result(op->get_result());
+    if(result != nullptr
+    && result->get_data_type() == node_t::NODE_VARIABLE)
+    {
+        writes.insert(result->get_string());
+    }
+
+    if(is_pure(type))
+    {
+        return false;
+    }
+
+    data::pointer_t lhs(op->get_left_handside());
+    if(writes_left_handside(type)
+    && lhs != nullptr
+    && lhs->get_data_type() == node_t::NODE_VARIABLE
+    && lhs->get_string().compare(0, 5, "%temp") != 0)
+    {
+        writes.insert(lhs->get_string());
+        return false;
+    }
+
+    return true;
+}
+
+
+constexpr std::size_t const     NO_BLOCK = static_cast<std::size_t>(-1);
+
+
+/** \brief A basic block of a list of operations.
+ *
+ * A block starts with a label or after a jump and ends with a jump or
+ * just before the next label. The f_writes and f_kills_all fields
+ * summarize the side effects of all the operations of the block.
+ */
+struct basic_block
+{
+    std::vector<operation::list_t::iterator>
+                                f_operations = std::vector<operation::list_t::iterator>();
+    std::vector<std::size_t>    f_successors = std::vector<std::size_t>();
+    std::vector<std::size_t>    f_predecessors = std::vector<std::size_t>();
+    std::vector<std::size_t>    f_children = std::vector<std::size_t>();
+    std::size_t                 f_idom = NO_BLOCK;
+    std::set<std::string>       f_writes = std::set<std::string>();
+    bool                        f_kills_all = false;
+};
+
+
+std::string data_to_string(data::pointer_t d)
+{
+    std::stringstream ss;
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_BOOLEAN:
+        ss << (d->get_boolean() ? "true" : "false");
+        break;
+
+    case node_t::NODE_FALSE:
+        ss << "false";
+        break;
+
+    case node_t::NODE_FLOATING_POINT:
+        ss << d->get_floating_point().get();
+        break;
+
+    case node_t::NODE_IDENTIFIER:
+    case node_t::NODE_VARIABLE:
+        ss << d->get_string();
+        break;
+
+    case node_t::NODE_INTEGER:
+        ss << d->get_integer().get();
+        break;
+
+    case node_t::NODE_NULL:
+        ss << "null";
+        break;
+
+    case node_t::NODE_STRING:
+        ss << '"' << d->get_string() << '"';
+        break;
+
+    case node_t::NODE_TRUE:
+        ss << "true";
+        break;
+
+    default:
+        ss << '<' << node::type_to_string(d->get_data_type()) << '>';
+        break;
+
+    }
+    return ss.str();
+}
+
+
+void dump_operations(std::ostream & out, operation::list_t const & operations)
+{
+    for(auto const & op : operations)
+    {
+        node_t const type(op->get_operation());
+        if(type == node_t::NODE_LABEL)
+        {
+            out << op->get_label() << ":\n";
+            continue;
+        }
+
+        out << "    ";
+        if(op->get_result() != nullptr)
+        {
+            out << data_to_string(op->get_result()) << " = ";
+        }
+        out << node::type_to_string(type);
+
+        char const * separator(" ");
+        data::vector_t operands{
+            op->get_left_handside(),
+            op->get_right_handside(),
+        };
+        std::size_t const max(op->get_parameter_size());
+        for(std::size_t p(0); p < max; ++p)
+        {
+            operands.push_back(op->get_parameter(p));
+        }
+        for(auto const & d : operands)
+        {
+            if(d != nullptr)
+            {
+                out << separator << data_to_string(d);
+                separator = ", ";
+            }
+        }
+        if(!op->get_label().empty())
+        {
+            out << separator << op->get_label();
+        }
+        for(auto const & c : op->get_cases())
+        {
+            out << "\n        case " << data_to_string(c.f_low);
+            if(c.f_high != c.f_low)
+            {
+                out << " ... " << data_to_string(c.f_high);
+            }
+            out << ": " << c.f_label;
+        }
+        out << '\n';
+    }
+}
+
+
+
+/** \brief Number the values of one list of operations.
+ *
+ * Each list of operations (the main program and each user function)
+ * gets optimized on its own since the temporaries of a list are local
+ * to its frame.
+ *
+ * The list is cut in basic blocks and the blocks are numbered in the
+ * order of their dominator tree. Each node of the tree gets its own
+ * scope in the table of values: the values computed in a block are
+ * visible in all the blocks it dominates (i.e. after the join of an
+ * `if()/else` or in the body of a loop) and forgotten once its subtree
+ * was numbered.
+ *
+ * The single definition temporaries and the constants hold the same
+ * value wherever their definition dominates, so they can be used as is.
+ * The named variables get a new version each time they may be written.
+ * On entry to a block, the variables written on any path going from its
+ * immediate dominator to that block (i.e. the body of a loop for its
+ * header) get a new version, so a value computed in the dominator is
+ * only reused if its operands did not change on the way.
+ */
+class value_numbering
+{
+public:
+                            value_numbering(
+                                  operation::list_t & operations
+                                , constant_variable_t const & constants
+                                , bool main);
+
+    std::size_t             run();
+
+private:
+    void                    build_blocks();
+    void                    compute_dominators();
+    void                    enter_block(std::size_t idx);
+    std::size_t             number_block(std::size_t idx, std::vector<std::string> & keys);
+    bool                    is_single_definition(data::pointer_t d) const;
+    bool                    is_constant(data::pointer_t d) const;
+    data::pointer_t         resolve(data::pointer_t d, bool allow_literal) const;
+    void                    substitute(operation::pointer_t op);
+    std::string             operand_key(data::pointer_t d);
+    std::string             operation_key(operation::pointer_t op);
+    void                    kill(operation::pointer_t op);
+    std::size_t             remove_dead_code();
+
+    operation::list_t &     f_operations;
+    constant_variable_t const &
+                            f_constants;
+    bool                    f_main = false;
+    std::set<std::string>   f_single_definitions = std::set<std::string>();
+    std::set<std::string>   f_initialized = std::set<std::string>();
+    std::map<std::string, data::pointer_t>
+                            f_replacements = std::map<std::string, data::pointer_t>();
+    std::map<std::string, data::pointer_t>
+                            f_values = std::map<std::string, data::pointer_t>();
+    std::map<std::string, std::size_t>
+                            f_versions = std::map<std::string, std::size_t>();
+    std::size_t             f_epoch = 0;
+    std::size_t             f_last_epoch = 0;
+    std::vector<basic_block>
+                            f_blocks = std::vector<basic_block>();
+    std::map<std::string, data::pointer_t>
+                            f_table = std::map<std::string, data::pointer_t>();
+};
+
+
+value_numbering::value_numbering(
+          operation::list_t & operations
+        , constant_variable_t const & constants
+        , bool main)
+    : f_operations(operations)
+    , f_constants(constants)
+    , f_main(main)
+{
+    // a "%temp" defined exactly once and never written otherwise always
+    // holds the value computed by its definition; the result of a
+    // conditional expression (one store per branch) and the locals are
+    // left alone
+    //
+    std::map<std::string, std::size_t> definitions;
+    for(auto const & op : f_operations)
+    {
+        data::pointer_t result(op->get_result());
+        if(is_temporary_variable(result))
+        {
+            ++definitions[result->get_string()];
+        }
+        data::pointer_t lhs(op->get_left_handside());
+        if(writes_left_handside(op->get_operation())
+        && is_temporary_variable(lhs))
+        {
+            definitions[lhs->get_string()] += 2;
+        }
+    }
+    for(auto const & op : f_operations)
+    {
+        data::pointer_t result(op->get_result());
+        if(!is_temporary_variable(result))
+        {
+            continue;
+        }
+        std::string const & name(result->get_string());
+        if(definitions[name] == 1
+        && name.compare(0, 5, "%temp") == 0
+        && !result->get_node()->get_flag(flag_t::NODE_VARIABLE_FLAG_VARIABLE)
+        && is_number(result))
+        {
+            f_single_definitions.insert(name);
+        }
+    }
+}
+
+
+bool value_numbering::is_single_definition(data::pointer_t d) const
+{
+    return is_temporary_variable(d)
+        && f_single_definitions.find(d->get_string()) != f_single_definitions.end();
+}
+
+
+/** \brief Check whether a variable cannot change anymore.
+ *
+ * In the main program, a constant with an initializer only becomes
+ * constant once the initializer ran. The user functions only get called
+ * after that point.
+ */
+bool value_numbering::is_constant(data::pointer_t d) const
+{
+    if(!is_named_variable(d))
+    {
+        return false;
+    }
+    auto const it(f_constants.find(d->get_string()));
+    if(it == f_constants.end())
+    {
+        return false;
+    }
+    return !f_main
+        || it->second.f_initializer == nullptr
+        || f_initialized.find(d->get_string()) != f_initialized.end();
+}
+
+
+/** \brief Find the value of an operand.
+ *
+ * Follows the chain of copies and CSE replacements. When \p allow_literal
+ * is false, the last variable found in the chain is returned instead of
+ * the literal at the end of it.
+ */
+data::pointer_t value_numbering::resolve(data::pointer_t d, bool allow_literal) const
+{
+    for(;;)
+    {
+        if(d == nullptr
+        || d->get_data_type() != node_t::NODE_VARIABLE)
+        {
+            return d;
+        }
+        std::map<std::string, data::pointer_t> const & values(
+                    d->is_temporary() ? f_replacements : f_values);
+        auto const it(values.find(d->get_string()));
+        if(it == values.end())
+        {
+            return d;
+        }
+        if(!allow_literal
+        && is_literal(it->second))
+        {
+            return d;
+        }
+        d = it->second;
+    }
+}
+
+
+/** \brief Replace the operands of \p op with their known value.
+ *
+ * The binary assembler expects the literals on the right handside of
+ * the binary operators, so a literal only replaces a left handside when
+ * the operator is commutative and the operands can be swapped. The
+ * operators of the other operations always get a variable.
+ */
+void value_numbering::substitute(operation::pointer_t op)
+{
+    node_t const type(op->get_operation());
+    bool const binary(is_pure(type)
+                   && op->get_left_handside() != nullptr
+                   && op->get_right_handside() != nullptr);
+
+    data::pointer_t lhs(op->get_left_handside());
+    if(lhs != nullptr
+    && !writes_left_handside(type))
+    {
+        lhs = resolve(lhs, false);
+    }
+    data::pointer_t rhs(resolve(op->get_right_handside(), false));
+
+    if(binary)
+    {
+        data::pointer_t const lhs_value(resolve(lhs, true));
+        data::pointer_t const rhs_value(resolve(rhs, true));
+        if(is_literal(rhs_value)
+        && !is_literal(lhs))
+        {
+            rhs = rhs_value;
+        }
+        else if(is_literal(lhs_value)
+             && !is_literal(rhs)
+             && is_commutative(type))
+        {
+            lhs = rhs;
+            rhs = lhs_value;
+        }
+    }
+    else if(type == node_t::NODE_ASSIGNMENT
+         && rhs != nullptr)
+    {
+        rhs = resolve(rhs, true);
+    }
+
+    op->set_left_handside(lhs);
+    op->set_right_handside(rhs);
+
+    std::size_t const max(op->get_parameter_size());
+    for(std::size_t p(0); p < max; ++p)
+    {
+        op->set_parameter(p, resolve(op->get_parameter(p), false));
+    }
+}
+
+
+std::string value_numbering::operand_key(data::pointer_t d)
+{
+    if(d == nullptr)
+    {
+        return "-";
+    }
+
+    switch(d->get_data_type())
+    {
+    case node_t::NODE_BOOLEAN:
+        return d->get_boolean() ? "T" : "F";
+
+    case node_t::NODE_FALSE:
+        return "F";
+
+    case node_t::NODE_FLOATING_POINT:
+        {
+            double const value(d->get_floating_point().get());
+            std::uint64_t bits(0);
+            std::memcpy(&bits, &value, sizeof(bits));
+            return "f" + std::to_string(bits);
+        }
+
+    case node_t::NODE_IDENTIFIER:
+        return "n" + std::to_string(d->get_string().length()) + ":" + d->get_string();
+
+    case node_t::NODE_INTEGER:
+        return "i" + std::to_string(d->get_integer().get());
+
+    case node_t::NODE_STRING:
+        return "s" + std::to_string(d->get_string().length()) + ":" + d->get_string();
+
+    case node_t::NODE_TRUE:
+        return "T";
+
+    case node_t::NODE_VARIABLE:
+        if(is_single_definition(d))
+        {
+            return "t" + d->get_string();
+        }
+        if(is_constant(d))
+        {
+            return "c" + d->get_string();
+        }
+        return "v"
+            + d->get_string()
+            + "@"
+            + std::to_string(f_epoch)
+            + "."
+            + std::to_string(f_versions[d->get_string()]);
+
+    default:
+        return std::string();
+
+    }
+}
+
+
+std::string value_numbering::operation_key(operation::pointer_t op)
+{
+    if(op->get_parameter_size() != 0)
+    {
+        // i.e. an array with a range
+        //
+        return std::string();
+    }
+
+    std::string lhs(operand_key(op->get_left_handside()));
+    std::string rhs(operand_key(op->get_right_handside()));
+    if(lhs.empty()
+    || rhs.empty())
+    {
+        return std::string();
+    }
+    if(is_commutative(op->get_operation())
+    && rhs < lhs)
+    {
+        std::swap(lhs, rhs);
+    }
+
+    std::string key(node::type_to_string(op->get_operation()));
+    key += '|';
+    node::pointer_t type(op->get_node()->get_type_node());
+    if(type != nullptr)
+    {
+        key += type->get_string();
+    }
+    key += '|';
+    key += lhs;
+    key += '|';
+    key += rhs;
+    return key;
+}
+
+
+/** \brief Forget the values which \p op may change.
+ *
+ * A write to a variable gives it a new version. Any operation which
+ * may have other side effects (i.e. a call) starts a new epoch so all
+ * the variables get a new version at once.
+ */
+void value_numbering::kill(operation::pointer_t op)
+{
+    std::set<std::string> writes;
+    if(side_effect(op, writes))
+    {
+        f_epoch = ++f_last_epoch;
+    }
+    for(auto const & name : writes)
+    {
+        ++f_versions[name];
+    }
+}
+
+
+/** \brief Cut the list of operations in basic blocks.
+ *
+ * The successors of a block are the targets of its last operation and
+ * the next block when the last operation may fall through. The side
+ * effects of the operations of each block are saved in the block.
+ */
+void value_numbering::build_blocks()
+{
+    std::map<std::string, std::size_t> labels;
+    bool start(true);
+    for(auto it(f_operations.begin()); it != f_operations.end(); ++it)
+    {
+        node_t const type((*it)->get_operation());
+        if(start
+        || type == node_t::NODE_LABEL)
+        {
+            if(f_blocks.empty()
+            || !f_blocks.back().f_operations.empty())
+            {
+                f_blocks.emplace_back();
+            }
+            start = false;
+        }
+        if(type == node_t::NODE_LABEL)
+        {
+            labels[(*it)->get_label()] = f_blocks.size() - 1;
+        }
+
+        basic_block & block(f_blocks.back());
+        block.f_operations.push_back(it);
+        if(side_effect(*it, block.f_writes))
+        {
+            block.f_kills_all = true;
+        }
+
+        switch(type)
+        {
+        case node_t::NODE_GOTO:
+        case node_t::NODE_IF_FALSE:
+        case node_t::NODE_IF_TRUE:
+        case node_t::NODE_RETURN:
+        case node_t::NODE_SWITCH:
+            start = true;
+            break;
+
+        default:
+            break;
+
+        }
+    }
+
+    for(std::size_t idx(0); idx < f_blocks.size(); ++idx)
+    {
+        basic_block & block(f_blocks[idx]);
+        operation::pointer_t last(*block.f_operations.back());
+        auto const add_successor = [&](std::string const & label)
+        {
+            auto const target(labels.find(label));
+            if(target != labels.end())
+            {
+                block.f_successors.push_back(target->second);
+            }
+        };
+        bool fall_through(true);
+        switch(last->get_operation())
+        {
+        case node_t::NODE_GOTO:
+        case node_t::NODE_RETURN:
+            add_successor(last->get_label());
+            fall_through = false;
+            break;
+
+        case node_t::NODE_IF_FALSE:
+        case node_t::NODE_IF_TRUE:
+            add_successor(last->get_label());
+            break;
+
+        case node_t::NODE_SWITCH:
+            add_successor(last->get_label());
+            for(auto const & c : last->get_cases())
+            {
+                add_successor(c.f_label);
+            }
+            fall_through = false;
+            break;
+
+        default:
+            break;
+
+        }
+        if(fall_through
+        && idx + 1 < f_blocks.size())
+        {
+            block.f_successors.push_back(idx + 1);
+        }
+        for(auto const & successor : block.f_successors)
+        {
+            f_blocks[successor].f_predecessors.push_back(idx);
+        }
+    }
+}
+
+
+/** \brief Compute the dominator tree of the blocks.
+ *
+ * This is the iterative algorithm of Cooper, Harvey, and Kennedy over
+ * the blocks in reverse postorder. The blocks which cannot be reached
+ * from the first block have no immediate dominator and become roots.
+ */
+void value_numbering::compute_dominators()
+{
+    if(f_blocks.empty())
+    {
+        return;
+    }
+
+    // postorder of the reachable blocks
+    //
+    std::vector<std::size_t> order;
+    std::vector<bool> visited(f_blocks.size(), false);
+    std::vector<std::pair<std::size_t, std::size_t>> stack{ { 0, 0 } };
+    visited[0] = true;
+    while(!stack.empty())
+    {
+        auto & top(stack.back());
+        basic_block const & block(f_blocks[top.first]);
+        if(top.second < block.f_successors.size())
+        {
+            std::size_t const successor(block.f_successors[top.second]);
+            ++top.second;
+            if(!visited[successor])
+            {
+                visited[successor] = true;
+                stack.push_back({ successor, 0 });
+            }
+            continue;
+        }
+        order.push_back(top.first);
+        stack.pop_back();
+    }
+
+    std::vector<std::size_t> position(f_blocks.size(), NO_BLOCK);
+    for(std::size_t idx(0); idx < order.size(); ++idx)
+    {
+        position[order[idx]] = idx;
+    }
+    auto const intersect = [&](std::size_t a, std::size_t b)
+    {
+        while(a != b)
+        {
+            while(position[a] < position[b])
+            {
+                a = f_blocks[a].f_idom;
+            }
+            while(position[b] < position[a])
+            {
+                b = f_blocks[b].f_idom;
+            }
+        }
+        return a;
+    };
+
+    f_blocks[0].f_idom = 0;
+    bool changed(true);
+    while(changed)
+    {
+        changed = false;
+        for(auto it(order.rbegin()); it != order.rend(); ++it)
+        {
+            if(*it == 0)
+            {
+                continue;
+            }
+            std::size_t idom(NO_BLOCK);
+            for(auto const & p : f_blocks[*it].f_predecessors)
+            {
+                if(f_blocks[p].f_idom == NO_BLOCK)
+                {
+                    continue;
+                }
+                idom = idom == NO_BLOCK ? p : intersect(p, idom);
+            }
+            if(f_blocks[*it].f_idom != idom)
+            {
+                f_blocks[*it].f_idom = idom;
+                changed = true;
+            }
+        }
+    }
+
+    f_blocks[0].f_idom = NO_BLOCK;
+    for(std::size_t idx(1); idx < f_blocks.size(); ++idx)
+    {
+        std::size_t const idom(f_blocks[idx].f_idom);
+        if(idom != NO_BLOCK)
+        {
+            f_blocks[idom].f_children.push_back(idx);
+        }
+    }
+}
+
+
+/** \brief Apply the side effects of the paths reaching a block.
+ *
+ * The current state is the one found at the end of the immediate
+ * dominator of the block. The blocks found on the paths going from
+ * that dominator to this block (including this block itself when it
+ * is the header of a loop) may write some variables, so these get a
+ * new version. A root starts with a new epoch.
+ */
+void value_numbering::enter_block(std::size_t idx)
+{
+    std::size_t const idom(f_blocks[idx].f_idom);
+    if(idom == NO_BLOCK)
+    {
+        f_epoch = ++f_last_epoch;
+        return;
+    }
+
+    std::set<std::string> writes;
+    bool kills_all(false);
+    std::vector<bool> seen(f_blocks.size(), false);
+    std::vector<std::size_t> todo(f_blocks[idx].f_predecessors);
+    while(!todo.empty())
+    {
+        std::size_t const b(todo.back());
+        todo.pop_back();
+        if(b == idom
+        || seen[b]
+        || (b != 0 && f_blocks[b].f_idom == NO_BLOCK))
+        {
+            // the dominator itself, a block already handled, or a
+            // block which is never executed
+            //
+            continue;
+        }
+        seen[b] = true;
+        writes.insert(f_blocks[b].f_writes.begin(), f_blocks[b].f_writes.end());
+        kills_all = kills_all || f_blocks[b].f_kills_all;
+        todo.insert(todo.end(), f_blocks[b].f_predecessors.begin(), f_blocks[b].f_predecessors.end());
+    }
+
+    if(kills_all)
+    {
+        f_epoch = ++f_last_epoch;
+    }
+    for(auto const & name : writes)
+    {
+        ++f_versions[name];
+    }
+}
+
+
+/** \brief Number the values of the operations of one block.
+ *
+ * The keys added to the table are saved in \p keys so they can be
+ * removed once all the blocks dominated by this one were numbered.
+ */
+std::size_t value_numbering::number_block(std::size_t idx, std::vector<std::string> & keys)
+{
+    std::size_t removed(0);
+    for(auto const & it : f_blocks[idx].f_operations)
+    {
+        operation::pointer_t op(*it);
+        bool const last(std::next(it) == f_operations.end());
+
+        substitute(op);
+
+        node_t const type(op->get_operation());
+        data::pointer_t result(op->get_result());
+        if(type == node_t::NODE_ASSIGNMENT)
+        {
+            // copy propagation, the result of an assignment is its
+            // right handside
+            //
+            data::pointer_t rhs(op->get_right_handside());
+            if(rhs != nullptr
+            && is_single_definition(result)
+            && (is_single_definition(rhs) || (is_literal(rhs) && literal_matches(rhs, result))))
+            {
+                f_replacements[result->get_string()] = rhs;
+            }
+
+            // a constant initialized in the prologue of the main program
+            //
+            data::pointer_t lhs(op->get_left_handside());
+            if(f_main
+            && is_named_variable(lhs))
+            {
+                auto const c(f_constants.find(lhs->get_string()));
+                if(c != f_constants.end()
+                && c->second.f_initializer == op)
+                {
+                    f_initialized.insert(lhs->get_string());
+                    if(is_single_definition(rhs)
+                    || (is_literal(rhs) && literal_matches(rhs, lhs)))
+                    {
+                        f_values[lhs->get_string()] = rhs;
+                    }
+                }
+            }
+        }
+        else if(is_pure(type)
+             && is_single_definition(result))
+        {
+            std::string const key(operation_key(op));
+            if(!key.empty())
+            {
+                auto const e(f_table.find(key));
+                if(e == f_table.end())
+                {
+                    f_table[key] = result;
+                    keys.push_back(key);
+                }
+                else if(!last)
+                {
+                    // the main program returns the value computed by
+                    // its last operation so that one is always kept
+                    //
+                    f_replacements[result->get_string()] = e->second;
+                    f_operations.erase(it);
+                    ++removed;
+                    continue;
+                }
+            }
+        }
+
+        kill(op);
+    }
+
+    return removed;
+}
+
+
+std::size_t value_numbering::run()
+{
+    build_blocks();
+    compute_dominators();
+
+    // walk the dominator tree; each node saves the state found at its
+    // end so each of its children starts from that state
+    //
+    struct frame
+    {
+        std::size_t                         f_block = 0;
+        std::size_t                         f_next_child = 0;
+        std::size_t                         f_epoch = 0;
+        std::map<std::string, std::size_t>  f_versions = std::map<std::string, std::size_t>();
+        std::vector<std::string>            f_keys = std::vector<std::string>();
+    };
+
+    std::size_t removed(0);
+    std::vector<frame> stack;
+    auto const visit = [&](std::size_t idx)
+    {
+        enter_block(idx);
+        frame f;
+        f.f_block = idx;
+        removed += number_block(idx, f.f_keys);
+        f.f_epoch = f_epoch;
+        f.f_versions = f_versions;
+        stack.push_back(std::move(f));
+    };
+    for(std::size_t root(0); root < f_blocks.size(); ++root)
+    {
+        if(root != 0
+        && f_blocks[root].f_idom != NO_BLOCK)
+        {
+            continue;
+        }
+        f_versions.clear();
+        visit(root);
+        while(!stack.empty())
+        {
+            frame & top(stack.back());
+            if(top.f_next_child < f_blocks[top.f_block].f_children.size())
+            {
+                std::size_t const child(f_blocks[top.f_block].f_children[top.f_next_child]);
+                ++top.f_next_child;
+                f_epoch = top.f_epoch;
+                f_versions = top.f_versions;
+                visit(child);
+                continue;
+            }
+            for(auto const & key : top.f_keys)
+            {
+                f_table.erase(key);
+            }
+            stack.pop_back();
+        }
+    }
+
+    // the replacements found later in the list may apply to operations
+    // found earlier (i.e. in the condition of a loop); the values of the
+    // constants only apply after their initializer
+    //
+    f_values.clear();
+    for(auto const & op : f_operations)
+    {
+        substitute(op);
+    }
+
+    return removed + remove_dead_code();
+}
+
+
+/** \brief Remove the computations which results are never used.
+ *
+ * An assignment is kept but its result is dropped.
+ */
+std::size_t value_numbering::remove_dead_code()
+{
+    std::size_t removed(0);
+    bool changed(true);
+    while(changed)
+    {
+        changed = false;
+
+        std::map<std::string, std::size_t> uses;
+        for(auto const & op : f_operations)
+        {
+            data::vector_t operands{
+                op->get_left_handside(),
+                op->get_right_handside(),
+            };
+            std::size_t const max(op->get_parameter_size());
+            for(std::size_t p(0); p < max; ++p)
+            {
+                operands.push_back(op->get_parameter(p));
+            }
+            for(auto const & d : operands)
+            {
+                if(is_temporary_variable(d))
+                {
+                    ++uses[d->get_string()];
+                }
+            }
+        }
+
+        for(auto it(f_operations.begin()); it != f_operations.end();)
+        {
+            operation::pointer_t op(*it);
+            data::pointer_t result(op->get_result());
+            if(!is_single_definition(result)
+            || uses[result->get_string()] != 0
+            || std::next(it) == f_operations.end())
+            {
+                ++it;
+                continue;
+            }
+
+            node_t const type(op->get_operation());
+            if(is_pure(type))
+            {
+                it = f_operations.erase(it);
+                ++removed;
+                changed = true;
+                continue;
+            }
+            if(type == node_t::NODE_ASSIGNMENT
+            && op->get_right_handside() != nullptr)
+            {
+                op->set_result(data::pointer_t());
+            }
+            ++it;
+        }
+    }
+
+    return removed;
+}
+
+
+
+} // no name namespace
+
+
+
+/** \brief Optimize the flattened operations.
+ *
+ * The temporaries created by flatten() are assigned exactly once, by
+ * the operation computing them, so each of those values has a unique
+ * name. The exception is the result of a conditional expression which
+ * gets one store per branch; it is not optimized. The named variables
+ * (i.e. the loop counters) are written many times and no phi function
+ * merges their values where paths join, so they get versioned instead.
+ * This function runs these optimizations on those values:
+ *
+ * \li value numbering -- an operation computing the same value as an
+ *     operation found in a dominating block is removed and its result
+ *     replaced by the result of the earlier one (i.e. `a.length` or
+ *     `x * y` used twice, before an `if()` and after its join, or
+ *     before a loop and in its body); a variable gets a new number
+ *     each time it may be modified, including on the paths joining
+ *     at a label (i.e. the back-edge of a loop);
+ * \li copy propagation -- the uses of the result of an assignment are
+ *     replaced by the value being assigned;
+ * \li constant propagation -- a constant variable is never modified
+ *     once initialized, so its reads are not renumbered by calls and,
+ *     in the main program, they get replaced by its initial value;
+ *     this covers the `extern const` variables;
+ * \li dead code elimination -- the operations computing a temporary
+ *     which is never used are removed.
+ *
+ * Only the numeric temporaries (Integer, Double, Boolean) are handled.
+ * The strings are passed by pointer and may be modified in place.
+ */
+void flatten_nodes::optimize()
+{
+    // find the constants which cannot change once initialized
+    //
+    constant_variable_t constants;
+    std::map<std::string, std::size_t> writes;
+    auto const count_writes = [&writes](operation::list_t const & operations)
+    {
+        for(auto const & op : operations)
+        {
+            data::pointer_t lhs(op->get_left_handside());
+            if(writes_left_handside(op->get_operation())
+            && is_named_variable(lhs))
+            {
+                ++writes[lhs->get_string()];
+            }
+        }
+    };
+    count_writes(f_operations);
+    for(auto const & f : f_functions)
+    {
+        count_writes(f->get_operations());
+    }
+    std::map<std::string, operation::pointer_t> initializers;
+    for(auto const & op : f_operations)
+    {
+        if(ends_prologue(op))
+        {
+            break;
+        }
+        data::pointer_t lhs(op->get_left_handside());
+        if(op->get_operation() == node_t::NODE_ASSIGNMENT
+        && op->get_right_handside() != nullptr
+        && is_named_variable(lhs))
+        {
+            initializers[lhs->get_string()] = op;
+        }
+    }
+    for(auto const & v : f_variables)
+    {
+        if(!is_named_variable(v.second)
+        || !v.second->get_node()->get_flag(flag_t::NODE_VARIABLE_FLAG_CONST))
+        {
+            continue;
+        }
+        std::size_t const count(writes[v.first]);
+        if(count == 0)
+        {
+            constants[v.first] = constant_variable();
+        }
+        else if(count == 1)
+        {
+            auto const it(initializers.find(v.first));
+            if(it != initializers.end())
+            {
+                constants[v.first].f_initializer = it->second;
+            }
+        }
+    }
+
+    std::size_t const original_size(f_operations.size());
+    std::size_t removed(0);
+    for(auto const & f : f_functions)
+    {
+        value_numbering vn(f->get_operations(), constants, false);
+        removed += vn.run();
+    }
+    value_numbering vn(f_operations, constants, true);
+    removed += vn.run();
+
+    if(removed != 0)
+    {
+        message msg(message_level_t::MESSAGE_LEVEL_DEBUG, err_code_t::AS_ERR_NONE);
+        msg << "value numbering removed "
+            << removed
+            << " operations ("
+            << original_size
+            << " -> "
+            << f_operations.size()
+            << " in the main program).";
+    }
+}
+
+
+/** \brief Print the operations.
+ *
+ * This is used by the `--dump-ir` command line option of the as2js
+ * tool. Each operation is printed on its own line as:
+ *
+ * \code
+ *     <result> = <operation> <operands>, <label>
+ * \endcode
+ *
+ * \param[in] out  The stream where the operations get printed.
+ */
+void flatten_nodes::dump(std::ostream & out) const
+{
+    out << "; main program\n";
+    dump_operations(out, f_operations);
+
+    for(auto const & f : f_functions)
+    {
+        out << "\n; function " << f->get_label() << "(";
+        char const * separator("");
+        for(auto const & p : f->get_parameters())
+        {
+            out << separator << data_to_string(p);
+            separator = ", ";
+        }
+        out << ")";
+        if(f->get_return_value() != nullptr)
+        {
+            out << " -> " << data_to_string(f->get_return_value());
+        }
+        out << "\n";
+        dump_operations(out, f->get_operations());
+    }
+}
+
+
+
+} // namespace as2js
+// vim: ts=4 sw=4 et
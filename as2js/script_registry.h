@@ -0,0 +1,114 @@
+// Copyright (c) 2005-2025  Made to Order Software Corp.  All Rights Reserved
+//
+// https://snapwebsites.org/project/as2js
+// contact@m2osw.com
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#pragma once
+
+/** \brief Manage a large number of compiled scripts.
+ *
+ * A service running many small scripts wants to load each binary once,
+ * share it between all of its threads, and not keep scripts that were
+ * not used in a long time in memory. The script_registry handles all
+ * of that: it loads running_file images by filename or by content,
+ * shares them through a shared pointer, evicts the least recently used
+ * images once the total memory limit is reached, and reloads a file
+ * once its modification time changes.
+ */
+
+// self
+//
+#include    <as2js/binary.h>
+
+
+// C++
+//
+#include    <list>
+#include    <mutex>
+#include    <set>
+
+
+
+namespace as2js
+{
+
+
+
+class script_registry
+{
+public:
+    typedef std::shared_ptr<script_registry>    pointer_t;
+    typedef std::uint64_t                       hash_t;
+
+    static constexpr std::size_t                DEFAULT_MEMORY_LIMIT = 256 * 1024 * 1024;
+
+                                script_registry(std::size_t memory_limit = DEFAULT_MEMORY_LIMIT);
+                                script_registry(script_registry const &) = delete;
+    script_registry &           operator = (script_registry const &) = delete;
+
+    void                        set_memory_limit(std::size_t memory_limit);
+    std::size_t                 get_memory_limit() const;
+    std::size_t                 get_memory_usage() const;
+    std::size_t                 size() const;
+
+    running_file::pointer_t     get(std::string const & filename);
+    running_file::pointer_t     get_from_content(std::string const & image);
+    running_file::pointer_t     find(hash_t hash);
+    void                        invalidate(std::string const & filename);
+    void                        clear();
+
+    static hash_t               hash(void const * data, std::size_t size);
+
+private:
+    typedef std::list<hash_t>   lru_t;
+
+    struct image_entry
+    {
+        running_file::pointer_t f_file = running_file::pointer_t();
+        std::size_t             f_memory_size = 0;
+        lru_t::iterator         f_lru = lru_t::iterator();
+        std::set<std::string>   f_filenames = std::set<std::string>();
+        bool                    f_by_content = false;
+    };
+    typedef std::map<hash_t, image_entry>       image_map_t;
+
+    struct file_entry
+    {
+        hash_t                  f_hash = 0;
+        std::int64_t            f_mtime_sec = 0;
+        std::int64_t            f_mtime_nsec = 0;
+        std::int64_t            f_size = 0;
+        std::int64_t            f_inode = 0;
+    };
+    typedef std::map<std::string, file_entry>   file_map_t;
+
+    running_file::pointer_t     add_image(hash_t hash, running_file::pointer_t file);
+    void                        touch(image_entry & image);
+    void                        forget_file(file_map_t::iterator it);
+    void                        erase_image(image_map_t::iterator it);
+    void                        evict();
+
+    mutable std::mutex          f_mutex = std::mutex();
+    std::size_t                 f_memory_limit = DEFAULT_MEMORY_LIMIT;
+    std::size_t                 f_memory_usage = 0;
+    lru_t                       f_lru = lru_t();            // most recently used first
+    image_map_t                 f_images = image_map_t();
+    file_map_t                  f_files = file_map_t();
+};
+
+
+
+} // namespace as2js
+// vim: ts=4 sw=4 et
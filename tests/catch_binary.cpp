@@ -19,6 +19,9 @@
 // as2js
 //
 #include    <as2js/binary.h>
+#include    <as2js/script_registry.h>
+
+#include    <as2js/exception.h>
 
 
 
@@ -37,12 +40,20 @@
 
 // C++
 //
+#include    <algorithm>
+#include    <chrono>
+#include    <fstream>
 #include    <iomanip>
+#include    <set>
 
 
 // C
 //
 #include    <math.h>
+#include    <stddef.h>
+#include    <stdio.h>
+#include    <string.h>
+#include    <unistd.h>
 
 
 // last include
@@ -56,27 +67,37 @@ namespace
 
 
 
-void run_script(std::string const & s)
+// for the script to work, the compiler must find the scripts directory
+// which is defined in the rc file
+//
+void write_rc()
+{
+    std::ofstream rc("as2js/as2js.rc");
+    rc << "{\"scripts\":\""
+       << SNAP_CATCH2_NAMESPACE::g_source_dir()
+       << "/scripts\"}\n";
+}
+
+
+void run_script(std::string const & s, std::string const & options = std::string())
 {
     std::string cmd("export AS2JS_RC='");
     cmd += SNAP_CATCH2_NAMESPACE::g_binary_dir();
     cmd += "' && ";
 //cmd += "gdb -ex \"catch throws\" -ex \"run\" -args ";
     cmd += SNAP_CATCH2_NAMESPACE::g_binary_dir();
-    cmd += "/tools/as2js -b -o ";
+    cmd += "/tools/as2js -b ";
+    if(!options.empty())
+    {
+        cmd += options;
+        cmd += ' ';
+    }
+    cmd += "-o ";
     cmd += SNAP_CATCH2_NAMESPACE::g_binary_dir();
     cmd += "/tests/a.out ";
     cmd += s;
 
-    // for the script to work, the compiler must find the scripts directory
-    // which is defined in the rc file
-    //
-    {
-        std::ofstream rc("as2js/as2js.rc");
-        rc << "{\"scripts\":\""
-           << SNAP_CATCH2_NAMESPACE::g_source_dir()
-           << "/scripts\"}\n";
-    }
+    write_rc();
 
     // first compile the file
     //
@@ -90,6 +111,161 @@ std::cerr << "-------------- system() called returned from binary test (" << r <
 }
 
 
+// compile the script with --dump-ir and return the optimized operations
+//
+std::string dump_ir(std::string const & s)
+{
+    std::string const output(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/operations.ir");
+
+    std::string cmd("export AS2JS_RC='");
+    cmd += SNAP_CATCH2_NAMESPACE::g_binary_dir();
+    cmd += "' && ";
+    cmd += SNAP_CATCH2_NAMESPACE::g_binary_dir();
+    cmd += "/tools/as2js --dump-ir ";
+    cmd += s;
+    cmd += " >";
+    cmd += output;
+
+    write_rc();
+
+    std::cout
+        << "--- dump operations with command \""
+        << cmd
+        << "\".\n";
+    int const r(system(cmd.c_str()));
+    CATCH_REQUIRE(r == 0);
+
+    snapdev::file_contents ir(output);
+    CATCH_REQUIRE(ir.read_all());
+    return ir.contents();
+}
+
+
+std::size_t count_occurrences(std::string const & text, std::string const & pattern)
+{
+    std::size_t count(0);
+    for(std::string::size_type pos(text.find(pattern));
+        pos != std::string::npos;
+        pos = text.find(pattern, pos + pattern.length()))
+    {
+        ++count;
+    }
+    return count;
+}
+
+
+// the protection of the page holding ptr as found in /proc/self/maps
+// (i.e. "r-xp")
+//
+std::string page_protection(void const * ptr)
+{
+    std::uintptr_t const address(reinterpret_cast<std::uintptr_t>(ptr));
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while(std::getline(maps, line))
+    {
+        std::uintptr_t start(0);
+        std::uintptr_t end(0);
+        char protection[5] = {};
+        if(sscanf(line.c_str(), "%lx-%lx %4s", &start, &end, protection) == 3
+        && address >= start
+        && address < end)
+        {
+            return protection;
+        }
+    }
+    return std::string();
+}
+
+
+// add a JMP (cc < 0) or a Jcc with a 32 bit displacement to label
+//
+void add_jump(as2js::build_file & file, std::string const & label, int cc = -1)
+{
+    std::vector<std::uint8_t> jump;
+    if(cc < 0)
+    {
+        jump = { 0xE9, 0x00, 0x00, 0x00, 0x00 };
+    }
+    else
+    {
+        jump = { 0x0F, static_cast<std::uint8_t>(0x80 | cc), 0x00, 0x00, 0x00, 0x00 };
+    }
+    as2js::offset_t const start(file.get_current_text_offset());
+    file.add_relocation(
+              label
+            , as2js::relocation_t::RELOCATION_LABEL_32BITS
+            , start + jump.size() - 4
+            , start + jump.size());
+    file.add_text(jump.data(), jump.size());
+}
+
+
+void add_nops(as2js::build_file & file, std::size_t count)
+{
+    std::vector<std::uint8_t> const nops(count, 0x90);
+    file.add_text(nops.data(), nops.size());
+}
+
+
+// finalize the file and return its .text without the INT3 padding
+//
+std::vector<std::uint8_t> finalize_text(as2js::build_file & file)
+{
+    std::vector<std::uint8_t> image(file.finalize());
+    file.save(image.data());
+
+    as2js::binary_header const * header(reinterpret_cast<as2js::binary_header const *>(image.data()));
+    CATCH_REQUIRE(header->f_start == sizeof(as2js::binary_header));
+    CATCH_REQUIRE(header->f_variables % as2js::BINARY_PAGE_SIZE == 0);
+    CATCH_REQUIRE(header->f_variables <= image.size());
+
+    std::vector<std::uint8_t> text(
+              image.begin() + header->f_start
+            , image.begin() + header->f_variables);
+    while(!text.empty() && text.back() == 0xCC)
+    {
+        text.pop_back();
+    }
+    return text;
+}
+
+
+// the offset where the jump found at offset lands
+//
+std::int64_t jump_target(std::vector<std::uint8_t> const & text, std::size_t offset)
+{
+    if(text[offset] == 0xEB
+    || (text[offset] & 0xF0) == 0x70)
+    {
+        return offset + 2 + static_cast<std::int8_t>(text[offset + 1]);
+    }
+
+    std::size_t size(5);
+    if(text[offset] == 0x0F)
+    {
+        CATCH_REQUIRE((text[offset + 1] & 0xF0) == 0x80);
+        size = 6;
+    }
+    else
+    {
+        CATCH_REQUIRE(text[offset] == 0xE9);
+    }
+    std::int32_t disp(0);
+    memcpy(&disp, text.data() + offset + size - 4, sizeof(disp));
+    return offset + size + disp;
+}
+
+
+// get a runtime function from the external function table
+//
+template<typename F>
+F extern_function(as2js::external_function_t func)
+{
+    return reinterpret_cast<F>(as2js::get_extern_function(func));
+}
+
+
 
 enum class value_type_t : std::uint16_t
 {
@@ -358,14 +534,8 @@ meta load_script_meta(std::string const & s)
 }
 
 
-void execute(meta const & m)
+void set_variables(as2js::running_file & script, meta const & m)
 {
-    std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
-    filename += "/tests/a.out";
-
-    as2js::running_file script;
-    CATCH_REQUIRE(script.load(filename));
-
     for(auto const & var : m.f_variables)
     {
         if(!var.second.is_out())
@@ -441,6 +611,18 @@ void execute(meta const & m)
             }
         }
     }
+}
+
+
+void execute(meta const & m)
+{
+    std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+    filename += "/tests/a.out";
+
+    as2js::running_file script;
+    CATCH_REQUIRE(script.load(filename));
+
+    set_variables(script, m);
 
     as2js::binary_result result;
 
@@ -717,6 +899,329 @@ void execute(meta const & m)
 }
 
 
+double meta_to_double(std::string const & value)
+{
+    if(value == "POSITIVE_INFINITY")
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    if(value == "NEGATIVE_INFINITY")
+    {
+        return -std::numeric_limits<double>::infinity();
+    }
+    if(value == "EPSILON")
+    {
+        return 2.220446049250313e-16;
+    }
+    return std::stod(value, nullptr);
+}
+
+
+template<typename T>
+void compare_batch(
+      as2js::running_file & script
+    , as2js::batch_column::vector_t const & columns
+    , std::size_t const rows
+    , std::string const & name)
+{
+    // note: std::vector<bool> does not offer a data() function
+    //
+    std::unique_ptr<T[]> batch_results(new T[rows]);
+    std::unique_ptr<T[]> run_results(new T[rows]);
+
+    // one run() per row, the way it was done before run_batch() existed
+    //
+    as2js::execution_context::pointer_t c1(script.create_context());
+    std::vector<as2js::binary_variable *> vars;
+    for(auto const & c : columns)
+    {
+        vars.push_back(c1->get_variables() + c.get_handle().get_index());
+    }
+    auto const run_start(std::chrono::steady_clock::now());
+    for(std::size_t row(0); row < rows; ++row)
+    {
+        for(std::size_t col(0); col < columns.size(); ++col)
+        {
+            columns[col].apply(vars[col], row);
+        }
+        as2js::binary_result result;
+        script.run(*c1, result);
+        if constexpr (std::is_same_v<T, std::int64_t>)
+        {
+            run_results[row] = result.get_integer();
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            run_results[row] = result.get_floating_point();
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            run_results[row] = result.get_string();
+        }
+        else
+        {
+            run_results[row] = result.get_boolean();
+        }
+    }
+    auto const run_end(std::chrono::steady_clock::now());
+
+    as2js::execution_context::pointer_t c2(script.create_context());
+    auto const batch_start(std::chrono::steady_clock::now());
+    script.run_batch(*c2, columns, rows, batch_results.get());
+    auto const batch_end(std::chrono::steady_clock::now());
+
+    std::cout
+        << "--- "
+        << name
+        << ": "
+        << rows
+        << " rows, run(): "
+        << std::chrono::duration_cast<std::chrono::microseconds>(run_end - run_start).count()
+        << "us, run_batch(): "
+        << std::chrono::duration_cast<std::chrono::microseconds>(batch_end - batch_start).count()
+        << "us\n";
+
+    for(std::size_t row(0); row < rows; ++row)
+    {
+        if constexpr (std::is_same_v<T, double>)
+        {
+            if(std::isnan(run_results[row]))
+            {
+                CATCH_REQUIRE(std::isnan(batch_results[row]));
+                continue;
+            }
+        }
+        CATCH_REQUIRE(batch_results[row] == run_results[row]);
+    }
+}
+
+
+void benchmark_batch(std::string const & s, std::size_t const rows)
+{
+    run_script(s);
+    meta const m(load_script_meta(s));
+
+    std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+    filename += "/tests/a.out";
+
+    as2js::running_file script;
+    CATCH_REQUIRE(script.load(filename));
+
+    // build the columns; the first integer/double column gets a different
+    // value on each row so the rows are not all identical
+    //
+    std::list<std::vector<std::int64_t>> integers;
+    std::list<std::vector<double>> doubles;
+    std::list<std::vector<std::string>> strings;
+    std::list<std::unique_ptr<bool[]>> booleans;
+    bool varied(false);
+    as2js::batch_column::vector_t columns;
+    for(auto const & var : m.f_variables)
+    {
+        if(var.second.is_out())
+        {
+            continue;
+        }
+        as2js::variable_handle const handle(script.get_handle(var.first));
+        switch(var.second.get_type())
+        {
+        case value_type_t::VALUE_TYPE_BOOLEAN:
+            booleans.emplace_back(new bool[rows]);
+            for(std::size_t row(0); row < rows; ++row)
+            {
+                booleans.back()[row] = var.second.f_value == "true";
+            }
+            columns.emplace_back(handle, booleans.back().get());
+            break;
+
+        case value_type_t::VALUE_TYPE_INTEGER:
+            integers.emplace_back(rows, std::stoll(var.second.f_value, nullptr, 0));
+            if(!varied)
+            {
+                for(std::size_t row(0); row < rows; ++row)
+                {
+                    integers.back()[row] += row & 255;
+                }
+                varied = true;
+            }
+            columns.emplace_back(handle, integers.back().data());
+            break;
+
+        case value_type_t::VALUE_TYPE_FLOATING_POINT:
+            doubles.emplace_back(rows, meta_to_double(var.second.f_value));
+            if(!varied)
+            {
+                for(std::size_t row(0); row < rows; ++row)
+                {
+                    doubles.back()[row] += static_cast<double>(row & 255) / 8.0;
+                }
+                varied = true;
+            }
+            columns.emplace_back(handle, doubles.back().data());
+            break;
+
+        case value_type_t::VALUE_TYPE_STRING:
+            strings.emplace_back(rows, var.second.f_value);
+            columns.emplace_back(handle, strings.back().data());
+            break;
+
+        default:
+            CATCH_REQUIRE(!"variable type not supported by benchmark_batch().");
+            break;
+
+        }
+    }
+
+    switch(m.f_result.get_type())
+    {
+    case value_type_t::VALUE_TYPE_BOOLEAN:
+        compare_batch<bool>(script, columns, rows, s);
+        break;
+
+    case value_type_t::VALUE_TYPE_INTEGER:
+        compare_batch<std::int64_t>(script, columns, rows, s);
+        break;
+
+    case value_type_t::VALUE_TYPE_FLOATING_POINT:
+        compare_batch<double>(script, columns, rows, s);
+        break;
+
+    case value_type_t::VALUE_TYPE_STRING:
+        compare_batch<std::string>(script, columns, rows, s);
+        break;
+
+    default:
+        CATCH_REQUIRE(!"result type not supported by benchmark_batch().");
+        break;
+
+    }
+}
+
+
+
+// size of the .text section without the INT3 used to pad it to a page
+//
+std::size_t text_size(as2js::running_file const & script)
+{
+    as2js::binary_header const * header(reinterpret_cast<as2js::binary_header const *>(script.get_image()));
+    std::uint8_t const * image(script.get_image());
+    std::size_t end(header->f_variables);
+    while(end > header->f_start && image[end - 1] == 0xCC)
+    {
+        --end;
+    }
+    return end - header->f_start;
+}
+
+
+struct allocation_measure
+{
+    std::size_t     f_text_size = 0;
+    std::int64_t    f_duration = 0;     // in microseconds
+};
+
+
+// compile the script with or without the register allocator, verify its
+// result against the .meta and run it `runs` times to time it
+//
+allocation_measure measure_register_allocation(
+      std::string const & s
+    , meta const & m
+    , bool allocate
+    , std::size_t runs)
+{
+    run_script(s, allocate ? std::string() : std::string("--no-register-allocation true"));
+    execute(m);
+
+    as2js::running_file script;
+    CATCH_REQUIRE(script.load(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out"));
+    set_variables(script, m);
+
+    as2js::binary_result result;
+    auto const start(std::chrono::steady_clock::now());
+    for(std::size_t idx(0); idx < runs; ++idx)
+    {
+        script.run(result);
+    }
+    auto const end(std::chrono::steady_clock::now());
+
+    allocation_measure measure;
+    measure.f_text_size = text_size(script);
+    measure.f_duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    return measure;
+}
+
+
+// compile a script appending `count` fragments to a string and verify
+// the result
+//
+void append_fragments(std::size_t const count)
+{
+    std::string const fragment("fragment #");
+
+    // without loops, the script is a sequence of appends
+    //
+    std::string const script_filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/string_append.ajs");
+    {
+        std::ofstream script(script_filename);
+        script << "use extended_operators;\n"
+                  "extern const fragment: String;\n"
+                  "extern var r_append: String;\n"
+                  "r_append := \"\";\n";
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            script << "r_append += fragment;\n";
+        }
+    }
+    run_script(script_filename);
+
+    std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+    filename += "/tests/a.out";
+
+    as2js::running_file script;
+    CATCH_REQUIRE(script.load(filename));
+    as2js::execution_context::pointer_t c(script.create_context());
+    c->set_variable("fragment", fragment);
+
+    std::string expected;
+    for(std::size_t idx(0); idx < count; ++idx)
+    {
+        expected += fragment;
+    }
+
+    auto const start(std::chrono::steady_clock::now());
+    as2js::binary_result result;
+    script.run(*c, result);
+    auto const end(std::chrono::steady_clock::now());
+
+    std::cout
+        << "--- string_append: "
+        << count
+        << " appends in "
+        << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+        << "us\n";
+
+    CATCH_REQUIRE(result.get_string() == expected);
+    std::string value;
+    c->get_variable("r_append", value);
+    CATCH_REQUIRE(value == expected);
+
+    // the views reference the variables of the context, no copies
+    //
+    std::string_view view;
+    c->get_variable("r_append", view);
+    CATCH_REQUIRE(view == expected);
+    CATCH_REQUIRE(result.get_string_view() == expected);
+
+    // the string grows geometrically so the arena holds much less
+    // than the sum of all the intermediate strings (a small string
+    // still fits in the first block)
+    //
+    CATCH_REQUIRE(c->get_arena().get_capacity()
+            <= std::max(expected.length() * 8, as2js::execution_arena::DEFAULT_BLOCK_SIZE));
+}
+
+
 
 }
 
@@ -817,5 +1322,1224 @@ CATCH_TEST_CASE("binary_string_operators", "[binary][binary_string]")
 }
 
 
+CATCH_TEST_CASE("binary_protection", "[binary][protection]")
+{
+    CATCH_START_SECTION("binary_protection: .text is read/execute, .data starts on a page")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_additive.ajs");
+
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out"));
+
+        as2js::binary_header const * header(reinterpret_cast<as2js::binary_header const *>(script.get_image()));
+        CATCH_REQUIRE(header->f_variables % as2js::BINARY_PAGE_SIZE == 0);
+        CATCH_REQUIRE(header->f_variables % sysconf(_SC_PAGESIZE) == 0);
+
+        // the .text gets padded with INT3 up to the next page only
+        //
+        std::uint8_t const * image(script.get_image());
+        std::size_t padding(0);
+        while(image[header->f_variables - padding - 1] == 0xCC)
+        {
+            ++padding;
+        }
+        CATCH_REQUIRE(padding < as2js::BINARY_PAGE_SIZE);
+
+        std::string const text(page_protection(script.get_image() + header->f_start));
+        CATCH_REQUIRE(text.length() == 4);
+        CATCH_REQUIRE(text[0] == 'r');
+        CATCH_REQUIRE(text[1] == '-');
+        CATCH_REQUIRE(text[2] == 'x');
+
+        std::string const data(page_protection(script.get_image() + header->f_variables));
+        CATCH_REQUIRE(data.length() == 4);
+        CATCH_REQUIRE(data[2] == '-');
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_extern_functions", "[binary][extern]")
+{
+    CATCH_START_SECTION("binary_extern_functions: table linked on load and called through %rip")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/math_operator_rounding.ajs");
+
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out");
+        snapdev::file_contents file(filename);
+        CATCH_REQUIRE(file.read_all());
+        std::string const & image(file.contents());
+        CATCH_REQUIRE(image.length() >= sizeof(as2js::binary_header));
+
+        as2js::binary_header const * header(reinterpret_cast<as2js::binary_header const *>(image.data()));
+        CATCH_REQUIRE(header->f_extern_function_count > 0);
+        CATCH_REQUIRE(header->f_extern_functions >= header->f_variables);
+        CATCH_REQUIRE(header->f_extern_functions % sizeof(std::uint64_t) == 0);
+        CATCH_REQUIRE(header->f_extern_functions + header->f_extern_function_count * sizeof(std::uint64_t) <= image.length());
+
+        // in the file, each slot holds an external_function_t number
+        // (EXTERNAL_FUNCTION_STRINGS_HASH is the last one)
+        //
+        std::vector<std::uint64_t> slots(header->f_extern_function_count);
+        memcpy(slots.data(), image.data() + header->f_extern_functions, slots.size() * sizeof(std::uint64_t));
+        std::size_t floor_slot(slots.size());
+        for(std::size_t idx(0); idx < slots.size(); ++idx)
+        {
+            CATCH_REQUIRE(slots[idx] < static_cast<std::uint64_t>(as2js::external_function_t::EXTERNAL_FUNCTION_STRINGS_HASH) + 1);
+            if(slots[idx] == static_cast<std::uint64_t>(as2js::external_function_t::EXTERNAL_FUNCTION_MATH_FLOOR))
+            {
+                floor_slot = idx;
+            }
+        }
+        CATCH_REQUIRE(floor_slot < slots.size());
+
+        // the RELOCATION_EXTERN_FUNCTION entries point the CALL *disp32(%rip)
+        // instructions to their slot
+        //
+        std::set<std::size_t> called_slots;
+        for(std::size_t pos(header->f_start); pos + 6 <= header->f_variables; ++pos)
+        {
+            if(static_cast<std::uint8_t>(image[pos]) != 0xFF
+            || static_cast<std::uint8_t>(image[pos + 1]) != 0x15)
+            {
+                continue;
+            }
+            std::int32_t disp(0);
+            memcpy(&disp, image.data() + pos + 2, sizeof(disp));
+            std::int64_t const target(static_cast<std::int64_t>(pos) + 6 + disp);
+            std::int64_t const table_start(header->f_extern_functions);
+            std::int64_t const table_end(table_start + header->f_extern_function_count * sizeof(std::uint64_t));
+            if(target >= table_start
+            && target < table_end
+            && (target - table_start) % sizeof(std::uint64_t) == 0)
+            {
+                called_slots.insert((target - table_start) / sizeof(std::uint64_t));
+            }
+        }
+        for(std::size_t idx(0); idx < slots.size(); ++idx)
+        {
+            if(slots[idx] != static_cast<std::uint64_t>(as2js::external_function_t::EXTERNAL_FUNCTION_CPU_FEATURES))
+            {
+                CATCH_REQUIRE(called_slots.find(idx) != called_slots.end());
+            }
+        }
+
+        // once loaded, the slots hold the address of the functions
+        //
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(filename));
+        std::uint64_t const * table(reinterpret_cast<std::uint64_t const *>(script.get_image() + header->f_extern_functions));
+        double (*floor_function)(double)(::floor);
+        CATCH_REQUIRE(table[floor_slot] == reinterpret_cast<std::uint64_t>(floor_function));
+
+        // and the code calls them
+        //
+        script.set_variable("nh", -2.5);
+        as2js::binary_result result;
+        script.run(result);
+        CATCH_REQUIRE(result.get_floating_point() == -3.0);
+        double value(0.0);
+        script.get_variable("r_floor_nh", value);
+        CATCH_REQUIRE(value == -3.0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_extern_functions: invalid images are rejected")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/math_operator_rounding.ajs");
+
+        std::string const a_out(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out");
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/invalid.out");
+        snapdev::file_contents file(a_out);
+        CATCH_REQUIRE(file.read_all());
+        std::string const original(file.contents());
+        auto save_image = [&filename](std::string const & image)
+        {
+            std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+            out.write(image.data(), image.length());
+        };
+
+        {
+            // unchanged, it loads
+            //
+            save_image(original);
+            as2js::running_file script;
+            CATCH_REQUIRE(script.load(filename));
+        }
+
+        {
+            // a 1.3 image uses absolute addresses to call the external
+            // functions, it cannot run with this version
+            //
+            std::string image(original);
+            image[offsetof(as2js::binary_header, f_version_minor)] = 3;
+            save_image(image);
+            as2js::running_file script;
+            CATCH_REQUIRE_FALSE(script.load(filename));
+            as2js::running_file mapped;
+            CATCH_REQUIRE_FALSE(mapped.map(filename));
+        }
+
+        {
+            // an unknown external function
+            //
+            std::string image(original);
+            as2js::binary_header const * header(reinterpret_cast<as2js::binary_header const *>(image.data()));
+            std::uint64_t const unknown(10'000);
+            memcpy(image.data() + header->f_extern_functions, &unknown, sizeof(unknown));
+            save_image(image);
+            as2js::running_file script;
+            CATCH_REQUIRE_FALSE(script.load(filename));
+        }
+
+        {
+            // a table which is not in the .data section
+            //
+            std::string image(original);
+            as2js::binary_header * header(reinterpret_cast<as2js::binary_header *>(image.data()));
+            header->f_extern_functions = header->f_start;
+            save_image(image);
+            as2js::running_file script;
+            CATCH_REQUIRE_FALSE(script.load(filename));
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_peephole", "[binary][peephole]")
+{
+    CATCH_START_SECTION("binary_peephole: redundant instructions are removed")
+    {
+        as2js::build_file file;
+
+        std::uint8_t const store_rax[] = { 0x48, 0x89, 0x45, 0xF8 };        // MOV %rax, -8(%rbp)
+        std::uint8_t const load_rax[] = { 0x48, 0x8B, 0x45, 0xF8 };         // MOV -8(%rbp), %rax
+        std::uint8_t const self_move[] = { 0x48, 0x89, 0xC0 };              // MOV %rax, %rax
+        std::uint8_t const load_rcx[] = { 0x48, 0x8B, 0x4D, 0xF8 };         // MOV -8(%rbp), %rcx
+        std::uint8_t const store_rax_16[] = { 0x48, 0x89, 0x45, 0xF0 };     // MOV %rax, -16(%rbp)
+        std::uint8_t const load_rax_16[] = { 0x48, 0x8B, 0x45, 0xF0 };      // MOV -16(%rbp), %rax
+        std::uint8_t const ret[] = { 0xC3 };
+
+        file.add_text(store_rax, sizeof(store_rax));
+        file.add_text(load_rax, sizeof(load_rax));          // removed
+        file.add_text(self_move, sizeof(self_move));        // removed
+        add_jump(file, "next");                             // removed
+        file.add_label("next");
+        file.add_text(load_rcx, sizeof(load_rcx));          // other register, kept
+        file.add_text(store_rax_16, sizeof(store_rax_16));
+        file.add_label("branch");
+        file.add_text(load_rax_16, sizeof(load_rax_16));    // label, kept
+        file.add_text(ret, sizeof(ret));
+
+        std::vector<std::uint8_t> const expected{
+            0x48, 0x89, 0x45, 0xF8,
+            0x48, 0x8B, 0x4D, 0xF8,
+            0x48, 0x89, 0x45, 0xF0,
+            0x48, 0x8B, 0x45, 0xF0,
+            0xC3,
+        };
+        CATCH_REQUIRE(finalize_text(file) == expected);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_peephole: forward jumps at the limit of a disp8")
+    {
+        as2js::build_file file;
+
+        std::uint8_t const ret[] = { 0xC3 };
+
+        add_jump(file, "near", 0x04);       // JE, label 127 bytes after the jump
+        add_nops(file, 127);
+        file.add_label("near");
+        add_jump(file, "far");              // JMP, label 128 bytes after the jump
+        add_nops(file, 128);
+        file.add_label("far");
+        file.add_text(ret, sizeof(ret));
+
+        std::vector<std::uint8_t> const text(finalize_text(file));
+        CATCH_REQUIRE(text.size() == 2 + 127 + 5 + 128 + 1);
+
+        CATCH_REQUIRE(text[0] == 0x74);     // JE disp8
+        CATCH_REQUIRE(text[1] == 0x7F);
+        CATCH_REQUIRE(jump_target(text, 0) == 2 + 127);
+
+        std::size_t const far(2 + 127);
+        CATCH_REQUIRE(text[far] == 0xE9);   // JMP disp32
+        CATCH_REQUIRE(text[far + 1] == 0x80);
+        CATCH_REQUIRE(text[far + 2] == 0x00);
+        CATCH_REQUIRE(text[far + 3] == 0x00);
+        CATCH_REQUIRE(text[far + 4] == 0x00);
+        CATCH_REQUIRE(jump_target(text, far) == far + 5 + 128);
+
+        CATCH_REQUIRE(text.back() == 0xC3);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_peephole: backward jumps at the limit of a disp8")
+    {
+        as2js::build_file file;
+
+        std::uint8_t const ret[] = { 0xC3 };
+
+        // the optimizer checks the displacement of the 32 bit jump so
+        // -128 from the end of the long jump is the limit; the short
+        // jump is 3 bytes smaller so its displacement becomes -125
+        //
+        file.add_label("far");
+        add_nops(file, 123);
+        add_jump(file, "far", 0x05);        // JNE, -129 from the end of the jump
+        file.add_label("near");
+        add_nops(file, 123);
+        add_jump(file, "near");             // JMP, -128 from the end of the jump
+        file.add_text(ret, sizeof(ret));
+
+        std::vector<std::uint8_t> const text(finalize_text(file));
+        CATCH_REQUIRE(text.size() == 123 + 6 + 123 + 2 + 1);
+
+        CATCH_REQUIRE(text[123] == 0x0F);   // JNE disp32
+        CATCH_REQUIRE(text[124] == 0x85);
+        CATCH_REQUIRE(text[125] == 0x7F);
+        CATCH_REQUIRE(text[126] == 0xFF);
+        CATCH_REQUIRE(text[127] == 0xFF);
+        CATCH_REQUIRE(text[128] == 0xFF);
+        CATCH_REQUIRE(jump_target(text, 123) == 0);
+
+        std::size_t const near(123 + 6 + 123);
+        CATCH_REQUIRE(text[near] == 0xEB);  // JMP disp8
+        CATCH_REQUIRE(text[near + 1] == 0x83);
+        CATCH_REQUIRE(jump_target(text, near) == 123 + 6);
+
+        CATCH_REQUIRE(text.back() == 0xC3);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_value_numbering", "[binary][value_numbering]")
+{
+    CATCH_START_SECTION("binary_value_numbering: reuse the values of the dominating blocks")
+    {
+        std::string const s(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_value_numbering_dominator.ajs");
+        std::string const ir(dump_ir(s));
+
+        // x * y computed before the if() is reused in both branches,
+        // after the join, and in the loop
+        //
+        CATCH_REQUIRE(count_occurrences(ir, "MULTIPLY x, y") == 1);
+
+        // r_v is not written between its two uses, r_w is
+        //
+        CATCH_REQUIRE(count_occurrences(ir, "MULTIPLY r_v, y") == 1);
+        CATCH_REQUIRE(count_occurrences(ir, "MULTIPLY r_w, y") == 2);
+
+        run_script(s);
+        meta m(load_script_meta(s));
+        execute(m);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_value_numbering: values written in a loop are not reused")
+    {
+        std::string const s(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_value_numbering_loop.ajs");
+        std::string const ir(dump_ir(s));
+
+        // r_cur changes in the first loop, r_a in the second one
+        //
+        CATCH_REQUIRE(count_occurrences(ir, "MULTIPLY r_cur, x") == 3);
+        CATCH_REQUIRE(count_occurrences(ir, "MULTIPLY r_a, x") == 1);
+
+        run_script(s);
+        meta m(load_script_meta(s));
+        execute(m);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_typed_arrays", "[binary][array]")
+{
+    typedef void (*initialize_t)(as2js::binary_variable *, std::int64_t);
+    typedef void (*free_t)(as2js::binary_variable *);
+    typedef void (*push_t)(as2js::binary_variable *, as2js::binary_variable *);
+    typedef std::int64_t (*length_t)(as2js::binary_variable const *);
+    typedef void * (*data_t)(as2js::binary_variable const *);
+    typedef void (*push_integer_t)(as2js::binary_variable *, std::int64_t);
+    typedef void (*push_floating_point_t)(as2js::binary_variable *, double);
+    typedef void (*push_boolean_t)(as2js::binary_variable *, bool);
+    typedef std::int64_t (*get_integer_t)(as2js::binary_variable const *, std::int64_t);
+    typedef double (*get_floating_point_t)(as2js::binary_variable const *, std::int64_t);
+    typedef bool (*get_boolean_t)(as2js::binary_variable const *, std::int64_t);
+    typedef void (*set_integer_t)(as2js::binary_variable *, std::int64_t, std::int64_t);
+    typedef void (*set_floating_point_t)(as2js::binary_variable *, std::int64_t, double);
+    typedef void (*set_boolean_t)(as2js::binary_variable *, std::int64_t, bool);
+
+    initialize_t const array_initialize_typed(extern_function<initialize_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_INITIALIZE_TYPED));
+    free_t const array_free(extern_function<free_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_FREE));
+    push_t const array_push(extern_function<push_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_PUSH));
+    length_t const array_length(extern_function<length_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_LENGTH));
+    data_t const array_data(extern_function<data_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_DATA));
+    push_integer_t const array_push_integer(extern_function<push_integer_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_PUSH_INTEGER));
+    push_floating_point_t const array_push_floating_point(extern_function<push_floating_point_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_PUSH_FLOATING_POINT));
+    push_boolean_t const array_push_boolean(extern_function<push_boolean_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_PUSH_BOOLEAN));
+    get_integer_t const array_get_integer(extern_function<get_integer_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_GET_INTEGER));
+    get_floating_point_t const array_get_floating_point(extern_function<get_floating_point_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_GET_FLOATING_POINT));
+    get_boolean_t const array_get_boolean(extern_function<get_boolean_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_GET_BOOLEAN));
+    set_integer_t const array_set_integer(extern_function<set_integer_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_SET_INTEGER));
+    set_floating_point_t const array_set_floating_point(extern_function<set_floating_point_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_SET_FLOATING_POINT));
+    set_boolean_t const array_set_boolean(extern_function<set_boolean_t>(as2js::external_function_t::EXTERNAL_FUNCTION_ARRAY_SET_BOOLEAN));
+
+    CATCH_START_SECTION("binary_typed_arrays: array of integers")
+    {
+        as2js::binary_variable v;
+        array_initialize_typed(&v, as2js::ARRAY_ELEMENT_INTEGER);
+        CATCH_REQUIRE(v.f_type == as2js::VARIABLE_TYPE_ARRAY);
+        CATCH_REQUIRE(v.f_element_type == as2js::ARRAY_ELEMENT_INTEGER);
+        CATCH_REQUIRE(v.f_flags == as2js::VARIABLE_FLAG_ALLOCATED);
+        CATCH_REQUIRE(array_length(&v) == 0);
+
+        array_push_integer(&v, 5);
+        array_push_integer(&v, -3);
+        CATCH_REQUIRE(array_length(&v) == 2);
+        CATCH_REQUIRE(array_get_integer(&v, 0) == 5);
+        CATCH_REQUIRE(array_get_integer(&v, 1) == -3);
+
+        // setting past the end enlarges the array with zeroes
+        //
+        array_set_integer(&v, 4, 7);
+        array_set_integer(&v, 0, 11);
+        CATCH_REQUIRE(array_length(&v) == 5);
+        CATCH_REQUIRE(array_get_integer(&v, 0) == 11);
+        CATCH_REQUIRE(array_get_integer(&v, 2) == 0);
+        CATCH_REQUIRE(array_get_integer(&v, 4) == 7);
+
+        // the generic push accepts an integer variable
+        //
+        as2js::binary_variable item;
+        item.f_type = as2js::VARIABLE_TYPE_INTEGER;
+        item.f_data = static_cast<std::uint64_t>(-42);
+        array_push(&v, &item);
+
+        std::int64_t const expected[] = { 11, -3, 0, 0, 7, -42 };
+        CATCH_REQUIRE(array_length(&v) == static_cast<std::int64_t>(std::size(expected)));
+        std::int64_t const * data(reinterpret_cast<std::int64_t const *>(array_data(&v)));
+        CATCH_REQUIRE(std::equal(data, data + std::size(expected), expected));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_get_integer(&v, 6)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: index 6 out of range in array_get_integer(), the array has 6 items."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_get_integer(&v, -1)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: index -1 out of range in array_get_integer(), the array has 6 items."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_set_integer(&v, -1, 1)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: negative index in array_set_integer()."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_get_floating_point(&v, 0)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: array in array_get_floating_point() has items of type INTEGER instead of FLOATING_POINT."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_push_boolean(&v, true)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: array in array_push_boolean() has items of type INTEGER instead of BOOLEAN."));
+
+        item.f_type = as2js::VARIABLE_TYPE_BOOLEAN;
+        item.f_data = 1;
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_push(&v, &item)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: cannot push an item of type boolean to an array of INTEGER in array_push()."));
+
+        array_free(&v);
+        CATCH_REQUIRE(v.f_flags == as2js::VARIABLE_FLAG_DEFAULT);
+        CATCH_REQUIRE(v.f_data == 0);
+        CATCH_REQUIRE(array_length(&v) == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_typed_arrays: array of floating points")
+    {
+        as2js::binary_variable v;
+        array_initialize_typed(&v, as2js::ARRAY_ELEMENT_FLOATING_POINT);
+        CATCH_REQUIRE(v.f_type == as2js::VARIABLE_TYPE_ARRAY);
+        CATCH_REQUIRE(v.f_element_type == as2js::ARRAY_ELEMENT_FLOATING_POINT);
+        CATCH_REQUIRE(array_length(&v) == 0);
+
+        array_push_floating_point(&v, 1.5);
+        array_push_floating_point(&v, -0.25);
+        CATCH_REQUIRE(array_length(&v) == 2);
+        CATCH_REQUIRE(array_get_floating_point(&v, 0) == 1.5);
+        CATCH_REQUIRE(array_get_floating_point(&v, 1) == -0.25);
+
+        array_set_floating_point(&v, 3, 9.75);
+        array_set_floating_point(&v, 1, 3.0);
+        CATCH_REQUIRE(array_length(&v) == 4);
+        CATCH_REQUIRE(array_get_floating_point(&v, 1) == 3.0);
+        CATCH_REQUIRE(array_get_floating_point(&v, 2) == 0.0);
+
+        // the generic push accepts floating points and integers
+        //
+        as2js::binary_variable item;
+        item.f_type = as2js::VARIABLE_TYPE_FLOATING_POINT;
+        double const value(-8.5);
+        memcpy(&item.f_data, &value, sizeof(value));
+        array_push(&v, &item);
+        item.f_type = as2js::VARIABLE_TYPE_INTEGER;
+        item.f_data = 17;
+        array_push(&v, &item);
+
+        double const expected[] = { 1.5, 3.0, 0.0, 9.75, -8.5, 17.0 };
+        CATCH_REQUIRE(array_length(&v) == static_cast<std::int64_t>(std::size(expected)));
+        double const * data(reinterpret_cast<double const *>(array_data(&v)));
+        CATCH_REQUIRE(std::equal(data, data + std::size(expected), expected));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_get_floating_point(&v, 6)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: index 6 out of range in array_get_floating_point(), the array has 6 items."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_set_floating_point(&v, -1, 1.0)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: negative index in array_set_floating_point()."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_get_integer(&v, 0)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: array in array_get_integer() has items of type FLOATING_POINT instead of INTEGER."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_push_integer(&v, 1)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: array in array_push_integer() has items of type FLOATING_POINT instead of INTEGER."));
+
+        array_free(&v);
+        CATCH_REQUIRE(v.f_flags == as2js::VARIABLE_FLAG_DEFAULT);
+        CATCH_REQUIRE(v.f_data == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_typed_arrays: array of booleans")
+    {
+        as2js::binary_variable v;
+        array_initialize_typed(&v, as2js::ARRAY_ELEMENT_BOOLEAN);
+        CATCH_REQUIRE(v.f_type == as2js::VARIABLE_TYPE_ARRAY);
+        CATCH_REQUIRE(v.f_element_type == as2js::ARRAY_ELEMENT_BOOLEAN);
+        CATCH_REQUIRE(array_length(&v) == 0);
+
+        array_push_boolean(&v, true);
+        array_push_boolean(&v, false);
+        CATCH_REQUIRE(array_length(&v) == 2);
+        CATCH_REQUIRE(array_get_boolean(&v, 0));
+        CATCH_REQUIRE_FALSE(array_get_boolean(&v, 1));
+
+        array_set_boolean(&v, 3, true);
+        array_set_boolean(&v, 0, false);
+        CATCH_REQUIRE(array_length(&v) == 4);
+        CATCH_REQUIRE_FALSE(array_get_boolean(&v, 0));
+        CATCH_REQUIRE_FALSE(array_get_boolean(&v, 2));
+        CATCH_REQUIRE(array_get_boolean(&v, 3));
+
+        // any non-zero boolean is saved as 1
+        //
+        as2js::binary_variable item;
+        item.f_type = as2js::VARIABLE_TYPE_BOOLEAN;
+        item.f_data = 0x100;
+        array_push(&v, &item);
+
+        std::uint8_t const expected[] = { 0, 0, 0, 1, 1 };
+        CATCH_REQUIRE(array_length(&v) == static_cast<std::int64_t>(std::size(expected)));
+        std::uint8_t const * data(reinterpret_cast<std::uint8_t const *>(array_data(&v)));
+        CATCH_REQUIRE(std::equal(data, data + std::size(expected), expected));
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_get_boolean(&v, 5)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: index 5 out of range in array_get_boolean(), the array has 5 items."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_set_boolean(&v, -1, true)
+                , as2js::out_of_range
+                , Catch::Matchers::ExceptionMessage(
+                          "out_of_range: negative index in array_set_boolean()."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_set_integer(&v, 0, 1)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: array in array_set_integer() has items of type BOOLEAN instead of INTEGER."));
+
+        array_free(&v);
+        CATCH_REQUIRE(v.f_flags == as2js::VARIABLE_FLAG_DEFAULT);
+        CATCH_REQUIRE(v.f_data == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_typed_arrays: invalid element type")
+    {
+        as2js::binary_variable v;
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_initialize_typed(&v, 4)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: unknown array element type 4 in array_initialize_typed()."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  array_initialize_typed(&v, -1)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: unknown array element type -1 in array_initialize_typed()."));
+        CATCH_REQUIRE(v.f_type == as2js::VARIABLE_TYPE_UNKNOWN);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_typed_arrays: arrays in the arena are copied to the heap at the end of a run")
+    {
+        std::string const script_filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/typed_arrays.ajs");
+        {
+            std::ofstream script(script_filename);
+            script << "extern var r_integers: Integer;\n"
+                      "extern var r_floating_points: Double;\n"
+                      "extern var r_booleans: Boolean;\n"
+                      "extern var r_variables: Integer;\n"
+                      "r_integers := 1;\n";
+        }
+        run_script(script_filename);
+
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out"));
+        as2js::execution_context::pointer_t c(script.create_context());
+
+        // the variables of the script are turned into arrays the way the
+        // generated code would do it while running
+        //
+        as2js::binary_variable * integers(c->find_variable("r_integers"));
+        as2js::binary_variable * floating_points(c->find_variable("r_floating_points"));
+        as2js::binary_variable * booleans(c->find_variable("r_booleans"));
+        as2js::binary_variable * variables(c->find_variable("r_variables"));
+        CATCH_REQUIRE(integers != nullptr);
+        CATCH_REQUIRE(floating_points != nullptr);
+        CATCH_REQUIRE(booleans != nullptr);
+        CATCH_REQUIRE(variables != nullptr);
+
+        as2js::binary_variable item;
+        item.f_type = as2js::VARIABLE_TYPE_INTEGER;
+        item.f_data = 33;
+
+        std::size_t const count(1'000);
+        {
+            as2js::context_scope const scope(*c);
+
+            array_initialize_typed(integers, as2js::ARRAY_ELEMENT_INTEGER);
+            array_initialize_typed(floating_points, as2js::ARRAY_ELEMENT_FLOATING_POINT);
+            array_initialize_typed(booleans, as2js::ARRAY_ELEMENT_BOOLEAN);
+            array_initialize_typed(variables, as2js::ARRAY_ELEMENT_VARIABLE);
+            for(std::size_t idx(0); idx < count; ++idx)
+            {
+                array_push_integer(integers, idx * 3);
+                array_push_floating_point(floating_points, idx / 4.0);
+                array_push_boolean(booleans, (idx & 1) != 0);
+            }
+            array_push(variables, &item);
+
+            CATCH_REQUIRE(integers->f_flags == as2js::VARIABLE_FLAG_ARENA);
+            CATCH_REQUIRE(floating_points->f_flags == as2js::VARIABLE_FLAG_ARENA);
+            CATCH_REQUIRE(booleans->f_flags == as2js::VARIABLE_FLAG_ARENA);
+            CATCH_REQUIRE(variables->f_flags == as2js::VARIABLE_FLAG_ARENA);
+            CATCH_REQUIRE(c->get_arena().get_used() >= count * (sizeof(std::int64_t) + sizeof(double) + 1));
+        }
+
+        c->release_arena();
+        CATCH_REQUIRE(c->get_arena().get_used() == 0);
+
+        CATCH_REQUIRE(integers->f_flags == as2js::VARIABLE_FLAG_ALLOCATED);
+        CATCH_REQUIRE(floating_points->f_flags == as2js::VARIABLE_FLAG_ALLOCATED);
+        CATCH_REQUIRE(booleans->f_flags == as2js::VARIABLE_FLAG_ALLOCATED);
+        CATCH_REQUIRE(variables->f_flags == (as2js::VARIABLE_FLAG_ALLOCATED | as2js::VARIABLE_FLAG_OWNED));
+
+        CATCH_REQUIRE(array_length(integers) == static_cast<std::int64_t>(count));
+        CATCH_REQUIRE(array_length(floating_points) == static_cast<std::int64_t>(count));
+        CATCH_REQUIRE(array_length(booleans) == static_cast<std::int64_t>(count));
+        for(std::size_t idx(0); idx < count; ++idx)
+        {
+            CATCH_REQUIRE(array_get_integer(integers, idx) == static_cast<std::int64_t>(idx * 3));
+            CATCH_REQUIRE(array_get_floating_point(floating_points, idx) == idx / 4.0);
+            CATCH_REQUIRE(array_get_boolean(booleans, idx) == ((idx & 1) != 0));
+        }
+
+        // the items of an array of variables get copied too
+        //
+        CATCH_REQUIRE(array_length(variables) == 1);
+        as2js::binary_variable * const * items(reinterpret_cast<as2js::binary_variable * const *>(array_data(variables)));
+        CATCH_REQUIRE(items[0] != &item);
+        CATCH_REQUIRE(items[0]->f_type == as2js::VARIABLE_TYPE_INTEGER);
+        CATCH_REQUIRE(items[0]->f_data == 33);
+
+        // the heap copies can still grow
+        //
+        array_set_integer(integers, count, -1);
+        CATCH_REQUIRE(array_length(integers) == static_cast<std::int64_t>(count + 1));
+        CATCH_REQUIRE(array_get_integer(integers, count) == -1);
+
+        // the context frees the heap copies when destroyed
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_execution_context", "[binary][context]")
+{
+    CATCH_START_SECTION("binary_execution_context: one running_file, several contexts")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_additive.ajs");
+
+        std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+        filename += "/tests/a.out";
+
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(filename));
+
+        as2js::execution_context::pointer_t c1(script.create_context());
+        as2js::execution_context::pointer_t c2(script.create_context());
+
+        c1->set_variable("x", static_cast<std::int64_t>(45));
+        c1->set_variable("y", static_cast<std::int64_t>(-12));
+        c2->set_variable("x", static_cast<std::int64_t>(1000));
+        c2->set_variable("y", static_cast<std::int64_t>(234));
+
+        as2js::binary_result r1;
+        script.run(*c1, r1);
+        as2js::binary_result r2;
+        script.run(*c2, r2);
+
+        CATCH_REQUIRE(r1.get_integer() == 33);
+        CATCH_REQUIRE(r2.get_integer() == 1234);
+
+        // the first run was not affected by the second context
+        //
+        std::int64_t value(0);
+        c1->get_variable("r_add", value);
+        CATCH_REQUIRE(value == 33);
+        c2->get_variable("r_add", value);
+        CATCH_REQUIRE(value == 1234);
+
+        // and the default context was not touched at all
+        //
+        script.get_variable("r_add", value);
+        CATCH_REQUIRE(value == 0);
+
+        // a context can only be used with the file that created it
+        //
+        as2js::running_file other;
+        CATCH_REQUIRE(other.load(filename));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  other.run(*c1, r1)
+                , as2js::invalid_data
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: the execution context was not created by this running_file."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_execution_context: variable handles")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_additive.ajs");
+
+        std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+        filename += "/tests/a.out";
+
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(filename));
+
+        as2js::variable_handle const x(script.get_handle("x"));
+        as2js::variable_handle const y(script.get_handle("y"));
+        as2js::variable_handle const r_add(script.get_handle("r_add"));
+        CATCH_REQUIRE(x.is_valid());
+        CATCH_REQUIRE_FALSE(as2js::variable_handle().is_valid());
+
+        for(std::int64_t idx(0); idx < 10; ++idx)
+        {
+            script.set(x, idx * 100);
+            script.set(y, idx);
+
+            as2js::binary_result result;
+            script.run(result);
+            CATCH_REQUIRE(result.get_integer() == idx * 101);
+
+            std::int64_t value(0);
+            script.get(r_add, value);
+            CATCH_REQUIRE(value == idx * 101);
+        }
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  script.set(x, 3.5)
+                , as2js::incompatible_type
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: trying to set variable \"x\" to a double value when the variable is of type: \"integer\"."));
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  script.get_handle("unknown")
+                , as2js::invalid_data
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: could not find variable \"unknown\"."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_execution_context: mapped file")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/string_operator_additive.ajs");
+        meta m(load_script_meta(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/string_operator_additive.ajs"));
+
+        std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+        filename += "/tests/a.out";
+
+        as2js::running_file loaded;
+        CATCH_REQUIRE(loaded.load(filename));
+        as2js::running_file mapped;
+        CATCH_REQUIRE(mapped.map(filename));
+
+        for(auto const & var : m.f_variables)
+        {
+            if(!var.second.is_out()
+            && var.second.get_type() == value_type_t::VALUE_TYPE_STRING)
+            {
+                loaded.set_variable(var.first, var.second.f_value);
+                mapped.set_variable(var.first, var.second.f_value);
+            }
+        }
+
+        as2js::binary_result r1;
+        loaded.run(r1);
+        as2js::binary_result r2;
+        mapped.run(r2);
+        CATCH_REQUIRE(r1.get_string() == m.f_result.f_value);
+        CATCH_REQUIRE(r2.get_string() == m.f_result.f_value);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_execution_context: arena is reset after each run")
+    {
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/string_operator_additive.ajs");
+        meta m(load_script_meta(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/string_operator_additive.ajs"));
+
+        std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+        filename += "/tests/a.out";
+
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(filename));
+        as2js::execution_context::pointer_t c(script.create_context());
+
+        std::size_t capacity(0);
+        for(int count(0); count < 100; ++count)
+        {
+            for(auto const & var : m.f_variables)
+            {
+                if(!var.second.is_out()
+                && var.second.get_type() == value_type_t::VALUE_TYPE_STRING)
+                {
+                    c->set_variable(var.first, var.second.f_value);
+                }
+            }
+
+            as2js::binary_result r;
+            script.run(*c, r);
+            CATCH_REQUIRE(r.get_string() == m.f_result.f_value);
+
+            // nothing remains allocated in the arena and the blocks get
+            // reused by the following runs
+            //
+            CATCH_REQUIRE(c->get_arena().get_used() == 0);
+            if(count == 0)
+            {
+                capacity = c->get_arena().get_capacity();
+            }
+            else
+            {
+                CATCH_REQUIRE(c->get_arena().get_capacity() == capacity);
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_script_registry", "[binary][registry]")
+{
+    CATCH_START_SECTION("binary_script_registry: load, share, reload, evict")
+    {
+        std::string const a_out(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out");
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/registry.out");
+        auto copy_a_out = [&a_out, &filename]()
+        {
+            // the file is mapped, replace it instead of overwriting it
+            //
+            {
+                std::ifstream in(a_out, std::ios::binary);
+                std::ofstream out(filename + ".tmp", std::ios::binary | std::ios::trunc);
+                out << in.rdbuf();
+            }
+            CATCH_REQUIRE(rename((filename + ".tmp").c_str(), filename.c_str()) == 0);
+        };
+
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_additive.ajs");
+        copy_a_out();
+
+        as2js::script_registry registry;
+        as2js::running_file::pointer_t s1(registry.get(filename));
+        CATCH_REQUIRE(s1 != nullptr);
+        CATCH_REQUIRE(registry.get(filename) == s1);
+        CATCH_REQUIRE(registry.size() == 1);
+        CATCH_REQUIRE(registry.get_memory_usage() == s1->get_memory_size());
+
+        // the same contents give the same image
+        //
+        snapdev::file_contents image(filename);
+        CATCH_REQUIRE(image.read_all());
+        CATCH_REQUIRE(registry.get_from_content(image.contents()) == s1);
+        as2js::script_registry::hash_t const h1(as2js::script_registry::hash(
+                                  image.contents().data()
+                                , image.contents().length()));
+        CATCH_REQUIRE(registry.find(h1) == s1);
+
+        as2js::execution_context::pointer_t c1(s1->create_context());
+        c1->set_variable("x", static_cast<std::int64_t>(45));
+        c1->set_variable("y", static_cast<std::int64_t>(-12));
+        as2js::binary_result r1;
+        s1->run(*c1, r1);
+        CATCH_REQUIRE(r1.get_integer() == 33);
+
+        // replacing the file gives us a new image
+        //
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/string_operator_additive.ajs");
+        copy_a_out();
+
+        as2js::running_file::pointer_t s2(registry.get(filename));
+        CATCH_REQUIRE(s2 != nullptr);
+        CATCH_REQUIRE(s2 != s1);
+        CATCH_REQUIRE(registry.get(filename) == s2);
+
+        // s1 was loaded by content too so it is still available
+        //
+        CATCH_REQUIRE(registry.find(h1) == s1);
+        CATCH_REQUIRE(registry.size() == 2);
+
+        // the old image can still be used by its owner
+        //
+        s1->run(*c1, r1);
+        CATCH_REQUIRE(r1.get_integer() == 33);
+
+        // a limit of 1 byte keeps only the most recently used image
+        //
+        registry.set_memory_limit(1);
+        CATCH_REQUIRE(registry.size() == 1);
+        CATCH_REQUIRE(registry.find(h1) == nullptr);
+        CATCH_REQUIRE(registry.get(filename) == s2);
+
+        registry.invalidate(filename);
+        CATCH_REQUIRE(registry.size() == 0);
+        CATCH_REQUIRE(registry.get_memory_usage() == 0);
+
+        CATCH_REQUIRE_THROWS_MATCHES(
+                  registry.get(filename + ".missing")
+                , as2js::cannot_open_file
+                , Catch::Matchers::ExceptionMessage(
+                          "as2js_exception: could not open binary file \""
+                        + filename
+                        + ".missing\"."));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_script_registry: the loader changes do not affect the identity of an image")
+    {
+        // this script calls external functions so the loader patches
+        // the table of the image
+        //
+        run_script(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/math_operator_rounding.ajs");
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out");
+
+        snapdev::file_contents image(filename);
+        CATCH_REQUIRE(image.read_all());
+        std::string const & contents(image.contents());
+        as2js::binary_header const * header(reinterpret_cast<as2js::binary_header const *>(contents.data()));
+        CATCH_REQUIRE(header->f_extern_function_count > 0);
+
+        as2js::script_registry registry;
+        as2js::running_file::pointer_t s1(registry.get(filename));
+        CATCH_REQUIRE(s1 != nullptr);
+        CATCH_REQUIRE(memcmp(s1->get_image() + header->f_extern_functions
+                           , contents.data() + header->f_extern_functions
+                           , header->f_extern_function_count * sizeof(std::uint64_t)) != 0);
+
+        as2js::script_registry::hash_t const h(as2js::script_registry::hash(contents.data(), contents.length()));
+        CATCH_REQUIRE(as2js::script_registry::hash(s1->get_image(), s1->get_image_size()) == h);
+        CATCH_REQUIRE(registry.find(h) == s1);
+        CATCH_REQUIRE(registry.get_from_content(contents) == s1);
+        CATCH_REQUIRE(registry.size() == 1);
+
+        // any other change is part of the identity
+        //
+        std::string modified(contents);
+        modified[header->f_start] ^= 0x01;
+        CATCH_REQUIRE(as2js::script_registry::hash(modified.data(), modified.length()) != h);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_compile_script", "[binary][compile]")
+{
+    CATCH_START_SECTION("binary_compile_script: compile to memory and run")
+    {
+        // also creates the as2js.rc file the compiler needs
+        //
+        std::string const source_filename(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/integer_operator_additive.ajs");
+        run_script(source_filename);
+
+        snapdev::file_contents source(source_filename);
+        CATCH_REQUIRE(source.read_all());
+        as2js::running_file::pointer_t script(as2js::compile_script(source.contents()));
+        CATCH_REQUIRE(script != nullptr);
+
+        // same results as the binary file generated by the tool
+        //
+        as2js::running_file file;
+        CATCH_REQUIRE(file.load(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/a.out"));
+        CATCH_REQUIRE(script->variable_size() == file.variable_size());
+
+        as2js::execution_context::pointer_t c1(script->create_context());
+        as2js::execution_context::pointer_t c2(file.create_context());
+        for(auto const & c : { c1, c2 })
+        {
+            c->set_variable("x", static_cast<std::int64_t>(45));
+            c->set_variable("y", static_cast<std::int64_t>(-12));
+        }
+        as2js::binary_result r1;
+        script->run(*c1, r1);
+        as2js::binary_result r2;
+        file.run(*c2, r2);
+        CATCH_REQUIRE(r1.get_integer() == 33);
+        CATCH_REQUIRE(r2.get_integer() == 33);
+
+        std::int64_t value(0);
+        c1->get_variable("r_add", value);
+        CATCH_REQUIRE(value == 33);
+
+        // the default context works too
+        //
+        as2js::running_file::pointer_t expression(as2js::compile_script(
+                  "extern const x: Integer;\n"
+                  "extern var r_score: Integer;\n"
+                  "r_score := x * 3 + 1;\n"));
+        CATCH_REQUIRE(expression != nullptr);
+        expression->set_variable("x", static_cast<std::int64_t>(7));
+        as2js::binary_result r3;
+        expression->run(r3);
+        CATCH_REQUIRE(r3.get_integer() == 22);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("binary_compile_script: invalid source")
+    {
+        CATCH_REQUIRE(as2js::compile_script("extern var r: Integer;\nr := ;\n") == nullptr);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_random", "[binary][random]")
+{
+    CATCH_START_SECTION("binary_random: seeded contexts are reproducible")
+    {
+        std::string const script_filename(SNAP_CATCH2_NAMESPACE::g_binary_dir() + "/tests/random.ajs");
+        {
+            std::ofstream script(script_filename);
+            script << "use extended_operators;\n"
+                      "extern var r_random: Double;\n"
+                      "r_random := Math.random();\n";
+        }
+        run_script(script_filename);
+
+        std::string filename(SNAP_CATCH2_NAMESPACE::g_binary_dir());
+        filename += "/tests/a.out";
+
+        as2js::running_file script;
+        CATCH_REQUIRE(script.load(filename));
+        as2js::execution_context::pointer_t c1(script.create_context());
+        as2js::execution_context::pointer_t c2(script.create_context());
+        c1->set_random_seed(123);
+        c2->set_random_seed(123);
+
+        as2js::random_generator expected(123);
+        for(int idx(0); idx < 100; ++idx)
+        {
+            as2js::binary_result r1;
+            script.run(*c1, r1);
+            as2js::binary_result r2;
+            script.run(*c2, r2);
+
+            double const value(r1.get_floating_point());
+            CATCH_REQUIRE(value >= 0.0);
+            CATCH_REQUIRE(value < 1.0);
+            CATCH_REQUIRE(r2.get_floating_point() == value);
+            CATCH_REQUIRE(expected.next_double() == value);
+        }
+
+        // the default context is seeded through the running_file
+        //
+        script.set_random_seed(123);
+        as2js::binary_result r3;
+        script.run(r3);
+        CATCH_REQUIRE(r3.get_floating_point() == as2js::random_generator(123).next_double());
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_string_append", "[binary][string]")
+{
+    CATCH_START_SECTION("binary_string_append: append 16 fragments")
+    {
+        append_fragments(16);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_string_append_benchmark", "[.][binary][string][benchmark]")
+{
+    CATCH_START_SECTION("binary_string_append_benchmark: append 10,000 fragments")
+    {
+        append_fragments(10'000);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_batch", "[binary][batch]")
+{
+    CATCH_START_SECTION("binary_batch: compare run() and run_batch() on all the scripts")
+    {
+        snapdev::glob_to_list<std::list<std::string>> scripts;
+        CATCH_REQUIRE(scripts.read_path<snapdev::glob_to_list_flag_t::GLOB_FLAG_NONE>
+                                    (SNAP_CATCH2_NAMESPACE::g_source_dir()
+                                        + "/tests/binary/*_operator_*.ajs"));
+        for(auto const & s : scripts)
+        {
+            benchmark_batch(s, 16);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_batch_benchmark", "[.][binary][batch][benchmark]")
+{
+    CATCH_START_SECTION("binary_batch_benchmark: time run() and run_batch() on all the scripts")
+    {
+        snapdev::glob_to_list<std::list<std::string>> scripts;
+        CATCH_REQUIRE(scripts.read_path<snapdev::glob_to_list_flag_t::GLOB_FLAG_NONE>
+                                    (SNAP_CATCH2_NAMESPACE::g_source_dir()
+                                        + "/tests/binary/*_operator_*.ajs"));
+        for(auto const & s : scripts)
+        {
+            benchmark_batch(s, 10'000);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_register_allocation", "[binary][register]")
+{
+    CATCH_START_SECTION("binary_register_allocation: same result without the allocator, larger .text")
+    {
+        std::string const s(SNAP_CATCH2_NAMESPACE::g_source_dir()
+                        + "/tests/binary/register_allocation_pressure.ajs");
+        meta const m(load_script_meta(s));
+
+        allocation_measure const with_registers(measure_register_allocation(s, m, true, 1));
+        allocation_measure const without_registers(measure_register_allocation(s, m, false, 1));
+
+        // without registers, each temporary gets loaded from and saved
+        // to its stack slot
+        //
+        CATCH_REQUIRE(with_registers.f_text_size < without_registers.f_text_size);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("binary_register_allocation_benchmark", "[.][binary][register][benchmark]")
+{
+    CATCH_START_SECTION("binary_register_allocation_benchmark: .text size and run time with and without the allocator")
+    {
+        std::size_t const runs(10'000);
+
+        snapdev::glob_to_list<std::list<std::string>> scripts;
+        CATCH_REQUIRE(scripts.read_path<snapdev::glob_to_list_flag_t::GLOB_FLAG_NONE>
+                                    (SNAP_CATCH2_NAMESPACE::g_source_dir()
+                                        + "/tests/binary/*.ajs"));
+        std::size_t total_with(0);
+        std::size_t total_without(0);
+        for(auto const & s : scripts)
+        {
+            if(access(snapdev::pathinfo::replace_suffix(s, ".ajs", ".meta").c_str(), R_OK) != 0)
+            {
+                continue;
+            }
+            meta const m(load_script_meta(s));
+
+            allocation_measure const with_registers(measure_register_allocation(s, m, true, runs));
+            allocation_measure const without_registers(measure_register_allocation(s, m, false, runs));
+            total_with += with_registers.f_text_size;
+            total_without += without_registers.f_text_size;
+
+            std::cout
+                << "--- "
+                << snapdev::pathinfo::basename(s)
+                << ": .text "
+                << without_registers.f_text_size
+                << " -> "
+                << with_registers.f_text_size
+                << " bytes, "
+                << runs
+                << " runs "
+                << without_registers.f_duration
+                << "us -> "
+                << with_registers.f_duration
+                << "us\n";
+        }
+        std::cout
+            << "--- total .text without/with register allocation: "
+            << total_without
+            << " -> "
+            << total_with
+            << " bytes\n";
+    }
+    CATCH_END_SECTION()
+}
+
+
 
 // vim: ts=4 sw=4 et
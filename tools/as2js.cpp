@@ -102,6 +102,7 @@ enum class command_t
     COMMAND_CPP,
     COMMAND_CREATE_ARCHIVE,
     COMMAND_DATA_SECTION,
+    COMMAND_DUMP_IR,
     COMMAND_END_SECTION,
     COMMAND_EXECUTE,
     COMMAND_EXTRACT_ARCHIVE,
@@ -135,6 +136,7 @@ private:
     int                         output_error_count();
     void                        compile();
     void                        generate_binary(as2js::compiler::pointer_t c);
+    void                        dump_ir(as2js::compiler::pointer_t c);
     void                        binary_utils();
     void                        list_external_variables(
                                       std::ifstream & in
@@ -245,6 +247,10 @@ int as2js_compiler::parse_command_line_options(int argc, char *argv[])
                 {
                     set_output(command_t::COMMAND_DATA_SECTION);
                 }
+                else if(strcmp(argv[i] + 2, "dump-ir") == 0)
+                {
+                    set_output(command_t::COMMAND_DUMP_IR);
+                }
                 else if(strcmp(argv[i] + 2, "end-section") == 0)
                 {
                     set_output(command_t::COMMAND_END_SECTION);
@@ -309,6 +315,10 @@ int as2js_compiler::parse_command_line_options(int argc, char *argv[])
                 {
                     set_option(as2js::option_t::OPTION_JSON, argc, argv, i);
                 }
+                else if(strcmp(argv[i] + 2, "no-register-allocation") == 0)
+                {
+                    set_option(as2js::option_t::OPTION_NO_REGISTER_ALLOCATION, argc, argv, i);
+                }
                 else if(strcmp(argv[i] + 2, "octal") == 0)
                 {
                     set_option(as2js::option_t::OPTION_OCTAL, argc, argv, i);
@@ -511,6 +521,7 @@ void as2js_compiler::usage()
            "  -b | --binary          generate a binary file.\n"
            "       --binary-version  output version of the binary file.\n"
            "       --data-section    position where the data section starts.\n"
+           "       --dump-ir         output the optimized operations of the binary.\n"
            "       --end-section     position where the end section starts.\n"
            "       --error-on-missing-variables\n"
            "                         variables defined on the command must exist.\n"
@@ -534,6 +545,8 @@ void as2js_compiler::usage()
            "\n"
            "Options:\n"
            "  -L <path>              path to archive libraries.\n"
+           "  --no-register-allocation true\n"
+           "                         keep all the temporaries on the stack.\n"
     ;
 }
 
@@ -634,6 +647,7 @@ int as2js_compiler::run()
     case command_t::COMMAND_PARSER_TREE:
     case command_t::COMMAND_COMPILER_TREE:
     case command_t::COMMAND_BINARY:
+    case command_t::COMMAND_DUMP_IR:
     case command_t::COMMAND_ASSEMBLY:
     case command_t::COMMAND_JAVASCRIPT:
     case command_t::COMMAND_CPP:
@@ -748,6 +762,10 @@ void as2js_compiler::compile()
             generate_binary(compiler);
             break;
 
+        case command_t::COMMAND_DUMP_IR:
+            dump_ir(compiler);
+            break;
+
         case command_t::COMMAND_ASSEMBLY:
         case command_t::COMMAND_JAVASCRIPT:
         case command_t::COMMAND_CPP:
@@ -807,6 +825,22 @@ void as2js_compiler::generate_binary(as2js::compiler::pointer_t compiler)
 }
 
 
+void as2js_compiler::dump_ir(as2js::compiler::pointer_t compiler)
+{
+    as2js::flatten_nodes::pointer_t fn(as2js::flatten(f_root, compiler));
+    if(fn == nullptr)
+    {
+        ++f_error_count;
+        std::cerr
+            << "error: the tree could not be transformed to operations.\n";
+        return;
+    }
+
+    fn->optimize();
+    fn->dump(std::cout);
+}
+
+
 void as2js_compiler::binary_utils()
 {
     if(!f_output.empty())